@@ -31,7 +31,10 @@ import com.tencent.mtt.hippy.dom.flex.FlexWrap;
 import com.tencent.mtt.hippy.dom.flex.FloatUtil;
 import com.tencent.smtt.flexbox.FlexNodeStyle.Edge;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.util.ArrayList;
+import java.util.IdentityHashMap;
 import java.util.List;
 
 public class FlexNode implements FlexNodeAPI<FlexNode> {
@@ -69,6 +72,247 @@ public class FlexNode implements FlexNodeAPI<FlexNode> {
 	private float mBorderBottom = 0;
 	private boolean mHasNewLayout = true;
 
+	// layout results of nodes with new layout are read from one direct buffer
+	// filled by native, instead of set field by field through JNI.
+	// record is FlexLayoutOutputRecord in FlexNode.cpp: int index, 16 floats.
+	private final static int LAYOUT_OUTPUT_RECORD_BYTES = 68;
+	private static boolean sFlatLayoutOutput = true;
+	private ByteBuffer mLayoutOutput;
+
+	public static void setFlatLayoutOutput(boolean enabled) {
+		sFlatLayoutOutput = enabled;
+	}
+
+	// predictable text measures of a layout are made by one call of
+	// measureFuncBatch before layout, instead of a call of measureFunc each.
+	private static boolean sBatchMeasure = true;
+
+	public static void setBatchMeasure(boolean enabled) {
+		sBatchMeasure = enabled;
+	}
+
+	// statistics of a layout, filled by calculateLayout when an array of
+	// LAYOUT_STATS_SIZE is passed, so the caller chooses which layouts to
+	// sample. in order of HPLayoutStats in HPLayoutStats.h: counts, then
+	// milliseconds spent in each LayoutPhase, then total milliseconds.
+	public final static int LAYOUT_STATS_VISIT_COUNT = 0;
+	public final static int LAYOUT_STATS_LAYOUT_COUNT = 1;
+	public final static int LAYOUT_STATS_MEASURE_WIDTH_COUNT = 2;
+	public final static int LAYOUT_STATS_MEASURE_HEIGHT_COUNT = 3;
+	public final static int LAYOUT_STATS_NEW_LAYOUT_COUNT = 4;
+	public final static int LAYOUT_STATS_MEASURE_FUNC_COUNT = 5;
+	public final static int LAYOUT_STATS_LAYOUT_CACHE_HIT_COUNT = 6;
+	public final static int LAYOUT_STATS_LAYOUT_CACHE_MISS_COUNT = 7;
+	public final static int LAYOUT_STATS_MEASURE_CACHE_HIT_COUNT = 8;
+	public final static int LAYOUT_STATS_MEASURE_CACHE_MISS_COUNT = 9;
+	public final static int LAYOUT_STATS_MEASURE_CACHE_EVICT_COUNT = 10;
+	public final static int LAYOUT_STATS_FIXED_DIM_HIT_COUNT = 11;
+	public final static int LAYOUT_STATS_SHARED_MEASURE_HIT_COUNT = 12;
+	public final static int LAYOUT_STATS_BATCH_MEASURE_COUNT = 13;
+	public final static int LAYOUT_STATS_BATCH_MEASURE_HIT_COUNT = 14;
+	public final static int LAYOUT_STATS_WINDOWED_OUT_COUNT = 15;
+	public final static int LAYOUT_STATS_APPEND_LAYOUT_COUNT = 16;
+	// time of phase i is at LAYOUT_STATS_PHASE_TIME + i.
+	public final static int LAYOUT_STATS_PHASE_TIME = 17;
+	public final static int LAYOUT_STATS_PHASE_COUNT = 9;
+	public final static int LAYOUT_STATS_TOTAL_TIME = 26;
+	public final static int LAYOUT_STATS_SIZE = 27;
+
+	private static native int nativeFlexNodeApplyMutations(long[] nativeNodes, ByteBuffer mutations,
+	                                                       int count);
+
+	/* Batches creation of nodes and tree and style changes, applied to native
+	 * nodes by one JNI call instead of a call per node or property. java
+	 * children lists are updated when the change is added. native nodes stop at
+	 * the first invalid change, apply() then undoes it and the changes after it
+	 * on java nodes, so both trees stay the same.
+	 * record is HPMutation in HPNodeMutation.h, property ids are HPStyleProperty,
+	 * values are as passed to FlexNodeStyle natives, e.g. enum ordinal.
+	 */
+	public static final class Mutations {
+		private final static int RECORD_BYTES = 16;
+		private final static int OP_CREATE_NODE = 0;
+		private final static int OP_INSERT_CHILD = 1;
+		private final static int OP_REMOVE_CHILD = 2;
+		private final static int OP_SET_STYLE = 3;
+
+		public final static int DIRECTION = 0;
+		public final static int FLEX_DIRECTION = 1;
+		public final static int JUSTIFY_CONTENT = 2;
+		public final static int ALIGN_CONTENT = 3;
+		public final static int ALIGN_ITEMS = 4;
+		public final static int ALIGN_SELF = 5;
+		public final static int FLEX_WRAP = 6;
+		public final static int POSITION_TYPE = 7;
+		public final static int DISPLAY = 8;
+		public final static int OVERFLOW = 9;
+		public final static int FLEX = 10;
+		public final static int FLEX_GROW = 11;
+		public final static int FLEX_SHRINK = 12;
+		public final static int FLEX_BASIS = 13;
+		public final static int WIDTH = 14;
+		public final static int HEIGHT = 15;
+		public final static int MIN_WIDTH = 16;
+		public final static int MIN_HEIGHT = 17;
+		public final static int MAX_WIDTH = 18;
+		public final static int MAX_HEIGHT = 19;
+		// properties with edge
+		public final static int MARGIN = 20;
+		public final static int MARGIN_AUTO = 21;
+		public final static int PADDING = 22;
+		public final static int BORDER = 23;
+		public final static int POSITION = 24;
+		// properties without edge
+		public final static int NODE_TYPE = 25;
+
+		private ByteBuffer mBuffer = ByteBuffer.allocateDirect(RECORD_BYTES * 64)
+		                                       .order(ByteOrder.nativeOrder());
+		private int mCount = 0;
+		private final ArrayList<FlexNode> mNodes = new ArrayList<>();
+		private final IdentityHashMap<FlexNode, Integer> mNodeIndex =
+		    new IdentityHashMap<>();
+		private final ArrayList<TreeChange> mTreeChanges = new ArrayList<>();
+
+		// tree change done on java nodes when added, see apply().
+		private static final class TreeChange {
+			final int record;
+			final boolean insert;
+			final FlexNode parent;
+			final FlexNode child;
+			final int index;
+
+			TreeChange(int record, boolean insert, FlexNode parent, FlexNode child, int index) {
+				this.record = record;
+				this.insert = insert;
+				this.parent = parent;
+				this.child = child;
+				this.index = index;
+			}
+		}
+
+		// native node of the returned node is created by apply(), it can't be
+		// passed to other FlexNode methods before, or at all if apply() stopped
+		// before its creation.
+		public FlexNode createNode() {
+			FlexNode node = new FlexNode(0);
+			add(OP_CREATE_NODE, 0, 0, node, 0);
+			return node;
+		}
+
+		public void setStyle(FlexNode node, int property, float value) {
+			setEdgeStyle(node, property, 0, value);
+		}
+
+		public void setEdgeStyle(FlexNode node, int property, int edge, float value) {
+			int offset = add(OP_SET_STYLE, property, edge, node, 0);
+			mBuffer.putFloat(offset + 12, value);
+			node.mDirty = true;
+			// edges of layout results are read back only for edges set, see
+			// setMargin, setPadding and setBorder.
+			if (property == MARGIN || property == MARGIN_AUTO) {
+				node.mEdgeSetFlag |= FlexNode.MARGIN;
+			} else if (property == PADDING) {
+				node.mEdgeSetFlag |= FlexNode.PADDING;
+			} else if (property == BORDER) {
+				node.mEdgeSetFlag |= FlexNode.BORDER;
+			}
+		}
+
+		public void insertChild(FlexNode parent, FlexNode child, int index) {
+			if (child.mParent != null) {
+				throw new IllegalStateException("Child already has a parent, it must be removed first.");
+			}
+			if (parent.mChildren == null) {
+				parent.mChildren = new ArrayList<FlexNode>(4);
+			}
+			parent.mChildren.add(index, child);
+			child.mParent = parent;
+			mTreeChanges.add(new TreeChange(mCount, true, parent, child, index));
+			int offset = add(OP_INSERT_CHILD, 0, 0, parent, indexOf(child));
+			mBuffer.putInt(offset + 12, index);
+		}
+
+		public void removeChild(FlexNode parent, FlexNode child) {
+			int index = parent.mChildren == null ? -1 : parent.mChildren.indexOf(child);
+			if (index < 0) {
+				return;
+			}
+			parent.mChildren.remove(index);
+			child.mParent = null;
+			mTreeChanges.add(new TreeChange(mCount, false, parent, child, index));
+			add(OP_REMOVE_CHILD, 0, 0, parent, indexOf(child));
+		}
+
+		// apply and clear added changes, returns count of changes applied, less
+		// than the count added if native nodes stopped at an invalid change.
+		public int apply() {
+			long[] nativeNodes = new long[mNodes.size()];
+			for (int i = 0; i < nativeNodes.length; i++) {
+				nativeNodes[i] = mNodes.get(i).mNativeFlexNode;
+			}
+			int applied = nativeFlexNodeApplyMutations(nativeNodes, mBuffer, mCount);
+			// pointers of created native nodes are filled in, also if apply
+			// stopped after their creation, so they are freed with java nodes.
+			for (int i = 0; i < nativeNodes.length; i++) {
+				FlexNode node = mNodes.get(i);
+				if (node.mNativeFlexNode == 0 && nativeNodes[i] != 0) {
+					node.mNativeFlexNode = nativeNodes[i];
+					node.mFlexNodeStyle = new FlexNodeStyle(nativeNodes[i]);
+				}
+			}
+			// undo tree changes not applied to native nodes, last first.
+			for (int i = mTreeChanges.size() - 1; i >= 0; i--) {
+				TreeChange change = mTreeChanges.get(i);
+				if (change.record < applied) {
+					break;
+				}
+				if (change.insert) {
+					change.parent.mChildren.remove(change.index);
+					change.child.mParent = null;
+				} else {
+					change.parent.mChildren.add(change.index, change.child);
+					change.child.mParent = change.parent;
+				}
+			}
+			mTreeChanges.clear();
+			mCount = 0;
+			mNodes.clear();
+			mNodeIndex.clear();
+			return applied;
+		}
+
+		private int indexOf(FlexNode node) {
+			Integer index = mNodeIndex.get(node);
+			if (index == null) {
+				index = mNodes.size();
+				mNodes.add(node);
+				mNodeIndex.put(node, index);
+			}
+			return index;
+		}
+
+		private int add(int op, int property, int edge, FlexNode node, int arg) {
+			int offset = mCount * RECORD_BYTES;
+			if (offset + RECORD_BYTES > mBuffer.capacity()) {
+				ByteBuffer buffer = ByteBuffer.allocateDirect(mBuffer.capacity() * 2)
+				                              .order(ByteOrder.nativeOrder());
+				mBuffer.position(0);
+				mBuffer.limit(offset);
+				buffer.put(mBuffer);
+				mBuffer.clear();
+				mBuffer = buffer;
+			}
+			mBuffer.put(offset, (byte) op);
+			mBuffer.put(offset + 1, (byte) property);
+			mBuffer.put(offset + 2, (byte) edge);
+			mBuffer.put(offset + 3, (byte) 0);
+			mBuffer.putInt(offset + 4, indexOf(node));
+			mBuffer.putInt(offset + 8, arg);
+			mCount++;
+			return offset;
+		}
+	}
+
 	  public FlexNodeStyle Style() {return mFlexNodeStyle;}
 	  
 	  @CalledByNative
@@ -76,6 +320,19 @@ public class FlexNode implements FlexNodeAPI<FlexNode> {
 	    return measure(width, widthMode, height, heightMode);
 	  }
 
+	  // measure requests of one layout in a call, nodes[indices[i]] is measured
+	  // with width, width mode, height, height mode at constraints[4 * i],
+	  // results are packed like measureFunc.
+	  @CalledByNative
+	  private static void measureFuncBatch(FlexNode[] nodes, int[] indices, float[] constraints,
+	                                       long[] results) {
+	    for (int i = 0; i < indices.length; i++) {
+	      int offset = i * 4;
+	      results[i] = nodes[indices[i]].measure(constraints[offset], (int) constraints[offset + 1],
+	                                             constraints[offset + 2], (int) constraints[offset + 3]);
+	    }
+	  }
+
     protected String resultToString(){
         return "layout: {" +
                 "left: " + getLayoutX() + ", " +
@@ -125,10 +382,17 @@ public class FlexNode implements FlexNodeAPI<FlexNode> {
 	    reset();
 	  }
 	  
+	  // node of Mutations.createNode(), native node is set when created.
+	  private FlexNode(long nativeFlexNode) {
+	    mNativeFlexNode = nativeFlexNode;
+	  }
+
 	  private native void nativeFlexNodeFree(long nativeFlexNode);
 	  protected void finalize() throws Throwable {
 	    try {
-	    	nativeFlexNodeFree(mNativeFlexNode);
+	    	if (mNativeFlexNode != 0) {
+	    		nativeFlexNodeFree(mNativeFlexNode);
+	    	}
 	    	mFlexNodeStyle = null;
 	    } finally {
 	      super.finalize();
@@ -210,8 +474,20 @@ public class FlexNode implements FlexNodeAPI<FlexNode> {
 	  }
 
 	  private native void nativeFlexNodeCalculateLayout(long nativeFlexNode, float width, float height,
-                                                      long[] nativeNodes, FlexNode[] nodes, int direction);
+                                                      long[] nativeNodes, FlexNode[] nodes, int direction,
+                                                      boolean batchMeasure, double[] stats);
+	  private native int nativeFlexNodeCalculateLayoutFlat(long nativeFlexNode, float width, float height,
+                                                      long[] nativeNodes, FlexNode[] nodes,
+                                                      ByteBuffer output, int direction,
+                                                      boolean batchMeasure, double[] stats);
 	  public void calculateLayout(float width, float height, FlexDirection direction) {
+	    calculateLayout(width, height, direction, null);
+	  }
+
+	  // stats is filled with statistics of this layout if not null, see
+	  // LAYOUT_STATS_SIZE.
+	  public void calculateLayout(float width, float height, FlexDirection direction,
+	                              double[] stats) {
         //long startTime = System.currentTimeMillis();
         //Log.e("layout", "3calculateLayout time start");
 	    long[] nativeNodes;
@@ -231,8 +507,51 @@ public class FlexNode implements FlexNodeAPI<FlexNode> {
         }
 
         //Log.e("layout", "calculateLayout time:"+ (System.currentTimeMillis() - startTime));
-        nativeFlexNodeCalculateLayout(mNativeFlexNode, width, height,
-                                    nativeNodes, nodes, direction.ordinal());
+        if (!sFlatLayoutOutput) {
+          nativeFlexNodeCalculateLayout(mNativeFlexNode, width, height,
+                                      nativeNodes, nodes, direction.ordinal(), sBatchMeasure,
+                                      stats);
+          return;
+        }
+
+        int capacity = nodes.length * LAYOUT_OUTPUT_RECORD_BYTES;
+        if (mLayoutOutput == null || mLayoutOutput.capacity() < capacity) {
+          // grow with headroom, so appending some nodes does not reallocate.
+          mLayoutOutput = ByteBuffer.allocateDirect(capacity + capacity / 2)
+                                    .order(ByteOrder.nativeOrder());
+        }
+        int count = nativeFlexNodeCalculateLayoutFlat(mNativeFlexNode, width, height,
+                                    nativeNodes, nodes, mLayoutOutput, direction.ordinal(),
+                                    sBatchMeasure, stats);
+        for (int i = 0, offset = 0; i < count; i++, offset += LAYOUT_OUTPUT_RECORD_BYTES) {
+          nodes[mLayoutOutput.getInt(offset)].applyLayoutOutput(mLayoutOutput, offset + 4);
+        }
+	  }
+
+	  private void applyLayoutOutput(ByteBuffer output, int offset) {
+	    mWidth = output.getFloat(offset);
+	    mHeight = output.getFloat(offset + 4);
+	    mLeft = output.getFloat(offset + 8);
+	    mTop = output.getFloat(offset + 12);
+	    if ((mEdgeSetFlag & MARGIN) == MARGIN) {
+	      mMarginLeft = output.getFloat(offset + 16);
+	      mMarginTop = output.getFloat(offset + 20);
+	      mMarginRight = output.getFloat(offset + 24);
+	      mMarginBottom = output.getFloat(offset + 28);
+	    }
+	    if ((mEdgeSetFlag & PADDING) == PADDING) {
+	      mPaddingLeft = output.getFloat(offset + 32);
+	      mPaddingTop = output.getFloat(offset + 36);
+	      mPaddingRight = output.getFloat(offset + 40);
+	      mPaddingBottom = output.getFloat(offset + 44);
+	    }
+	    if ((mEdgeSetFlag & BORDER) == BORDER) {
+	      mBorderLeft = output.getFloat(offset + 48);
+	      mBorderTop = output.getFloat(offset + 52);
+	      mBorderRight = output.getFloat(offset + 56);
+	      mBorderBottom = output.getFloat(offset + 60);
+	    }
+	    mHasNewLayout = true;
 	  }
 	
 	private native float nativeFlexNodeGetWidth(long nativeFlexNode );
@@ -22,6 +22,7 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "FlexNodeJni.h"
 #include "FlexNodeStyle.h"
@@ -30,12 +31,6 @@ static inline HPNodeRef _jlong2HPNodeRef(jlong addr) {
   return (reinterpret_cast<FlexNode*>(addr))->mHPNode;
 }
 
-#ifdef LAYOUT_TIME_ANALYZE
-static int layout_analyze_measureCount = 0;
-static double layout_analyze_measureTime = 0.0f;
-static int newLayoutCount = 0;
-#endif
-
 static jclass clazz;
 
 static jfieldID widthField;
@@ -61,6 +56,20 @@ static jfieldID borderBottomField;
 static jfieldID edgeSetFlagField;
 static jfieldID hasNewLayoutField;
 
+// layout result of a node with new layout, written to the output buffer of
+// nativeFlexNodeCalculateLayoutFlat. read by FlexNode.applyLayoutOutput in java,
+// keep them same. edges are in order left, top, right, bottom.
+typedef struct {
+  int32_t index;  // index of node in nativeNodes
+  float width;
+  float height;
+  float left;
+  float top;
+  float margin[4];
+  float padding[4];
+  float border[4];
+} FlexLayoutOutputRecord;
+
 class LayoutContext {
  public:
   LayoutContext(jlongArray nativeNodes, jobjectArray javaNodes) {
@@ -84,6 +93,16 @@ class LayoutContext {
     jnode_arr = javaNodes;
   }
 
+  size_t size() { return node_ptr_index_map.size(); }
+
+  // index of node in nativeNodes, -1 if not found.
+  int index(HPNodeRef node) {
+    auto idx = node_ptr_index_map.find(node);
+    return idx == node_ptr_index_map.end() ? -1 : static_cast<int>(idx->second);
+  }
+
+  jobjectArray javaNodes() { return jnode_arr; }
+
   base::android::ScopedJavaLocalRef<jobject> get(HPNodeRef node) {
     JNIEnv* env = GetJNIEnv();
     auto idx = node_ptr_index_map.find(node);
@@ -100,6 +119,15 @@ class LayoutContext {
   jobjectArray jnode_arr;
 };
 
+// measure result from java, width and height are packed in high and low 32 bits.
+static inline HPSize _unpackMeasureResult(jlong measureResult) {
+  static_assert(sizeof(measureResult) == 8,
+                "Expected measureResult to be 8 bytes, or two 32 bit ints");
+  int32_t wBits = 0xFFFFFFFF & (measureResult >> 32);
+  int32_t hBits = 0xFFFFFFFF & measureResult;
+  return HPSize{static_cast<float>(wBits), static_cast<float>(hBits)};
+}
+
 static HPSize HPJNIMeasureFunc(HPNodeRef node,
                                float width,
                                MeasureMode widthMode,
@@ -111,25 +139,11 @@ static HPSize HPJNIMeasureFunc(HPNodeRef node,
       (reinterpret_cast<LayoutContext*>(layoutContext))->get(node);
 
   if (!jnode.is_null()) {
-#ifdef LAYOUT_TIME_ANALYZE
-    clock_t start = clock();
-#endif
     const auto measureResult =
         Java_FlexNode_measureFunc(GetJNIEnv(), jnode.obj(), width, widthMode, height, heightMode);
-#ifdef LAYOUT_TIME_ANALYZE
-    clock_t end = clock();
-    layout_analyze_measureTime += (end - start);
-    layout_analyze_measureCount++;
-#endif
-    static_assert(sizeof(measureResult) == 8,
-                  "Expected measureResult to be 8 bytes, or two 32 bit ints");
-
-    int32_t wBits = 0xFFFFFFFF & (measureResult >> 32);
-    int32_t hBits = 0xFFFFFFFF & measureResult;
     // __android_log_print(ANDROID_LOG_INFO,  "TextNode2", "in FlexNode widthMode %d width %f,
-    // heightMode %d height %f, result :width %d, height %d",widthMode,width,heightMode, height,
-    // wBits, hBits);
-    return HPSize{static_cast<float>(wBits), static_cast<float>(hBits)};
+    // heightMode %d height %f",widthMode,width,heightMode, height);
+    return _unpackMeasureResult(measureResult);
   } else {
     return HPSize{
         widthMode == 0 ? 0 : width,
@@ -138,21 +152,75 @@ static HPSize HPJNIMeasureFunc(HPNodeRef node,
   }
 }
 
+// all requests are measured by one call of FlexNode.measureFuncBatch in java.
+// nodes without java node are answered like HPJNIMeasureFunc. if java throws,
+// requests are left unfilled and measured by HPJNIMeasureFunc in layout.
+static void HPJNIBatchMeasureFunc(HPMeasureRequest* requests, uint32_t count, void* layoutContext) {
+  ASSERT(layoutContext != nullptr);
+  LayoutContext* context = reinterpret_cast<LayoutContext*>(layoutContext);
+  std::vector<jint> indices;
+  std::vector<jfloat> constraints;
+  std::vector<uint32_t> measured;
+  indices.reserve(count);
+  constraints.reserve(count * 4);
+  measured.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    HPMeasureRequest& request = requests[i];
+    int index = context->index(request.node);
+    if (index < 0) {
+      request.result = HPSize{
+          request.widthMeasureMode == 0 ? 0 : request.width,
+          request.heightMeasureMode == 0 ? 0 : request.height,
+      };
+      continue;
+    }
+    indices.push_back(index);
+    constraints.push_back(request.width);
+    constraints.push_back(static_cast<jfloat>(request.widthMeasureMode));
+    constraints.push_back(request.height);
+    constraints.push_back(static_cast<jfloat>(request.heightMeasureMode));
+    measured.push_back(i);
+  }
+  if (indices.empty()) {
+    return;
+  }
+
+  JNIEnv* env = GetJNIEnv();
+  jsize size = static_cast<jsize>(indices.size());
+  jintArray jindices = env->NewIntArray(size);
+  jfloatArray jconstraints = jindices != nullptr ? env->NewFloatArray(size * 4) : nullptr;
+  jlongArray jresults = jconstraints != nullptr ? env->NewLongArray(size) : nullptr;
+  if (jresults == nullptr) {
+    // out of memory, exception is pending.
+    env->ExceptionClear();
+  } else {
+    env->SetIntArrayRegion(jindices, 0, size, indices.data());
+    env->SetFloatArrayRegion(jconstraints, 0, size * 4, constraints.data());
+    if (Java_FlexNode_measureFuncBatch(env, context->javaNodes(), jindices, jconstraints,
+                                       jresults)) {
+      std::vector<jlong> results(size);
+      env->GetLongArrayRegion(jresults, 0, size, results.data());
+      for (jsize i = 0; i < size; i++) {
+        requests[measured[i]].result = _unpackMeasureResult(results[i]);
+      }
+    }
+  }
+  if (jresults != nullptr) {
+    env->DeleteLocalRef(jresults);
+  }
+  if (jconstraints != nullptr) {
+    env->DeleteLocalRef(jconstraints);
+  }
+  if (jindices != nullptr) {
+    env->DeleteLocalRef(jindices);
+  }
+}
+
 static jlong FlexNodeNew(JNIEnv* env, const base::android::JavaParamRef<jobject>& jcaller) {
   FlexNode* flex_node = new FlexNode(env, jcaller);
   return reinterpret_cast<intptr_t>(flex_node);
 }
 
-#ifdef LAYOUT_TIME_ANALYZE
-static int FlexNodeCount(HPNodeRef node) {
-  int allCount = node->childCount();
-  for (unsigned int i = 0; i < node->childCount(); i++) {
-    allCount += FlexNodeCount(node->getChild(i));
-  }
-  return allCount;
-}
-#endif
-
 static void TransferLayoutOutputsRecursive(HPNodeRef node, void* layoutContext) {
   ASSERT(layoutContext != nullptr);
   base::android::ScopedJavaLocalRef<jobject> jnode =
@@ -165,28 +233,9 @@ static void TransferLayoutOutputsRecursive(HPNodeRef node, void* layoutContext)
   jobject java_node = jnode.obj();
 
   if (!HPNodeHasNewLayout(node)) {
-#ifdef LAYOUT_TIME_ANALYZE
-    //    if (weakRef && ( localRef = GetJNIEnv()->NewLocalRef( weakRef) ) !=NULL ) {
-    //      JNIEnv* env = GetJNIEnv();
-    static jclass clazz = env->FindClass(kFlexNodeClassPath);
-    static jfieldID widthField = env->GetFieldID(clazz, "mWidth", "F");
-    float javaWidth = env->GetFloatField(java_node, widthField);
-    // static jfieldID hasNewLayoutField = env->GetFieldID( clazz, "mHasNewLayout",  "Z");
-    // hasNewLayout = env->GetBooleanField(weakRef ,hasNewLayoutField );
-    if (!isDefined(javaWidth)) {
-      __android_log_print(ANDROID_LOG_ERROR, "HippyLayoutTime",
-                          "cache width NAN  node's fetchCount %d nodetype %d", node->fetchCount,
-                          node->style.nodeType);
-    }
-//      GetJNIEnv()->DeleteLocalRef( localRef );
-//    }
-#endif
     return;
   }
 
-#ifdef LAYOUT_TIME_ANALYZE
-  newLayoutCount++;
-#endif
   const int MARGIN = 1;
   const int PADDING = 2;
   const int BORDER = 4;
@@ -233,20 +282,152 @@ static void TransferLayoutOutputsRecursive(HPNodeRef node, void* layoutContext)
 
   env->SetBooleanField(java_node, hasNewLayoutField, true);
   HPNodesetHasNewLayout(node, false);
-#ifdef LAYOUT_TIME_ANALYZE
-  node->fetchCount++;
-#endif
   for (unsigned int i = 0; i < node->childCount(); i++) {
     TransferLayoutOutputsRecursive(node->getChild(i), layoutContext);
   }
 }
 
+// write records of nodes with new layout to records, one JNI call per layout
+// instead of about 18 per node.
+static void TransferLayoutOutputsFlat(HPNodeRef node,
+                                      LayoutContext* layoutContext,
+                                      FlexLayoutOutputRecord* records,
+                                      jint* count) {
+  if (!HPNodeHasNewLayout(node)) {
+    return;
+  }
+  int index = layoutContext->index(node);
+  if (index < 0) {
+    return;
+  }
+
+  FlexLayoutOutputRecord& record = records[(*count)++];
+  record.index = index;
+  record.width = HPNodeLayoutGetWidth(node);
+  record.height = HPNodeLayoutGetHeight(node);
+  record.left = HPNodeLayoutGetLeft(node);
+  record.top = HPNodeLayoutGetTop(node);
+  const CSSDirection edges[4] = {CSSLeft, CSSTop, CSSRight, CSSBottom};
+  for (int i = 0; i < 4; i++) {
+    record.margin[i] = HPNodeLayoutGetMargin(node, edges[i]);
+    record.padding[i] = HPNodeLayoutGetPadding(node, edges[i]);
+    record.border[i] = HPNodeLayoutGetBorder(node, edges[i]);
+  }
+
+  HPNodesetHasNewLayout(node, false);
+  for (unsigned int i = 0; i < node->childCount(); i++) {
+    TransferLayoutOutputsFlat(node->getChild(i), layoutContext, records, count);
+  }
+}
+
+// stats are written to java array jstats in order of fields of HPLayoutStats,
+// see FlexNode.LAYOUT_STATS_* in java.
+static const jsize kLayoutStatsSize = 17 + LayoutPhaseCount + 1;
+
+static void WriteLayoutStats(const HPLayoutStats& stats,
+                             const base::android::JavaParamRef<jdoubleArray>& jstats) {
+  JNIEnv* env = GetJNIEnv();
+  if (env->GetArrayLength(jstats.obj()) < kLayoutStatsSize) {
+    return;
+  }
+  jdouble values[kLayoutStatsSize] = {
+      static_cast<jdouble>(stats.visitCount),
+      static_cast<jdouble>(stats.layoutCount),
+      static_cast<jdouble>(stats.measureWidthCount),
+      static_cast<jdouble>(stats.measureHeightCount),
+      static_cast<jdouble>(stats.newLayoutCount),
+      static_cast<jdouble>(stats.measureFuncCount),
+      static_cast<jdouble>(stats.layoutCacheHitCount),
+      static_cast<jdouble>(stats.layoutCacheMissCount),
+      static_cast<jdouble>(stats.measureCacheHitCount),
+      static_cast<jdouble>(stats.measureCacheMissCount),
+      static_cast<jdouble>(stats.measureCacheEvictCount),
+      static_cast<jdouble>(stats.fixedDimHitCount),
+      static_cast<jdouble>(stats.sharedMeasureHitCount),
+      static_cast<jdouble>(stats.batchMeasureCount),
+      static_cast<jdouble>(stats.batchMeasureHitCount),
+      static_cast<jdouble>(stats.windowedOutCount),
+      static_cast<jdouble>(stats.appendLayoutCount),
+  };
+  for (int i = 0; i < LayoutPhaseCount; i++) {
+    values[17 + i] = stats.phaseTime[i];
+  }
+  values[kLayoutStatsSize - 1] = stats.totalTime;
+  env->SetDoubleArrayRegion(jstats.obj(), 0, kLayoutStatsSize, values);
+}
+
+static void CalculateLayout(HPNodeRef node,
+                            jfloat width,
+                            jfloat height,
+                            jint direction,
+                            jboolean batchMeasure,
+                            const base::android::JavaParamRef<jdoubleArray>& jstats,
+                            LayoutContext* layoutContext) {
+  if (direction < 0 || direction > 2) {
+    direction = 1;  // HPDirection::LTR
+  }
+
+  // statistics are recorded only for layouts java asks them for.
+  HPLayoutStats stats;
+  HPLayoutStats* statsRef = jstats.is_null() ? nullptr : &stats;
+  if (batchMeasure) {
+    // predictable text measures cross JNI once, before layout.
+    HPNodeDoBatchMeasuredLayout(node, width, height, HPJNIBatchMeasureFunc,
+                                (HPDirection)direction, reinterpret_cast<void*>(layoutContext),
+                                statsRef);
+  } else {
+    HPNodeDoLayout(node, width, height, (HPDirection)direction,
+                   reinterpret_cast<void*>(layoutContext), statsRef);
+  }
+  if (statsRef != nullptr) {
+    WriteLayoutStats(stats, jstats);
+  }
+}
+
 FlexNode::FlexNode(JNIEnv* env, const base::android::JavaParamRef<jobject>& jcaller) {
   mHPNode = HPNodeNew();
   //  jobject jnode = env->NewWeakGlobalRef(jcaller.obj());
   //  mHPNode->setContext(jnode);
 }
 
+FlexNode::FlexNode(HPNodeRef node) : mHPNode(node) {}
+
+// nodes referenced by mutations are FlexNode pointers in nativeNodes, 0 for
+// nodes to create, which are replaced by pointers of new FlexNodes.
+static jint FlexNodeApplyMutations(JNIEnv* env,
+                                   const base::android::JavaParamRef<jclass>& jcaller,
+                                   const base::android::JavaParamRef<jlongArray>& nativeNodes,
+                                   const base::android::JavaParamRef<jobject>& mutations,
+                                   jint count) {
+  FLEX_NODE_LOG("FlexNode::ApplyMutations:%d", count);
+  if (nativeNodes.is_null() || mutations.is_null() || count <= 0) {
+    return 0;
+  }
+  void* address = env->GetDirectBufferAddress(mutations.obj());
+  jlong capacity = env->GetDirectBufferCapacity(mutations.obj());
+  // count * sizeof(HPMutation) overflows 32 bit size_t.
+  if (address == nullptr ||
+      capacity < static_cast<jlong>(count) * static_cast<jlong>(sizeof(HPMutation))) {
+    return 0;
+  }
+
+  jsize size = env->GetArrayLength(nativeNodes.obj());
+  jlong* flexNodes = env->GetLongArrayElements(nativeNodes.obj(), nullptr);
+  std::vector<HPNodeRef> nodes(size);
+  for (jsize i = 0; i < size; i++) {
+    nodes[i] = flexNodes[i] == 0 ? nullptr : _jlong2HPNodeRef(flexNodes[i]);
+  }
+  jint applied = HPNodeApplyMutations(nodes.data(), size,
+                                      reinterpret_cast<const HPMutation*>(address), count);
+  for (jsize i = 0; i < size; i++) {
+    if (flexNodes[i] == 0 && nodes[i] != nullptr) {
+      flexNodes[i] = reinterpret_cast<intptr_t>(new FlexNode(nodes[i]));
+    }
+  }
+  env->ReleaseLongArrayElements(nativeNodes.obj(), flexNodes, 0);
+  return applied;
+}
+
 FlexNode::~FlexNode() {
   //  jobject weakRef = (jobject) mHPNode->getContext();
   HPNodeFree(mHPNode);
@@ -277,54 +458,54 @@ void FlexNode::FlexNodeCalculateLayout(JNIEnv* env,
                                        jfloat height,
                                        const base::android::JavaParamRef<jlongArray>& nativeNodes,
                                        const base::android::JavaParamRef<jobjectArray>& javaNodes,
-                                       jint direction) {
+                                       jint direction,
+                                       jboolean batchMeasure,
+                                       const base::android::JavaParamRef<jdoubleArray>& stats) {
   FLEX_NODE_LOG("FlexNode::CalculateLayout:%.2f,%.2f", width, height);
 
   ASSERT(!nativeNodes.is_null());
   ASSERT(!javaNodes.is_null());
   LayoutContext layoutContext(nativeNodes, javaNodes);
 
-  // __android_log_print(ANDROID_LOG_INFO,  "HippyLayout", "start
-  // HPNodeDoLayout===========================================");
-#ifdef LAYOUT_TIME_ANALYZE
-  // clock_t start =  clock();
-  newLayoutCount = 0;
-  struct timeval start, end;
-  gettimeofday(&start, NULL);
-  layout_analyze_measureCount = 0;
-  layout_analyze_measureTime = 0.0f;
-#endif
-  if (direction < 0 || direction > 2) {
-    direction = 1;  // HPDirection::LTR
-  }
-
-  HPNodeDoLayout(mHPNode, width, height, (HPDirection)direction,
-                 reinterpret_cast<void*>(&layoutContext));
-
-#ifdef LAYOUT_TIME_ANALYZE
-  // clock_t end = clock();
-  gettimeofday(&end, NULL);
-  __android_log_print(ANDROID_LOG_INFO, "HippyLayoutTime",
-                      "HPNodeDoLayout %ld ms MeasureCount %d MeasureTime %lf ms",
-                      // (end - start)/(double) CLOCKS_PER_SEC * 1000,
-                      (1000 * (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000),
-                      layout_analyze_measureCount,
-                      layout_analyze_measureTime / static_cast<double>(CLOCKS_PER_SEC) * 1000);
-#endif
+  CalculateLayout(mHPNode, width, height, direction, batchMeasure, stats, &layoutContext);
   TransferLayoutOutputsRecursive(mHPNode, reinterpret_cast<void*>(&layoutContext));
-#ifdef LAYOUT_TIME_ANALYZE
-  gettimeofday(&start, NULL);
-  __android_log_print(ANDROID_LOG_INFO, "HippyLayoutTime", "TransferLayoutOutputsRecursive %ld ms ",
-                      (1000 * (start.tv_sec - end.tv_sec) + (start.tv_usec - end.tv_usec) / 1000));
-  __android_log_print(ANDROID_LOG_INFO, "HippyLayoutTime",
-                      "FlexNodeCount %d TransferLayoutOutputsRecursive newLayoutCount %d",
-                      FlexNodeCount(mHPNode), newLayoutCount);
-#endif
   // HPNodePrint(mHPNode);
   // __android_log_print(ANDROID_LOG_INFO,  "HippyLayout", "end
   // HPNodeDoLayout===========================================");
 }
 
+jint FlexNode::FlexNodeCalculateLayoutFlat(
+    JNIEnv* env,
+    const base::android::JavaParamRef<jobject>& obj,
+    jfloat width,
+    jfloat height,
+    const base::android::JavaParamRef<jlongArray>& nativeNodes,
+    const base::android::JavaParamRef<jobjectArray>& javaNodes,
+    const base::android::JavaParamRef<jobject>& output,
+    jint direction,
+    jboolean batchMeasure,
+    const base::android::JavaParamRef<jdoubleArray>& stats) {
+  FLEX_NODE_LOG("FlexNode::CalculateLayoutFlat:%.2f,%.2f", width, height);
+
+  ASSERT(!nativeNodes.is_null());
+  ASSERT(!javaNodes.is_null());
+  LayoutContext layoutContext(nativeNodes, javaNodes);
+  CalculateLayout(mHPNode, width, height, direction, batchMeasure, stats, &layoutContext);
+
+  void* address = output.is_null() ? nullptr : env->GetDirectBufferAddress(output.obj());
+  jlong capacity = output.is_null() ? 0 : env->GetDirectBufferCapacity(output.obj());
+  if (address == nullptr ||
+      capacity < static_cast<jlong>(layoutContext.size() * sizeof(FlexLayoutOutputRecord))) {
+    // not a direct buffer or too small, set fields of java nodes instead.
+    TransferLayoutOutputsRecursive(mHPNode, reinterpret_cast<void*>(&layoutContext));
+    return 0;
+  }
+  jint count = 0;
+  TransferLayoutOutputsFlat(mHPNode, &layoutContext,
+                            reinterpret_cast<FlexLayoutOutputRecord*>(address), &count);
+  return count;
+}
+
 void FlexNode::FlexNodeNodeMarkDirty(JNIEnv* env, const base::android::JavaParamRef<jobject>& obj) {
   FLEX_NODE_LOG("FlexNode::MarkDirty");
   HPNodeMarkDirty(mHPNode);
@@ -30,6 +30,8 @@ class FlexNode {
  public:
   HPNodeRef mHPNode;
   FlexNode(JNIEnv* env, const base::android::JavaParamRef<jobject>& jcaller);
+  // wraps a node created by HPNodeApplyMutations.
+  explicit FlexNode(HPNodeRef node);
   void FlexNodeReset(JNIEnv* env, const base::android::JavaParamRef<jobject>& jcaller);
 
   // Methods called from Java via JNI -----------------------------------------
@@ -49,7 +51,23 @@ class FlexNode {
                                jfloat height,
                                const base::android::JavaParamRef<jlongArray>& nativeNodes,
                                const base::android::JavaParamRef<jobjectArray>& javaNodes,
-                               jint direction);
+                               jint direction,
+                               jboolean batchMeasure,
+                               const base::android::JavaParamRef<jdoubleArray>& stats);
+  // layout, then write results of nodes with new layout to direct buffer output,
+  // returns count of records written. text is measured by one call of
+  // FlexNode.measureFuncBatch if batchMeasure, else node by node. statistics
+  // of the layout are written to stats if it's not null.
+  jint FlexNodeCalculateLayoutFlat(JNIEnv* env,
+                                   const base::android::JavaParamRef<jobject>& obj,
+                                   jfloat width,
+                                   jfloat height,
+                                   const base::android::JavaParamRef<jlongArray>& nativeNodes,
+                                   const base::android::JavaParamRef<jobjectArray>& javaNodes,
+                                   const base::android::JavaParamRef<jobject>& output,
+                                   jint direction,
+                                   jboolean batchMeasure,
+                                   const base::android::JavaParamRef<jdoubleArray>& stats);
 
   void FlexNodeNodeMarkDirty(JNIEnv* env, const base::android::JavaParamRef<jobject>& obj);
   bool FlexNodeNodeIsDirty(JNIEnv* env, const base::android::JavaParamRef<jobject>& obj);
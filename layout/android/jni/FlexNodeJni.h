@@ -26,6 +26,23 @@ Java_com_tencent_smtt_flexbox_FlexNode_nativeFlexNodeNew(JNIEnv* env, jobject jc
   return FlexNodeNew(env, base::android::JavaParamRef<jobject>(env, jcaller));
 }
 
+static jint FlexNodeApplyMutations(JNIEnv* env,
+                                   const base::android::JavaParamRef<jclass>& jcaller,
+                                   const base::android::JavaParamRef<jlongArray>& nativeNodes,
+                                   const base::android::JavaParamRef<jobject>& mutations,
+                                   jint count);
+
+JNI_GENERATOR_EXPORT jint
+Java_com_tencent_smtt_flexbox_FlexNode_nativeFlexNodeApplyMutations(JNIEnv* env,
+                                                                    jclass jcaller,
+                                                                    jlongArray nativeNodes,
+                                                                    jobject mutations,
+                                                                    jint count) {
+  return FlexNodeApplyMutations(env, base::android::JavaParamRef<jclass>(env, jcaller),
+                                base::android::JavaParamRef<jlongArray>(env, nativeNodes),
+                                base::android::JavaParamRef<jobject>(env, mutations), count);
+}
+
 JNI_GENERATOR_EXPORT void Java_com_tencent_smtt_flexbox_FlexNode_nativeFlexNodeFree(
     JNIEnv* env,
     jobject jcaller,
@@ -66,13 +83,38 @@ JNI_GENERATOR_EXPORT void Java_com_tencent_smtt_flexbox_FlexNode_nativeFlexNodeC
     jfloat height,
     jlongArray nativeNodes,
     jobjectArray javaNodes,
-    jint direction) {
+    jint direction,
+    jboolean batchMeasure,
+    jdoubleArray stats) {
   FlexNode* native = reinterpret_cast<FlexNode*>(nativeFlexNode);
   CHECK_NATIVE_PTR(env, jcaller, native, "FlexNodeCalculateLayout");
   return native->FlexNodeCalculateLayout(
       env, base::android::JavaParamRef<jobject>(env, jcaller), width, height,
       base::android::JavaParamRef<jlongArray>(env, nativeNodes),
-      base::android::JavaParamRef<jobjectArray>(env, javaNodes), direction);
+      base::android::JavaParamRef<jobjectArray>(env, javaNodes), direction, batchMeasure,
+      base::android::JavaParamRef<jdoubleArray>(env, stats));
+}
+
+JNI_GENERATOR_EXPORT jint Java_com_tencent_smtt_flexbox_FlexNode_nativeFlexNodeCalculateLayoutFlat(
+    JNIEnv* env,
+    jobject jcaller,
+    jlong nativeFlexNode,
+    jfloat width,
+    jfloat height,
+    jlongArray nativeNodes,
+    jobjectArray javaNodes,
+    jobject output,
+    jint direction,
+    jboolean batchMeasure,
+    jdoubleArray stats) {
+  FlexNode* native = reinterpret_cast<FlexNode*>(nativeFlexNode);
+  CHECK_NATIVE_PTR(env, jcaller, native, "FlexNodeCalculateLayoutFlat", 0);
+  return native->FlexNodeCalculateLayoutFlat(
+      env, base::android::JavaParamRef<jobject>(env, jcaller), width, height,
+      base::android::JavaParamRef<jlongArray>(env, nativeNodes),
+      base::android::JavaParamRef<jobjectArray>(env, javaNodes),
+      base::android::JavaParamRef<jobject>(env, output), direction, batchMeasure,
+      base::android::JavaParamRef<jdoubleArray>(env, stats));
 }
 
 JNI_GENERATOR_EXPORT jfloat
@@ -506,26 +548,35 @@ JNI_GENERATOR_EXPORT void Java_com_tencent_smtt_flexbox_FlexNode_nativeFlexNoder
   return native->FlexNodeReset(env, base::android::JavaParamRef<jobject>(env, jcaller));
 }
 
+// java class and callback method ids, looked up once by RegisterNativesImpl.
+static jclass g_FlexNode_clazz = nullptr;
+static jmethodID g_FlexNode_measureFunc = nullptr;
+static jmethodID g_FlexNode_measureFuncBatch = nullptr;
+
 static jlong Java_FlexNode_measureFunc(JNIEnv* env,
                                        jobject obj,
                                        jfloat width,
                                        jint widthMode,
                                        jfloat height,
                                        jint heightMode) {
-  jclass clazz = env->FindClass(kFlexNodeClassPath);
-  jmethodID method_id = env->GetMethodID(clazz, "measureFunc",
-                                         "("
-                                         "F"
-                                         "I"
-                                         "F"
-                                         "I"
-                                         ")"
-                                         "J");
-  jlong ret = env->CallLongMethod(obj, method_id, width, widthMode, height, heightMode);
-
-  env->DeleteLocalRef(clazz);
-  // env->DeleteLocalRef( method_id );
-  return ret;
+  return env->CallLongMethod(obj, g_FlexNode_measureFunc, width, widthMode, height, heightMode);
+}
+
+// false if measureFuncBatch threw, the exception is cleared then and results
+// must not be read.
+static bool Java_FlexNode_measureFuncBatch(JNIEnv* env,
+                                           jobjectArray nodes,
+                                           jintArray indices,
+                                           jfloatArray constraints,
+                                           jlongArray results) {
+  env->CallStaticVoidMethod(g_FlexNode_clazz, g_FlexNode_measureFuncBatch, nodes, indices,
+                            constraints, results);
+  if (env->ExceptionCheck()) {
+    env->ExceptionDescribe();
+    env->ExceptionClear();
+    return false;
+  }
+  return true;
 }
 
 // Step 3: RegisterNatives.
@@ -542,6 +593,14 @@ static const JNINativeMethod kMethodsFlexNode[] = {
      ")"
      "V",
      reinterpret_cast<void*>(Java_com_tencent_smtt_flexbox_FlexNode_nativeFlexNodeFree)},
+    {"nativeFlexNodeApplyMutations",
+     "("
+     "[J"
+     "Ljava/nio/ByteBuffer;"
+     "I"
+     ")"
+     "I",
+     reinterpret_cast<void*>(Java_com_tencent_smtt_flexbox_FlexNode_nativeFlexNodeApplyMutations)},
     {"nativeFlexNodeInsertChild",
      "("
      "J"
@@ -565,9 +624,26 @@ static const JNINativeMethod kMethodsFlexNode[] = {
      "[J"
      "[Lcom/tencent/smtt/flexbox/FlexNode;"
      "I"
+     "Z"
+     "[D"
      ")"
      "V",
      reinterpret_cast<void*>(Java_com_tencent_smtt_flexbox_FlexNode_nativeFlexNodeCalculateLayout)},
+    {"nativeFlexNodeCalculateLayoutFlat",
+     "("
+     "J"
+     "F"
+     "F"
+     "[J"
+     "[Lcom/tencent/smtt/flexbox/FlexNode;"
+     "Ljava/nio/ByteBuffer;"
+     "I"
+     "Z"
+     "[D"
+     ")"
+     "I",
+     reinterpret_cast<void*>(
+         Java_com_tencent_smtt_flexbox_FlexNode_nativeFlexNodeCalculateLayoutFlat)},
     {"nativeFlexNodeGetWidth",
      "("
      "J"
@@ -865,6 +941,24 @@ static bool RegisterNativesImpl(JNIEnv* env) {
   if (env->RegisterNatives(clazz, kMethodsFlexNode, kMethodsFlexNodeSize) < 0) {
     return false;
   }
+  g_FlexNode_clazz = static_cast<jclass>(env->NewGlobalRef(clazz));
+  g_FlexNode_measureFunc = env->GetMethodID(clazz, "measureFunc",
+                                            "("
+                                            "F"
+                                            "I"
+                                            "F"
+                                            "I"
+                                            ")"
+                                            "J");
+  g_FlexNode_measureFuncBatch =
+      env->GetStaticMethodID(clazz, "measureFuncBatch",
+                             "("
+                             "[Lcom/tencent/smtt/flexbox/FlexNode;"
+                             "[I"
+                             "[F"
+                             "[J"
+                             ")"
+                             "V");
   env->DeleteLocalRef(clazz);
-  return true;
+  return g_FlexNode_measureFunc != nullptr && g_FlexNode_measureFuncBatch != nullptr;
 }
@@ -0,0 +1,481 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* layout benchmark suite shared by hippy and yoga benchmark targets, so that
+ * both engines run the same scenarios on the same trees.
+ *
+ * an engine is a class with static functions listed in BenchmarkEngine below,
+ * each scenario is timed in four phases:
+ *   construction  - build the tree
+ *   first layout  - layout of the new tree
+ *   cached        - layout again without any change
+ *   incremental   - change one node, then layout again
+ * tree freeing is not timed.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define BENCHMARK_DEFAULT_WARMUP 5
+#define BENCHMARK_DEFAULT_ITERATIONS 50
+
+#if 0
+// interface of an engine, for reference only.
+class BenchmarkEngine {
+ public:
+  typedef NodeRef Node;
+  static const char* name();
+  static Node newNode();
+  static void freeRecursive(Node node);
+  static void insertChild(Node node, Node child, uint32_t index);
+  static void setWidth(Node node, float width);
+  static void setHeight(Node node, float height);
+  static void setFlexGrow(Node node, float flexGrow);
+  static void setFlexShrink(Node node, float flexShrink);
+  static void setFlexDirectionRow(Node node);
+  static void setFlexWrap(Node node);
+  static void setMargin(Node node, float margin);
+  static void setPadding(Node node, float padding);
+  // text leaf of length characters, see BenchmarkMeasureText. a node which
+  // is already a text leaf is marked dirty.
+  static void setText(Node node, uint32_t length);
+  static void layout(Node node, float width, float height);
+};
+#endif
+
+static const float kBenchmarkCharWidth = 7.0f;
+static const float kBenchmarkLineHeight = 17.0f;
+
+// size of a text of length characters, wrapped at width if it's not undefined.
+static inline void BenchmarkMeasureText(uint32_t length,
+                                        float width,
+                                        bool widthUndefined,
+                                        bool widthExactly,
+                                        float* measuredWidth,
+                                        float* measuredHeight) {
+  float textWidth = length * kBenchmarkCharWidth;
+  if (widthExactly) {
+    *measuredWidth = width;
+  } else if (widthUndefined || textWidth <= width) {
+    *measuredWidth = textWidth;
+  } else {
+    *measuredWidth = width;
+  }
+  float lines = 1;
+  if (!widthUndefined && width > 0 && textWidth > width) {
+    lines = ceilf(textWidth / width);
+  }
+  *measuredHeight = lines * kBenchmarkLineHeight;
+}
+
+// wall clock time, clock() sums cpu time of all threads in parallel layout.
+static inline double BenchmarkNowInMs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+// deterministic pseudo random numbers, so trees are same in every engine.
+class BenchmarkRandom {
+ public:
+  explicit BenchmarkRandom(uint32_t seed) : state(seed) {}
+  uint32_t next(uint32_t min, uint32_t max) {
+    state = state * 1664525u + 1013904223u;
+    return min + (state >> 8) % (max - min + 1);
+  }
+
+ private:
+  uint32_t state;
+};
+
+typedef struct {
+  uint32_t warmup;
+  uint32_t iterations;
+  // run scenarios whose name contains filter only, nullptr for all.
+  const char* filter;
+  // write results as json to this file, "-" for stdout.
+  const char* jsonPath;
+} BenchmarkOptions;
+
+// parse --warmup N --iterations N --filter NAME --json FILE, false if invalid.
+static inline bool BenchmarkParseOptions(int argc, char const* argv[], BenchmarkOptions* options) {
+  options->warmup = BENCHMARK_DEFAULT_WARMUP;
+  options->iterations = BENCHMARK_DEFAULT_ITERATIONS;
+  options->filter = nullptr;
+  options->jsonPath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) {
+      return false;
+    }
+    if (strcmp(argv[i], "--warmup") == 0) {
+      options->warmup = static_cast<uint32_t>(atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--iterations") == 0) {
+      options->iterations = static_cast<uint32_t>(atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--filter") == 0) {
+      options->filter = argv[++i];
+    } else if (strcmp(argv[i], "--json") == 0) {
+      options->jsonPath = argv[++i];
+    } else {
+      return false;
+    }
+  }
+  return options->iterations > 0;
+}
+
+typedef struct {
+  std::string scenario;
+  std::string phase;
+  uint32_t nodeCount;
+  uint32_t iterations;
+  double mean;
+  double stddev;
+  double min;
+  double p50;
+  double p90;
+  double p99;
+  double max;
+} BenchmarkResult;
+
+class BenchmarkReport {
+ public:
+  BenchmarkReport(const char* engine, const BenchmarkOptions& options)
+      : engine(engine), options(options) {}
+
+  const BenchmarkOptions& getOptions() { return options; }
+
+  bool shouldRun(const char* scenario) {
+    return options.filter == nullptr || strstr(scenario, options.filter) != nullptr;
+  }
+
+  // times of each iteration in milliseconds, warmup excluded.
+  void add(const char* scenario,
+           const char* phase,
+           uint32_t nodeCount,
+           std::vector<double>& timesInMs) {
+    BenchmarkResult result;
+    result.scenario = scenario;
+    result.phase = phase;
+    result.nodeCount = nodeCount;
+    result.iterations = static_cast<uint32_t>(timesInMs.size());
+    std::sort(timesInMs.begin(), timesInMs.end());
+    double sum = 0;
+    for (size_t i = 0; i < timesInMs.size(); i++) {
+      sum += timesInMs[i];
+    }
+    result.mean = sum / timesInMs.size();
+    double variance = 0;
+    for (size_t i = 0; i < timesInMs.size(); i++) {
+      variance += pow(timesInMs[i] - result.mean, 2);
+    }
+    result.stddev = sqrt(variance / timesInMs.size());
+    result.min = timesInMs.front();
+    result.p50 = percentile(timesInMs, 50);
+    result.p90 = percentile(timesInMs, 90);
+    result.p99 = percentile(timesInMs, 99);
+    result.max = timesInMs.back();
+    results.push_back(result);
+
+    // keep stdout clean for json.
+    FILE* out = options.jsonPath && strcmp(options.jsonPath, "-") == 0 ? stderr : stdout;
+    fprintf(out, "%-24s %-13s nodes: %6u  p50: %9.4lf ms  p90: %9.4lf ms  p99: %9.4lf ms  "
+            "mean: %9.4lf ms  stddev: %9.4lf ms\n",
+            scenario, phase, nodeCount, result.p50, result.p90, result.p99, result.mean,
+            result.stddev);
+    fflush(out);
+  }
+
+  // time body, called warmup + iterations times.
+  void run(const char* scenario,
+           const char* phase,
+           uint32_t nodeCount,
+           const std::function<void()>& body) {
+    std::vector<double> timesInMs;
+    for (uint32_t i = 0; i < options.warmup + options.iterations; i++) {
+      double start = BenchmarkNowInMs();
+      body();
+      if (i >= options.warmup) {
+        timesInMs.push_back(BenchmarkNowInMs() - start);
+      }
+    }
+    add(scenario, phase, nodeCount, timesInMs);
+  }
+
+  bool writeJson() {
+    if (options.jsonPath == nullptr) {
+      return true;
+    }
+    bool toStdout = strcmp(options.jsonPath, "-") == 0;
+    FILE* file = toStdout ? stdout : fopen(options.jsonPath, "w");
+    if (file == nullptr) {
+      fprintf(stderr, "can not open %s\n", options.jsonPath);
+      return false;
+    }
+    fprintf(file, "{\n  \"engine\": \"%s\",\n  \"warmup\": %u,\n  \"iterations\": %u,\n", engine,
+            options.warmup, options.iterations);
+    fprintf(file, "  \"results\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+      const BenchmarkResult& r = results[i];
+      fprintf(file,
+              "%s\n    {\"scenario\": \"%s\", \"phase\": \"%s\", \"nodes\": %u, "
+              "\"iterations\": %u, \"mean_ms\": %.6lf, \"stddev_ms\": %.6lf, "
+              "\"min_ms\": %.6lf, \"p50_ms\": %.6lf, \"p90_ms\": %.6lf, \"p99_ms\": %.6lf, "
+              "\"max_ms\": %.6lf}",
+              i == 0 ? "" : ",", r.scenario.c_str(), r.phase.c_str(), r.nodeCount, r.iterations,
+              r.mean, r.stddev, r.min, r.p50, r.p90, r.p99, r.max);
+    }
+    fprintf(file, "\n  ]\n}\n");
+    if (!toStdout) {
+      fclose(file);
+    }
+    return true;
+  }
+
+ private:
+  // nearest rank percentile of sorted times.
+  static double percentile(const std::vector<double>& sorted, uint32_t p) {
+    size_t rank = static_cast<size_t>(ceil(p / 100.0 * sorted.size()));
+    return sorted[rank == 0 ? 0 : rank - 1];
+  }
+
+  const char* engine;
+  BenchmarkOptions options;
+  std::vector<BenchmarkResult> results;
+};
+
+// a built tree, mutated node is changed before incremental layout.
+template <typename Node>
+struct BenchmarkTree {
+  Node root;
+  Node mutated;
+  // mutate text length of mutated if true, else its width.
+  bool mutateText;
+  uint32_t nodeCount;
+};
+
+template <typename Engine>
+class BenchmarkScenarios {
+ public:
+  typedef typename Engine::Node Node;
+  typedef BenchmarkTree<Node> Tree;
+  typedef void (*BuildFunc)(Tree& tree);
+
+  static void runAll(BenchmarkReport& report) {
+    run(report, "long list", buildLongList);
+    run(report, "text cards", buildTextCards);
+    run(report, "deep nesting", buildDeepNesting);
+    run(report, "wrap grid", buildWrapGrid);
+    run(report, "huge nested", buildHugeNested);
+  }
+
+  static void run(BenchmarkReport& report, const char* scenario, BuildFunc build) {
+    if (!report.shouldRun(scenario)) {
+      return;
+    }
+    const float viewportWidth = 375;
+    const float viewportHeight = 667;
+    const BenchmarkOptions& options = report.getOptions();
+    std::vector<double> times[4];
+    Tree tree;
+    uint32_t nodeCount = 0;
+    for (uint32_t i = 0; i < options.warmup + options.iterations; i++) {
+      double start = BenchmarkNowInMs();
+      build(tree);
+      double built = BenchmarkNowInMs();
+      Engine::layout(tree.root, viewportWidth, viewportHeight);
+      double first = BenchmarkNowInMs();
+      Engine::layout(tree.root, viewportWidth, viewportHeight);
+      double cached = BenchmarkNowInMs();
+      if (tree.mutateText) {
+        Engine::setText(tree.mutated, 37 + i % 11);
+      } else {
+        Engine::setWidth(tree.mutated, 23.5f + i % 7);
+      }
+      Engine::layout(tree.root, viewportWidth, viewportHeight);
+      double incremental = BenchmarkNowInMs();
+      nodeCount = tree.nodeCount;
+      Engine::freeRecursive(tree.root);
+
+      if (i >= options.warmup) {
+        times[0].push_back(built - start);
+        times[1].push_back(first - built);
+        times[2].push_back(cached - first);
+        times[3].push_back(incremental - cached);
+      }
+    }
+    report.add(scenario, "construction", nodeCount, times[0]);
+    report.add(scenario, "first layout", nodeCount, times[1]);
+    report.add(scenario, "cached", nodeCount, times[2]);
+    report.add(scenario, "incremental", nodeCount, times[3]);
+  }
+
+  static Node newChild(Tree& tree, Node parent, uint32_t index) {
+    Node node = Engine::newNode();
+    Engine::insertChild(parent, node, index);
+    tree.nodeCount++;
+    return node;
+  }
+
+  static Node newText(Tree& tree, Node parent, uint32_t index, uint32_t length) {
+    Node node = newChild(tree, parent, index);
+    Engine::setText(node, length);
+    Engine::setFlexShrink(node, 1);
+    return node;
+  }
+
+  static void beginTree(Tree& tree) {
+    tree.root = Engine::newNode();
+    tree.mutated = tree.root;
+    tree.mutateText = false;
+    tree.nodeCount = 1;
+  }
+
+  // feed of 500 rows: avatar, title and subtitle texts, badge.
+  static void buildLongList(Tree& tree) {
+    BenchmarkRandom random(1);
+    beginTree(tree);
+    const uint32_t rowCount = 500;
+    for (uint32_t i = 0; i < rowCount; i++) {
+      Node row = newChild(tree, tree.root, i);
+      Engine::setFlexDirectionRow(row);
+      Engine::setPadding(row, 8);
+      Node avatar = newChild(tree, row, 0);
+      Engine::setWidth(avatar, 40);
+      Engine::setHeight(avatar, 40);
+      Engine::setMargin(avatar, 4);
+      Node content = newChild(tree, row, 1);
+      Engine::setFlexGrow(content, 1);
+      Engine::setFlexShrink(content, 1);
+      newText(tree, content, 0, random.next(8, 30));
+      Node subtitle = newText(tree, content, 1, random.next(20, 90));
+      Node badge = newChild(tree, row, 2);
+      Engine::setWidth(badge, 24);
+      Engine::setHeight(badge, 16);
+      if (i == rowCount / 2) {
+        tree.mutated = subtitle;
+        tree.mutateText = true;
+      }
+    }
+  }
+
+  // 60 cards: header with icon and title, long body text, image, footer buttons.
+  static void buildTextCards(Tree& tree) {
+    BenchmarkRandom random(2);
+    beginTree(tree);
+    const uint32_t cardCount = 60;
+    for (uint32_t i = 0; i < cardCount; i++) {
+      Node card = newChild(tree, tree.root, i);
+      Engine::setMargin(card, 8);
+      Engine::setPadding(card, 12);
+      Node header = newChild(tree, card, 0);
+      Engine::setFlexDirectionRow(header);
+      Node icon = newChild(tree, header, 0);
+      Engine::setWidth(icon, 32);
+      Engine::setHeight(icon, 32);
+      newText(tree, header, 1, random.next(10, 60));
+      Node body = newText(tree, card, 1, random.next(100, 400));
+      Node image = newChild(tree, card, 2);
+      Engine::setHeight(image, 150);
+      Node footer = newChild(tree, card, 3);
+      Engine::setFlexDirectionRow(footer);
+      for (uint32_t j = 0; j < 3; j++) {
+        Node button = newChild(tree, footer, j);
+        Engine::setFlexGrow(button, 1);
+        Engine::setPadding(button, 6);
+        newText(tree, button, 0, random.next(2, 8));
+      }
+      if (i == cardCount / 2) {
+        tree.mutated = body;
+        tree.mutateText = true;
+      }
+    }
+  }
+
+  // 200 levels of alternating row and column containers, each with a box.
+  static void buildDeepNesting(Tree& tree) {
+    beginTree(tree);
+    Node parent = tree.root;
+    for (uint32_t i = 0; i < 200; i++) {
+      Node box = newChild(tree, parent, 0);
+      Engine::setWidth(box, 10);
+      Engine::setHeight(box, 10);
+      Node container = newChild(tree, parent, 1);
+      Engine::setFlexGrow(container, 1);
+      Engine::setPadding(container, 1);
+      if (i % 2 == 0) {
+        Engine::setFlexDirectionRow(container);
+      }
+      parent = container;
+    }
+    Node leaf = newChild(tree, parent, 0);
+    Engine::setWidth(leaf, 10);
+    Engine::setHeight(leaf, 10);
+    tree.mutated = leaf;
+  }
+
+  // 600 wrapped items of various sizes, each with a label.
+  static void buildWrapGrid(Tree& tree) {
+    BenchmarkRandom random(4);
+    beginTree(tree);
+    Engine::setFlexDirectionRow(tree.root);
+    Engine::setFlexWrap(tree.root);
+    const uint32_t itemCount = 600;
+    for (uint32_t i = 0; i < itemCount; i++) {
+      Node item = newChild(tree, tree.root, i);
+      Engine::setWidth(item, static_cast<float>(random.next(40, 100)));
+      Engine::setHeight(item, static_cast<float>(random.next(40, 70)));
+      Engine::setMargin(item, 2);
+      newText(tree, item, 0, random.next(1, 12));
+      if (i == itemCount / 2) {
+        tree.mutated = item;
+      }
+    }
+  }
+
+  // yoga's "Huge nested layout", 10 children at each of 4 levels.
+  static void buildHugeNested(Tree& tree) {
+    beginTree(tree);
+    buildHugeNestedLevel(tree, tree.root, 0);
+  }
+
+  static void buildHugeNestedLevel(Tree& tree, Node parent, uint32_t depth) {
+    for (uint32_t i = 0; i < 10; i++) {
+      Node child = newChild(tree, parent, 0);
+      if (depth % 2 == 1) {
+        Engine::setFlexDirectionRow(child);
+      }
+      Engine::setFlexGrow(child, 1);
+      Engine::setWidth(child, 10);
+      Engine::setHeight(child, 10);
+      if (depth < 3) {
+        buildHugeNestedLevel(tree, child, depth + 1);
+      } else if (i == 0) {
+        tree.mutated = child;
+      }
+    }
+  }
+};
@@ -20,214 +20,275 @@
  * limitations under the License.
  */
 /* this benchmark refer facebook yoga , so it can compare with yoga.
+ * shared scenarios are in ../common/LayoutBenchmark.h, cases at the end are
+ * hippy only.
  */
-#include <math.h>
+#include <dirent.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+#include <unistd.h>
 
-#include "./Hippy.h"
+#include <string>
+#include <vector>
 
-#define NUM_REPETITIONS 1000
+#include "./Hippy.h"
+#include "LayoutBenchmark.h"
+
+static HPSize _measureText(HPNodeRef node,
+                           float width,
+                           MeasureMode widthMode,
+                           float height,
+                           MeasureMode heightMode,
+                           void* layoutContext) {
+  uint32_t length = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(node->getContext()));
+  HPSize size;
+  BenchmarkMeasureText(length, width, widthMode == MeasureModeUndefined,
+                       widthMode == MeasureModeExactly, &size.width, &size.height);
+  return size;
+}
 
-#define HPBENCHMARKS(BLOCK)                \
-  int main(int argc, char const* argv[]) { \
-    clock_t __start;                       \
-    clock_t __endTimes[NUM_REPETITIONS];   \
-    { BLOCK }                              \
-    return 0;                              \
+class HPBenchmarkEngine {
+ public:
+  typedef HPNodeRef Node;
+  static const char* name() { return "hippy"; }
+  static Node newNode() { return HPNodeNew(); }
+  static void freeRecursive(Node node) { HPNodeFreeRecursive(node); }
+  static void insertChild(Node node, Node child, uint32_t index) {
+    HPNodeInsertChild(node, child, index);
   }
-
-#define HPBENCHMARK(NAME, BLOCK)                         \
-  __start = clock();                                     \
-  for (uint32_t __i = 0; __i < NUM_REPETITIONS; __i++) { \
-    {BLOCK} __endTimes[__i] = clock();                   \
-  }                                                      \
-  __printBenchmarkResult(NAME, __start, __endTimes);
-
-static int __compareDoubles(const void* a, const void* b) {
-  double arg1 = *(const double*)a;
-  double arg2 = *(const double*)b;
-
-  if (arg1 < arg2) {
-    return -1;
+  static void setWidth(Node node, float width) { HPNodeStyleSetWidth(node, width); }
+  static void setHeight(Node node, float height) { HPNodeStyleSetHeight(node, height); }
+  static void setFlexGrow(Node node, float flexGrow) { HPNodeStyleSetFlexGrow(node, flexGrow); }
+  static void setFlexShrink(Node node, float flexShrink) {
+    HPNodeStyleSetFlexShrink(node, flexShrink);
   }
-
-  if (arg1 > arg2) {
-    return 1;
+  static void setFlexDirectionRow(Node node) {
+    HPNodeStyleSetFlexDirection(node, FLexDirectionRow);
   }
-
-  return 0;
-}
-
-static void __printBenchmarkResult(char* name, clock_t start, clock_t* endTimes) {
-  double timesInMs[NUM_REPETITIONS];
-  double mean = 0;
-  clock_t lastEnd = start;
-  for (uint32_t i = 0; i < NUM_REPETITIONS; i++) {
-    timesInMs[i] = (endTimes[i] - lastEnd) / static_cast<double>(CLOCKS_PER_SEC) * 1000;
-    lastEnd = endTimes[i];
-    mean += timesInMs[i];
+  static void setFlexWrap(Node node) { HPNodeStyleSetFlexWrap(node, FlexWrap); }
+  static void setMargin(Node node, float margin) { HPNodeStyleSetMargin(node, CSSAll, margin); }
+  static void setPadding(Node node, float padding) {
+    HPNodeStyleSetPadding(node, CSSAll, padding);
   }
-  mean /= NUM_REPETITIONS;
-
-  qsort(timesInMs, NUM_REPETITIONS, sizeof(double), __compareDoubles);
-  double median = timesInMs[NUM_REPETITIONS / 2];
-
-  double variance = 0;
-  for (uint32_t i = 0; i < NUM_REPETITIONS; i++) {
-    variance += pow(timesInMs[i] - mean, 2);
+  static void setText(Node node, uint32_t length) {
+    node->setContext(reinterpret_cast<void*>(static_cast<uintptr_t>(length)));
+    if (node->measure == _measureText) {
+      HPNodeMarkDirty(node);
+    } else {
+      HPNodeSetMeasureFunc(node, _measureText);
+    }
   }
-  variance /= NUM_REPETITIONS;
-  double stddev = sqrt(variance);
-
-  printf("%s: median: %lf ms, stddev: %lf ms\n", name, median, stddev);
+  static void layout(Node node, float width, float height) {
+    HPNodeDoLayout(node, width, height, DirectionLTR);
+  }
+};
+
+// text measured concurrently before layout, _measureText is thread safe.
+class HPPremeasureBenchmarkEngine : public HPBenchmarkEngine {
+ public:
+  static HPLayoutThreadPoolRef pool;
+  static void layout(Node node, float width, float height) {
+    HPNodeDoPremeasuredLayout(node, width, height, pool, DirectionLTR);
+  }
+};
+
+HPLayoutThreadPoolRef HPPremeasureBenchmarkEngine::pool = nullptr;
+
+// build the "Huge nested layout" tree, nodes allocated in arena if not nullptr.
+static HPNodeRef _buildHugeNestedTree(HPNodeArenaRef arena) {
+  const HPNodeRef root = HPNodeNewInArena(arena);
+
+  for (uint32_t i = 0; i < 10; i++) {
+    const HPNodeRef child = HPNodeNewInArena(arena);
+    HPNodeStyleSetFlexGrow(child, 1);
+    HPNodeStyleSetWidth(child, 10);
+    HPNodeStyleSetHeight(child, 10);
+    HPNodeInsertChild(root, child, 0);
+
+    for (uint32_t ii = 0; ii < 10; ii++) {
+      const HPNodeRef grandChild = HPNodeNewInArena(arena);
+      HPNodeStyleSetFlexDirection(grandChild, FLexDirectionRow);
+      HPNodeStyleSetFlexGrow(grandChild, 1);
+      HPNodeStyleSetWidth(grandChild, 10);
+      HPNodeStyleSetHeight(grandChild, 10);
+      HPNodeInsertChild(child, grandChild, 0);
+
+      for (uint32_t iii = 0; iii < 10; iii++) {
+        const HPNodeRef grandGrandChild = HPNodeNewInArena(arena);
+        HPNodeStyleSetFlexGrow(grandGrandChild, 1);
+        HPNodeStyleSetWidth(grandGrandChild, 10);
+        HPNodeStyleSetHeight(grandGrandChild, 10);
+        HPNodeInsertChild(grandChild, grandGrandChild, 0);
+
+        for (uint32_t iiii = 0; iiii < 10; iiii++) {
+          const HPNodeRef grandGrandGrandChild = HPNodeNewInArena(arena);
+          HPNodeStyleSetFlexDirection(grandGrandGrandChild, FLexDirectionRow);
+          HPNodeStyleSetFlexGrow(grandGrandGrandChild, 1);
+          HPNodeStyleSetWidth(grandGrandGrandChild, 10);
+          HPNodeStyleSetHeight(grandGrandGrandChild, 10);
+          HPNodeInsertChild(grandGrandChild, grandGrandGrandChild, 0);
+        }
+      }
+    }
+  }
+  return root;
 }
 
-static HPSize _measure(HPNodeRef node,
-                       float width,
-                       MeasureMode widthMode,
-                       float height,
-                       MeasureMode heightMode,
-                       void* layoutContext) {
-  HPSize size = {widthMode == MeasureModeUndefined ? 10 : width,
-                 heightMode == MeasureModeUndefined ? 10 : width};
-  return size;
+// dirty every node, so next layout walks the whole tree without cache.
+static void _markTreeDirty(HPNodeRef node) {
+  node->setDirty(true);
+  for (uint32_t i = 0; i < node->childCount(); i++) {
+    _markTreeDirty(node->getChild(i));
+  }
 }
 
-HPBENCHMARKS({
-  HPBENCHMARK("Stack with flex", {
-    const HPNodeRef root = HPNodeNew();
-    HPNodeStyleSetWidth(root, 100);
-    HPNodeStyleSetHeight(root, 100);
-
-    for (uint32_t i = 0; i < 10; i++) {
-      const HPNodeRef child = HPNodeNew();
-      HPNodeSetMeasureFunc(child, _measure);
-      HPNodeStyleSetFlex(child, 1);
-      HPNodeInsertChild(root, child, 0);
+// remove directory and files in it.
+static void _removeDirectory(const char* path) {
+  DIR* dir = opendir(path);
+  if (dir == nullptr) {
+    return;
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      unlink((std::string(path) + "/" + entry->d_name).c_str());
     }
+  }
+  closedir(dir);
+  rmdir(path);
+}
 
-    HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR);
+// compare heap allocated nodes with arena allocated nodes, and serial with
+// parallel layout, on the huge nested tree, and time its frame buffer and
+// persistent cache.
+static void _runHippyOnlyBenchmarks(BenchmarkReport& report) {
+  const uint32_t nodeCount = 11111;
+  HPNodeArenaRef arena = HPNodeArenaNew(1024);
+  if (report.shouldRun("huge nested, heap")) {
+    report.run("huge nested, heap", "build+free", nodeCount,
+               []() { HPNodeFreeRecursive(_buildHugeNestedTree(nullptr)); });
+    HPNodeRef root = _buildHugeNestedTree(nullptr);
+    report.run("huge nested, heap", "full relayout", nodeCount, [root]() {
+      _markTreeDirty(root);
+      HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR);
+    });
     HPNodeFreeRecursive(root);
-  });
-
-  HPBENCHMARK("Align stretch in undefined axis", {
-    const HPNodeRef root = HPNodeNew();
+  }
 
-    for (uint32_t i = 0; i < 10; i++) {
-      const HPNodeRef child = HPNodeNew();
-      HPNodeStyleSetHeight(child, 20);
-      HPNodeSetMeasureFunc(child, _measure);
-      HPNodeInsertChild(root, child, 0);
-    }
+  if (report.shouldRun("huge nested, arena")) {
+    report.run("huge nested, arena", "build+free", nodeCount,
+               [arena]() { HPNodeFreeRecursive(_buildHugeNestedTree(arena)); });
+    HPNodeRef root = HPNodeArenaCompact(_buildHugeNestedTree(arena));
+    report.run("huge nested, arena", "full relayout", nodeCount, [root]() {
+      _markTreeDirty(root);
+      HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR);
+    });
+    HPNodeFreeRecursive(root);
+  }
+  HPNodeArenaFree(arena);
 
+  // absolute frames of the laid out tree for a renderer.
+  if (report.shouldRun("huge nested, frame buffer")) {
+    HPNodeRef root = _buildHugeNestedTree(nullptr);
     HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR);
+    HPFrameBufferRef buffer = HPFrameBufferNew();
+    report.run("huge nested, frame buffer", "fill", nodeCount,
+               [root, buffer]() { HPNodeFillFrameBuffer(root, buffer); });
+    HPFrameBufferFree(buffer);
     HPNodeFreeRecursive(root);
-  });
-
-  HPBENCHMARK("Nested flex", {
-    const HPNodeRef root = HPNodeNew();
-
-    for (uint32_t i = 0; i < 10; i++) {
-      const HPNodeRef child = HPNodeNew();
-      HPNodeStyleSetFlex(child, 1);
-      HPNodeInsertChild(root, child, 0);
+  }
 
-      for (uint32_t ii = 0; ii < 10; ii++) {
-        const HPNodeRef grandChild = HPNodeNew();
-        HPNodeSetMeasureFunc(grandChild, _measure);
-        HPNodeStyleSetFlex(grandChild, 1);
-        HPNodeInsertChild(child, grandChild, 0);
-      }
+  // first layout read from files of a previous launch.
+  if (report.shouldRun("huge nested, persistent cache")) {
+    char directory[] = "/tmp/hippy_layout_benchmarkXXXXXX";
+    if (mkdtemp(directory) != nullptr) {
+      HPPersistentLayoutCacheRef cache = HPPersistentLayoutCacheNew(directory);
+      HPNodeRef root = _buildHugeNestedTree(nullptr);
+      HPNodeDoPersistentCachedLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, cache);
+      HPNodeFreeRecursive(root);
+      root = _buildHugeNestedTree(nullptr);
+      report.run("huge nested, persistent cache", "first layout", nodeCount, [root, cache]() {
+        HPNodeDoPersistentCachedLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, cache);
+      });
+      HPNodeFreeRecursive(root);
+      HPPersistentLayoutCacheFree(cache);
+      _removeDirectory(directory);
     }
+  }
 
-    HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR);
+  // text heavy scenarios with text measured on 4 threads before layout.
+  HPPremeasureBenchmarkEngine::pool = HPLayoutThreadPoolNew(4);
+  BenchmarkScenarios<HPPremeasureBenchmarkEngine>::run(
+      report, "long list, premeasure 4",
+      BenchmarkScenarios<HPPremeasureBenchmarkEngine>::buildLongList);
+  BenchmarkScenarios<HPPremeasureBenchmarkEngine>::run(
+      report, "text cards, premeasure 4",
+      BenchmarkScenarios<HPPremeasureBenchmarkEngine>::buildTextCards);
+  HPLayoutThreadPoolFree(HPPremeasureBenchmarkEngine::pool);
+  HPPremeasureBenchmarkEngine::pool = nullptr;
+
+  // parallel layout of the 10 top level subtrees (1111 nodes each).
+  if (report.shouldRun("huge nested, parallel 4")) {
+    HPLayoutThreadPoolRef pool = HPLayoutThreadPoolNew(4);
+    HPNodeRef root = _buildHugeNestedTree(nullptr);
+    report.run("huge nested, parallel 4", "full relayout", nodeCount, [root, pool]() {
+      _markTreeDirty(root);
+      HPNodeDoParallelLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, pool, DirectionLTR);
+    });
     HPNodeFreeRecursive(root);
-  });
-
-  HPBENCHMARK("Huge nested layout", {
-    const HPNodeRef root = HPNodeNew();
-
-    for (uint32_t i = 0; i < 10; i++) {
-      const HPNodeRef child = HPNodeNew();
-      HPNodeStyleSetFlexGrow(child, 1);
-      HPNodeStyleSetWidth(child, 10);
-      HPNodeStyleSetHeight(child, 10);
-      HPNodeInsertChild(root, child, 0);
-
-      for (uint32_t ii = 0; ii < 10; ii++) {
-        const HPNodeRef grandChild = HPNodeNew();
-        HPNodeStyleSetFlexDirection(grandChild, FLexDirectionRow);
-        HPNodeStyleSetFlexGrow(grandChild, 1);
-        HPNodeStyleSetWidth(grandChild, 10);
-        HPNodeStyleSetHeight(grandChild, 10);
-        HPNodeInsertChild(child, grandChild, 0);
-
-        for (uint32_t iii = 0; iii < 10; iii++) {
-          const HPNodeRef grandGrandChild = HPNodeNew();
-          HPNodeStyleSetFlexGrow(grandGrandChild, 1);
-          HPNodeStyleSetWidth(grandGrandChild, 10);
-          HPNodeStyleSetHeight(grandGrandChild, 10);
-          HPNodeInsertChild(grandChild, grandGrandChild, 0);
-
-          for (uint32_t iiii = 0; iiii < 10; iiii++) {
-            const HPNodeRef grandGrandGrandChild = HPNodeNew();
-            HPNodeStyleSetFlexDirection(grandGrandGrandChild, FLexDirectionRow);
-            HPNodeStyleSetFlexGrow(grandGrandGrandChild, 1);
-            HPNodeStyleSetWidth(grandGrandGrandChild, 10);
-            HPNodeStyleSetHeight(grandGrandGrandChild, 10);
-            HPNodeInsertChild(grandGrandChild, grandGrandGrandChild, 0);
-          }
-        }
-      }
-    }
+    HPLayoutThreadPoolFree(pool);
+  }
+}
 
-    HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR);
-    HPNodeFreeRecursive(root);
-  });
-
-  // added by ianwang(honwsn@gmail.com) ,for no style test that will cost more time then the
-  // previous test case.
-  HPBENCHMARK("Huge nested layout, no style width & height", {
-    const HPNodeRef root = HPNodeNew();
-
-    for (uint32_t i = 0; i < 10; i++) {
-      const HPNodeRef child = HPNodeNew();
-      HPNodeStyleSetFlexGrow(child, 1);
-      //      HPNodeStyleSetWidth(child, 10);
-      //      HPNodeStyleSetHeight(child, 10);
-      HPNodeInsertChild(root, child, 0);
-
-      for (uint32_t ii = 0; ii < 10; ii++) {
-        const HPNodeRef grandChild = HPNodeNew();
-        HPNodeStyleSetFlexDirection(grandChild, FLexDirectionRow);
-        HPNodeStyleSetFlexGrow(grandChild, 1);
-        //        HPNodeStyleSetWidth(grandChild, 10);
-        //        HPNodeStyleSetHeight(grandChild, 10);
-        HPNodeInsertChild(child, grandChild, 0);
-
-        for (uint32_t iii = 0; iii < 10; iii++) {
-          const HPNodeRef grandGrandChild = HPNodeNew();
-          HPNodeStyleSetFlexGrow(grandGrandChild, 1);
-          //          HPNodeStyleSetWidth(grandGrandChild, 10);
-          //          HPNodeStyleSetHeight(grandGrandChild, 10);
-          HPNodeInsertChild(grandChild, grandGrandChild, 0);
-
-          for (uint32_t iiii = 0; iiii < 10; iiii++) {
-            const HPNodeRef grandGrandGrandChild = HPNodeNew();
-            HPNodeStyleSetFlexDirection(grandGrandGrandChild, FLexDirectionRow);
-            HPNodeStyleSetFlexGrow(grandGrandGrandChild, 1);
-            HPNodeStyleSetWidth(grandGrandGrandChild, 10);
-            HPNodeStyleSetHeight(grandGrandGrandChild, 10);
-            HPNodeInsertChild(grandGrandChild, grandGrandGrandChild, 0);
-          }
-        }
+// 8 independent long list roots, serial and concurrent on 1 to 8 threads.
+static void _runLayoutRootsBenchmarks(BenchmarkReport& report) {
+  typedef BenchmarkScenarios<HPBenchmarkEngine> Scenarios;
+  const uint32_t rootCount = 8;
+  const uint32_t threadCounts[] = {0, 1, 2, 4, 8};
+  for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); t++) {
+    char scenario[64];
+    if (threadCounts[t] == 0) {
+      snprintf(scenario, sizeof(scenario), "%u roots, serial", rootCount);
+    } else {
+      snprintf(scenario, sizeof(scenario), "%u roots, %u threads", rootCount, threadCounts[t]);
+    }
+    if (!report.shouldRun(scenario)) {
+      continue;
+    }
+    HPLayoutThreadPoolRef pool =
+        threadCounts[t] == 0 ? nullptr : HPLayoutThreadPoolNew(threadCounts[t]);
+    std::vector<HPLayoutRoot> roots(rootCount);
+    uint32_t nodeCount = 0;
+    for (uint32_t i = 0; i < rootCount; i++) {
+      Scenarios::Tree tree;
+      Scenarios::buildLongList(tree);
+      HPLayoutRoot root = {tree.root, 375, 667, DirectionLTR, nullptr, nullptr};
+      roots[i] = root;
+      nodeCount += tree.nodeCount;
+    }
+    report.run(scenario, "full relayout", nodeCount, [&roots, pool]() {
+      for (size_t i = 0; i < roots.size(); i++) {
+        _markTreeDirty(roots[i].node);
       }
+      HPNodeDoLayoutRoots(roots.data(), static_cast<uint32_t>(roots.size()), pool);
+    });
+    for (uint32_t i = 0; i < rootCount; i++) {
+      HPNodeFreeRecursive(roots[i].node);
     }
+    HPLayoutThreadPoolFree(pool);
+  }
+}
 
-    HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR);
-    HPNodeFreeRecursive(root);
-  });
-});
+int main(int argc, char const* argv[]) {
+  BenchmarkOptions options;
+  if (!BenchmarkParseOptions(argc, argv, &options)) {
+    fprintf(stderr, "usage: %s [--warmup N] [--iterations N] [--filter NAME] [--json FILE|-]\n",
+            argv[0]);
+    return 1;
+  }
+  BenchmarkReport report(HPBenchmarkEngine::name(), options);
+  BenchmarkScenarios<HPBenchmarkEngine>::runAll(report);
+  _runHippyOnlyBenchmarks(report);
+  _runLayoutRootsBenchmarks(report);
+  return report.writeJson() ? 0 : 1;
+}
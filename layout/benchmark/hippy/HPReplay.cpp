@@ -0,0 +1,105 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* replay layout of tree snapshots recorded by HPNodeRecordSnapshot, e.g.
+ * slow pages from production, with the same timing and json output as
+ * hippy_layout_benchmark.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "./Hippy.h"
+#include "LayoutBenchmark.h"
+
+static bool _readFile(const char* path, std::vector<uint8_t>* data) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  uint8_t chunk[4096];
+  size_t size;
+  while ((size = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    data->insert(data->end(), chunk, chunk + size);
+  }
+  bool ok = ferror(file) == 0;
+  fclose(file);
+  return ok;
+}
+
+// time load and full layout of one snapshot, scenario named by its file.
+static bool _replay(BenchmarkReport& report, const char* path) {
+  const char* name = strrchr(path, '/');
+  name = name == nullptr ? path : name + 1;
+  if (!report.shouldRun(name)) {
+    return true;
+  }
+  std::vector<uint8_t> data;
+  if (!_readFile(path, &data)) {
+    fprintf(stderr, "can not read %s\n", path);
+    return false;
+  }
+  HPTreeSnapshotRef snapshot = HPTreeSnapshotLoad(data.data(), data.size());
+  if (snapshot == nullptr) {
+    fprintf(stderr, "%s is not a valid snapshot\n", path);
+    return false;
+  }
+  const uint32_t nodeCount = snapshot->nodeCount();
+  report.run(name, "load", nodeCount, [&data]() {
+    HPTreeSnapshotFree(HPTreeSnapshotLoad(data.data(), data.size()));
+  });
+  report.run(name, "first layout", nodeCount,
+             [snapshot]() { HPTreeSnapshotLayout(snapshot); });
+  if (HPTreeSnapshotGetMissCount(snapshot) > 0) {
+    // layout differs from the recorded one, results are approximate.
+    fprintf(stderr, "%s: %u measure requests not recorded\n", name,
+            HPTreeSnapshotGetMissCount(snapshot));
+  }
+  HPTreeSnapshotFree(snapshot);
+  return true;
+}
+
+int main(int argc, char const* argv[]) {
+  // snapshot files are the arguments which are not options.
+  std::vector<const char*> optionArgs(1, argv[0]);
+  std::vector<const char*> paths;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--", 2) == 0) {
+      optionArgs.push_back(argv[i]);
+      if (i + 1 < argc) {
+        optionArgs.push_back(argv[++i]);
+      }
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  BenchmarkOptions options;
+  if (paths.empty() ||
+      !BenchmarkParseOptions(static_cast<int>(optionArgs.size()), optionArgs.data(), &options)) {
+    fprintf(stderr,
+            "usage: %s [--warmup N] [--iterations N] [--filter NAME] [--json FILE|-] "
+            "SNAPSHOT...\n",
+            argv[0]);
+    return 1;
+  }
+  BenchmarkReport report("hippy replay", options);
+  bool ok = true;
+  for (size_t i = 0; i < paths.size(); i++) {
+    ok = _replay(report, paths[i]) && ok;
+  }
+  return report.writeJson() && ok ? 0 : 1;
+}
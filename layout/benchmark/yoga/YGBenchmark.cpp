@@ -4,211 +4,70 @@
  * This source code is licensed under the MIT license found in the LICENSE
  * file in the root directory of this source tree.
  */
+/* scenarios are shared with hippy benchmark, see ../common/LayoutBenchmark.h.
+ */
 #include <Yoga.h>
-#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
 
-#define NUM_REPETITIONS 1000
+#include "LayoutBenchmark.h"
+
+static YGSize _measureText(YGNodeConstRef node,
+                           float width,
+                           YGMeasureMode widthMode,
+                           float height,
+                           YGMeasureMode heightMode) {
+  uint32_t length = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(YGNodeGetContext(node)));
+  YGSize size;
+  BenchmarkMeasureText(length, width, widthMode == YGMeasureModeUndefined,
+                       widthMode == YGMeasureModeExactly, &size.width, &size.height);
+  return size;
+}
 
-#define YGBENCHMARKS(BLOCK)                \
-  int main(int argc, char const* argv[]) { \
-    clock_t __start;                       \
-    clock_t __endTimes[NUM_REPETITIONS];   \
-    { BLOCK }                              \
-    return 0;                              \
+class YGBenchmarkEngine {
+ public:
+  typedef YGNodeRef Node;
+  static const char* name() { return "yoga"; }
+  static Node newNode() { return YGNodeNew(); }
+  static void freeRecursive(Node node) { YGNodeFreeRecursive(node); }
+  static void insertChild(Node node, Node child, uint32_t index) {
+    YGNodeInsertChild(node, child, index);
   }
-
-#define YGBENCHMARK(NAME, BLOCK)                         \
-  __start = clock();                                     \
-  for (uint32_t __i = 0; __i < NUM_REPETITIONS; __i++) { \
-    {BLOCK} __endTimes[__i] = clock();                   \
-  }                                                      \
-  __printBenchmarkResult(NAME, __start, __endTimes);
-
-static int __compareDoubles(const void* a, const void* b) {
-  double arg1 = *(const double*)a;
-  double arg2 = *(const double*)b;
-
-  if (arg1 < arg2) {
-    return -1;
+  static void setWidth(Node node, float width) { YGNodeStyleSetWidth(node, width); }
+  static void setHeight(Node node, float height) { YGNodeStyleSetHeight(node, height); }
+  static void setFlexGrow(Node node, float flexGrow) { YGNodeStyleSetFlexGrow(node, flexGrow); }
+  static void setFlexShrink(Node node, float flexShrink) {
+    YGNodeStyleSetFlexShrink(node, flexShrink);
   }
-
-  if (arg1 > arg2) {
-    return 1;
+  static void setFlexDirectionRow(Node node) {
+    YGNodeStyleSetFlexDirection(node, YGFlexDirectionRow);
   }
-
-  return 0;
-}
-
-static void __printBenchmarkResult(char* name, clock_t start, clock_t* endTimes) {
-  double timesInMs[NUM_REPETITIONS];
-  double mean = 0;
-  clock_t lastEnd = start;
-  for (uint32_t i = 0; i < NUM_REPETITIONS; i++) {
-    timesInMs[i] = (endTimes[i] - lastEnd) / static_cast<double>(CLOCKS_PER_SEC) * 1000;
-    lastEnd = endTimes[i];
-    mean += timesInMs[i];
+  static void setFlexWrap(Node node) { YGNodeStyleSetFlexWrap(node, YGWrapWrap); }
+  static void setMargin(Node node, float margin) { YGNodeStyleSetMargin(node, YGEdgeAll, margin); }
+  static void setPadding(Node node, float padding) {
+    YGNodeStyleSetPadding(node, YGEdgeAll, padding);
   }
-  mean /= NUM_REPETITIONS;
-
-  qsort(timesInMs, NUM_REPETITIONS, sizeof(double), __compareDoubles);
-  double median = timesInMs[NUM_REPETITIONS / 2];
-
-  double variance = 0;
-  for (uint32_t i = 0; i < NUM_REPETITIONS; i++) {
-    variance += pow(timesInMs[i] - mean, 2);
+  static void setText(Node node, uint32_t length) {
+    YGNodeSetContext(node, reinterpret_cast<void*>(static_cast<uintptr_t>(length)));
+    if (YGNodeHasMeasureFunc(node)) {
+      YGNodeMarkDirty(node);
+    } else {
+      YGNodeSetMeasureFunc(node, _measureText);
+    }
   }
-  variance /= NUM_REPETITIONS;
-  double stddev = sqrt(variance);
-
-  printf("%s: median: %lf ms, stddev: %lf ms\n", name, median, stddev);
-}
+  static void layout(Node node, float width, float height) {
+    YGNodeCalculateLayout(node, width, height, YGDirectionLTR);
+  }
+};
 
-static YGSize _measure(YGNodeRef node,
-                       float width,
-                       YGMeasureMode widthMode,
-                       float height,
-                       YGMeasureMode heightMode) {
-  YGSize size = {widthMode == YGMeasureModeUndefined ? 10 : width,
-                 heightMode == YGMeasureModeUndefined ? 10 : width};
-  return size;
+int main(int argc, char const* argv[]) {
+  BenchmarkOptions options;
+  if (!BenchmarkParseOptions(argc, argv, &options)) {
+    fprintf(stderr, "usage: %s [--warmup N] [--iterations N] [--filter NAME] [--json FILE|-]\n",
+            argv[0]);
+    return 1;
+  }
+  BenchmarkReport report(YGBenchmarkEngine::name(), options);
+  BenchmarkScenarios<YGBenchmarkEngine>::runAll(report);
+  return report.writeJson() ? 0 : 1;
 }
-
-YGBENCHMARKS({
-  YGBENCHMARK("Stack with flex", {
-    const YGNodeRef root = YGNodeNew();
-    YGNodeStyleSetWidth(root, 100);
-    YGNodeStyleSetHeight(root, 100);
-
-    for (uint32_t i = 0; i < 10; i++) {
-      const YGNodeRef child = YGNodeNew();
-      YGNodeSetMeasureFunc(child, _measure);
-      YGNodeStyleSetFlex(child, 1);
-      YGNodeInsertChild(root, child, 0);
-    }
-
-    YGNodeCalculateLayout(root, YGUndefined, YGUndefined, YGDirectionLTR);
-    YGNodeFreeRecursive(root);
-  });
-
-  YGBENCHMARK("Align stretch in undefined axis", {
-    const YGNodeRef root = YGNodeNew();
-
-    for (uint32_t i = 0; i < 10; i++) {
-      const YGNodeRef child = YGNodeNew();
-      YGNodeStyleSetHeight(child, 20);
-      YGNodeSetMeasureFunc(child, _measure);
-      YGNodeInsertChild(root, child, 0);
-    }
-
-    YGNodeCalculateLayout(root, YGUndefined, YGUndefined, YGDirectionLTR);
-    YGNodeFreeRecursive(root);
-  });
-
-  YGBENCHMARK("Nested flex", {
-    const YGNodeRef root = YGNodeNew();
-
-    for (uint32_t i = 0; i < 10; i++) {
-      const YGNodeRef child = YGNodeNew();
-      YGNodeStyleSetFlex(child, 1);
-      YGNodeInsertChild(root, child, 0);
-
-      for (uint32_t ii = 0; ii < 10; ii++) {
-        const YGNodeRef grandChild = YGNodeNew();
-        YGNodeSetMeasureFunc(grandChild, _measure);
-        YGNodeStyleSetFlex(grandChild, 1);
-        YGNodeInsertChild(child, grandChild, 0);
-      }
-    }
-
-    YGNodeCalculateLayout(root, YGUndefined, YGUndefined, YGDirectionLTR);
-    YGNodeFreeRecursive(root);
-  });
-
-  YGBENCHMARK("Huge nested layout", {
-    const YGNodeRef root = YGNodeNew();
-
-    for (uint32_t i = 0; i < 10; i++) {
-      const YGNodeRef child = YGNodeNew();
-      YGNodeStyleSetFlexGrow(child, 1);
-      YGNodeStyleSetWidth(child, 10);
-      YGNodeStyleSetHeight(child, 10);
-      YGNodeInsertChild(root, child, 0);
-
-      for (uint32_t ii = 0; ii < 10; ii++) {
-        const YGNodeRef grandChild = YGNodeNew();
-        YGNodeStyleSetFlexDirection(grandChild, YGFlexDirectionRow);
-        YGNodeStyleSetFlexGrow(grandChild, 1);
-        YGNodeStyleSetWidth(grandChild, 10);
-        YGNodeStyleSetHeight(grandChild, 10);
-        YGNodeInsertChild(child, grandChild, 0);
-
-        for (uint32_t iii = 0; iii < 10; iii++) {
-          const YGNodeRef grandGrandChild = YGNodeNew();
-          YGNodeStyleSetFlexGrow(grandGrandChild, 1);
-          YGNodeStyleSetWidth(grandGrandChild, 10);
-          YGNodeStyleSetHeight(grandGrandChild, 10);
-          YGNodeInsertChild(grandChild, grandGrandChild, 0);
-
-          for (uint32_t iiii = 0; iiii < 10; iiii++) {
-            const YGNodeRef grandGrandGrandChild = YGNodeNew();
-            YGNodeStyleSetFlexDirection(grandGrandGrandChild, YGFlexDirectionRow);
-            YGNodeStyleSetFlexGrow(grandGrandGrandChild, 1);
-            YGNodeStyleSetWidth(grandGrandGrandChild, 10);
-            YGNodeStyleSetHeight(grandGrandGrandChild, 10);
-            YGNodeInsertChild(grandGrandChild, grandGrandGrandChild, 0);
-          }
-        }
-      }
-    }
-
-    YGNodeCalculateLayout(root, YGUndefined, YGUndefined, YGDirectionLTR);
-    YGNodeFreeRecursive(root);
-  });
-
-  // added by ianwang(honwsn@gmail.com) ,for no style test that will cost more time then the
-  // previous test case.
-  YGBENCHMARK("Huge nested layout, no style width & height", {
-    const YGNodeRef root = YGNodeNew();
-
-    for (uint32_t i = 0; i < 10; i++) {
-      const YGNodeRef child = YGNodeNew();
-      YGNodeStyleSetFlexGrow(child, 1);
-      //        YGNodeStyleSetWidth(child, 10);
-      //        YGNodeStyleSetHeight(child, 10);
-      YGNodeInsertChild(root, child, 0);
-
-      for (uint32_t ii = 0; ii < 10; ii++) {
-        const YGNodeRef grandChild = YGNodeNew();
-        YGNodeStyleSetFlexDirection(grandChild, YGFlexDirectionRow);
-        YGNodeStyleSetFlexGrow(grandChild, 1);
-        //          YGNodeStyleSetWidth(grandChild, 10);
-        //          YGNodeStyleSetHeight(grandChild, 10);
-        YGNodeInsertChild(child, grandChild, 0);
-
-        for (uint32_t iii = 0; iii < 10; iii++) {
-          const YGNodeRef grandGrandChild = YGNodeNew();
-          YGNodeStyleSetFlexGrow(grandGrandChild, 1);
-          //            YGNodeStyleSetWidth(grandGrandChild, 10);
-          //            YGNodeStyleSetHeight(grandGrandChild, 10);
-          YGNodeInsertChild(grandChild, grandGrandChild, 0);
-
-          for (uint32_t iiii = 0; iiii < 10; iiii++) {
-            const YGNodeRef grandGrandGrandChild = YGNodeNew();
-            YGNodeStyleSetFlexDirection(grandGrandGrandChild, YGFlexDirectionRow);
-            YGNodeStyleSetFlexGrow(grandGrandGrandChild, 1);
-            YGNodeStyleSetWidth(grandGrandGrandChild, 10);
-            YGNodeStyleSetHeight(grandGrandGrandChild, 10);
-            YGNodeInsertChild(grandGrandChild, grandGrandGrandChild, 0);
-          }
-        }
-      }
-    }
-
-    YGNodeCalculateLayout(root, YGUndefined, YGUndefined, YGDirectionLTR);
-    YGNodeFreeRecursive(root);
-  });
-});
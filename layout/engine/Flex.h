@@ -94,20 +94,31 @@ typedef enum {
 
 typedef enum { NodeTypeDefault, NodeTypeText } NodeType;
 
+// margin, padding and border results, rarely read by users,
+// allocated by HPNode only when one of them is not zero.
 typedef struct {
-  float position[4];
-  float cachedPosition[4];
-  float dim[2];
   float margin[4];
   float padding[4];
   float border[4];
+} HPLayoutEdges;
+
+typedef struct {
+  float position[4];
+  float cachedPosition[4];
+  float dim[2];
   bool hadOverflow;
   HPDirection direction;
-  // used to layout
+  // nullptr means all edge results are zero
+  HPLayoutEdges *edges;
+} HPLayout;
+
+// sizes used to resolve flexible lengths of an item, only valid while its
+// container is laid out, so kept in HPLayoutScratch instead of the node.
+typedef struct {
   float flexBaseSize;
   float hypotheticalMainAxisMarginBoxSize;
   float hypotheticalMainAxisSize;
-} HPLayout;
+} HPFlexItemSizes;
 
 typedef enum {
   LayoutActionMeasureWidth = 1,
@@ -19,11 +19,19 @@
 
 #include <cmath>
 
+#include "HPAxis.h"
 #include "HPNode.h"
 #include "HPUtil.h"
 
 FlexLine::FlexLine(HPNodeRef container) {
+  reset(container);
+}
+
+// clear line state for reuse, items keep their capacity.
+void FlexLine::reset(HPNodeRef container) {
   ASSERT(container != nullptr);
+  items.clear();
+  itemSizes.clear();
   flexContainer = container;
   sumHypotheticalMainSize = 0;
   totalFlexGrow = 0;
@@ -38,19 +46,20 @@ FlexLine::FlexLine(HPNodeRef container) {
 /*
  * add a item in flex line.
  */
-void FlexLine::addItem(HPNodeRef item) {
+void FlexLine::addItem(HPNodeRef item, const HPFlexItemSizes& sizes) {
   if (item == nullptr) {
     return;
   }
 
-  sumHypotheticalMainSize += item->result.hypotheticalMainAxisMarginBoxSize;
-  totalFlexGrow += item->style.flexGrow;
-  totalFlexShrink += item->style.flexShrink;
+  sumHypotheticalMainSize += sizes.hypotheticalMainAxisMarginBoxSize;
+  totalFlexGrow += item->style->flexGrow;
+  totalFlexShrink += item->style->flexShrink;
   // For every unfrozen item on the line, multiply its flex shrink factor by its
   // inner flex base size, and note this as its scaled flex shrink factor.
   // TODO(ianwang): inner flex base size ??????????
-  totalWeightedFlexShrink += item->style.flexShrink * item->result.flexBaseSize;
+  totalWeightedFlexShrink += item->style->flexShrink * sizes.flexBaseSize;
   items.push_back(item);
+  itemSizes.push_back(sizes);
 }
 
 bool FlexLine::isEmpty() {
@@ -76,12 +85,24 @@ void FlexLine::FreezeInflexibleItems(FlexLayoutAction layoutAction) {
   // no need use the resolveMainAxis of flexContainer
   // just get main axis from style
   // because it just calculate the size of items.
-  FlexDirection mainAxis = flexContainer->style.flexDirection;
+  FlexDirection mainAxis = flexContainer->style->flexDirection;
   FlexSign flexSign = Sign();
   remainingFreeSpace = containerMainInnerSize - sumHypotheticalMainSize;
-  std::vector<HPNodeRef> inFlexibleItems;
-  for (size_t i = 0; i < items.size(); i++) {
+  inflexibleItems.clear();
+  size_t itemsSize = items.size();
+  flexBaseSizes.resize(itemsSize);
+  hypotheticalSizes.resize(itemsSize);
+  flexGrows.resize(itemsSize);
+  flexShrinks.resize(itemsSize);
+  minMainSizes.resize(itemsSize);
+  maxMainSizes.resize(itemsSize);
+  mainSizes.resize(itemsSize);
+  extraSpaces.resize(itemsSize);
+  targetSizes.resize(itemsSize);
+  frozen.resize(itemsSize);
+  for (size_t i = 0; i < itemsSize; i++) {
     HPNodeRef item = items[i];
+    const HPFlexItemSizes& sizes = itemSizes[i];
     if (layoutAction == LayoutActionLayout) {
       // if it in LayoutActionLayout state, reset frozen as false
       // resolve item main size again.
@@ -89,39 +110,48 @@ void FlexLine::FreezeInflexibleItems(FlexLayoutAction layoutAction) {
     }
 
     float flexFactor =
-        flexSign == PositiveFlexibility ? item->style.flexGrow : item->style.flexShrink;
+        flexSign == PositiveFlexibility ? item->style->flexGrow : item->style->flexShrink;
     if (flexFactor == 0 ||
         (flexSign == PositiveFlexibility &&
-         item->result.flexBaseSize > item->result.hypotheticalMainAxisSize) ||
-        (flexSign == NegativeFlexibility &&
-         item->result.flexBaseSize < item->result.hypotheticalMainAxisSize)) {
-      item->setLayoutDim(mainAxis, item->result.hypotheticalMainAxisSize);
-      inFlexibleItems.push_back(item);
+         sizes.flexBaseSize > sizes.hypotheticalMainAxisSize) ||
+        (flexSign == NegativeFlexibility && sizes.flexBaseSize < sizes.hypotheticalMainAxisSize)) {
+      item->setLayoutDim(mainAxis, sizes.hypotheticalMainAxisSize);
+      inflexibleItems.push_back(i);
     }
+
+    // same bounds as boundAxis, which ignores undefined and negative ones.
+    float min = item->style->minDim[axisDim[mainAxis]];
+    float max = item->style->maxDim[axisDim[mainAxis]];
+    flexBaseSizes[i] = sizes.flexBaseSize;
+    hypotheticalSizes[i] = sizes.hypotheticalMainAxisSize;
+    flexGrows[i] = item->style->flexGrow;
+    flexShrinks[i] = item->style->flexShrink;
+    minMainSizes[i] = !isUndefined(min) && min >= 0.0 ? min : -INFINITY;
+    maxMainSizes[i] = !isUndefined(max) && max >= 0.0 ? max : INFINITY;
+    mainSizes[i] = item->result.dim[axisDim[mainAxis]];
+    frozen[i] = item->isFrozen;
   }
 
   // Recalculate the remaining free space and total flex grow , total flex
   // shrink
-  FreezeViolations(inFlexibleItems);
+  FreezeViolations(inflexibleItems);
   // Get Initial value here!!!
   initialFreeSpace = remainingFreeSpace;
 }
 
-void FlexLine::FreezeViolations(std::vector<HPNode*>& violations) {
-  // no need use the resolveMainAxis of flexContainer
-  // just get main axis from style
-  // because it just calculate the size of items.
-  FlexDirection mainAxis = flexContainer->style.flexDirection;
+// called after FreezeInflexibleItems gathered the items.
+void FlexLine::FreezeViolations(std::vector<size_t>& violations) {
   for (size_t i = 0; i < violations.size(); i++) {
-    HPNodeRef item = violations[i];
-    if (item->isFrozen)
+    size_t index = violations[i];
+    if (frozen[index])
       continue;
-    remainingFreeSpace -= (item->getLayoutDim(mainAxis) - item->result.hypotheticalMainAxisSize);
-    totalFlexGrow -= item->style.flexGrow;
-    totalFlexShrink -= item->style.flexShrink;
-    totalWeightedFlexShrink -= item->style.flexShrink * item->result.flexBaseSize;
+    remainingFreeSpace -= (mainSizes[index] - hypotheticalSizes[index]);
+    totalFlexGrow -= flexGrows[index];
+    totalFlexShrink -= flexShrinks[index];
+    totalWeightedFlexShrink -= flexShrinks[index] * flexBaseSizes[index];
     totalWeightedFlexShrink = fmax(totalWeightedFlexShrink, 0.0);
-    item->isFrozen = true;
+    frozen[index] = true;
+    items[index]->isFrozen = true;
   }
 }
 
@@ -130,11 +160,11 @@ bool FlexLine::ResolveFlexibleLengths() {
   // no need use the resolveMainAxis of flexContainer
   // just get main axis from style
   // because it just calculate the size of items.
-  FlexDirection mainAxis = flexContainer->style.flexDirection;
+  FlexDirection mainAxis = flexContainer->style->flexDirection;
   float usedFreeSpace = 0;
   float totalViolation = 0;
-  std::vector<HPNodeRef> minViolations;
-  std::vector<HPNodeRef> maxViolations;
+  minViolations.clear();
+  maxViolations.clear();
 
   FlexSign flexSign = Sign();
   float sumFlexFactors = (flexSign == PositiveFlexibility) ? totalFlexGrow : totalFlexShrink;
@@ -150,44 +180,67 @@ bool FlexLine::ResolveFlexibleLengths() {
     }
   }
 
-  for (size_t i = 0; i < items.size(); i++) {
-    HPNodeRef item = items[i];
-    if (item->isFrozen)
-      continue;
-
-    float extraSpace = 0;
-    if (remainingFreeSpace > 0 && totalFlexGrow > 0 && flexSign == PositiveFlexibility) {
-      extraSpace = remainingFreeSpace * item->style.flexGrow / totalFlexGrow;
-    } else if (remainingFreeSpace < 0 && totalWeightedFlexShrink > 0 &&
-               flexSign == NegativeFlexibility) {
-      // For every unfrozen item on the line, multiply its flex shrink factor by
-      // its inner flex base size, and note this as its scaled flex shrink
-      // factor. Find the ratio of the item's scaled flex shrink factor to the
-      // sum of the scaled flex shrink factors of all unfrozen items on the
-      // line.
-
-      extraSpace = remainingFreeSpace * item->style.flexShrink * item->result.flexBaseSize /
-                   totalWeightedFlexShrink;
+  // the branches below are the same for all items, so the loops computing
+  // target sizes have no branch and no dependency between items. sizes of
+  // frozen items are computed as well and dropped later.
+  size_t itemsSize = items.size();
+  const float* grows = flexGrows.data();
+  const float* shrinks = flexShrinks.data();
+  const float* bases = flexBaseSizes.data();
+  const float* hypotheticals = hypotheticalSizes.data();
+  const float* mins = minMainSizes.data();
+  const float* maxs = maxMainSizes.data();
+  float* extras = extraSpaces.data();
+  float* targets = targetSizes.data();
+  // locals, stores to arrays may alias members as far as compiler knows.
+  const float freeSpace = remainingFreeSpace;
+  const float sumGrow = totalFlexGrow;
+  const float sumWeightedShrink = totalWeightedFlexShrink;
+  if (freeSpace > 0 && sumGrow > 0 && flexSign == PositiveFlexibility) {
+    for (size_t i = 0; i < itemsSize; i++) {
+      extras[i] = freeSpace * grows[i] / sumGrow;
     }
+  } else if (freeSpace < 0 && sumWeightedShrink > 0 && flexSign == NegativeFlexibility) {
+    // For every unfrozen item on the line, multiply its flex shrink factor by
+    // its inner flex base size, and note this as its scaled flex shrink
+    // factor. Find the ratio of the item's scaled flex shrink factor to the
+    // sum of the scaled flex shrink factors of all unfrozen items on the
+    // line.
+    for (size_t i = 0; i < itemsSize; i++) {
+      extras[i] = freeSpace * shrinks[i] * bases[i] / sumWeightedShrink;
+    }
+  } else {
+    for (size_t i = 0; i < itemsSize; i++) {
+      extras[i] = 0;
+    }
+  }
+  // Set the item's target main size to its flex base size minus a fraction
+  // of the absolute value of the remaining free space proportional to the
+  // ratio, clamped like boundAxis.
+  for (size_t i = 0; i < itemsSize; i++) {
+    float target = hypotheticals[i] + extras[i];
+    target = target > maxs[i] ? maxs[i] : target;
+    targets[i] = target < mins[i] ? mins[i] : target;
+  }
+
+  for (size_t i = 0; i < itemsSize; i++) {
+    if (frozen[i])
+      continue;
 
     float violation = 0;
-    if (std::isfinite(extraSpace)) {
-      // Set the item's target main size to its flex base size minus a fraction
-      // of the absolute value of the remaining free space proportional to the
-      // ratio.
-      float itemMainSize = item->result.hypotheticalMainAxisSize + extraSpace;
-      float adjustItemMainSize = item->boundAxis(mainAxis, itemMainSize);
-      item->setLayoutDim(mainAxis, adjustItemMainSize);
+    if (std::isfinite(extras[i])) {
+      float itemMainSize = hypotheticals[i] + extras[i];
+      mainSizes[i] = targets[i];
       // use hypotheticalMainAxisSize  instead of item->boundAxis(mainAxis,
-      // item->result.flexBasis);
-      usedFreeSpace += adjustItemMainSize - item->result.hypotheticalMainAxisSize;
-      violation = adjustItemMainSize - itemMainSize;
+      // sizes.flexBaseSize);
+      usedFreeSpace += targets[i] - hypotheticals[i];
+      violation = targets[i] - itemMainSize;
     }
 
     if (violation > 0) {
-      minViolations.push_back(item);
+      minViolations.push_back(i);
     } else if (violation < 0) {
-      maxViolations.push_back(item);
+      maxViolations.push_back(i);
     }
     totalViolation += violation;
   }
@@ -205,6 +258,10 @@ bool FlexLine::ResolveFlexibleLengths() {
     remainingFreeSpace -= usedFreeSpace;
     // TODO(ianwang): FreezeViolations all
     // FreezeViolations(items);
+    // scatter resolved sizes, unchanged ones are written back as they were.
+    for (size_t i = 0; i < itemsSize; i++) {
+      items[i]->result.dim[axisDim[mainAxis]] = mainSizes[i];
+    }
   }
 
   return !totalViolation;
@@ -218,24 +275,29 @@ bool FlexLine::ResolveFlexibleLengths() {
  * Otherwise, set all auto margins to zero. 2.Align the items along the
  * main-axis per justify-content.
  */
-void FlexLine::alignItems() {
+void FlexLine::alignItems(HPLayoutScratch* scratch) {
   // need use the resolveMainAxis of flexContainer
   // because 'alignItems' calculate item's positions
   // which influenced by node's layout direction property.
   FlexDirection mainAxis = flexContainer->resolveMainAxis();
+  HP_AXIS_DISPATCH(mainAxis, alignItems, (scratch));
+}
+
+template <FlexDirection mainAxis>
+void FlexLine::alignItems(HPLayoutScratch* scratch) {
   int itemsSize = items.size();
   // get autoMargin count,assure remainingFreeSpace Calculate again
   remainingFreeSpace = containerMainInnerSize;
   int autoMarginCount = 0;
   for (int i = 0; i < itemsSize; i++) {
     HPNodeRef item = items[i];
-    remainingFreeSpace -= (item->getLayoutDim(mainAxis) + item->getMargin(mainAxis));
+    remainingFreeSpace -= (item->getLayoutDim<mainAxis>() + item->getMargin<mainAxis>());
     // TODO(ianwang): remainingFreeSpace may be a small float value , for example
     // : 1.52587891e-005 == 0.000015
-    if (item->isAutoStartMargin(mainAxis)) {
+    if (item->style.edges(mainAxis).autoStartMargin) {
       autoMarginCount++;
     }
-    if (item->isAutoEndMargin(mainAxis)) {
+    if (item->style.edges(mainAxis).autoEndMargin) {
       autoMarginCount++;
     }
   }
@@ -254,25 +316,25 @@ void FlexLine::alignItems() {
 
   for (int i = 0; i < itemsSize; i++) {
     HPNodeRef item = items[i];
-    if (item->isAutoStartMargin(mainAxis)) {
-      item->setLayoutStartMargin(mainAxis, autoMargin);
+    const HPResolvedEdges& itemEdges = item->style.edges(mainAxis);
+    if (itemEdges.autoStartMargin) {
+      item->setLayoutStartMargin<mainAxis>(autoMargin);
     } else {
       // For margin:: assign style value to result value at this place..
-      item->setLayoutStartMargin(mainAxis, item->getStartMargin(mainAxis));
+      item->setLayoutStartMargin<mainAxis>(itemEdges.startMargin);
     }
 
-    if (item->isAutoEndMargin(mainAxis)) {
-      item->setLayoutEndMargin(mainAxis, autoMargin);
+    if (itemEdges.autoEndMargin) {
+      item->setLayoutEndMargin<mainAxis>(autoMargin);
     } else {
-      item->setLayoutEndMargin(mainAxis, item->getEndMargin(mainAxis));
+      item->setLayoutEndMargin<mainAxis>(itemEdges.endMargin);
     }
   }
 
   // 2. Align the items along the main-axis per justify-content.
-  float offset = flexContainer->getStartPaddingAndBorder(mainAxis);
-  HPStyle style = flexContainer->getStyle();
+  float offset = flexContainer->getStartPaddingAndBorder<mainAxis>();
   float space = 0;
-  switch (style.justifyContent) {
+  switch (flexContainer->style->justifyContent) {
     case FlexAlignStart:
       break;
     case FlexAlignCenter:
@@ -299,10 +361,11 @@ void FlexLine::alignItems() {
   // start end position set.
   for (int i = 0; i < itemsSize; i++) {
     HPNodeRef item = items[i];
-    offset += item->getLayoutStartMargin(mainAxis);
-    item->setLayoutStartPosition(mainAxis, offset);
-    item->setLayoutEndPosition(
-        mainAxis, flexContainer->getLayoutDim(mainAxis) - item->getLayoutDim(mainAxis) - offset);
-    offset += item->getLayoutDim(mainAxis) + item->getLayoutEndMargin(mainAxis) + space;
+    offset += item->getLayoutStartMargin<mainAxis>();
+    item->setLayoutStartPosition<mainAxis>(offset, scratch);
+    item->setLayoutEndPosition<mainAxis>(
+        flexContainer->getLayoutDim<mainAxis>() - item->getLayoutDim<mainAxis>() - offset,
+        scratch);
+    offset += item->getLayoutDim<mainAxis>() + item->getLayoutEndMargin<mainAxis>() + space;
   }
 }
@@ -17,12 +17,16 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <vector>
 
 #include "Flex.h"
 
 class HPNode;
 typedef HPNode* HPNodeRef;
+class HPLayoutScratch;
 
 enum FlexSign {
   PositiveFlexibility,
@@ -32,20 +36,26 @@ enum FlexSign {
 class FlexLine {
  public:
   explicit FlexLine(HPNodeRef container);
-  void addItem(HPNodeRef item);
+  void reset(HPNodeRef container);
+  void addItem(HPNodeRef item, const HPFlexItemSizes& sizes);
   bool isEmpty();
   FlexSign Sign() const {
     return sumHypotheticalMainSize < containerMainInnerSize ? PositiveFlexibility
                                                             : NegativeFlexibility;
   }
   void SetContainerMainInnerSize(float size) { containerMainInnerSize = size; }
-  void FreezeViolations(std::vector<HPNode*>& violations);
+  // violations are indexes of items in this line.
+  void FreezeViolations(std::vector<size_t>& violations);
   void FreezeInflexibleItems(FlexLayoutAction layoutAction);
+  // main sizes are written back to items when it returns true.
   bool ResolveFlexibleLengths();
-  void alignItems();
+  // scratch of the layout pass, see HPNode::markNewLayout.
+  void alignItems(HPLayoutScratch* scratch);
 
  public:
   std::vector<HPNodeRef> items;
+  // flex base and hypothetical sizes, parallel to items
+  std::vector<HPFlexItemSizes> itemSizes;
   HPNodeRef flexContainer;
   // inner size in container main axis
   float containerMainInnerSize;
@@ -64,4 +74,29 @@ class FlexLine {
   // init in FreezeInflexibleItems...
   float initialFreeSpace;
   float remainingFreeSpace;
+
+ private:
+  // reused by FreezeInflexibleItems and ResolveFlexibleLengths,
+  // keep capacity when line is recycled by HPLayoutScratch.
+  std::vector<size_t> inflexibleItems;
+  std::vector<size_t> minViolations;
+  std::vector<size_t> maxViolations;
+
+  // inputs and results of ResolveFlexibleLengths gathered by
+  // FreezeInflexibleItems, parallel to items, so the loops resolving
+  // lengths run over contiguous arrays instead of items.
+  std::vector<float> flexBaseSizes;
+  std::vector<float> hypotheticalSizes;
+  std::vector<float> flexGrows;
+  std::vector<float> flexShrinks;
+  // min and max main size, -inf and inf if not bound.
+  std::vector<float> minMainSizes;
+  std::vector<float> maxMainSizes;
+  std::vector<float> mainSizes;
+  std::vector<float> extraSpaces;
+  std::vector<float> targetSizes;
+  std::vector<uint8_t> frozen;
+
+  template <FlexDirection mainAxis>
+  void alignItems(HPLayoutScratch* scratch);
 };
@@ -0,0 +1,56 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Flex.h"
+
+// compile time counterparts of isRowDirection, axisStart, axisEnd and axisDim.
+// layout kernels are instantiated once per axis, so index math and direction
+// branches on the axis are folded by the compiler.
+template <FlexDirection axis>
+struct HPAxis {
+  static const bool isRow = axis == FLexDirectionRow || axis == FLexDirectionRowReverse;
+  static const CSSDirection start = axis == FLexDirectionRow          ? CSSLeft
+                                    : axis == FLexDirectionRowReverse ? CSSRight
+                                    : axis == FLexDirectionColumn     ? CSSTop
+                                                                      : CSSBottom;
+  static const CSSDirection end = axis == FLexDirectionRow          ? CSSRight
+                                  : axis == FLexDirectionRowReverse ? CSSLeft
+                                  : axis == FLexDirectionColumn     ? CSSBottom
+                                                                    : CSSTop;
+  static const Dimension dim = isRow ? DimWidth : DimHeight;
+};
+
+// call the instance of kernel for an axis known at runtime, e.g.
+// HP_AXIS_DISPATCH(mainAxis, alignItems, ()) calls alignItems<mainAxis>().
+// it's done once per container, the kernel runs on all its items.
+#define HP_AXIS_DISPATCH(axis, kernel, arguments)   \
+  switch (axis) {                                   \
+    case FLexDirectionRow:                          \
+      kernel<FLexDirectionRow> arguments;           \
+      break;                                        \
+    case FLexDirectionRowReverse:                   \
+      kernel<FLexDirectionRowReverse> arguments;    \
+      break;                                        \
+    case FLexDirectionColumn:                       \
+      kernel<FLexDirectionColumn> arguments;        \
+      break;                                        \
+    case FLexDirectionColumnReverse:                \
+      kernel<FLexDirectionColumnReverse> arguments; \
+      break;                                        \
+  }
@@ -0,0 +1,214 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPBatchMeasure.h"
+
+#include "HPNode.h"
+
+HPBatchMeasureTable::HPBatchMeasureTable() {}
+
+HPBatchMeasureTable::~HPBatchMeasureTable() {}
+
+void HPBatchMeasureTable::collect(HPNodeRef root, float parentWidth, float parentHeight) {
+  clear();
+  if (root->needsLayout()) {
+    collectNode(root, parentWidth, parentHeight);
+  }
+}
+
+// available size and measure modes follow layoutImpl, min and max are only
+// approximated.
+void HPBatchMeasureTable::collectNode(HPNodeRef node, float parentWidth, float parentHeight) {
+  HPStyleRef style = node->style;
+  if (style->displayType == DisplayTypeNone) {
+    return;
+  }
+  if (isDefined(parentWidth)) {
+    parentWidth -= node->getMargin(FLexDirectionRow);
+    parentWidth = parentWidth >= 0.0f ? parentWidth : 0.0f;
+  }
+  if (isDefined(parentHeight)) {
+    parentHeight -= node->getMargin(FLexDirectionColumn);
+    parentHeight = parentHeight >= 0.0f ? parentHeight : 0.0f;
+  }
+
+  float availableWidth = VALUE_UNDEFINED;
+  if (isDefined(node->styleDim[DimWidth])) {
+    availableWidth = node->boundAxis(FLexDirectionRow, node->styleDim[DimWidth]) -
+                     node->getPaddingAndBorder(FLexDirectionRow);
+  } else if (isDefined(parentWidth)) {
+    availableWidth = parentWidth - node->getPaddingAndBorder(FLexDirectionRow);
+  }
+  float availableHeight = VALUE_UNDEFINED;
+  if (isDefined(node->styleDim[DimHeight])) {
+    availableHeight = node->boundAxis(FLexDirectionColumn, node->styleDim[DimHeight]) -
+                      node->getPaddingAndBorder(FLexDirectionColumn);
+  } else if (isDefined(parentHeight)) {
+    availableHeight = parentHeight - node->getPaddingAndBorder(FLexDirectionColumn);
+  }
+  if (isDefined(style->maxDim[DimWidth])) {
+    float maxDimWidth = style->maxDim[DimWidth] - node->getPaddingAndBorder(FLexDirectionRow);
+    if (maxDimWidth >= 0.0f && maxDimWidth < NanAsINF(availableWidth)) {
+      availableWidth = maxDimWidth;
+    }
+  }
+  if (isDefined(style->maxDim[DimHeight])) {
+    float maxDimHeight = style->maxDim[DimHeight] - node->getPaddingAndBorder(FLexDirectionColumn);
+    if (maxDimHeight >= 0.0f && maxDimHeight < NanAsINF(availableHeight)) {
+      availableHeight = maxDimHeight;
+    }
+  }
+  availableWidth = availableWidth < 0.0f ? 0.0f : availableWidth;
+  availableHeight = availableHeight < 0.0f ? 0.0f : availableHeight;
+
+  HPNodeRef parent = node->parent;
+  MeasureMode widthMeasureMode = MeasureModeUndefined;
+  if (isDefined(node->styleDim[DimWidth])) {
+    widthMeasureMode = MeasureModeExactly;
+  } else if (isDefined(availableWidth)) {
+    if (parent && parent->style->isOverflowScroll() &&
+        isRowDirection(parent->style->flexDirection)) {
+      availableWidth = VALUE_AUTO;
+    } else {
+      widthMeasureMode = MeasureModeAtMost;
+    }
+  }
+  MeasureMode heightMeasureMode = MeasureModeUndefined;
+  if (isDefined(node->styleDim[DimHeight])) {
+    heightMeasureMode = MeasureModeExactly;
+  } else if (isDefined(availableHeight)) {
+    if (parent && parent->style->isOverflowScroll() &&
+        isColumnDirection(parent->style->flexDirection)) {
+      availableHeight = VALUE_AUTO;
+    } else {
+      heightMeasureMode = MeasureModeAtMost;
+    }
+  }
+
+  if (node->measure != nullptr) {
+    if (!node->isDirty ||
+        (widthMeasureMode == MeasureModeExactly && heightMeasureMode == MeasureModeExactly)) {
+      return;
+    }
+    // single grow shrink child is not measured, see layoutSingleNode.
+    if (style->flexGrow > 0 && style->flexShrink > 0 && parent && parent->childCount() == 1 &&
+        !parent->isStyleDimensionAuto(FLexDirectionRow) &&
+        !parent->isStyleDimensionAuto(FLexDirectionColumn)) {
+      return;
+    }
+    HPSize size;
+    if (node->measureCacheKey != 0 &&
+        HPMeasureCache::shared()->get(node->measureCacheKey, availableWidth, widthMeasureMode,
+                                      availableHeight, heightMeasureMode, size)) {
+      return;
+    }
+    HPMeasureRequest request = {node,          availableWidth,    widthMeasureMode,
+                                availableHeight, heightMeasureMode,
+                                {VALUE_UNDEFINED, VALUE_UNDEFINED}};
+    pending.push_back(request);
+    return;
+  }
+
+  for (size_t i = 0; i < node->children.size(); i++) {
+    HPNodeRef child = node->children[i];
+    if (child->needsLayout() && child->style->positionType != PositionTypeAbsolute) {
+      collectNode(child, availableWidth, availableHeight);
+    }
+  }
+}
+
+// chunks per thread, so threads finishing early can steal the rest.
+static const uint32_t kMeasureChunksPerThread = 4;
+
+void HPBatchMeasureTable::measureTask(void* data) {
+  MeasureTask* task = reinterpret_cast<MeasureTask*>(data);
+  for (uint32_t i = 0; i < task->count; i++) {
+    HPMeasureRequest& request = task->requests[i];
+    request.result = request.node->measure(request.node, request.width, request.widthMeasureMode,
+                                           request.height, request.heightMeasureMode,
+                                           task->layoutContext);
+  }
+}
+
+void HPBatchMeasureTable::measureInParallel(HPLayoutThreadPool* pool, void* layoutContext) {
+  uint32_t count = static_cast<uint32_t>(pending.size());
+  uint32_t chunkCount = (pool->threadCount() + 1) * kMeasureChunksPerThread;
+  uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+  chunkSize = chunkSize > 0 ? chunkSize : 1;
+  taskData.clear();
+  for (uint32_t begin = 0; begin < count; begin += chunkSize) {
+    MeasureTask task = {&pending[begin], count - begin < chunkSize ? count - begin : chunkSize,
+                        layoutContext};
+    taskData.push_back(task);
+  }
+  if (taskData.size() <= 1) {
+    if (!taskData.empty()) {
+      measureTask(&taskData[0]);
+    }
+    return;
+  }
+  tasks.resize(taskData.size());
+  for (size_t i = 0; i < taskData.size(); i++) {
+    tasks[i].func = measureTask;
+    tasks[i].data = &taskData[i];
+  }
+  HPLayoutTaskBatch batch;
+  pool->submit(&batch, tasks.data(), static_cast<uint32_t>(tasks.size()));
+  pool->wait(&batch);
+}
+
+void HPBatchMeasureTable::commit() {
+  for (uint32_t i = 0; i < pending.size(); i++) {
+    HPMeasureRequest& request = pending[i];
+    if (isUndefined(request.result.width) || isUndefined(request.result.height)) {
+      continue;
+    }
+    index[request.node] = i;
+    if (request.node->measureCacheKey != 0) {
+      HPMeasureCache::shared()->put(request.node->measureCacheKey, request.width,
+                                    request.widthMeasureMode, request.height,
+                                    request.heightMeasureMode, request.result);
+    }
+  }
+}
+
+bool HPBatchMeasureTable::lookup(HPNodeRef node,
+                                 float width,
+                                 MeasureMode widthMeasureMode,
+                                 float height,
+                                 MeasureMode heightMeasureMode,
+                                 HPSize& size) {
+  std::unordered_map<HPNodeRef, uint32_t>::iterator it = index.find(node);
+  if (it == index.end()) {
+    return false;
+  }
+  // available size is not used by measure when its mode is undefined.
+  const HPMeasureRequest& request = pending[it->second];
+  if (request.widthMeasureMode != widthMeasureMode ||
+      request.heightMeasureMode != heightMeasureMode ||
+      (widthMeasureMode != MeasureModeUndefined && !FloatIsEqual(request.width, width)) ||
+      (heightMeasureMode != MeasureModeUndefined && !FloatIsEqual(request.height, height))) {
+    return false;
+  }
+  size = request.result;
+  return true;
+}
+
+void HPBatchMeasureTable::clear() {
+  pending.clear();
+  index.clear();
+}
@@ -0,0 +1,102 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "Flex.h"
+#include "HPLayoutThreadPool.h"
+
+class HPNode;
+typedef HPNode* HPNodeRef;
+
+// one measure of a node, result is filled by HPBatchMeasureFunc. result is
+// undefined until filled, a request left unfilled, e.g. when the function
+// fails, is measured by the node's measure function during layout.
+typedef struct {
+  HPNodeRef node;
+  float width;
+  MeasureMode widthMeasureMode;
+  float height;
+  MeasureMode heightMeasureMode;
+  HPSize result;
+} HPMeasureRequest;
+
+// measure all requests at once, e.g. with one call across JNI.
+typedef void (*HPBatchMeasureFunc)(HPMeasureRequest* requests,
+                                   uint32_t count,
+                                   void* layoutContext);
+
+/* Measure results of one layout pass resolved before the pass starts.
+ * collect() walks dirty subtrees top-down and predicts the constraints
+ * layoutImpl will measure dirty measure nodes with, from definite sizes of
+ * ancestors and the available size given to the root. layoutSingleNode
+ * takes a result from here when the constraints match, otherwise the
+ * node's measure function is called as usual, so a wrong prediction costs
+ * one more measure but never changes the layout.
+ */
+class HPBatchMeasureTable {
+ public:
+  HPBatchMeasureTable();
+  virtual ~HPBatchMeasureTable();
+  // predict requests of nodes under root, root's styleDim is set as
+  // HPNode::layout does before layoutImpl.
+  void collect(HPNodeRef root, float parentWidth, float parentHeight);
+  std::vector<HPMeasureRequest>& requests() { return pending; }
+  // fill requests by measure functions of their nodes, concurrently on pool
+  // and the calling thread, so measure functions must be thread safe.
+  void measureInParallel(HPLayoutThreadPool* pool, void* layoutContext);
+  // make filled requests available to find(), results of nodes with
+  // measureCacheKey are shared through HPMeasureCache as well.
+  void commit();
+  bool find(HPNodeRef node,
+            float width,
+            MeasureMode widthMeasureMode,
+            float height,
+            MeasureMode heightMeasureMode,
+            HPSize& size) {
+    return !index.empty() &&
+           lookup(node, width, widthMeasureMode, height, heightMeasureMode, size);
+  }
+  void clear();
+
+ protected:
+  void collectNode(HPNodeRef node, float parentWidth, float parentHeight);
+  bool lookup(HPNodeRef node,
+              float width,
+              MeasureMode widthMeasureMode,
+              float height,
+              MeasureMode heightMeasureMode,
+              HPSize& size);
+  static void measureTask(void* data);
+
+ private:
+  typedef struct {
+    HPMeasureRequest* requests;
+    uint32_t count;
+    void* layoutContext;
+  } MeasureTask;
+
+  std::vector<HPMeasureRequest> pending;
+  std::unordered_map<HPNodeRef, uint32_t> index;
+  std::vector<MeasureTask> taskData;
+  std::vector<HPLayoutTask> tasks;
+};
@@ -0,0 +1,131 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPFrameBuffer.h"
+
+#include <cmath>
+
+#include "HPNode.h"
+#include "HPUtil.h"
+
+HPFrameBuffer::HPFrameBuffer() {}
+
+HPFrameBuffer::~HPFrameBuffer() {}
+
+uint32_t HPFrameBuffer::fill(HPNodeRef root, float scale) {
+  output.clear();
+  if (root == nullptr) {
+    return 0;
+  }
+  if (!(scale > 0)) {
+    scale = 1;
+  }
+  collect(root);
+  resolveAbsolutePositions();
+  snapToPixelGrid(scale);
+  return count();
+}
+
+const HPAbsoluteFrame* HPFrameBuffer::frames() const {
+  return output.data();
+}
+
+uint32_t HPFrameBuffer::count() const {
+  return static_cast<uint32_t>(output.size());
+}
+
+void HPFrameBuffer::collect(HPNodeRef root) {
+  lefts.clear();
+  tops.clear();
+  widths.clear();
+  heights.clear();
+  parents.clear();
+  textNodes.clear();
+  stack.clear();
+  stackParents.clear();
+  stack.push_back(root);
+  stackParents.push_back(HP_FRAME_NO_PARENT);
+  while (!stack.empty()) {
+    HPNodeRef node = stack.back();
+    uint32_t parent = stackParents.back();
+    stack.pop_back();
+    stackParents.pop_back();
+
+    uint32_t index = static_cast<uint32_t>(lefts.size());
+    lefts.push_back(node->result.position[CSSLeft]);
+    tops.push_back(node->result.position[CSSTop]);
+    widths.push_back(node->result.dim[DimWidth]);
+    heights.push_back(node->result.dim[DimHeight]);
+    parents.push_back(parent);
+    textNodes.push_back(node->style->nodeType == NodeTypeText);
+    HPAbsoluteFrame frame = {0, 0, 0, 0, parent, 1, node};
+    output.push_back(frame);
+
+    // reversed, so children are popped in order.
+    for (size_t i = node->children.size(); i > 0; i--) {
+      stack.push_back(node->children[i - 1]);
+      stackParents.push_back(index);
+    }
+  }
+
+  // subtrees follow their root, sizes are added up from the last frame.
+  for (size_t i = output.size() - 1; i > 0; i--) {
+    output[parents[i]].subtreeSize += output[i].subtreeSize;
+  }
+}
+
+void HPFrameBuffer::resolveAbsolutePositions() {
+  float* x = lefts.data();
+  float* y = tops.data();
+  const uint32_t* parent = parents.data();
+  size_t frameCount = lefts.size();
+  for (size_t i = 1; i < frameCount; i++) {
+    x[i] += x[parent[i]];
+    y[i] += y[parent[i]];
+  }
+}
+
+// same rounding as convertLayoutResult on absolute edges: edges of text
+// nodes with fractional size are floored at start and ceiled at end, so
+// text is never clipped.
+void HPFrameBuffer::snapToPixelGrid(float scale) {
+  size_t frameCount = output.size();
+  for (size_t i = 0; i < frameCount; i++) {
+    const bool isTextNode = textNodes[i];
+    const float left = lefts[i] * scale;
+    const float top = tops[i] * scale;
+    const float width = widths[i] * scale;
+    const float height = heights[i] * scale;
+    // only text nodes look at fractional sizes.
+    const bool hasFractionalWidth = isTextNode && !FloatIsEqual(fmodf(width, 1.0), 0) &&
+                                    !FloatIsEqual(fmodf(width, 1.0), 1.0);
+    const bool hasFractionalHeight = isTextNode && !FloatIsEqual(fmodf(height, 1.0), 0) &&
+                                     !FloatIsEqual(fmodf(height, 1.0), 1.0);
+    const float snappedLeft = HPRoundValueToPixelGrid(left, false, isTextNode);
+    const float snappedTop = HPRoundValueToPixelGrid(top, false, isTextNode);
+    const float snappedRight = HPRoundValueToPixelGrid(left + width, hasFractionalWidth,
+                                                       isTextNode && !hasFractionalWidth);
+    const float snappedBottom = HPRoundValueToPixelGrid(top + height, hasFractionalHeight,
+                                                        isTextNode && !hasFractionalHeight);
+
+    HPAbsoluteFrame& frame = output[i];
+    frame.x = snappedLeft / scale;
+    frame.y = snappedTop / scale;
+    frame.width = (snappedRight - snappedLeft) / scale;
+    frame.height = (snappedBottom - snappedTop) / scale;
+  }
+}
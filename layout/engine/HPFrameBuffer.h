@@ -0,0 +1,78 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+class HPNode;
+typedef HPNode* HPNodeRef;
+
+#define HP_FRAME_NO_PARENT 0xffffffff
+
+// frame of a node in coordinates of the root's parent, snapped to the pixel
+// grid like convertLayoutResult does.
+typedef struct {
+  float x;
+  float y;
+  float width;
+  float height;
+  // index of parent's frame, HP_FRAME_NO_PARENT for root.
+  uint32_t parent;
+  // frames of the subtree are [index, index + subtreeSize).
+  uint32_t subtreeSize;
+  HPNodeRef node;
+} HPAbsoluteFrame;
+
+/* Absolute frames of a laid out tree in one flat array, in depth first order,
+ * for renderers to consume directly instead of adding up relative positions
+ * node by node.
+ * fill walks the tree once gathering relative results into arrays, then
+ * absolute positions and snapping are computed by loops over the arrays.
+ * parents precede their children, so one forward pass resolves positions.
+ */
+class HPFrameBuffer {
+ public:
+  HPFrameBuffer();
+  virtual ~HPFrameBuffer();
+  // scale is pixels per layout unit, frames are snapped to whole pixels.
+  // returns count of frames, nodes of display none included.
+  uint32_t fill(HPNodeRef root, float scale = 1);
+  const HPAbsoluteFrame* frames() const;
+  uint32_t count() const;
+
+ protected:
+  void collect(HPNodeRef root);
+  void resolveAbsolutePositions();
+  void snapToPixelGrid(float scale);
+
+ private:
+  std::vector<HPAbsoluteFrame> output;
+  // results gathered by collect, parallel to output, left and top are
+  // turned into absolute ones in place.
+  std::vector<float> lefts;
+  std::vector<float> tops;
+  std::vector<float> widths;
+  std::vector<float> heights;
+  std::vector<uint32_t> parents;
+  std::vector<uint8_t> textNodes;
+  // pending nodes of the depth first walk and indexes of their parents.
+  std::vector<HPNodeRef> stack;
+  std::vector<uint32_t> stackParents;
+};
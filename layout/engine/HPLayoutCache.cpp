@@ -17,6 +17,9 @@
 
 #include "HPLayoutCache.h"
 
+#include <atomic>
+#include <vector>
+
 #include "HPUtil.h"
 
 #ifdef __DEBUG__
@@ -24,7 +27,21 @@
 #include <string>
 #endif
 
+static std::atomic<uint32_t> gCacheCapacity(HP_LAYOUT_CACHE_DEFAULT_CAPACITY);
+
+// sums of HPLayoutStats of layouts which collect statistics, see addGlobalStats.
+static std::atomic<uint64_t> gLayoutHits(0);
+static std::atomic<uint64_t> gLayoutMisses(0);
+static std::atomic<uint64_t> gMeasureHits(0);
+static std::atomic<uint64_t> gMeasureMisses(0);
+static std::atomic<uint64_t> gEvicts(0);
+
 HPLayoutCache::HPLayoutCache() {
+  layoutHits = 0;
+  layoutMisses = 0;
+  measureHits = 0;
+  measureMisses = 0;
+  evicts = 0;
   initCache();
 }
 
@@ -33,7 +50,8 @@ HPLayoutCache::~HPLayoutCache() {}
 void HPLayoutCache::cacheResult(HPSize availableSize,
                                 HPSize resultSize,
                                 HPSizeMode measureMode,
-                                FlexLayoutAction layoutAction) {
+                                FlexLayoutAction layoutAction,
+                                HPLayoutStats* stats) {
   if (layoutAction == LayoutActionLayout) {
     cachedLayout.availableSize = availableSize;
     cachedLayout.widthMeasureMode = measureMode.widthMeasureMode;
@@ -41,12 +59,52 @@ void HPLayoutCache::cacheResult(HPSize availableSize,
     cachedLayout.resultSize = resultSize;
     cachedLayout.layoutAction = layoutAction;
   } else {
-    cachedMeasures[nextMeasureIndex].availableSize = availableSize;
-    cachedMeasures[nextMeasureIndex].widthMeasureMode = measureMode.widthMeasureMode;
-    cachedMeasures[nextMeasureIndex].heightMeasureMode = measureMode.heightMeasureMode;
-    cachedMeasures[nextMeasureIndex].resultSize = resultSize;
-    cachedMeasures[nextMeasureIndex].layoutAction = layoutAction;
-    nextMeasureIndex = (nextMeasureIndex + 1) % MAX_MEASURES_COUNT;
+    MeasureEntry* entry = nullptr;
+    for (size_t i = 0; i < cachedMeasures.size(); i++) {
+      MeasureResult& cached = cachedMeasures[i].result;
+      if (cached.layoutAction == layoutAction &&
+          cached.widthMeasureMode == measureMode.widthMeasureMode &&
+          cached.heightMeasureMode == measureMode.heightMeasureMode &&
+          HPSizeIsEqual(cached.availableSize, availableSize)) {
+        entry = &cachedMeasures[i];
+        break;
+      }
+    }
+    if (entry == nullptr) {
+      uint32_t capacity = gCacheCapacity.load(std::memory_order_relaxed);
+      if (capacity == 0) {
+        return;
+      }
+      while (cachedMeasures.size() >= capacity) {
+        evictLeastUsed(stats);
+      }
+      cachedMeasures.push_back(MeasureEntry());
+      entry = &cachedMeasures.back();
+      entry->useCount = 0;
+    }
+    entry->result.availableSize = availableSize;
+    entry->result.widthMeasureMode = measureMode.widthMeasureMode;
+    entry->result.heightMeasureMode = measureMode.heightMeasureMode;
+    entry->result.resultSize = resultSize;
+    entry->result.layoutAction = layoutAction;
+  }
+}
+
+// evict the least used result, the oldest one if tied.
+void HPLayoutCache::evictLeastUsed(HPLayoutStats* stats) {
+  size_t leastUsed = 0;
+  for (size_t i = 1; i < cachedMeasures.size(); i++) {
+    if (cachedMeasures[i].useCount < cachedMeasures[leastUsed].useCount) {
+      leastUsed = i;
+    }
+  }
+  for (size_t i = 0; i < cachedMeasures.size(); i++) {
+    cachedMeasures[i].useCount >>= 1;
+  }
+  cachedMeasures.erase(cachedMeasures.begin() + leastUsed);
+  if (stats != nullptr) {
+    stats->measureCacheEvictCount++;
+    evicts++;
   }
 }
 
@@ -77,12 +135,8 @@ MeasureResult* HPLayoutCache::useMeasureCacheIfPossible(HPSize availableSize,
                                                         HPSizeMode measureMode,
                                                         FlexLayoutAction layoutAction,
                                                         bool isMeasureNode) {
-  if (nextMeasureIndex <= 0) {
-    return nullptr;
-  }
-
-  for (uint32_t i = 0; i < nextMeasureIndex; i++) {
-    MeasureResult& cacheMeasure = cachedMeasures[i];
+  for (size_t i = 0; i < cachedMeasures.size(); i++) {
+    MeasureResult& cacheMeasure = cachedMeasures[i].result;
     if (layoutAction != cacheMeasure.layoutAction && !isMeasureNode) {
       continue;
     }
@@ -137,6 +191,7 @@ MeasureResult* HPLayoutCache::useMeasureCacheIfPossible(HPSize availableSize,
 #ifdef __DEBUG__
       HPLogd("cache: action:%d\n", cacheMeasure.layoutAction);
 #endif
+      cachedMeasures[i].useCount++;
       return &cacheMeasure;
     }
   }
@@ -151,7 +206,10 @@ MeasureResult* HPLayoutCache::useLayoutCacheIfPossible(HPSize availableSize,
     return nullptr;
   }
 
-  if (HPSizeIsEqual(cachedLayout.availableSize, availableSize) &&
+  // the last layout is restored on a hit, only reuse it for the same input,
+  // as one within tolerance would lay out items slightly differently.
+  if (cachedLayout.availableSize.width == availableSize.width &&
+      cachedLayout.availableSize.height == availableSize.height &&
       cachedLayout.widthMeasureMode == measureMode.widthMeasureMode &&
       cachedLayout.heightMeasureMode == measureMode.heightMeasureMode) {
 #ifdef __DEBUG__
@@ -166,20 +224,41 @@ MeasureResult* HPLayoutCache::useLayoutCacheIfPossible(HPSize availableSize,
 MeasureResult* HPLayoutCache::getCachedMeasureResult(HPSize availableSize,
                                                      HPSizeMode measureMode,
                                                      FlexLayoutAction layoutAction,
-                                                     bool isMeasureNode) {
+                                                     bool isMeasureNode,
+                                                     HPLayoutStats* stats) {
+  MeasureResult* result = nullptr;
   if (isMeasureNode) {
-    MeasureResult* result = useLayoutCacheIfPossible(availableSize, measureMode);
-    if (result != nullptr) {
-      return result;
+    result = useLayoutCacheIfPossible(availableSize, measureMode);
+    if (result == nullptr) {
+      result = useMeasureCacheIfPossible(availableSize, measureMode, layoutAction, isMeasureNode);
     }
-    return useMeasureCacheIfPossible(availableSize, measureMode, layoutAction, isMeasureNode);
   } else if (layoutAction == LayoutActionLayout) {
-    return useLayoutCacheIfPossible(availableSize, measureMode);
+    result = useLayoutCacheIfPossible(availableSize, measureMode);
   } else {
-    return useMeasureCacheIfPossible(availableSize, measureMode, layoutAction, isMeasureNode);
+    result = useMeasureCacheIfPossible(availableSize, measureMode, layoutAction, isMeasureNode);
   }
 
-  return nullptr;
+  if (stats == nullptr) {
+    return result;
+  }
+  if (layoutAction == LayoutActionLayout) {
+    if (result != nullptr) {
+      stats->layoutCacheHitCount++;
+      layoutHits++;
+    } else {
+      stats->layoutCacheMissCount++;
+      layoutMisses++;
+    }
+  } else {
+    if (result != nullptr) {
+      stats->measureCacheHitCount++;
+      measureHits++;
+    } else {
+      stats->measureCacheMissCount++;
+      measureMisses++;
+    }
+  }
+  return result;
 }
 
 MeasureResult* HPLayoutCache::getCachedLayout() {
@@ -187,19 +266,66 @@ MeasureResult* HPLayoutCache::getCachedLayout() {
 }
 
 void HPLayoutCache::initCache() {
+  clearCachedLayout();
+  // storage is kept for next layout.
+  cachedMeasures.clear();
+}
+
+void HPLayoutCache::clearCachedLayout() {
   cachedLayout.availableSize = {VALUE_UNDEFINED, VALUE_UNDEFINED};
   cachedLayout.resultSize = {VALUE_UNDEFINED, VALUE_UNDEFINED};
   cachedLayout.widthMeasureMode = MeasureModeUndefined;
   cachedLayout.heightMeasureMode = MeasureModeUndefined;
-  for (uint32_t i = 0; i < MAX_MEASURES_COUNT; i++) {
-    cachedMeasures[i].availableSize = {VALUE_UNDEFINED, VALUE_UNDEFINED};
-    cachedMeasures[i].resultSize = {VALUE_UNDEFINED, VALUE_UNDEFINED};
-    cachedMeasures[i].widthMeasureMode = MeasureModeUndefined;
-    cachedMeasures[i].heightMeasureMode = MeasureModeUndefined;
-  }
-  nextMeasureIndex = 0;
 }
 
 void HPLayoutCache::clearCache() {
   initCache();
 }
+
+uint32_t HPLayoutCache::measureCount() {
+  return static_cast<uint32_t>(cachedMeasures.size());
+}
+
+HPLayoutCacheStats HPLayoutCache::stats() {
+  HPLayoutCacheStats result;
+  result.layoutHitCount = layoutHits;
+  result.layoutMissCount = layoutMisses;
+  result.measureHitCount = measureHits;
+  result.measureMissCount = measureMisses;
+  result.evictCount = evicts;
+  return result;
+}
+
+void HPLayoutCache::setCapacity(uint32_t capacity) {
+  gCacheCapacity.store(capacity, std::memory_order_relaxed);
+}
+
+uint32_t HPLayoutCache::capacity() {
+  return gCacheCapacity.load(std::memory_order_relaxed);
+}
+
+HPLayoutCacheStats HPLayoutCache::globalStats() {
+  HPLayoutCacheStats result;
+  result.layoutHitCount = gLayoutHits.load(std::memory_order_relaxed);
+  result.layoutMissCount = gLayoutMisses.load(std::memory_order_relaxed);
+  result.measureHitCount = gMeasureHits.load(std::memory_order_relaxed);
+  result.measureMissCount = gMeasureMisses.load(std::memory_order_relaxed);
+  result.evictCount = gEvicts.load(std::memory_order_relaxed);
+  return result;
+}
+
+void HPLayoutCache::resetGlobalStats() {
+  gLayoutHits.store(0, std::memory_order_relaxed);
+  gLayoutMisses.store(0, std::memory_order_relaxed);
+  gMeasureHits.store(0, std::memory_order_relaxed);
+  gMeasureMisses.store(0, std::memory_order_relaxed);
+  gEvicts.store(0, std::memory_order_relaxed);
+}
+
+void HPLayoutCache::addGlobalStats(const HPLayoutStats* stats) {
+  gLayoutHits.fetch_add(stats->layoutCacheHitCount, std::memory_order_relaxed);
+  gLayoutMisses.fetch_add(stats->layoutCacheMissCount, std::memory_order_relaxed);
+  gMeasureHits.fetch_add(stats->measureCacheHitCount, std::memory_order_relaxed);
+  gMeasureMisses.fetch_add(stats->measureCacheMissCount, std::memory_order_relaxed);
+  gEvicts.fetch_add(stats->measureCacheEvictCount, std::memory_order_relaxed);
+}
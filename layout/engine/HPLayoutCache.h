@@ -19,7 +19,10 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "Flex.h"
+#include "HPLayoutStats.h"
 
 typedef struct {
   HPSize availableSize;
@@ -29,8 +32,25 @@ typedef struct {
   FlexLayoutAction layoutAction;
 } MeasureResult;
 
-#define MAX_MEASURES_COUNT 6
+// default max count of measure results cached by one node.
+#define HP_LAYOUT_CACHE_DEFAULT_CAPACITY 16
+
+typedef struct {
+  uint64_t layoutHitCount;
+  uint64_t layoutMissCount;
+  uint64_t measureHitCount;
+  uint64_t measureMissCount;
+  uint64_t evictCount;
+} HPLayoutCacheStats;
 
+/* Per node cache of layout and measure results.
+ * the last layout is kept in cachedLayout, measure results are kept in a
+ * list growing up to capacity, when full, the least used result is evicted,
+ * use counts are halved at every eviction so that old results age out.
+ * hits, misses and evictions are only counted when a HPLayoutStats is passed,
+ * into it and into the node's statistics. global statistics are the sums of
+ * the HPLayoutStats of layouts which collect them.
+ */
 class HPLayoutCache {
  public:
   HPLayoutCache();
@@ -38,15 +58,34 @@ class HPLayoutCache {
   void cacheResult(HPSize availableSize,
                    HPSize resultSize,
                    HPSizeMode measureMode,
-                   FlexLayoutAction layoutAction);
+                   FlexLayoutAction layoutAction,
+                   HPLayoutStats* stats = nullptr);
   MeasureResult* getCachedMeasureResult(HPSize availableSize,
                                         HPSizeMode measureMode,
                                         FlexLayoutAction layoutAction,
-                                        bool isMeasureNode);
+                                        bool isMeasureNode,
+                                        HPLayoutStats* stats = nullptr);
   MeasureResult* getCachedLayout();
+  // drops the last layout, measure results are kept.
+  void clearCachedLayout();
   void clearCache();
+  uint32_t measureCount();
+  HPLayoutCacheStats stats();
+
+  // capacity applies to all nodes, results over it are evicted on next cache.
+  static void setCapacity(uint32_t capacity);
+  static uint32_t capacity();
+  static HPLayoutCacheStats globalStats();
+  static void resetGlobalStats();
+  // add cache counts of a layout's statistics to global statistics.
+  static void addGlobalStats(const HPLayoutStats* stats);
 
  protected:
+  typedef struct {
+    MeasureResult result;
+    uint32_t useCount;
+  } MeasureEntry;
+
   void initCache();
   MeasureResult* useLayoutCacheIfPossible(HPSize availableSize, HPSizeMode measureMode);
 
@@ -54,9 +93,15 @@ class HPLayoutCache {
                                            HPSizeMode measureMode,
                                            FlexLayoutAction layoutAction,
                                            bool isMeasureNode);
+  void evictLeastUsed(HPLayoutStats* stats);
 
  private:
   MeasureResult cachedLayout;
-  MeasureResult cachedMeasures[MAX_MEASURES_COUNT];
-  uint32_t nextMeasureIndex;
+  std::vector<MeasureEntry> cachedMeasures;
+  // statistics of this node, kept across clearCache, see above.
+  uint32_t layoutHits;
+  uint32_t layoutMisses;
+  uint32_t measureHits;
+  uint32_t measureMisses;
+  uint32_t evicts;
 };
@@ -0,0 +1,45 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPLayoutScheduler.h"
+
+#include <vector>
+
+static void layoutRootTask(void* data) {
+  HPLayoutRoot* root = reinterpret_cast<HPLayoutRoot*>(data);
+  HPLayoutOptions options;
+  options.stats = root->stats;
+  root->node->layout(root->parentWidth, root->parentHeight, root->direction, root->layoutContext,
+                     options);
+}
+
+void HPLayoutRootsConcurrently(HPLayoutRoot* roots, uint32_t count, HPLayoutThreadPool* pool) {
+  if (pool == nullptr || count <= 1) {
+    for (uint32_t i = 0; i < count; i++) {
+      layoutRootTask(&roots[i]);
+    }
+    return;
+  }
+  std::vector<HPLayoutTask> tasks(count);
+  for (uint32_t i = 0; i < count; i++) {
+    tasks[i].func = layoutRootTask;
+    tasks[i].data = &roots[i];
+  }
+  HPLayoutTaskBatch batch;
+  pool->submit(&batch, tasks.data(), count);
+  pool->wait(&batch);
+}
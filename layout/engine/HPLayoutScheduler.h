@@ -0,0 +1,44 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "HPNode.h"
+
+// one independent root tree and the arguments of its layout.
+typedef struct {
+  HPNodeRef node;
+  float parentWidth;
+  float parentHeight;
+  HPDirection direction;
+  void* layoutContext;
+  // filled if not nullptr, see HPLayoutStats.h
+  HPLayoutStats* stats;
+} HPLayoutRoot;
+
+/* Lays out root trees which share no node concurrently, one task per root
+ * on pool and the calling thread, roots are laid out serially inside.
+ * the engine keeps per pass data in thread local HPLayoutScratch, and global
+ * state is either read only during layout, sharded with a lock per shard
+ * and atomic reference counts (style intern table), guarded (HPMeasureCache)
+ * or kept per thread (HPLayoutCache counters), so only measure functions of
+ * the roots must be thread safe.
+ * without a pool roots are laid out one by one on the calling thread.
+ */
+void HPLayoutRootsConcurrently(HPLayoutRoot* roots, uint32_t count, HPLayoutThreadPool* pool);
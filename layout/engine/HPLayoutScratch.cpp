@@ -0,0 +1,174 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPLayoutScratch.h"
+
+#include <time.h>
+
+#include "HPUtil.h"
+
+// lists used in stack order, a list is allocated once for each depth.
+template <typename T>
+static T& acquireList(std::vector<T*>& lists, uint32_t& depth) {
+  if (depth == lists.size()) {
+    lists.push_back(new T());
+  }
+  return *lists[depth++];
+}
+
+template <typename T>
+static void releaseList(std::vector<T*>& lists, uint32_t& depth, T& list) {
+  ASSERT(depth > 0 && &list == lists[depth - 1]);
+  (void)list;
+  depth--;
+}
+
+template <typename T>
+static void deleteLists(std::vector<T*>& lists) {
+  for (size_t i = 0; i < lists.size(); i++) {
+    delete lists[i];
+  }
+  lists.clear();
+}
+
+HPLayoutScratch::HPLayoutScratch() {
+  lineListDepth = 0;
+  itemSizeDepth = 0;
+  itemDepth = 0;
+  taskDepth = 0;
+  pool = nullptr;
+  layoutStats = nullptr;
+  phase = LayoutPhaseOther;
+  phaseStart = 0;
+  measureTable = nullptr;
+  measureTableDepth = 0;
+  resumable = nullptr;
+}
+
+HPLayoutScratch::~HPLayoutScratch() {
+  ASSERT(lineListDepth == 0);
+  for (size_t i = 0; i < freeLines.size(); i++) {
+    delete freeLines[i];
+  }
+  freeLines.clear();
+  for (size_t i = 0; i < lineLists.size(); i++) {
+    delete lineLists[i];
+  }
+  lineLists.clear();
+  ASSERT(itemSizeDepth == 0);
+  deleteLists(itemSizeLists);
+  ASSERT(itemDepth == 0);
+  deleteLists(itemLists);
+  ASSERT(taskDepth == 0);
+  deleteLists(taskLists);
+  ASSERT(measureTableDepth == 0);
+  deleteLists(measureTables);
+}
+
+std::vector<FlexLine*>& HPLayoutScratch::acquireFlexLines() {
+  if (lineListDepth == lineLists.size()) {
+    lineLists.push_back(new std::vector<FlexLine*>());
+  }
+  std::vector<FlexLine*>& flexLines = *lineLists[lineListDepth++];
+  ASSERT(flexLines.empty());
+  return flexLines;
+}
+
+FlexLine* HPLayoutScratch::newFlexLine(HPNodeRef container) {
+  if (freeLines.empty()) {
+    return new FlexLine(container);
+  }
+  FlexLine* line = freeLines.back();
+  freeLines.pop_back();
+  line->reset(container);
+  return line;
+}
+
+void HPLayoutScratch::releaseFlexLines(std::vector<FlexLine*>& flexLines) {
+  ASSERT(lineListDepth > 0 && &flexLines == lineLists[lineListDepth - 1]);
+  freeLines.insert(freeLines.end(), flexLines.begin(), flexLines.end());
+  flexLines.clear();
+  lineListDepth--;
+}
+
+std::vector<HPFlexItemSizes>& HPLayoutScratch::acquireItemSizes() {
+  return acquireList(itemSizeLists, itemSizeDepth);
+}
+
+void HPLayoutScratch::releaseItemSizes(std::vector<HPFlexItemSizes>& itemSizes) {
+  itemSizes.clear();
+  releaseList(itemSizeLists, itemSizeDepth, itemSizes);
+}
+
+std::vector<HPNodeRef>& HPLayoutScratch::acquireItems() {
+  return acquireList(itemLists, itemDepth);
+}
+
+void HPLayoutScratch::releaseItems(std::vector<HPNodeRef>& items) {
+  items.clear();
+  releaseList(itemLists, itemDepth, items);
+}
+
+HPItemTaskList& HPLayoutScratch::acquireItemTasks() {
+  return acquireList(taskLists, taskDepth);
+}
+
+void HPLayoutScratch::releaseItemTasks(HPItemTaskList& taskList) {
+  taskList.data.clear();
+  taskList.stats.clear();
+  taskList.tasks.clear();
+  releaseList(taskLists, taskDepth, taskList);
+}
+
+HPBatchMeasureTable& HPLayoutScratch::acquireBatchMeasureTable() {
+  return acquireList(measureTables, measureTableDepth);
+}
+
+void HPLayoutScratch::releaseBatchMeasureTable(HPBatchMeasureTable& table) {
+  table.clear();
+  releaseList(measureTables, measureTableDepth, table);
+}
+
+void HPLayoutScratch::setStats(HPLayoutStats* stats) {
+  layoutStats = stats;
+  phase = LayoutPhaseOther;
+  phaseStart = stats != nullptr ? now() : 0;
+}
+
+LayoutPhase HPLayoutScratch::recordPhase(LayoutPhase newPhase) {
+  double time = now();
+  layoutStats->phaseTime[phase] += time - phaseStart;
+  phaseStart = time;
+  LayoutPhase previous = phase;
+  phase = newPhase;
+  return previous;
+}
+
+uint32_t HPLayoutScratch::freeFlexLineCount() {
+  return freeLines.size();
+}
+
+HPLayoutScratch* HPLayoutScratch::current() {
+  static thread_local HPLayoutScratch scratch;
+  return &scratch;
+}
+
+double HPLayoutScratch::now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
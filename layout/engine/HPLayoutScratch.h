@@ -0,0 +1,140 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "FlexLine.h"
+#include "HPBatchMeasure.h"
+#include "HPLayoutStats.h"
+#include "HPLayoutThreadPool.h"
+
+class HPResumableLayout;
+
+// layout of one item by layoutItemsInParallel, run as a pool task.
+typedef struct {
+  HPNodeRef container;
+  HPNodeRef item;
+  bool stretched;
+  FlexLayoutAction layoutAction;
+  HPSize availableSize;
+  HPLayoutThreadPool* pool;
+  void* layoutContext;
+  // statistics of this task, merged into the layout's after the batch.
+  HPLayoutStats* stats;
+} HPItemLayoutTask;
+
+// storage of one run of layoutItemsInParallel, stats and tasks are
+// parallel to data.
+typedef struct {
+  std::vector<HPItemLayoutTask> data;
+  std::vector<HPLayoutStats> stats;
+  std::vector<HPLayoutTask> tasks;
+} HPItemTaskList;
+
+/* Scratch storage for one layout pass, threaded through layoutImpl.
+ * FlexLine objects and flex line lists are recycled across the whole tree
+ * traversal and across layout calls, so a steady-state relayout makes no
+ * heap allocation for flex lines. per item flex sizes live here as well,
+ * instead of in every node's layout result.
+ * flex line lists are used in stack order: layoutImpl of a child always
+ * finishes before its parent releases its lines.
+ */
+class HPLayoutScratch {
+ public:
+  HPLayoutScratch();
+  virtual ~HPLayoutScratch();
+  std::vector<FlexLine*>& acquireFlexLines();
+  FlexLine* newFlexLine(HPNodeRef container);
+  void releaseFlexLines(std::vector<FlexLine*>& flexLines);
+  // flex base and hypothetical sizes of a container's items, stack ordered
+  // like flex line lists.
+  std::vector<HPFlexItemSizes>& acquireItemSizes();
+  void releaseItemSizes(std::vector<HPFlexItemSizes>& itemSizes);
+  // items of a container and their tasks in parallel layout, stack ordered
+  // like flex line lists.
+  std::vector<HPNodeRef>& acquireItems();
+  void releaseItems(std::vector<HPNodeRef>& items);
+  HPItemTaskList& acquireItemTasks();
+  void releaseItemTasks(HPItemTaskList& taskList);
+  // pool of the current parallel layout pass, nullptr for serial layout.
+  HPLayoutThreadPool* threadPool() { return pool; }
+  void setThreadPool(HPLayoutThreadPool* threadPool) { pool = threadPool; }
+  // statistics of the current layout pass, nullptr when not recorded.
+  HPLayoutStats* stats() { return layoutStats; }
+  // start recording to stats from now, nullptr stops recording.
+  void setStats(HPLayoutStats* stats);
+  // account time from now on to phase, return the previous phase.
+  LayoutPhase switchPhase(LayoutPhase phase) {
+    return layoutStats == nullptr ? phase : recordPhase(phase);
+  }
+  // measure results resolved by HPBatchMeasureFunc for the current pass,
+  // nullptr when the pass has no batch measure.
+  HPBatchMeasureTable* batchMeasureTable() { return measureTable; }
+  void setBatchMeasureTable(HPBatchMeasureTable* table) { measureTable = table; }
+  // table of a pass, stack ordered like flex line lists, since a pass may be
+  // nested in another one on this thread, e.g. from a measure function.
+  HPBatchMeasureTable& acquireBatchMeasureTable();
+  void releaseBatchMeasureTable(HPBatchMeasureTable& table);
+  // resumable layout running on this thread, nullptr for others.
+  HPResumableLayout* resumableLayout() { return resumable; }
+  void setResumableLayout(HPResumableLayout* layout) { resumable = layout; }
+  // count of flex lines waiting for reuse.
+  uint32_t freeFlexLineCount();
+
+  // scratch of the calling thread, kept alive between layout calls.
+  static HPLayoutScratch* current();
+  // monotonic clock in milliseconds.
+  static double now();
+
+ protected:
+  LayoutPhase recordPhase(LayoutPhase phase);
+
+ private:
+  std::vector<FlexLine*> freeLines;
+  std::vector<std::vector<FlexLine*>*> lineLists;
+  uint32_t lineListDepth;
+  std::vector<std::vector<HPFlexItemSizes>*> itemSizeLists;
+  uint32_t itemSizeDepth;
+  std::vector<std::vector<HPNodeRef>*> itemLists;
+  uint32_t itemDepth;
+  std::vector<HPItemTaskList*> taskLists;
+  uint32_t taskDepth;
+  HPLayoutThreadPool* pool;
+  HPLayoutStats* layoutStats;
+  LayoutPhase phase;
+  double phaseStart;
+  HPBatchMeasureTable* measureTable;
+  std::vector<HPBatchMeasureTable*> measureTables;
+  uint32_t measureTableDepth;
+  HPResumableLayout* resumable;
+};
+
+// switch to a phase in scope, the previous phase is restored at exit.
+class HPLayoutPhaseScope {
+ public:
+  HPLayoutPhaseScope(HPLayoutScratch* scratch, LayoutPhase phase)
+      : scratch(scratch), previous(scratch->switchPhase(phase)) {}
+  ~HPLayoutPhaseScope() { scratch->switchPhase(previous); }
+
+ private:
+  HPLayoutScratch* scratch;
+  LayoutPhase previous;
+};
@@ -0,0 +1,336 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPLayoutService.h"
+
+#include "Hippy.h"
+
+HPLayoutFramePool::HPLayoutFramePool() : kept(nullptr) {}
+
+HPLayoutFramePool::~HPLayoutFramePool() {
+  delete kept;
+}
+
+HPLayoutFrame* HPLayoutFramePool::take() {
+  HPLayoutFrame* frame;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    frame = kept;
+    kept = nullptr;
+  }
+  return frame != nullptr ? frame : new HPLayoutFrame();
+}
+
+void HPLayoutFramePool::put(HPLayoutFrame* frame) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (kept == nullptr) {
+      kept = frame;
+      return;
+    }
+  }
+  delete frame;
+}
+
+// deleter of published frames, see HPLayoutFramePool.
+typedef struct {
+  std::weak_ptr<HPLayoutFramePool> pool;
+  void operator()(HPLayoutFrame* frame) const {
+    std::shared_ptr<HPLayoutFramePool> owner = pool.lock();
+    if (owner != nullptr) {
+      owner->put(frame);
+    } else {
+      delete frame;
+    }
+  }
+} HPLayoutFrameRecycler;
+
+HPLayoutService::HPLayoutService(void* layoutContext) {
+  submittedVersion = 0;
+  stopping = false;
+  pool = std::make_shared<HPLayoutFramePool>();
+  front = share(pool->take());
+  front->version = 0;
+  context = layoutContext;
+  nodes.push_back(HPNodeNew());
+  nodeIds[nodes[0]] = 0;
+  width = VALUE_UNDEFINED;
+  height = VALUE_UNDEFINED;
+  direction = DirectionLTR;
+  thread = std::thread(&HPLayoutService::run, this);
+}
+
+HPLayoutService::~HPLayoutService() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  pendingCondition.notify_all();
+  thread.join();
+  // detached subtrees first, their nodes are in the table as well.
+  for (size_t i = 1; i < nodes.size(); i++) {
+    if (nodes[i] != nullptr && nodes[i]->getParent() == nullptr) {
+      HPNodeFreeRecursive(nodes[i]);
+    }
+  }
+  HPNodeFreeRecursive(nodes[0]);
+}
+
+uint64_t HPLayoutService::submit(const HPLayoutTransaction& transaction) {
+  uint64_t version;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(transaction);
+    version = ++submittedVersion;
+  }
+  pendingCondition.notify_one();
+  return version;
+}
+
+HPLayoutFramePtr HPLayoutService::frame() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return front;
+}
+
+HPLayoutFramePtr HPLayoutService::waitForFrame(uint64_t version) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (version > submittedVersion) {
+    version = submittedVersion;
+  }
+  publishCondition.wait(lock, [this, version]() { return front->version >= version; });
+  return front;
+}
+
+// pending transactions are applied together and laid out once, the frame
+// is published after the last of them.
+void HPLayoutService::run() {
+  std::deque<HPLayoutTransaction> transactions;
+  for (;;) {
+    uint64_t version;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      pendingCondition.wait(lock, [this]() { return stopping || !pending.empty(); });
+      if (pending.empty()) {
+        return;
+      }
+      transactions.swap(pending);
+      version = submittedVersion;
+    }
+    for (size_t i = 0; i < transactions.size(); i++) {
+      apply(transactions[i]);
+    }
+    transactions.clear();
+    HPNodeDoLayout(nodes[0], width, height, direction, context);
+
+    std::shared_ptr<HPLayoutFrame> next = share(pool->take());
+    fillFrame(next.get());
+    next->version = version;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      front.swap(next);
+    }
+    publishCondition.notify_all();
+    // the previous front is handed back to pool here, or later by the last
+    // reader holding it.
+    next.reset();
+  }
+}
+
+// a transaction is applied as a whole or not at all: ids past the node table
+// and the nodes the transaction creates, or a mutation HPNodeApplyMutations
+// stops at, drop the transaction and undo the mutations applied before.
+bool HPLayoutService::apply(const HPLayoutTransaction& transaction) {
+  uint32_t mutationCount = static_cast<uint32_t>(transaction.mutations.size());
+  uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
+  uint64_t idLimit = nodeCount;
+  for (uint32_t i = 0; i < mutationCount; i++) {
+    if (transaction.mutations[i].op == HPMutationCreateNode) {
+      idLimit++;
+    }
+  }
+  uint32_t newCount = nodeCount;
+  for (uint32_t i = 0; i < mutationCount; i++) {
+    const HPMutation& mutation = transaction.mutations[i];
+    uint32_t maxId = mutation.node;
+    if (mutation.op == HPMutationInsertChild || mutation.op == HPMutationRemoveChild) {
+      maxId = mutation.arg > maxId ? mutation.arg : maxId;
+    }
+    if (maxId >= idLimit) {
+      return false;
+    }
+    newCount = maxId >= newCount ? maxId + 1 : newCount;
+  }
+
+  std::vector<HPSavedNode> saved;
+  saveNodes(transaction, nodeCount, &saved);
+  nodes.resize(newCount, nullptr);
+  uint32_t applied =
+      HPNodeApplyMutations(nodes.data(), newCount, transaction.mutations.data(), mutationCount);
+  if (applied != mutationCount) {
+    restoreNodes(saved, nodeCount);
+    return false;
+  }
+  for (uint32_t i = 0; i < mutationCount; i++) {
+    const HPMutation& mutation = transaction.mutations[i];
+    if (mutation.op == HPMutationCreateNode && nodes[mutation.node] != nullptr) {
+      nodeIds[nodes[mutation.node]] = mutation.node;
+    }
+  }
+
+  for (size_t i = 0; i < transaction.measures.size(); i++) {
+    const HPLayoutMeasureBinding& binding = transaction.measures[i];
+    HPNodeRef node = binding.node < nodes.size() ? nodes[binding.node] : nullptr;
+    if (node == nullptr) {
+      continue;
+    }
+    bool contentChanged = node->getContext() != binding.context;
+    node->setContext(binding.context);
+    if (node->measure != binding.measure) {
+      node->setMeasureFunc(binding.measure);
+    } else if (contentChanged && node->measure != nullptr) {
+      node->markAsDirty();
+    }
+  }
+
+  for (size_t i = 0; i < transaction.freeNodes.size(); i++) {
+    uint32_t id = transaction.freeNodes[i];
+    if (id > 0 && id < nodes.size() && nodes[id] != nullptr) {
+      freeNode(nodes[id]);
+    }
+  }
+  width = transaction.width;
+  height = transaction.height;
+  direction = transaction.direction;
+  return true;
+}
+
+// style and children of the existing nodes mutations refer to, all the
+// state a transaction can change on them.
+void HPLayoutService::saveNodes(const HPLayoutTransaction& transaction,
+                                uint32_t nodeCount,
+                                std::vector<HPSavedNode>* saved) {
+  std::vector<bool> isSaved(nodeCount, false);
+  for (size_t i = 0; i < transaction.mutations.size(); i++) {
+    const HPMutation& mutation = transaction.mutations[i];
+    uint32_t ids[2] = {mutation.node, mutation.arg};
+    uint32_t idCount =
+        mutation.op == HPMutationInsertChild || mutation.op == HPMutationRemoveChild ? 2 : 1;
+    for (uint32_t j = 0; j < idCount; j++) {
+      uint32_t id = ids[j];
+      if (id >= nodeCount || nodes[id] == nullptr || isSaved[id]) {
+        continue;
+      }
+      isSaved[id] = true;
+      HPNodeRef node = nodes[id];
+      HPSavedNode state;
+      state.node = node;
+      state.style = node->getStyle();
+      state.styleDim[DimWidth] = node->styleDim[DimWidth];
+      state.styleDim[DimHeight] = node->styleDim[DimHeight];
+      for (uint32_t k = 0; k < node->childCount(); k++) {
+        state.children.push_back(node->getChild(k));
+      }
+      saved->push_back(state);
+    }
+  }
+}
+
+// every parent whose children changed is a saved node, so detaching all
+// children of saved and created nodes and inserting the saved children
+// again restores the tree.
+void HPLayoutService::restoreNodes(const std::vector<HPSavedNode>& saved, uint32_t nodeCount) {
+  for (size_t i = nodeCount; i < nodes.size(); i++) {
+    if (nodes[i] != nullptr) {
+      while (nodes[i]->childCount() > 0) {
+        nodes[i]->removeChild(0u);
+      }
+      if (nodes[i]->getParent() != nullptr) {
+        nodes[i]->getParent()->removeChild(nodes[i]);
+      }
+    }
+  }
+  for (size_t i = 0; i < saved.size(); i++) {
+    while (saved[i].node->childCount() > 0) {
+      saved[i].node->removeChild(0u);
+    }
+  }
+  for (size_t i = 0; i < saved.size(); i++) {
+    HPNodeRef node = saved[i].node;
+    for (size_t j = 0; j < saved[i].children.size(); j++) {
+      HPNodeRef child = saved[i].children[j];
+      if (child->getParent() != nullptr) {
+        child->getParent()->removeChild(child);
+      }
+      node->insertChild(child, static_cast<uint32_t>(j));
+    }
+    node->setStyle(saved[i].style);
+    node->styleDim[DimWidth] = saved[i].styleDim[DimWidth];
+    node->styleDim[DimHeight] = saved[i].styleDim[DimHeight];
+    node->markAsDirty();
+  }
+  // created nodes are in no tree any more.
+  for (size_t i = nodeCount; i < nodes.size(); i++) {
+    HPNodeFree(nodes[i]);
+  }
+  nodes.resize(nodeCount);
+}
+
+// only detached subtrees are freed, nodes in the tree are kept.
+void HPLayoutService::freeNode(HPNodeRef node) {
+  if (node->getParent() != nullptr) {
+    return;
+  }
+  forgetNodeIds(node);
+  HPNodeFreeRecursive(node);
+}
+
+void HPLayoutService::forgetNodeIds(HPNodeRef node) {
+  std::unordered_map<HPNodeRef, uint32_t>::iterator it = nodeIds.find(node);
+  if (it != nodeIds.end()) {
+    nodes[it->second] = nullptr;
+    nodeIds.erase(it);
+  }
+  for (uint32_t i = 0; i < node->childCount(); i++) {
+    forgetNodeIds(node->getChild(i));
+  }
+}
+
+std::shared_ptr<HPLayoutFrame> HPLayoutService::share(HPLayoutFrame* frame) {
+  HPLayoutFrameRecycler recycler = {pool};
+  return std::shared_ptr<HPLayoutFrame>(frame, recycler);
+}
+
+void HPLayoutService::fillFrame(HPLayoutFrame* frame) {
+  HPLayoutFrameRecord undefined = {VALUE_UNDEFINED, VALUE_UNDEFINED, VALUE_UNDEFINED,
+                                   VALUE_UNDEFINED};
+  frame->records.assign(nodes.size(), undefined);
+  fillRecords(nodes[0], frame);
+}
+
+void HPLayoutService::fillRecords(HPNodeRef node, HPLayoutFrame* frame) {
+  std::unordered_map<HPNodeRef, uint32_t>::iterator it = nodeIds.find(node);
+  if (it != nodeIds.end()) {
+    HPLayoutFrameRecord& record = frame->records[it->second];
+    record.left = node->result.position[CSSLeft];
+    record.top = node->result.position[CSSTop];
+    record.width = node->result.dim[DimWidth];
+    record.height = node->result.dim[DimHeight];
+  }
+  for (uint32_t i = 0; i < node->childCount(); i++) {
+    fillRecords(node->getChild(i), frame);
+  }
+}
@@ -0,0 +1,151 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "HPNode.h"
+#include "HPNodeMutation.h"
+
+// measure function and context of a node, a changed context means changed
+// content, e.g. new text, and marks the node dirty.
+typedef struct {
+  uint32_t node;
+  HPMeasureFunc measure;
+  void* context;
+} HPLayoutMeasureBinding;
+
+// changes of one transaction, applied in order: mutations, measure bindings,
+// then detached subtrees in freeNodes are freed. node ids are indexes of the
+// service's node table, node 0 is the root created by the service. new ids
+// must be below the table size plus the number of nodes created. a
+// transaction with an invalid mutation is dropped as a whole.
+typedef struct {
+  std::vector<HPMutation> mutations;
+  std::vector<HPLayoutMeasureBinding> measures;
+  std::vector<uint32_t> freeNodes;
+  float width;
+  float height;
+  HPDirection direction;
+} HPLayoutTransaction;
+
+// state of an existing node a transaction changes, see
+// HPLayoutService::saveNodes.
+typedef struct {
+  HPNodeRef node;
+  HPStyle style;
+  float styleDim[2];
+  std::vector<HPNodeRef> children;
+} HPSavedNode;
+
+// layout of a node relative to its parent, all NAN if the node is not in
+// the root's tree.
+typedef struct {
+  float left;
+  float top;
+  float width;
+  float height;
+} HPLayoutFrameRecord;
+
+// results of all nodes after the transactions up to version, immutable once
+// published.
+typedef struct {
+  uint64_t version;
+  std::vector<HPLayoutFrameRecord> records;
+} HPLayoutFrame;
+
+typedef std::shared_ptr<const HPLayoutFrame> HPLayoutFramePtr;
+
+/* Frames no reader holds any more, kept to be refilled. a published frame is
+ * handed back by the deleter of its last HPLayoutFramePtr, on the thread which
+ * drops it, or deleted if its service is gone. one frame is kept besides the
+ * front one, frames handed back while one is kept are deleted.
+ */
+class HPLayoutFramePool {
+ public:
+  HPLayoutFramePool();
+  virtual ~HPLayoutFramePool();
+  // a kept frame, or a new one if none is kept.
+  HPLayoutFrame* take();
+  void put(HPLayoutFrame* frame);
+
+ private:
+  std::mutex mutex;
+  HPLayoutFrame* kept;
+};
+
+/* Layout on a thread of its own. the tree is only touched by the service
+ * thread: callers submit transactions, the thread applies all pending ones,
+ * lays out once and publishes a new frame. readers hold the frame they got,
+ * which is never written again, so they see either the old or the new
+ * frame, never a mix. frames are double buffered, a frame is handed back
+ * to the service's HPLayoutFramePool when its last reader drops it, and is
+ * refilled instead of allocating a new one.
+ * measure functions are called on the service thread.
+ */
+class HPLayoutService {
+ public:
+  explicit HPLayoutService(void* layoutContext = nullptr);
+  virtual ~HPLayoutService();
+  // return version of the frame which includes the transaction.
+  uint64_t submit(const HPLayoutTransaction& transaction);
+  // latest published frame, version 0 and no records before the first.
+  HPLayoutFramePtr frame();
+  // block until a frame of version or later is published.
+  HPLayoutFramePtr waitForFrame(uint64_t version);
+
+ protected:
+  void run();
+  bool apply(const HPLayoutTransaction& transaction);
+  void saveNodes(const HPLayoutTransaction& transaction,
+                 uint32_t nodeCount,
+                 std::vector<HPSavedNode>* saved);
+  void restoreNodes(const std::vector<HPSavedNode>& saved, uint32_t nodeCount);
+  void freeNode(HPNodeRef node);
+  void forgetNodeIds(HPNodeRef node);
+  void fillRecords(HPNodeRef node, HPLayoutFrame* frame);
+  void fillFrame(HPLayoutFrame* frame);
+  std::shared_ptr<HPLayoutFrame> share(HPLayoutFrame* frame);
+
+ private:
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable pendingCondition;
+  std::condition_variable publishCondition;
+  std::deque<HPLayoutTransaction> pending;
+  uint64_t submittedVersion;
+  bool stopping;
+  std::shared_ptr<HPLayoutFramePool> pool;
+  std::shared_ptr<HPLayoutFrame> front;
+
+  // owned by the service thread
+  void* context;
+  std::vector<HPNodeRef> nodes;
+  std::unordered_map<HPNodeRef, uint32_t> nodeIds;
+  float width;
+  float height;
+  HPDirection direction;
+};
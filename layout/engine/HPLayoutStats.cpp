@@ -0,0 +1,48 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPLayoutStats.h"
+
+#include <string.h>
+
+void HPLayoutStatsReset(HPLayoutStats* stats) {
+  memset(stats, 0, sizeof(HPLayoutStats));
+}
+
+void HPLayoutStatsMerge(HPLayoutStats* stats, const HPLayoutStats* other) {
+  stats->visitCount += other->visitCount;
+  stats->layoutCount += other->layoutCount;
+  stats->measureWidthCount += other->measureWidthCount;
+  stats->measureHeightCount += other->measureHeightCount;
+  stats->newLayoutCount += other->newLayoutCount;
+  stats->measureFuncCount += other->measureFuncCount;
+  stats->layoutCacheHitCount += other->layoutCacheHitCount;
+  stats->layoutCacheMissCount += other->layoutCacheMissCount;
+  stats->measureCacheHitCount += other->measureCacheHitCount;
+  stats->measureCacheMissCount += other->measureCacheMissCount;
+  stats->measureCacheEvictCount += other->measureCacheEvictCount;
+  stats->fixedDimHitCount += other->fixedDimHitCount;
+  stats->sharedMeasureHitCount += other->sharedMeasureHitCount;
+  stats->batchMeasureCount += other->batchMeasureCount;
+  stats->batchMeasureHitCount += other->batchMeasureHitCount;
+  stats->windowedOutCount += other->windowedOutCount;
+  stats->appendLayoutCount += other->appendLayoutCount;
+  for (int i = 0; i < LayoutPhaseCount; i++) {
+    stats->phaseTime[i] += other->phaseTime[i];
+  }
+  stats->totalTime += other->totalTime;
+}
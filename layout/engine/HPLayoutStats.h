@@ -0,0 +1,75 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// steps of flex layout algorithm, time of each is recorded exclusive of
+// nested layouts and measure callbacks.
+typedef enum {
+  LayoutPhaseOther,           // cache lookup, available size, single node
+  LayoutPhaseFlexBasis,       // 3. flex base size of items
+  LayoutPhaseFlexLines,       // 4,5. container main size, collect flex lines
+  LayoutPhaseFlexibleLengths, // 6. resolve flexible lengths
+  LayoutPhaseCrossSize,       // 7-11. cross size of items and lines
+  LayoutPhaseMainAlign,       // 12. main axis alignment
+  LayoutPhaseCrossAlign,      // 13-16. cross axis alignment
+  LayoutPhaseFixedItems,      // absolute positioned items
+  LayoutPhaseMeasure,         // measure function callbacks
+  LayoutPhaseCount,
+} LayoutPhase;
+
+/* Statistics of one layout call, filled when a HPLayoutStats is passed to
+ * HPNodeDoLayout, it costs a branch per step when not passed.
+ * in parallel layout, counts and times of all threads are summed.
+ */
+typedef struct {
+  // layoutImpl invocations, by action
+  uint32_t visitCount;
+  uint32_t layoutCount;
+  uint32_t measureWidthCount;
+  uint32_t measureHeightCount;
+  // nodes with new layout result
+  uint32_t newLayoutCount;
+  uint32_t measureFuncCount;
+  // lookups in node's HPLayoutCache, by action, and measure results evicted
+  uint32_t layoutCacheHitCount;
+  uint32_t layoutCacheMissCount;
+  uint32_t measureCacheHitCount;
+  uint32_t measureCacheMissCount;
+  uint32_t measureCacheEvictCount;
+  // measure actions answered by fixed width or height
+  uint32_t fixedDimHitCount;
+  // measure results from HPMeasureCache
+  uint32_t sharedMeasureHitCount;
+  // requests resolved by HPBatchMeasureFunc before layout, and measures
+  // answered by them
+  uint32_t batchMeasureCount;
+  uint32_t batchMeasureHitCount;
+  // items out of a scroll window given an estimated size without layout
+  uint32_t windowedOutCount;
+  // containers whose appended items are laid out alone, by action
+  uint32_t appendLayoutCount;
+  // milliseconds, measure callback time is phaseTime[LayoutPhaseMeasure]
+  double phaseTime[LayoutPhaseCount];
+  double totalTime;
+} HPLayoutStats;
+
+void HPLayoutStatsReset(HPLayoutStats* stats);
+// add counts and times of other to stats.
+void HPLayoutStatsMerge(HPLayoutStats* stats, const HPLayoutStats* other);
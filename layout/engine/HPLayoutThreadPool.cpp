@@ -0,0 +1,184 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPLayoutThreadPool.h"
+
+#include "HPUtil.h"
+
+// pool and worker index of the current thread, nullptr for other threads.
+static thread_local HPLayoutThreadPool* currentPool = nullptr;
+static thread_local uint32_t currentWorker = 0;
+
+HPLayoutThreadPool::HPLayoutThreadPool(uint32_t threadCount, uint32_t minSubtreeNodes) {
+  minNodes = minSubtreeNodes;
+  nextQueue = 0;
+  queuedCount = 0;
+  stopping = false;
+  if (threadCount == 0) {
+    threadCount = 1;
+  }
+  for (uint32_t i = 0; i < threadCount; i++) {
+    queues.push_back(new TaskQueue());
+  }
+  for (uint32_t i = 0; i < threadCount; i++) {
+    threads.push_back(std::thread(&HPLayoutThreadPool::workerLoop, this, i));
+  }
+}
+
+HPLayoutThreadPool::~HPLayoutThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  sleepCondition.notify_all();
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+  threads.clear();
+  for (size_t i = 0; i < queues.size(); i++) {
+    ASSERT(queues[i]->tasks.empty());
+    delete queues[i];
+  }
+  queues.clear();
+}
+
+void HPLayoutThreadPool::submit(HPLayoutTaskBatch* batch, HPLayoutTask* tasks, uint32_t count) {
+  batch->tasks = tasks;
+  batch->remaining.store(count);
+  if (count == 0) {
+    return;
+  }
+
+  if (currentPool == this) {
+    // push to own deque, idle workers steal them.
+    TaskQueue* queue = queues[currentWorker];
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    for (uint32_t i = 0; i < count; i++) {
+      QueuedTask task = {batch, i};
+      queue->tasks.push_back(task);
+    }
+  } else {
+    for (uint32_t i = 0; i < count; i++) {
+      TaskQueue* queue = queues[nextQueue.fetch_add(1) % queues.size()];
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      QueuedTask task = {batch, i};
+      queue->tasks.push_back(task);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    queuedCount.fetch_add(count);
+  }
+  sleepCondition.notify_all();
+}
+
+void HPLayoutThreadPool::wait(HPLayoutTaskBatch* batch) {
+  QueuedTask task;
+  while (batch->remaining.load(std::memory_order_acquire) > 0 && takeTask(batch, task)) {
+    runTask(task);
+  }
+  // remaining tasks are running on other threads.
+  std::unique_lock<std::mutex> lock(doneMutex);
+  doneCondition.wait(lock, [batch]() {
+    return batch->remaining.load(std::memory_order_acquire) == 0;
+  });
+}
+
+uint32_t HPLayoutThreadPool::threadCount() {
+  return threads.size();
+}
+
+uint32_t HPLayoutThreadPool::minSubtreeNodes() {
+  return minNodes;
+}
+
+void HPLayoutThreadPool::workerLoop(uint32_t workerIndex) {
+  currentPool = this;
+  currentWorker = workerIndex;
+  while (true) {
+    QueuedTask task;
+    if (popTask(workerIndex, task) || stealTask(workerIndex, task)) {
+      runTask(task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    while (queuedCount.load() == 0 && !stopping) {
+      sleepCondition.wait(lock);
+    }
+    if (stopping && queuedCount.load() == 0) {
+      return;
+    }
+  }
+}
+
+bool HPLayoutThreadPool::popTask(uint32_t workerIndex, QueuedTask& task) {
+  TaskQueue* queue = queues[workerIndex];
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  if (queue->tasks.empty()) {
+    return false;
+  }
+  task = queue->tasks.back();
+  queue->tasks.pop_back();
+  queuedCount.fetch_sub(1);
+  return true;
+}
+
+bool HPLayoutThreadPool::stealTask(uint32_t workerIndex, QueuedTask& task) {
+  for (size_t i = 1; i <= queues.size(); i++) {
+    TaskQueue* queue = queues[(workerIndex + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->tasks.empty()) {
+      continue;
+    }
+    task = queue->tasks.front();
+    queue->tasks.pop_front();
+    queuedCount.fetch_sub(1);
+    return true;
+  }
+  return false;
+}
+
+// task of batch for a waiting thread, pool workers look at their own deque
+// first, nested batches are pushed to its back.
+bool HPLayoutThreadPool::takeTask(HPLayoutTaskBatch* batch, QueuedTask& task) {
+  uint32_t first = currentPool == this ? currentWorker : 0;
+  for (size_t i = 0; i < queues.size(); i++) {
+    TaskQueue* queue = queues[(first + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    for (size_t j = queue->tasks.size(); j > 0; j--) {
+      if (queue->tasks[j - 1].batch == batch) {
+        task = queue->tasks[j - 1];
+        queue->tasks.erase(queue->tasks.begin() + (j - 1));
+        queuedCount.fetch_sub(1);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void HPLayoutThreadPool::runTask(const QueuedTask& task) {
+  HPLayoutTask& layoutTask = task.batch->tasks[task.index];
+  layoutTask.func(layoutTask.data);
+  // the waiter may free the batch once remaining is 0, it's not read after.
+  if (task.batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    std::lock_guard<std::mutex> lock(doneMutex);
+    doneCondition.notify_all();
+  }
+}
@@ -0,0 +1,96 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// subtrees smaller than this are laid out on the calling thread.
+#define HP_PARALLEL_MIN_SUBTREE_NODES 64
+
+typedef void (*HPLayoutTaskFunc)(void* data);
+
+typedef struct {
+  HPLayoutTaskFunc func;
+  void* data;
+} HPLayoutTask;
+
+// tasks submitted together, wait() returns when all of them are done.
+typedef struct {
+  HPLayoutTask* tasks;
+  std::atomic<uint32_t> remaining;
+} HPLayoutTaskBatch;
+
+/* Work stealing thread pool for parallel layout of independent subtrees.
+ * every worker owns a task deque, pops its own tasks from the back and steals
+ * from the front of other workers' deques when empty.
+ * a thread waiting for a batch executes queued tasks of that batch meanwhile,
+ * so nested parallel layout inside a task never blocks a worker. tasks of
+ * other batches are never run by a waiter, they may be layouts of other trees
+ * which share the thread's layout scratch. once all tasks of the batch are
+ * taken, the waiter sleeps until they are done.
+ */
+class HPLayoutThreadPool {
+ public:
+  explicit HPLayoutThreadPool(uint32_t threadCount,
+                              uint32_t minSubtreeNodes = HP_PARALLEL_MIN_SUBTREE_NODES);
+  virtual ~HPLayoutThreadPool();
+  // tasks must stay alive until wait(batch) returns.
+  void submit(HPLayoutTaskBatch* batch, HPLayoutTask* tasks, uint32_t count);
+  void wait(HPLayoutTaskBatch* batch);
+  uint32_t threadCount();
+  uint32_t minSubtreeNodes();
+
+ protected:
+  typedef struct {
+    HPLayoutTaskBatch* batch;
+    uint32_t index;
+  } QueuedTask;
+
+  typedef struct {
+    std::mutex mutex;
+    std::deque<QueuedTask> tasks;
+  } TaskQueue;
+
+  void workerLoop(uint32_t workerIndex);
+  bool popTask(uint32_t workerIndex, QueuedTask& task);
+  bool stealTask(uint32_t workerIndex, QueuedTask& task);
+  bool takeTask(HPLayoutTaskBatch* batch, QueuedTask& task);
+  void runTask(const QueuedTask& task);
+
+ private:
+  std::vector<TaskQueue*> queues;
+  std::vector<std::thread> threads;
+  uint32_t minNodes;
+  // next queue for tasks submitted by threads out of this pool
+  std::atomic<uint32_t> nextQueue;
+  // tasks in queues, workers sleep when it's zero
+  std::atomic<uint32_t> queuedCount;
+  std::mutex sleepMutex;
+  std::condition_variable sleepCondition;
+  bool stopping;
+  // notified when the last task of a batch is done.
+  std::mutex doneMutex;
+  std::condition_variable doneCondition;
+};
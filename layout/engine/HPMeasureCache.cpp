@@ -0,0 +1,157 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPMeasureCache.h"
+
+#include <string.h>
+
+static uint32_t floatBits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+size_t HPMeasureCache::KeyHash::operator()(const HPMeasureCacheKey& key) const {
+  uint64_t hash = key.contentKey * 0x9E3779B97F4A7C15ull;
+  hash ^= (static_cast<uint64_t>(floatBits(key.width)) << 32) | floatBits(key.height);
+  hash ^= static_cast<uint64_t>(key.widthMeasureMode) << 4 | key.heightMeasureMode;
+  hash ^= hash >> 29;
+  return static_cast<size_t>(hash);
+}
+
+bool HPMeasureCache::KeyEqual::operator()(const HPMeasureCacheKey& a,
+                                          const HPMeasureCacheKey& b) const {
+  return a.contentKey == b.contentKey && floatBits(a.width) == floatBits(b.width) &&
+         floatBits(a.height) == floatBits(b.height) &&
+         a.widthMeasureMode == b.widthMeasureMode && a.heightMeasureMode == b.heightMeasureMode;
+}
+
+HPMeasureCache::HPMeasureCache(uint32_t capacity) {
+  maxSize = capacity;
+  hits = 0;
+  misses = 0;
+  evicts = 0;
+}
+
+HPMeasureCache::~HPMeasureCache() {}
+
+// at namespace scope, not function local, since it's first reached from
+// layout threads and android builds with -fno-threadsafe-statics.
+static HPMeasureCache gSharedMeasureCache;
+
+HPMeasureCache* HPMeasureCache::shared() {
+  return &gSharedMeasureCache;
+}
+
+// available size is not used by measure when its mode is undefined,
+// and may be undefined (NAN) which never equals itself.
+HPMeasureCacheKey HPMeasureCache::makeKey(uint64_t contentKey,
+                                          float width,
+                                          MeasureMode widthMeasureMode,
+                                          float height,
+                                          MeasureMode heightMeasureMode) {
+  HPMeasureCacheKey key;
+  key.contentKey = contentKey;
+  key.width = widthMeasureMode == MeasureModeUndefined ? 0.0f : width;
+  key.height = heightMeasureMode == MeasureModeUndefined ? 0.0f : height;
+  key.widthMeasureMode = widthMeasureMode;
+  key.heightMeasureMode = heightMeasureMode;
+  return key;
+}
+
+bool HPMeasureCache::get(uint64_t contentKey,
+                         float width,
+                         MeasureMode widthMeasureMode,
+                         float height,
+                         MeasureMode heightMeasureMode,
+                         HPSize& size) {
+  HPMeasureCacheKey key =
+      makeKey(contentKey, width, widthMeasureMode, height, heightMeasureMode);
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = index.find(key);
+  if (it == index.end()) {
+    misses++;
+    return false;
+  }
+  hits++;
+  // move to front as most recently used.
+  entries.splice(entries.begin(), entries, it->second);
+  size = it->second->size;
+  return true;
+}
+
+void HPMeasureCache::put(uint64_t contentKey,
+                         float width,
+                         MeasureMode widthMeasureMode,
+                         float height,
+                         MeasureMode heightMeasureMode,
+                         HPSize size) {
+  HPMeasureCacheKey key =
+      makeKey(contentKey, width, widthMeasureMode, height, heightMeasureMode);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (maxSize == 0) {
+    return;
+  }
+  auto it = index.find(key);
+  if (it != index.end()) {
+    it->second->size = size;
+    entries.splice(entries.begin(), entries, it->second);
+    return;
+  }
+  Entry entry = {key, size};
+  entries.push_front(entry);
+  index[key] = entries.begin();
+  evictIfNeeded();
+}
+
+void HPMeasureCache::evictIfNeeded() {
+  while (entries.size() > maxSize) {
+    index.erase(entries.back().key);
+    entries.pop_back();
+    evicts++;
+  }
+}
+
+void HPMeasureCache::invalidate() {
+  std::lock_guard<std::mutex> lock(mutex);
+  entries.clear();
+  index.clear();
+}
+
+void HPMeasureCache::setCapacity(uint32_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex);
+  maxSize = capacity;
+  evictIfNeeded();
+}
+
+HPMeasureCacheStats HPMeasureCache::stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  HPMeasureCacheStats result;
+  result.size = static_cast<uint32_t>(entries.size());
+  result.capacity = maxSize;
+  result.hitCount = hits;
+  result.missCount = misses;
+  result.evictCount = evicts;
+  return result;
+}
+
+void HPMeasureCache::resetStats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  hits = 0;
+  misses = 0;
+  evicts = 0;
+}
@@ -0,0 +1,106 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "Flex.h"
+
+#define HP_MEASURE_CACHE_DEFAULT_CAPACITY 512
+
+typedef struct {
+  uint64_t contentKey;
+  // width or height is 0 when its measure mode is undefined.
+  float width;
+  float height;
+  MeasureMode widthMeasureMode;
+  MeasureMode heightMeasureMode;
+} HPMeasureCacheKey;
+
+typedef struct {
+  uint32_t size;
+  uint32_t capacity;
+  uint64_t hitCount;
+  uint64_t missCount;
+  uint64_t evictCount;
+} HPMeasureCacheStats;
+
+/* Measure results shared by all nodes, keyed by a content key supplied by
+ * the caller (see HPNodeSetMeasureCacheKey) plus measure constraints.
+ * nodes with equal content key must measure to the same size, e.g. the key
+ * of text node is hash of text and font style.
+ * least recently used results are evicted when capacity is reached,
+ * invalidate() drops all results, e.g. when font scale changes.
+ */
+class HPMeasureCache {
+ public:
+  explicit HPMeasureCache(uint32_t capacity = HP_MEASURE_CACHE_DEFAULT_CAPACITY);
+  virtual ~HPMeasureCache();
+  static HPMeasureCache* shared();
+
+  bool get(uint64_t contentKey,
+           float width,
+           MeasureMode widthMeasureMode,
+           float height,
+           MeasureMode heightMeasureMode,
+           HPSize& size);
+  void put(uint64_t contentKey,
+           float width,
+           MeasureMode widthMeasureMode,
+           float height,
+           MeasureMode heightMeasureMode,
+           HPSize size);
+  void invalidate();
+  void setCapacity(uint32_t capacity);
+  HPMeasureCacheStats stats();
+  void resetStats();
+
+ protected:
+  typedef struct {
+    HPMeasureCacheKey key;
+    HPSize size;
+  } Entry;
+
+  struct KeyHash {
+    size_t operator()(const HPMeasureCacheKey& key) const;
+  };
+  struct KeyEqual {
+    bool operator()(const HPMeasureCacheKey& a, const HPMeasureCacheKey& b) const;
+  };
+
+  HPMeasureCacheKey makeKey(uint64_t contentKey,
+                            float width,
+                            MeasureMode widthMeasureMode,
+                            float height,
+                            MeasureMode heightMeasureMode);
+  void evictIfNeeded();
+
+ private:
+  std::mutex mutex;
+  // most recently used at front
+  std::list<Entry> entries;
+  std::unordered_map<HPMeasureCacheKey, std::list<Entry>::iterator, KeyHash, KeyEqual> index;
+  uint32_t maxSize;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evicts;
+};
@@ -21,6 +21,9 @@
 
 #include <algorithm>
 #include <string>
+#include <utility>
+
+#include "HPResumableLayout.h"
 
 // the layout progress refers
 // https://www.w3.org/TR/css-flexbox-1/#layout-algorithm
@@ -47,9 +50,18 @@ void HPNode::printNode(uint32_t indent) {
   std::string indentStr = getIndentString(indent);
   std::string startStr;
   startStr = indentStr + "<div layout=\"width:%s; height:%s; left:%s; top:%s;\" style=\"%s\">\n";
+  // width and height are not part of interned style
+  std::string styleStr;
+  if (isDefined(styleDim[DimWidth])) {
+    styleStr += "width:" + toString(styleDim[DimWidth]) + "; ";
+  }
+  if (isDefined(styleDim[DimHeight])) {
+    styleStr += "height:" + toString(styleDim[DimHeight]) + "; ";
+  }
+  styleStr += style->toString();
   HPLogd(startStr.c_str(), toString(result.dim[0]).c_str(), toString(result.dim[1]).c_str(),
          toString(result.position[0]).c_str(), toString(result.position[1]).c_str(),
-         style.toString().c_str());
+         styleStr.c_str());
 
   std::vector<HPNodeRef>& items = children;
   for (size_t i = 0; i < items.size(); i++) {
@@ -64,12 +76,56 @@ HPNode::HPNode() {
   context = nullptr;
   parent = nullptr;
   measure = nullptr;
+  measureCacheKey = 0;
   dirtiedFunc = nullptr;
+  arena = nullptr;
+  subtreeWeight = 0;
+  boundaryInput = nullptr;
+  appendInput = nullptr;
+  scrollWindow = nullptr;
+  isWindowedOut = false;
+  styleDim[DimWidth] = VALUE_UNDEFINED;
+  styleDim[DimHeight] = VALUE_UNDEFINED;
+  result.edges = nullptr;
 
   initLayoutResult();
   inInitailState = true;
 }
 
+HPNode::HPNode(HPNode &&node)
+    : style(node.style),
+      result(node.result),
+      children(std::move(node.children)),
+      layoutCache(node.layoutCache) {
+  styleDim[DimWidth] = node.styleDim[DimWidth];
+  styleDim[DimHeight] = node.styleDim[DimHeight];
+  context = node.context;
+  parent = node.parent;
+  measure = node.measure;
+  measureCacheKey = node.measureCacheKey;
+  arena = node.arena;
+  subtreeWeight = node.subtreeWeight;
+  boundaryInput = node.boundaryInput;
+  appendInput = node.appendInput;
+  scrollWindow = node.scrollWindow;
+  isFrozen = node.isFrozen;
+  isWindowedOut = node.isWindowedOut;
+  isDirty = node.isDirty;
+  hasDirtyDescendant = node.hasDirtyDescendant;
+  _hasNewLayout = node._hasNewLayout;
+  dirtiedFunc = node.dirtiedFunc;
+  inInitailState = node.inInitailState;
+  memcpy(unroundedLayout, node.unroundedLayout, sizeof(unroundedLayout));
+  isLayoutRounded = node.isLayoutRounded;
+
+  node.children.clear();
+  node.parent = nullptr;
+  node.result.edges = nullptr;
+  node.boundaryInput = nullptr;
+  node.appendInput = nullptr;
+  node.scrollWindow = nullptr;
+}
+
 HPNode::~HPNode() {
   // remove from parent
   if (parent != nullptr) {
@@ -86,26 +142,38 @@ HPNode::~HPNode() {
   }
 
   children.clear();
+  delete result.edges;
+  result.edges = nullptr;
+  delete boundaryInput;
+  boundaryInput = nullptr;
+  delete appendInput;
+  appendInput = nullptr;
+  delete scrollWindow;
+  scrollWindow = nullptr;
 }
 
 void HPNode::initLayoutResult() {
-#ifdef LAYOUT_TIME_ANALYZE
-  fetchCount = 0;
-#endif
   isFrozen = false;
   isDirty = true;
+  hasDirtyDescendant = false;
   _hasNewLayout = false;
   result.dim[DimWidth] = 0;
   result.dim[DimHeight] = 0;
 
   memset(reinterpret_cast<void*>(result.position), 0, sizeof(float) * 4);
   memset(reinterpret_cast<void*>(result.cachedPosition), 0, sizeof(float) * 4);
-  memset(reinterpret_cast<void*>(result.margin), 0, sizeof(float) * 4);
-  memset(reinterpret_cast<void*>(result.padding), 0, sizeof(float) * 4);
-  memset(reinterpret_cast<void*>(result.border), 0, sizeof(float) * 4);
+  // edge results are zero when not allocated
+  delete result.edges;
+  result.edges = nullptr;
 
   result.hadOverflow = false;
   result.direction = DirectionInherit;
+  isLayoutRounded = false;
+  // not a layout boundary until laid out again.
+  delete boundaryInput;
+  boundaryInput = nullptr;
+  delete appendInput;
+  appendInput = nullptr;
 }
 
 bool HPNode::reset() {
@@ -118,7 +186,7 @@ bool HPNode::reset() {
   return true;
 }
 
-void HPNode::resetLayoutRecursive(bool isDisplayNone) {
+void HPNode::resetLayoutRecursive(bool isDisplayNone, HPLayoutScratch* scratch) {
   if (inInitailState && isDisplayNone) {
     return;
   }
@@ -132,7 +200,7 @@ void HPNode::resetLayoutRecursive(bool isDisplayNone) {
     inInitailState = true;  // prevent resetLayoutRecursive run many times in recursive
     // in DisplayNone state, set hasNewLayout as true;
     // set dirty false;
-    setHasNewLayout(true);
+    markNewLayout(scratch);
     setDirty(false);
   }
   // if just because parent's display type change,
@@ -140,16 +208,16 @@ void HPNode::resetLayoutRecursive(bool isDisplayNone) {
   layoutCache.clearCache();
   for (size_t i = 0; i < children.size(); i++) {
     HPNodeRef item = children[i];
-    item->resetLayoutRecursive(isDisplayNone);
+    item->resetLayoutRecursive(isDisplayNone, scratch);
   }
 }
 
-HPStyle HPNode::getStyle() {
-  return style;
+const HPStyle& HPNode::getStyle() {
+  return style.get();
 }
 
 void HPNode::setStyle(const HPStyle& st) {
-  style = st;
+  style.set(st);
   // TODO(ianwang): layout if needed???
 }
 
@@ -164,7 +232,14 @@ bool HPNode::setMeasureFunc(HPMeasureFunc _measure) {
   }
 
   measure = _measure;
-  style.nodeType = _measure ? NodeTypeText : NodeTypeDefault;
+  NodeType nodeType = _measure ? NodeTypeText : NodeTypeDefault;
+  updateStyle([nodeType](HPStyle& st) {
+    if (st.nodeType == nodeType) {
+      return false;
+    }
+    st.nodeType = nodeType;
+    return true;
+  });
   markAsDirty();
   return true;
 }
@@ -183,7 +258,7 @@ void HPNode::addChild(HPNodeRef item) {
   }
   item->setParent(this);
   children.push_back(item);
-  markAsDirty();
+  markContentDirty(item);
 }
 
 bool HPNode::insertChild(HPNodeRef item, uint32_t index) {
@@ -193,7 +268,7 @@ bool HPNode::insertChild(HPNodeRef item, uint32_t index) {
   }
   item->setParent(this);
   children.insert(children.begin() + index, item);
-  markAsDirty();
+  markContentDirty(item);
   return true;
 }
 
@@ -209,8 +284,8 @@ bool HPNode::removeChild(HPNodeRef child) {
   if (p != children.end()) {
     children.erase(p);
     child->setParent(nullptr);
-    child->resetLayoutRecursive(false);
-    markAsDirty();
+    child->resetLayoutRecursive(false, nullptr);
+    markContentDirty();
     return true;
   }
   return false;
@@ -223,10 +298,10 @@ bool HPNode::removeChild(uint32_t index) {
   HPNodeRef child = getChild(index);
   if (child != nullptr) {
     child->setParent(nullptr);
-    child->resetLayoutRecursive(false);
+    child->resetLayoutRecursive(false, nullptr);
   }
   children.erase(children.begin() + index);
-  markAsDirty();
+  markContentDirty();
   return true;
 }
 
@@ -235,26 +310,99 @@ uint32_t HPNode::childCount() {
 }
 
 void HPNode::setDisplayType(DisplayType displayType) {
-  if (style.displayType == displayType)
+  if (style->displayType == displayType)
     return;
-  style.displayType = displayType;
-  isDirty = false;  // force following markAsDirty did effect to its parent
+  updateStyle([displayType](HPStyle& st) {
+    st.displayType = displayType;
+    return true;
+  });
   markAsDirty();
 }
 
+// style of this node changed, its size may change, so its parent is always
+// dirtied, even if this node is a layout boundary which is already dirty.
 void HPNode::markAsDirty() {
-  if (!isDirty) {
-    setDirty(true);
+  setDirty(true);
+  invalidateAppendPasses(nullptr);
+  if (parent) {
+    parent->markContentDirty(this);
+  }
+}
+
+// children or measured content of this node changed, item is the child
+// changed or inserted, nullptr if not known.
+// dirty is propagated to ancestors until a layout boundary, whose size can't
+// be changed by its descendants, ancestors above it only remember that they
+// have a dirty boundary to layout, see layoutDirtyBoundaries.
+void HPNode::markContentDirty(HPNodeRef item) {
+  invalidateAppendPasses(item);
+  if (isDirty) {
+    return;
+  }
+  setDirty(true);
+  if (parent == nullptr) {
+    return;
+  }
+  if (isLayoutBoundary()) {
+    parent->markHasDirtyDescendant();
+  } else {
+    parent->markContentDirty(this);
+  }
+}
+
+// passes are kept if item is appended after them, it's laid out alone then.
+void HPNode::invalidateAppendPasses(HPNodeRef item) {
+  if (appendInput == nullptr) {
+    return;
+  }
+  for (size_t i = 0; i < 3; i++) {
+    HPAppendPass& pass = appendInput->passes[i];
+    if (pass.valid && (item == nullptr || pass.itemCount > children.size() ||
+                       std::find(children.begin() + pass.itemCount, children.end(), item) ==
+                           children.end())) {
+      pass.valid = false;
+    }
+  }
+}
+
+void HPNode::markHasDirtyDescendant() {
+  if (!hasDirtyDescendant) {
+    hasDirtyDescendant = true;
     if (parent) {
-      parent->markAsDirty();
+      parent->markHasDirtyDescendant();
     }
   }
 }
 
+// size of a layout boundary only depends on its style and inputs from its
+// parent, the inputs of its last layout are kept to layout it alone.
+bool HPNode::isLayoutBoundary() {
+  return parent != nullptr && boundaryInput != nullptr && isDefined(styleDim[DimWidth]) &&
+         isDefined(styleDim[DimHeight]);
+}
+
+bool HPNode::needsLayout() {
+  return isDirty || hasDirtyDescendant;
+}
+
 void HPNode::setHasNewLayout(bool hasNewLayoutOrNot) {
   _hasNewLayout = hasNewLayoutOrNot;
 }
 
+// new layouts of an unfinished resumable layout are kept until it's
+// finished, so readers don't take partial results of the tree.
+void HPNode::markNewLayout(HPLayoutScratch* scratch) {
+  if (_hasNewLayout) {
+    return;
+  }
+  HPResumableLayout* resumable = scratch->resumableLayout();
+  if (resumable != nullptr) {
+    resumable->deferNewLayout(this);
+    return;
+  }
+  _hasNewLayout = true;
+}
+
 bool HPNode::hasNewLayout() {
   return _hasNewLayout;
 }
@@ -313,8 +461,24 @@ float HPNode::getLayoutDim(FlexDirection axis) {
   return result.dim[axisDim[axis]];
 }
 
+float HPNode::getStyleDim(FlexDirection axis) {
+  return styleDim[axisDim[axis]];
+}
+
+void HPNode::setStyleDim(FlexDirection axis, float value) {
+  styleDim[axisDim[axis]] = value;
+}
+
+void HPNode::setStyleDim(Dimension dimension, float value) {
+  styleDim[dimension] = value;
+}
+
+bool HPNode::isStyleDimensionAuto(FlexDirection axis) {
+  return isUndefined(styleDim[axisDim[axis]]);
+}
+
 float HPNode::getMainAxisDim() {
-  FlexDirection mainAxis = style.flexDirection;
+  FlexDirection mainAxis = style->flexDirection;
   if (!isLayoutDimDefined(mainAxis)) {
     return VALUE_UNDEFINED;
   }
@@ -322,51 +486,78 @@ float HPNode::getMainAxisDim() {
 }
 
 float HPNode::getStartBorder(FlexDirection axis) {
-  return style.getStartBorder(axis);
+  return style.edges(axis).startBorder;
 }
 
 float HPNode::getEndBorder(FlexDirection axis) {
-  return style.getEndBorder(axis);
+  return style.edges(axis).endBorder;
 }
 
 float HPNode::getStartPaddingAndBorder(FlexDirection axis) {
-  return style.getStartPadding(axis) + style.getStartBorder(axis);
+  return style.edges(axis).startPaddingAndBorder;
 }
 
 float HPNode::getEndPaddingAndBorder(FlexDirection axis) {
-  return style.getEndPadding(axis) + style.getEndBorder(axis);
+  return style.edges(axis).endPaddingAndBorder;
 }
 
 float HPNode::getPaddingAndBorder(FlexDirection axis) {
-  return getStartPaddingAndBorder(axis) + getEndPaddingAndBorder(axis);
+  return style.edges(axis).paddingAndBorder;
 }
 
 float HPNode::getStartMargin(FlexDirection axis) {
-  return style.getStartMargin(axis);
+  return style.edges(axis).startMargin;
 }
 
 float HPNode::getEndMargin(FlexDirection axis) {
-  return style.getEndMargin(axis);
+  return style.edges(axis).endMargin;
 }
 
 float HPNode::getMargin(FlexDirection axis) {
-  return style.getStartMargin(axis) + style.getEndMargin(axis);
+  return style.edges(axis).margin;
 }
 
 bool HPNode::isAutoStartMargin(FlexDirection axis) {
-  return style.isAutoStartMargin(axis);
+  return style.edges(axis).autoStartMargin;
 }
 
 bool HPNode::isAutoEndMargin(FlexDirection axis) {
-  return style.isAutoEndMargin(axis);
+  return style.edges(axis).autoEndMargin;
+}
+
+HPLayoutEdges* HPNode::layoutEdges() {
+  if (result.edges == nullptr) {
+    result.edges = new HPLayoutEdges();
+  }
+  return result.edges;
 }
 
 void HPNode::setLayoutStartMargin(FlexDirection axis, float value) {
-  result.margin[axisStart[axis]] = value;
+  if (result.edges == nullptr && value == 0) {
+    return;
+  }
+  layoutEdges()->margin[axisStart[axis]] = value;
 }
 
 void HPNode::setLayoutEndMargin(FlexDirection axis, float value) {
-  result.margin[axisEnd[axis]] = value;
+  if (result.edges == nullptr && value == 0) {
+    return;
+  }
+  layoutEdges()->margin[axisEnd[axis]] = value;
+}
+
+void HPNode::setLayoutPadding(CSSDirection dir, float value) {
+  if (result.edges == nullptr && value == 0) {
+    return;
+  }
+  layoutEdges()->padding[dir] = value;
+}
+
+void HPNode::setLayoutBorder(CSSDirection dir, float value) {
+  if (result.edges == nullptr && value == 0) {
+    return;
+  }
+  layoutEdges()->border[dir] = value;
 }
 
 inline float HPNode::getLayoutMargin(FlexDirection axis) {
@@ -374,11 +565,19 @@ inline float HPNode::getLayoutMargin(FlexDirection axis) {
 }
 
 float HPNode::getLayoutStartMargin(FlexDirection axis) {
-  return isDefined(result.margin[axisStart[axis]]) ? result.margin[axisStart[axis]] : 0;
+  if (result.edges == nullptr) {
+    return 0;
+  }
+  float value = result.edges->margin[axisStart[axis]];
+  return isDefined(value) ? value : 0;
 }
 
 float HPNode::getLayoutEndMargin(FlexDirection axis) {
-  return isDefined(result.margin[axisEnd[axis]]) ? result.margin[axisEnd[axis]] : 0;
+  if (result.edges == nullptr) {
+    return 0;
+  }
+  float value = result.edges->margin[axisEnd[axis]];
+  return isDefined(value) ? value : 0;
 }
 
 /* If both axisStart and axisEnd are defined,
@@ -389,42 +588,49 @@ float HPNode::getLayoutEndMargin(FlexDirection axis) {
  * 		  false get relative value for axis end
  */
 float HPNode::resolveRelativePosition(FlexDirection axis, bool forAxisStart) {
-  if (style.positionType != PositionTypeRelative) {
+  if (style->positionType != PositionTypeRelative) {
     return 0.0f;
   }
 
-  if (isDefined(style.getStartPosition(axis))) {
-    float value = style.getStartPosition(axis);
+  const HPResolvedEdges& edges = style.edges(axis);
+  if (isDefined(edges.startPosition)) {
+    float value = edges.startPosition;
     return forAxisStart ? value : -value;
-  } else if (isDefined(style.getEndPosition(axis))) {
-    float value = style.getEndPosition(axis);
+  } else if (isDefined(edges.endPosition)) {
+    float value = edges.endPosition;
     return forAxisStart ? -value : value;
   }
 
   return 0.0f;
 }
 
-void HPNode::setLayoutStartPosition(FlexDirection axis, float value, bool addRelativePosition) {
-  if (addRelativePosition && style.positionType == PositionTypeRelative) {
+void HPNode::setLayoutStartPosition(FlexDirection axis,
+                                    float value,
+                                    HPLayoutScratch* scratch,
+                                    bool addRelativePosition) {
+  if (addRelativePosition && style->positionType == PositionTypeRelative) {
     value += resolveRelativePosition(axis, true);
   }
 
   if (!FloatIsEqual(result.cachedPosition[axisStart[axis]], value)) {
     result.cachedPosition[axisStart[axis]] = value;
-    setHasNewLayout(true);
+    markNewLayout(scratch);
   }
 
   result.position[axisStart[axis]] = value;
 }
 
-void HPNode::setLayoutEndPosition(FlexDirection axis, float value, bool addRelativePosition) {
-  if (addRelativePosition && style.positionType == PositionTypeRelative) {
+void HPNode::setLayoutEndPosition(FlexDirection axis,
+                                  float value,
+                                  HPLayoutScratch* scratch,
+                                  bool addRelativePosition) {
+  if (addRelativePosition && style->positionType == PositionTypeRelative) {
     value += resolveRelativePosition(axis, false);
   }
 
   if (!FloatIsEqual(result.cachedPosition[axisEnd[axis]], value)) {
     result.cachedPosition[axisEnd[axis]] = value;
-    setHasNewLayout(true);
+    markNewLayout(scratch);
   }
 
   result.position[axisEnd[axis]] = value;
@@ -441,7 +647,7 @@ float HPNode::getLayoutEndPosition(FlexDirection axis) {
 // calculate main axis by refer this node's flex direction
 // and layout direction which resolved in resolveDirection.
 FlexDirection HPNode::resolveMainAxis() {
-  FlexDirection mainAxis = style.flexDirection;
+  FlexDirection mainAxis = style->flexDirection;
   HPDirection direction = getLayoutDirection();
   if (direction == DirectionRTL) {
     if (mainAxis == FLexDirectionRow) {
@@ -459,17 +665,17 @@ FlexDirection HPNode::resolveMainAxis() {
  * to determine cross start & cross end
  */
 FlexDirection HPNode::resolveCrossAxis() {
-  FlexDirection mainAxis = style.flexDirection;
+  FlexDirection mainAxis = style->flexDirection;
   FlexDirection crossAxis;
   // cross axis's direction rely on flex wrap mode.
   if (isRowDirection(mainAxis)) {
-    if (style.flexWrap == FlexWrapReverse) {
+    if (style->flexWrap == FlexWrapReverse) {
       crossAxis = FLexDirectionColumnReverse;
     } else {
       crossAxis = FLexDirectionColumn;
     }
   } else {
-    if (style.flexWrap == FlexWrapReverse) {
+    if (style->flexWrap == FlexWrapReverse) {
       crossAxis = FLexDirectionRowReverse;
     } else {
       crossAxis = FLexDirectionRow;
@@ -490,15 +696,15 @@ FlexDirection HPNode::resolveCrossAxis() {
 
 FlexAlign HPNode::getNodeAlign(HPNodeRef item) {
   ASSERT(item != nullptr);
-  if (item->style.alignSelf == FlexAlignAuto) {
-    return style.alignItems;
+  if (item->style->alignSelf == FlexAlignAuto) {
+    return style->alignItems;
   }
-  return item->style.alignSelf;
+  return item->style->alignSelf;
 }
 
 float HPNode::boundAxis(FlexDirection axis, float value) {
-  float min = style.minDim[axisDim[axis]];
-  float max = style.maxDim[axisDim[axis]];
+  float min = style->minDim[axisDim[axis]];
+  float max = style->maxDim[axisDim[axis]];
   float boundValue = value;
   if (!isUndefined(max) && max >= 0.0 && boundValue > max) {
     boundValue = max;
@@ -510,9 +716,9 @@ float HPNode::boundAxis(FlexDirection axis, float value) {
 }
 
 inline HPDirection HPNode::resolveDirection(HPDirection parentDirection) {
-  return style.direction == DirectionInherit
+  return style->direction == DirectionInherit
              ? (parentDirection > DirectionInherit ? parentDirection : DirectionLTR)
-             : style.direction;
+             : style->direction;
 }
 
 // called after resolveDirection
@@ -522,77 +728,143 @@ void HPNode::resolveStyleValues() {
   //  }
   FlexDirection mainAxis = resolveMainAxis();
   FlexDirection crossAxis = resolveCrossAxis();
+  const HPResolvedEdges& mainEdges = style.edges(mainAxis);
+  const HPResolvedEdges& crossEdges = style.edges(crossAxis);
   // set layout margin value
   // auto margins are treated as zero. may be modified during layout process
-  setLayoutStartMargin(mainAxis, getStartMargin(mainAxis));
-  setLayoutEndMargin(mainAxis, getEndMargin(mainAxis));
-  setLayoutStartMargin(crossAxis, getStartMargin(crossAxis));
-  setLayoutEndMargin(crossAxis, getEndMargin(crossAxis));
+  setLayoutStartMargin(mainAxis, mainEdges.startMargin);
+  setLayoutEndMargin(mainAxis, mainEdges.endMargin);
+  setLayoutStartMargin(crossAxis, crossEdges.startMargin);
+  setLayoutEndMargin(crossAxis, crossEdges.endMargin);
 
   // set layout padding value
-  result.padding[axisStart[mainAxis]] = style.getStartPadding(mainAxis);
-  result.padding[axisEnd[mainAxis]] = style.getEndPadding(mainAxis);
-  result.padding[axisStart[crossAxis]] = style.getStartPadding(crossAxis);
-  result.padding[axisEnd[crossAxis]] = style.getEndPadding(crossAxis);
+  setLayoutPadding(axisStart[mainAxis], mainEdges.startPadding);
+  setLayoutPadding(axisEnd[mainAxis], mainEdges.endPadding);
+  setLayoutPadding(axisStart[crossAxis], crossEdges.startPadding);
+  setLayoutPadding(axisEnd[crossAxis], crossEdges.endPadding);
 
   // set layout border value;
-  result.border[axisStart[mainAxis]] = style.getStartBorder(mainAxis);
-  result.border[axisEnd[mainAxis]] = style.getEndBorder(mainAxis);
-  result.border[axisStart[crossAxis]] = style.getStartBorder(crossAxis);
-  result.border[axisEnd[crossAxis]] = style.getEndBorder(crossAxis);
+  setLayoutBorder(axisStart[mainAxis], mainEdges.startBorder);
+  setLayoutBorder(axisEnd[mainAxis], mainEdges.endBorder);
+  setLayoutBorder(axisStart[crossAxis], crossEdges.startBorder);
+  setLayoutBorder(axisEnd[crossAxis], crossEdges.endBorder);
 }
 
-#ifdef LAYOUT_TIME_ANALYZE
-static int layoutCount = 0;
-static int layoutCacheCount = 0;
-static int measureCount = 0;
-static int measureCacheCount = 0;
-#endif
-
 void HPNode::layout(float parentWidth,
                     float parentHeight,
                     HPDirection parentDirection,
                     void* layoutContext) {
-#ifdef LAYOUT_TIME_ANALYZE
-  layoutCount = 0;
-  layoutCacheCount = 0;
-  measureCount = 0;
-  measureCacheCount = 0;
-#endif
-  if (isUndefined(style.flexBasis) && !isUndefined(style.dim[axisDim[style.flexDirection]])) {
-    style.flexBasis = style.dim[axisDim[style.flexDirection]];
+  layout(parentWidth, parentHeight, parentDirection, layoutContext, HPLayoutOptions());
+}
+
+void HPNode::layout(float parentWidth,
+                    float parentHeight,
+                    HPDirection parentDirection,
+                    void* layoutContext,
+                    const HPLayoutOptions& options) {
+  HPLayoutStats* stats = options.stats;
+  HPLayoutThreadPool* threadPool = options.threadPool;
+  HPBatchMeasureFunc batchMeasure = options.batchMeasure;
+  HPLayoutThreadPool* measurePool = options.measurePool;
+  double startTime = 0;
+  if (stats != nullptr) {
+    HPLayoutStatsReset(stats);
+    startTime = HPLayoutScratch::now();
+  }
+  if (isUndefined(style->flexBasis) && !isUndefined(styleDim[axisDim[style->flexDirection]])) {
+    float flexBasis = styleDim[axisDim[style->flexDirection]];
+    updateStyle([flexBasis](HPStyle& st) {
+      st.flexBasis = flexBasis;
+      return true;
+    });
   }
 
   // if container not set itself width and parent width is set,
   // set container width  as parentWidth subtract margin
   bool styleWidthReset = false;
-  if (isUndefined(style.dim[DimWidth]) && isDefined(parentWidth)) {
+  if (isUndefined(styleDim[DimWidth]) && isDefined(parentWidth)) {
     float containerWidth = parentWidth - getMargin(FLexDirectionRow);
-    style.setDim(DimWidth, containerWidth > 0.0f ? containerWidth : 0.0f);
+    setStyleDim(DimWidth, containerWidth > 0.0f ? containerWidth : 0.0f);
     styleWidthReset = true;
   }
 
   bool styleHeightReset = false;
-  if (isUndefined(style.dim[DimHeight]) && isDefined(parentHeight)) {
+  if (isUndefined(styleDim[DimHeight]) && isDefined(parentHeight)) {
     float containerHeight = parentHeight - getMargin(FLexDirectionColumn);
-    style.setDim(DimHeight, containerHeight > 0.0f ? containerHeight : 0.0f);
+    setStyleDim(DimHeight, containerHeight > 0.0f ? containerHeight : 0.0f);
     styleHeightReset = true;
   }
-  layoutImpl(parentWidth, parentHeight, parentDirection, LayoutActionLayout, layoutContext);
+  // scratch storage is reused by all layout calls on this thread. a layout
+  // may be nested in another one on this thread, e.g. from a measure
+  // function, whose pool, stats and measure table are restored at exit.
+  HPLayoutScratch* scratch = HPLayoutScratch::current();
+  HPLayoutThreadPool* oldThreadPool = scratch->threadPool();
+  HPLayoutStats* oldStats = scratch->stats();
+  HPBatchMeasureTable* oldMeasureTable = scratch->batchMeasureTable();
+  HPResumableLayout* oldResumableLayout = scratch->resumableLayout();
+  LayoutPhase oldPhase = scratch->switchPhase(LayoutPhaseOther);
+  scratch->setThreadPool(threadPool);
+  scratch->setStats(stats);
+  scratch->setBatchMeasureTable(nullptr);
+  // a layout nested in a resumable one runs to its end.
+  scratch->setResumableLayout(options.resumableLayout);
+  if (threadPool != nullptr) {
+    updateSubtreeWeight();
+  }
+  HPBatchMeasureTable* measureTable = nullptr;
+  if (batchMeasure != nullptr || measurePool != nullptr) {
+    measureTable = &scratch->acquireBatchMeasureTable();
+    measureTable->collect(this, parentWidth, parentHeight);
+    std::vector<HPMeasureRequest>& requests = measureTable->requests();
+    if (!requests.empty()) {
+      LayoutPhase previousPhase = scratch->switchPhase(LayoutPhaseMeasure);
+      if (batchMeasure != nullptr) {
+        batchMeasure(requests.data(), static_cast<uint32_t>(requests.size()), layoutContext);
+      } else {
+        measureTable->measureInParallel(measurePool, layoutContext);
+      }
+      scratch->switchPhase(previousPhase);
+      measureTable->commit();
+      if (stats != nullptr) {
+        stats->batchMeasureCount += static_cast<uint32_t>(requests.size());
+      }
+    }
+    scratch->setBatchMeasureTable(measureTable);
+  }
+  layoutImpl(parentWidth, parentHeight, parentDirection, LayoutActionLayout, scratch,
+             layoutContext);
+  // boundaries which are dirty under clean ancestors are not reached above.
+  if (layoutDirtyBoundaries(scratch, layoutContext)) {
+    layoutImpl(parentWidth, parentHeight, parentDirection, LayoutActionLayout, scratch,
+               layoutContext);
+  }
+  if (measureTable != nullptr) {
+    scratch->releaseBatchMeasureTable(*measureTable);
+  }
+  scratch->setBatchMeasureTable(oldMeasureTable);
+  scratch->switchPhase(LayoutPhaseOther);
+  // time of a nested layout is not counted in the phase of the outer one.
+  scratch->setStats(oldStats);
+  scratch->switchPhase(oldPhase);
+  scratch->setThreadPool(oldThreadPool);
+  scratch->setResumableLayout(oldResumableLayout);
+  if (options.resumableLayout != nullptr) {
+    options.resumableLayout->publishNewLayouts();
+  }
   if (styleWidthReset) {
-    style.setDim(DimWidth, VALUE_UNDEFINED);
+    setStyleDim(DimWidth, VALUE_UNDEFINED);
   }
   if (styleHeightReset) {
-    style.setDim(DimHeight, VALUE_UNDEFINED);
+    setStyleDim(DimHeight, VALUE_UNDEFINED);
   }
 
   // calculate container's position
   FlexDirection mainAxis = resolveMainAxis();
   FlexDirection crossAxis = resolveCrossAxis();
-  setLayoutStartPosition(mainAxis, getStartMargin(mainAxis), true);
-  setLayoutEndPosition(mainAxis, getEndMargin(mainAxis), true);
-  setLayoutStartPosition(crossAxis, getStartMargin(crossAxis), true);
-  setLayoutEndPosition(crossAxis, getEndMargin(crossAxis), true);
+  setLayoutStartPosition(mainAxis, getStartMargin(mainAxis), scratch, true);
+  setLayoutEndPosition(mainAxis, getEndMargin(mainAxis), scratch, true);
+  setLayoutStartPosition(crossAxis, getStartMargin(crossAxis), scratch, true);
+  setLayoutEndPosition(crossAxis, getEndMargin(crossAxis), scratch, true);
 
   // node 's layout is complete
   // convert its and its descendants position and size to a integer value.
@@ -601,72 +873,357 @@ void HPNode::layout(float parentWidth,
                                     // java . 3.8.2018. ianwang..
 #endif
 
-#ifdef LAYOUT_TIME_ANALYZE
-  HPLog(LogLevelDebug, "HippyLayoutTime layout: count %d cache %d, measure: count %d cache %d",
-        layoutCount, layoutCacheCount, measureCount, measureCacheCount);
-#endif
+  if (stats != nullptr) {
+    stats->totalTime = HPLayoutScratch::now() - startTime;
+    HPLayoutCache::addGlobalStats(stats);
+  }
 }
 
 // 3.Determine the flex base size and hypothetical main size of each item
-void HPNode::calculateItemsFlexBasis(HPSize availableSize, void* layoutContext) {
-  FlexDirection mainAxis = style.flexDirection;
+// appended items don't move the items before them and are sized alone.
+static bool isAppendableItem(HPNodeRef item) {
+  return item->style->positionType != PositionTypeAbsolute && item->style->flexGrow == 0 &&
+         !item->style.edges(FLexDirectionColumn).hasAutoMargin;
+}
+
+// index of the append pass of action, see HPAppendInput.
+static size_t appendPassIndex(FlexLayoutAction layoutAction) {
+  return layoutAction == LayoutActionMeasureHeight ? 0
+                                                   : layoutAction == LayoutActionMeasureWidth ? 1
+                                                                                              : 2;
+}
+
+// remember a pass of a single line column container whose items are placed
+// one after another, so that items appended later can be laid out alone.
+void HPNode::saveAppendPass(FlexLayoutAction layoutAction,
+                            HPSize availableSize,
+                            HPSizeMode measureMode,
+                            float sumItemsMainSize,
+                            float lineCrossSize) {
+  // the line is as wide as the container in layout, it's known before items
+  // are laid out only with a definite width.
+  bool appendable = style->flexDirection == FLexDirectionColumn &&
+                    style->flexWrap == FlexNoWrap && style->justifyContent == FlexAlignStart &&
+                    scrollWindow == nullptr &&
+                    measureMode.heightMeasureMode != MeasureModeAtMost &&
+                    (layoutAction != LayoutActionLayout || isDefined(styleDim[DimWidth]));
+  bool hasShrinkItems = false;
+  for (size_t i = 0; appendable && i < children.size(); i++) {
+    HPNodeRef item = children[i];
+    if (item->style->displayType == DisplayTypeNone) {
+      continue;
+    }
+    appendable = isAppendableItem(item);
+    hasShrinkItems = hasShrinkItems || item->style->flexShrink != 0;
+  }
+  if (!appendable) {
+    if (appendInput != nullptr) {
+      appendInput->passes[appendPassIndex(layoutAction)].valid = false;
+    }
+    return;
+  }
+  if (appendInput == nullptr) {
+    appendInput = new HPAppendInput();
+    for (size_t i = 0; i < 3; i++) {
+      appendInput->passes[i].valid = false;
+    }
+  }
+  HPAppendPass& pass = appendInput->passes[appendPassIndex(layoutAction)];
+  pass.valid = true;
+  pass.direction = getLayoutDirection();
+  pass.crossDim = styleDim[DimWidth];
+  pass.availableCross = availableSize.width;
+  pass.crossMeasureMode = measureMode.widthMeasureMode;
+  pass.itemCount = static_cast<uint32_t>(children.size());
+  pass.mainEnd = getStartPaddingAndBorder(FLexDirectionColumn) + sumItemsMainSize;
+  pass.mainDim = result.dim[DimHeight];
+  pass.lineCrossSize = lineCrossSize;
+  appendInput->hasShrinkItems = hasShrinkItems;
+}
+
+/*
+ * lay out items appended since the last pass of the same action alone, the
+ * items before them keep their sizes and positions, only their end
+ * positions are moved by the change of container height.
+ * return false if the whole flex algorithm has to run, e.g. inputs of the
+ * pass changed or appended items would shrink.
+ */
+bool HPNode::layoutAppendedItems(HPSize availableSize,
+                                 HPSizeMode measureMode,
+                                 FlexLayoutAction layoutAction,
+                                 HPLayoutScratch* scratch,
+                                 void* layoutContext) {
+  FlexDirection mainAxis = FLexDirectionColumn;
+  FlexDirection crossAxis = resolveCrossAxis();
+  HPAppendPass& pass = appendInput->passes[appendPassIndex(layoutAction)];
+  if (!pass.valid || pass.itemCount >= children.size() ||
+      pass.direction != getLayoutDirection() ||
+      measureMode.heightMeasureMode == MeasureModeAtMost ||
+      !FloatIsEqual(pass.crossDim, styleDim[DimWidth]) ||
+      !FloatIsEqual(pass.availableCross, availableSize.width) ||
+      pass.crossMeasureMode != measureMode.widthMeasureMode) {
+    return false;
+  }
+  for (size_t i = pass.itemCount; i < children.size(); i++) {
+    HPNodeRef item = children[i];
+    if (item->style->displayType != DisplayTypeNone && !isAppendableItem(item)) {
+      return false;
+    }
+  }
+
+  std::vector<FlexLine*>& flexLines = scratch->acquireFlexLines();
+  FlexLine* line = scratch->newFlexLine(this);
+  flexLines.push_back(line);
+  float mainEnd = pass.mainEnd;
+  bool hasShrinkItems = appendInput->hasShrinkItems;
+  for (size_t i = pass.itemCount; i < children.size(); i++) {
+    HPNodeRef item = children[i];
+    item->isWindowedOut = false;
+    if (item->style->displayType == DisplayTypeNone) {
+      item->resetLayoutRecursive(true, scratch);
+      continue;
+    }
+    HPFlexItemSizes sizes;
+    sizes.flexBaseSize = calculateItemFlexBaseSize(item, availableSize, scratch, layoutContext);
+    sizes.hypotheticalMainAxisSize = item->boundAxis(mainAxis, sizes.flexBaseSize);
+    sizes.hypotheticalMainAxisMarginBoxSize =
+        sizes.hypotheticalMainAxisSize + item->getMargin(mainAxis);
+    line->addItem(item, sizes);
+    mainEnd += sizes.hypotheticalMainAxisMarginBoxSize;
+    hasShrinkItems = hasShrinkItems || item->style->flexShrink != 0;
+  }
+
+  // 4. main size of container, the sum of items in the single line.
+  float sumItemsMainSize = mainEnd - getStartPaddingAndBorder(mainAxis);
+  float containerInnerMainSize = isDefined(styleDim[DimHeight])
+                                     ? styleDim[DimHeight] - getPaddingAndBorder(mainAxis)
+                                     : sumItemsMainSize;
+  float mainDim = boundAxis(mainAxis, containerInnerMainSize + getPaddingAndBorder(mainAxis));
+  float mainAxisContentSize = mainDim - getPaddingAndBorder(mainAxis);
+  if (sumItemsMainSize > mainAxisContentSize && hasShrinkItems) {
+    scratch->releaseFlexLines(flexLines);
+    return false;
+  }
+  appendInput->hasShrinkItems = hasShrinkItems;
+  if (scratch->stats() != nullptr) {
+    scratch->stats()->appendLayoutCount++;
+  }
+  result.dim[DimHeight] = mainDim;
+  if (layoutAction == LayoutActionMeasureHeight) {
+    pass.itemCount = static_cast<uint32_t>(children.size());
+    pass.mainEnd = mainEnd;
+    pass.mainDim = mainDim;
+    scratch->releaseFlexLines(flexLines);
+    return true;
+  }
+
+  // 6. no item flexes, appended items get their hypothetical main sizes.
+  line->SetContainerMainInnerSize(mainAxisContentSize);
+  line->FreezeInflexibleItems(layoutAction);
+  if (layoutAction == LayoutActionLayout && sumItemsMainSize > mainAxisContentSize) {
+    result.hadOverflow = true;
+  }
+
+  // 7. hypothetical cross size of appended items.
+  float maxItemCrossSize = 0;
+  for (size_t i = 0; i < line->items.size(); i++) {
+    HPNodeRef item = line->items[i];
+    layoutItemWithUsedMainSize(item, layoutAction, availableSize, scratch, layoutContext);
+    result.hadOverflow = result.hadOverflow | item->result.hadOverflow;
+    float itemOutCrossSize = item->getLayoutDim(crossAxis) + item->getMargin(crossAxis);
+    if (itemOutCrossSize > maxItemCrossSize) {
+      maxItemCrossSize = itemOutCrossSize;
+    }
+  }
+  if (layoutAction == LayoutActionMeasureWidth) {
+    // 8,15. the line is as wide as the widest item.
+    maxItemCrossSize = boundAxis(crossAxis, maxItemCrossSize);
+    if (maxItemCrossSize > pass.lineCrossSize) {
+      pass.lineCrossSize = maxItemCrossSize;
+    }
+    result.dim[DimWidth] =
+        boundAxis(crossAxis, pass.lineCrossSize + getPaddingAndBorder(crossAxis));
+    pass.itemCount = static_cast<uint32_t>(children.size());
+    pass.mainEnd = mainEnd;
+    pass.mainDim = mainDim;
+    scratch->releaseFlexLines(flexLines);
+    return true;
+  }
+
+  // 11. the line is as wide as the container.
+  line->lineCrossSize =
+      boundAxis(crossAxis, styleDim[DimWidth]) - getPaddingAndBorder(crossAxis);
+  for (size_t i = 0; i < line->items.size(); i++) {
+    HPNodeRef item = line->items[i];
+    if (getNodeAlign(item) == FlexAlignStretch && item->isStyleDimensionAuto(crossAxis) &&
+        !item->style.edges(crossAxis).hasAutoMargin) {
+      item->result.dim[axisDim[crossAxis]] =
+          item->boundAxis(crossAxis, line->lineCrossSize - item->getMargin(crossAxis));
+      layoutStretchedItem(item, layoutAction, availableSize, scratch, layoutContext);
+    }
+  }
+
+  // 12. appended items follow the last item, see FlexLine::alignItems.
+  float offset = pass.mainEnd;
+  for (size_t i = 0; i < line->items.size(); i++) {
+    HPNodeRef item = line->items[i];
+    item->setLayoutStartMargin(mainAxis, item->getStartMargin(mainAxis));
+    item->setLayoutEndMargin(mainAxis, item->getEndMargin(mainAxis));
+    offset += item->getLayoutStartMargin(mainAxis);
+    item->setLayoutStartPosition(mainAxis, offset, scratch);
+    item->setLayoutEndPosition(mainAxis, mainDim - item->getLayoutDim(mainAxis) - offset,
+                               scratch);
+    offset += item->getLayoutDim(mainAxis) + item->getLayoutEndMargin(mainAxis);
+  }
+  float mainDimDelta = mainDim - pass.mainDim;
+  if (mainDimDelta != 0) {
+    for (size_t i = 0; i < pass.itemCount; i++) {
+      HPNodeRef item = children[i];
+      if (item->style->displayType != DisplayTypeNone) {
+        item->setLayoutEndPosition(mainAxis, item->getLayoutEndPosition(mainAxis) + mainDimDelta,
+                                   scratch, false);
+      }
+    }
+  }
+  // 13-16. cross axis alignment of appended items.
+  crossAxisAlignment(flexLines, scratch);
+  scratch->releaseFlexLines(flexLines);
+
+  pass.itemCount = static_cast<uint32_t>(children.size());
+  pass.mainEnd = mainEnd;
+  pass.mainDim = mainDim;
+  return true;
+}
+
+// 3.Determine the flex base size of item.
+float HPNode::calculateItemFlexBaseSize(HPNodeRef item,
+                                       HPSize availableSize,
+                                       HPLayoutScratch* scratch,
+                                       void* layoutContext) {
+  FlexDirection mainAxis = style->flexDirection;
+  // 3.1 If the item has a definite used flex basis, that's the flex base
+  // size.
+  if (isDefined(item->style->getFlexBasis()) && isDefined(styleDim[axisDim[mainAxis]])) {
+    return item->style->getFlexBasis();
+  } else if (isDefined(item->styleDim[axisDim[mainAxis]])) {
+    // flex-basis:auto:
+    // When specified on a flex item, the auto keyword retrieves the value
+    // of the main size property as the used flex-basis.
+    // If that value is itself auto, then the used value is content.
+    return item->styleDim[axisDim[mainAxis]];
+  }
+  // 3.2 Otherwise, size the item into the available space using its used
+  // flex basis in place of its main size,
+  float oldMainDim = item->getStyleDim(mainAxis);
+  // item->style->flexBasis is auto value
+  item->setStyleDim(mainAxis, item->style->flexBasis);
+  item->layoutImpl(availableSize.width, availableSize.height, getLayoutDirection(),
+                   isRowDirection(mainAxis) ? LayoutActionMeasureWidth : LayoutActionMeasureHeight,
+                   scratch, layoutContext);
+  item->setStyleDim(mainAxis, oldMainDim);
+  return isDefined(item->result.dim[axisDim[mainAxis]]) ? item->result.dim[axisDim[mainAxis]] : 0;
+}
+
+void HPNode::calculateItemsFlexBasis(std::vector<HPFlexItemSizes>& itemSizes,
+                                     HPSize availableSize,
+                                     HPLayoutScratch* scratch,
+                                     void* layoutContext) {
+  FlexDirection mainAxis = style->flexDirection;
+  HP_AXIS_DISPATCH(mainAxis, calculateItemsFlexBasis,
+                   (itemSizes, availableSize, scratch, layoutContext));
+}
+
+template <FlexDirection mainAxis>
+void HPNode::calculateItemsFlexBasis(std::vector<HPFlexItemSizes>& itemSizes,
+                                     HPSize availableSize,
+                                     HPLayoutScratch* scratch,
+                                     void* layoutContext) {
   std::vector<HPNodeRef>& items = children;
+  itemSizes.resize(items.size());
+  // items of a single line scroll window are placed by a running main offset,
+  // justify-content and flexing are not taken into account.
+  HPScrollWindow* window = nullptr;
+  if (scrollWindow != nullptr && style->isOverflowScroll() && style->flexWrap == FlexNoWrap) {
+    window = scrollWindow;
+  }
+  float windowOffset = getStartPaddingAndBorder<mainAxis>();
+  float knownSizeSum = 0;
+  uint32_t knownSizeCount = 0;
+  float lastOuterSize = 0;
   for (size_t i = 0; i < items.size(); i++) {
     HPNodeRef item = items[i];
+    HPFlexItemSizes& sizes = itemSizes[i];
+    item->isWindowedOut = false;
     // for display none item, reset its and its descendants layout result.
-    if (item->style.displayType == DisplayTypeNone) {
-      item->resetLayoutRecursive();
+    if (item->style->displayType == DisplayTypeNone) {
+      item->resetLayoutRecursive(true, scratch);
       continue;
     }
     // https://stackoverflow.com/questions/34352140/what-are-the-differences-between-flex-basis-and-width
     // flex-basis has no effect on absolutely-positioned flex items. width and
     // height properties would be necessary. Absolutely-positioned flex items do
     // not participate in flex layout.
-    if (item->style.positionType == PositionTypeAbsolute) {
+    if (item->style->positionType == PositionTypeAbsolute) {
       continue;
     }
+    if (window != nullptr) {
+      // windowed out items are placed without a layout of their own, which
+      // would restore their results.
+      item->restoreUnroundedLayout();
+      // items never laid out have no size of their own yet.
+      if (isDefined(item->styleDim[HPAxis<mainAxis>::dim])) {
+        lastOuterSize = item->boundAxis<mainAxis>(item->styleDim[HPAxis<mainAxis>::dim]) +
+                        item->getMargin<mainAxis>();
+      } else if (item->inInitailState) {
+        lastOuterSize = window->averageItemSize;
+      } else {
+        lastOuterSize = item->getLayoutDim<mainAxis>() + item->getMargin<mainAxis>();
+      }
+      item->isWindowedOut = windowOffset + lastOuterSize <= window->start - window->margin ||
+                            windowOffset >= window->start + window->length + window->margin;
+      if (item->isWindowedOut && scratch->stats() != nullptr) {
+        scratch->stats()->windowedOutCount++;
+      }
+    }
     // 3.Determine the flex base size and hypothetical main size of each item:
-    // 3.1 If the item has a definite used flex basis, that's the flex base
-    // size.
-    if (isDefined(item->style.getFlexBasis()) && isDefined(style.dim[axisDim[mainAxis]])) {
-      item->result.flexBaseSize = item->style.getFlexBasis();
-    } else if (isDefined(item->style.dim[axisDim[mainAxis]])) {
-      // flex-basis:auto:
-      // When specified on a flex item, the auto keyword retrieves the value
-      // of the main size property as the used flex-basis.
-      // If that value is itself auto, then the used value is content.
-      item->result.flexBaseSize = item->style.dim[axisDim[mainAxis]];
+    if (item->isWindowedOut) {
+      // out of scroll window, keep the size of last layout instead of
+      // measuring the subtree.
+      sizes.flexBaseSize = lastOuterSize - item->getMargin<mainAxis>();
+      sizes.flexBaseSize = sizes.flexBaseSize > 0 ? sizes.flexBaseSize : 0;
     } else {
-      // 3.2 Otherwise, size the item into the available space using its used
-      // flex basis in place of its main size,
-      float oldMainDim = item->style.getDim(mainAxis);
-      // item->style.flexBasis is auto value
-      item->style.setDim(mainAxis, item->style.flexBasis);
-      item->layoutImpl(
-          availableSize.width, availableSize.height, getLayoutDirection(),
-          isRowDirection(mainAxis) ? LayoutActionMeasureWidth : LayoutActionMeasureHeight,
-          layoutContext);
-      item->style.setDim(mainAxis, oldMainDim);
-
-      item->result.flexBaseSize =
-          isDefined(item->result.dim[axisDim[mainAxis]]) ? item->result.dim[axisDim[mainAxis]] : 0;
+      sizes.flexBaseSize = calculateItemFlexBaseSize(item, availableSize, scratch, layoutContext);
     }
 
     // item->result.dim[axisDim[mainAxis]] = item->boundAxis(mainAxis,
     // item->result.flexBasis); The hypothetical main size is the item's flex
     // base size clamped according to its min and max main size properties (and
     // flooring the content box size at zero).
-    item->result.hypotheticalMainAxisSize = item->boundAxis(mainAxis, item->result.flexBaseSize);
-    item->result.hypotheticalMainAxisMarginBoxSize =
-        item->result.hypotheticalMainAxisSize + item->getMargin(mainAxis);
+    sizes.hypotheticalMainAxisSize = item->boundAxis<mainAxis>(sizes.flexBaseSize);
+    sizes.hypotheticalMainAxisMarginBoxSize =
+        sizes.hypotheticalMainAxisSize + item->getMargin<mainAxis>();
+    if (window != nullptr) {
+      windowOffset += sizes.hypotheticalMainAxisMarginBoxSize;
+      if (!item->isWindowedOut || !item->inInitailState) {
+        knownSizeSum += sizes.hypotheticalMainAxisMarginBoxSize;
+        knownSizeCount++;
+      }
+    }
+  }
+  // refine size model of the window by items laid out so far.
+  if (window != nullptr && knownSizeCount > 0) {
+    window->averageItemSize = knownSizeSum / knownSizeCount;
   }
 }
 
-bool HPNode::collectFlexLines(std::vector<FlexLine*>& flexLines, HPSize availableSize) {
+bool HPNode::collectFlexLines(std::vector<FlexLine*>& flexLines,
+                              std::vector<HPFlexItemSizes>& itemSizes,
+                              HPSize availableSize,
+                              HPLayoutScratch* scratch) {
   std::vector<HPNodeRef>& items = children;
   bool sumHypotheticalMainSizeOverflow = false;
   float availableWidth =
-      axisDim[style.flexDirection] == DimWidth ? availableSize.width : availableSize.height;
+      axisDim[style->flexDirection] == DimWidth ? availableSize.width : availableSize.height;
   if (isUndefined(availableWidth)) {
     availableWidth = INFINITY;
   }
@@ -676,8 +1233,8 @@ bool HPNode::collectFlexLines(std::vector<FlexLine*>& flexLines, HPSize availabl
   int i = 0;
   while (i < itemsSize) {
     HPNodeRef item = items[i];
-    if (item->style.positionType == PositionTypeAbsolute ||
-        item->style.displayType == DisplayTypeNone) {
+    if (item->style->positionType == PositionTypeAbsolute ||
+        item->style->displayType == DisplayTypeNone) {
       // see HippyTest.dirty_mark_all_children_as_dirty_when_display_changes
       // when display changes.
       if (i == itemsSize - 1 && line != nullptr) {
@@ -690,18 +1247,18 @@ bool HPNode::collectFlexLines(std::vector<FlexLine*>& flexLines, HPSize availabl
     }
 
     if (line == nullptr) {
-      line = new FlexLine(this);
+      line = scratch->newFlexLine(this);
     }
 
     float leftSpace = availableWidth - (line->sumHypotheticalMainSize +
-                                        item->result.hypotheticalMainAxisMarginBoxSize);
+                                        itemSizes[i].hypotheticalMainAxisMarginBoxSize);
     if (leftSpace < 0) {
       // may be line wrap happened
       sumHypotheticalMainSizeOverflow = true;
     }
 
-    if (style.flexWrap == FlexNoWrap) {
-      line->addItem(item);
+    if (style->flexWrap == FlexNoWrap) {
+      line->addItem(item, itemSizes[i]);
       if (i == itemsSize - 1) {
         flexLines.push_back(line);
         break;
@@ -709,7 +1266,7 @@ bool HPNode::collectFlexLines(std::vector<FlexLine*>& flexLines, HPSize availabl
       i++;
     } else {
       if (leftSpace >= 0 || line->isEmpty()) {
-        line->addItem(item);
+        line->addItem(item, itemSizes[i]);
         if (i == itemsSize - 1) {
           flexLines.push_back(line);
           line = nullptr;
@@ -727,12 +1284,16 @@ bool HPNode::collectFlexLines(std::vector<FlexLine*>& flexLines, HPSize availabl
 
 void HPNode::cacheLayoutOrMeasureResult(HPSize availableSize,
                                         HPSizeMode measureMode,
-                                        FlexLayoutAction layoutAction) {
+                                        FlexLayoutAction layoutAction,
+                                        HPLayoutScratch* scratch) {
   HPSize resultSize = {result.dim[DimWidth], result.dim[DimHeight]};
-  layoutCache.cacheResult(availableSize, resultSize, measureMode, layoutAction);
+  layoutCache.cacheResult(availableSize, resultSize, measureMode, layoutAction, scratch->stats());
   if (layoutAction == LayoutActionLayout) {
+    if (scratch->stats() != nullptr) {
+      scratch->stats()->newLayoutCount++;
+    }
     setDirty(false);
-    setHasNewLayout(true);
+    markNewLayout(scratch);
     inInitailState = false;
   }
 }
@@ -745,6 +1306,7 @@ void HPNode::layoutSingleNode(float availableWidth,
                               float availableHeight,
                               MeasureMode heightMeasureMode,
                               FlexLayoutAction layoutAction,
+                              HPLayoutScratch* scratch,
                               void* layoutContext) {
   if (widthMeasureMode == MeasureModeExactly && heightMeasureMode == MeasureModeExactly) {
     result.dim[DimWidth] = availableWidth + getPaddingAndBorder(FLexDirectionRow);
@@ -753,9 +1315,9 @@ void HPNode::layoutSingleNode(float availableWidth,
     // measure text, image etc. content node;
     HPSize dim = {0, 0};
     bool needMeasure = true;
-    if (style.flexGrow > 0 && style.flexShrink > 0 && parent && parent->childCount() == 1 &&
-        !parent->style.isDimensionAuto(FLexDirectionRow) &&
-        !parent->style.isDimensionAuto(FLexDirectionColumn)) {
+    if (style->flexGrow > 0 && style->flexShrink > 0 && parent && parent->childCount() == 1 &&
+        !parent->isStyleDimensionAuto(FLexDirectionRow) &&
+        !parent->isStyleDimensionAuto(FLexDirectionColumn)) {
       // don't measure single grow shrink child
       // see HPMeasureTest.cpp dont_measure_single_grow_shrink_child
       needMeasure = false;
@@ -765,8 +1327,35 @@ void HPNode::layoutSingleNode(float availableWidth,
       dim.width = availableWidth;
       dim.height = availableHeight;
     } else if (measure != nullptr && needMeasure) {
-      dim = measure(this, availableWidth, widthMeasureMode, availableHeight, heightMeasureMode,
-                    layoutContext);
+      // nodes with same content share measure results.
+      HPMeasureCache* measureCache = measureCacheKey != 0 ? HPMeasureCache::shared() : nullptr;
+      HPLayoutStats* stats = scratch->stats();
+      HPBatchMeasureTable* measureTable = scratch->batchMeasureTable();
+      if (measureTable != nullptr &&
+          measureTable->find(this, availableWidth, widthMeasureMode, availableHeight,
+                             heightMeasureMode, dim)) {
+        if (stats != nullptr) {
+          stats->batchMeasureHitCount++;
+        }
+      } else if (measureCache != nullptr &&
+          measureCache->get(measureCacheKey, availableWidth, widthMeasureMode, availableHeight,
+                            heightMeasureMode, dim)) {
+        if (stats != nullptr) {
+          stats->sharedMeasureHitCount++;
+        }
+      } else {
+        if (stats != nullptr) {
+          stats->measureFuncCount++;
+        }
+        LayoutPhase previousPhase = scratch->switchPhase(LayoutPhaseMeasure);
+        dim = measure(this, availableWidth, widthMeasureMode, availableHeight, heightMeasureMode,
+                      layoutContext);
+        scratch->switchPhase(previousPhase);
+        if (measureCache != nullptr) {
+          measureCache->put(measureCacheKey, availableWidth, widthMeasureMode, availableHeight,
+                            heightMeasureMode, dim);
+        }
+      }
     }
 
     result.dim[DimWidth] =
@@ -779,10 +1368,6 @@ void HPNode::layoutSingleNode(float availableWidth,
                                  ? (availableHeight + getPaddingAndBorder(FLexDirectionColumn))
                                  : (dim.height + getPaddingAndBorder(FLexDirectionColumn)));
   }
-
-  HPSize availableSize = {availableWidth, availableHeight};
-  HPSizeMode measureMode = {widthMeasureMode, heightMeasureMode};
-  cacheLayoutOrMeasureResult(availableSize, measureMode, layoutAction);
 }
 
 // reference: https://www.w3.org/TR/css-flexbox-1/#layout-algorithm
@@ -790,14 +1375,37 @@ void HPNode::layoutImpl(float parentWidth,
                         float parentHeight,
                         HPDirection parentDirection,
                         FlexLayoutAction layoutAction,
+                        HPLayoutScratch* scratch,
                         void* layoutContext) {
-#ifdef LAYOUT_TIME_ANALYZE
-  if (layoutAction == LayoutActionLayout) {
-    layoutCount++;
-  } else {
-    measureCount++;
+  if (scratch->resumableLayout() != nullptr && !scratch->resumableLayout()->checkpoint()) {
+    return;
+  }
+  HPLayoutPhaseScope phaseScope(scratch, LayoutPhaseOther);
+  // results are written from here on, also on a cache hit.
+  restoreUnroundedLayout();
+  HPLayoutStats* stats = scratch->stats();
+  if (stats != nullptr) {
+    stats->visitCount++;
+    if (layoutAction == LayoutActionLayout) {
+      stats->layoutCount++;
+    } else if (layoutAction == LayoutActionMeasureWidth) {
+      stats->measureWidthCount++;
+    } else {
+      stats->measureHeightCount++;
+    }
+  }
+
+  if (layoutAction == LayoutActionLayout && parent != nullptr && isDefined(styleDim[DimWidth]) &&
+      isDefined(styleDim[DimHeight])) {
+    if (boundaryInput == nullptr) {
+      boundaryInput = new HPLayoutBoundaryInput();
+    }
+    boundaryInput->parentWidth = parentWidth;
+    boundaryInput->parentHeight = parentHeight;
+    boundaryInput->parentDirection = parentDirection;
+    boundaryInput->styleDim[DimWidth] = styleDim[DimWidth];
+    boundaryInput->styleDim[DimHeight] = styleDim[DimHeight];
   }
-#endif
 
   HPDirection direction = resolveDirection(parentDirection);
   if (getLayoutDirection() != direction) {
@@ -806,7 +1414,7 @@ void HPNode::layoutImpl(float parentWidth,
     resolveStyleValues();
   }
 
-  FlexDirection mainAxis = style.flexDirection;
+  FlexDirection mainAxis = style->flexDirection;
   bool performLayout = layoutAction == LayoutActionLayout;
   if (isDefined(parentWidth)) {
     parentWidth -= getMargin(FLexDirectionRow);
@@ -819,26 +1427,26 @@ void HPNode::layoutImpl(float parentWidth,
   }
 
   // get node dim from style
-  float nodeWidth = isDefined(style.dim[DimWidth])
-                        ? boundAxis(FLexDirectionRow, style.dim[DimWidth])
+  float nodeWidth = isDefined(styleDim[DimWidth])
+                        ? boundAxis(FLexDirectionRow, styleDim[DimWidth])
                         : VALUE_UNDEFINED;
 
-  float nodeHeight = isDefined(style.dim[DimHeight])
-                         ? boundAxis(FLexDirectionColumn, style.dim[DimHeight])
+  float nodeHeight = isDefined(styleDim[DimHeight])
+                         ? boundAxis(FLexDirectionColumn, styleDim[DimHeight])
                          : VALUE_UNDEFINED;
 
   // layoutMeasuredWidth  layoutMeasuredHeight used in
   // "Determine the flex base size and hypothetical main size of each item"
   if (layoutAction == LayoutActionMeasureWidth && isDefined(nodeWidth)) {
-#ifdef LAYOUT_TIME_ANALYZE
-    measureCacheCount++;
-#endif
+    if (stats != nullptr) {
+      stats->fixedDimHitCount++;
+    }
     result.dim[DimWidth] = nodeWidth;
     return;
   } else if (layoutAction == LayoutActionMeasureHeight && isDefined(nodeHeight)) {
-#ifdef LAYOUT_TIME_ANALYZE
-    measureCacheCount++;
-#endif
+    if (stats != nullptr) {
+      stats->fixedDimHitCount++;
+    }
     result.dim[DimHeight] = nodeHeight;
     return;
   }
@@ -868,35 +1476,37 @@ void HPNode::layoutImpl(float parentWidth,
     availableHeight = parentHeight - getPaddingAndBorder(FLexDirectionColumn);
   }
 
-  if (isDefined(style.maxDim[DimWidth])) {
-    if (FloatIsEqual(style.maxDim[DimWidth], style.minDim[DimWidth])) {
-      style.dim[DimWidth] = style.minDim[DimWidth];
+  if (isDefined(style->maxDim[DimWidth])) {
+    if (FloatIsEqual(style->maxDim[DimWidth], style->minDim[DimWidth])) {
+      styleDim[DimWidth] = style->minDim[DimWidth];
     }
-    float maxDimWidth = style.maxDim[DimWidth] - getPaddingAndBorder(FLexDirectionRow);
+    float maxDimWidth = style->maxDim[DimWidth] - getPaddingAndBorder(FLexDirectionRow);
     if (maxDimWidth >= 0.0f && maxDimWidth < NanAsINF(availableWidth)) {
       availableWidth = maxDimWidth;
     }
   }
 
-  if (isDefined(style.maxDim[DimHeight])) {
-    if (FloatIsEqual(style.maxDim[DimHeight], style.minDim[DimHeight])) {
-      style.dim[DimHeight] = style.minDim[DimHeight];
+  if (isDefined(style->maxDim[DimHeight])) {
+    if (FloatIsEqual(style->maxDim[DimHeight], style->minDim[DimHeight])) {
+      styleDim[DimHeight] = style->minDim[DimHeight];
     }
-    float maxDimHeight = style.maxDim[DimHeight] - getPaddingAndBorder(FLexDirectionColumn);
+    float maxDimHeight = style->maxDim[DimHeight] - getPaddingAndBorder(FLexDirectionColumn);
     if (maxDimHeight >= 0.0f && maxDimHeight < NanAsINF(availableHeight)) {
       availableHeight = maxDimHeight;
     }
   }
 
   // available size to layout...
+  float unclampedWidth = availableWidth;
+  float unclampedHeight = availableHeight;
   availableWidth = availableWidth < 0.0f ? 0.0f : availableWidth;
   availableHeight = availableHeight < 0.0f ? 0.0f : availableHeight;
 
   MeasureMode widthMeasureMode = MeasureModeUndefined;
-  if (isDefined(style.dim[DimWidth])) {
+  if (isDefined(styleDim[DimWidth])) {
     widthMeasureMode = MeasureModeExactly;
   } else if (isDefined(availableWidth)) {
-    if (parent && parent->style.isOverflowScroll() && isRowDirection(parent->style.flexDirection)) {
+    if (parent && parent->style->isOverflowScroll() && isRowDirection(parent->style->flexDirection)) {
       widthMeasureMode = MeasureModeUndefined;
       availableWidth = VALUE_AUTO;
     } else {
@@ -905,11 +1515,11 @@ void HPNode::layoutImpl(float parentWidth,
   }
 
   MeasureMode heightMeasureMode = MeasureModeUndefined;
-  if (isDefined(style.dim[DimHeight])) {
+  if (isDefined(styleDim[DimHeight])) {
     heightMeasureMode = MeasureModeExactly;
   } else if (isDefined(availableHeight)) {
-    if (parent && parent->style.isOverflowScroll() &&
-        isColumnDirection(parent->style.flexDirection)) {
+    if (parent && parent->style->isOverflowScroll() &&
+        isColumnDirection(parent->style->flexDirection)) {
       heightMeasureMode = MeasureModeUndefined;
       availableHeight = VALUE_AUTO;
     } else {
@@ -919,27 +1529,29 @@ void HPNode::layoutImpl(float parentWidth,
 
   HPSize availableSize = {availableWidth, availableHeight};
   HPSizeMode measureMode = {widthMeasureMode, heightMeasureMode};
-  MeasureResult* cacheResult = layoutCache.getCachedMeasureResult(availableSize, measureMode,
-                                                                  layoutAction, measure != nullptr);
+  // exact sizes smaller than padding and border all leave no space to lay out
+  // in, but their results differ, so they are cached by the unclamped size.
+  HPSize cacheSize = availableSize;
+  if (measure == nullptr && widthMeasureMode == MeasureModeExactly) {
+    cacheSize.width = unclampedWidth;
+  }
+  if (measure == nullptr && heightMeasureMode == MeasureModeExactly) {
+    cacheSize.height = unclampedHeight;
+  }
+  MeasureResult* cacheResult = layoutCache.getCachedMeasureResult(
+      cacheSize, measureMode, layoutAction, measure != nullptr, stats);
   if (cacheResult != nullptr) {
     // set Result....
     switch (layoutAction) {
       case LayoutActionMeasureWidth:
-#ifdef LAYOUT_TIME_ANALYZE
-        measureCacheCount++;
-#endif
         ASSERT(isDefined(cacheResult->resultSize.width));
         result.dim[DimWidth] = cacheResult->resultSize.width;
         break;
       case LayoutActionMeasureHeight:
-#ifdef LAYOUT_TIME_ANALYZE
-        measureCacheCount++;
-#endif
         ASSERT(isDefined(cacheResult->resultSize.height));
         result.dim[DimHeight] = cacheResult->resultSize.height;
         break;
       case LayoutActionLayout:
-
         // if it's a measure node and cache result cached by
         // LayoutActionMeasureWidth or LayoutActionMeasureHeight so this is first
         // layout for current Measure Node, set hasNewLayout as true, if not,
@@ -950,14 +1562,13 @@ void HPNode::layoutImpl(float parentWidth,
           // need assign result size if layoutAction is different 3.14.2018
           result.dim[DimWidth] = cacheResult->resultSize.width;
           result.dim[DimHeight] = cacheResult->resultSize.height;
-          cacheLayoutOrMeasureResult(availableSize, measureMode, layoutAction);
+          cacheLayoutOrMeasureResult(cacheSize, measureMode, layoutAction, scratch);
         } else {
-#ifdef LAYOUT_TIME_ANALYZE
-          layoutCacheCount++;
-#endif
-          // do nothing..
           // layoutCache.cachedLayout object is last layout result.
-          // used to determine need layout or not.
+          // used to determine need layout or not, size of the node may be
+          // rewritten by its parent since, restore it.
+          result.dim[DimWidth] = cacheResult->resultSize.width;
+          result.dim[DimHeight] = cacheResult->resultSize.height;
         }
 
         // if it's a measure node , layout could be cache by
@@ -971,6 +1582,22 @@ void HPNode::layoutImpl(float parentWidth,
     }
     return;
   }
+  // a measure pass rewrites results of items, so the last layout can't be
+  // reused from cache, see LayoutActionLayout above.
+  if (layoutAction != LayoutActionLayout && !children.empty()) {
+    layoutCache.clearCachedLayout();
+  }
+  // results of items are written before they are laid out themselves, which
+  // would restore their rounded results over them, so restore them first.
+  for (size_t i = 0; i < children.size(); i++) {
+    children[i]->restoreUnroundedLayout();
+  }
+  // only items appended since last pass are laid out if possible.
+  if (appendInput != nullptr &&
+      layoutAppendedItems(availableSize, measureMode, layoutAction, scratch, layoutContext)) {
+    cacheLayoutOrMeasureResult(cacheSize, measureMode, layoutAction, scratch);
+    return;
+  }
   // before layout set result's hadOverflow as false.
   if (layoutAction == LayoutActionLayout) {
     result.hadOverflow = false;
@@ -978,15 +1605,23 @@ void HPNode::layoutImpl(float parentWidth,
   // single element measure width and height
   if ((children.size() == 0)) {
     layoutSingleNode(availableWidth, widthMeasureMode, availableHeight, heightMeasureMode,
-                     layoutAction, layoutContext);
+                     layoutAction, scratch, layoutContext);
+    cacheLayoutOrMeasureResult(cacheSize, measureMode, layoutAction, scratch);
     return;
   }
   // 3.Determine the flex base size and hypothetical main size of each item
-  calculateItemsFlexBasis(availableSize, layoutContext);
+  // item sizes are copied into flex lines, released once lines are collected.
+  scratch->switchPhase(LayoutPhaseFlexBasis);
+  std::vector<HPFlexItemSizes>& itemSizes = scratch->acquireItemSizes();
+  calculateItemsFlexBasis(itemSizes, availableSize, scratch, layoutContext);
   // 9.3. Main Size Determination
   // 5. Collect flex items into flex lines:
-  std::vector<FlexLine*> flexLines;
-  bool sumHypotheticalMainSizeOverflow = collectFlexLines(flexLines, availableSize);
+  // flex lines are recycled by scratch, released before every return below.
+  scratch->switchPhase(LayoutPhaseFlexLines);
+  std::vector<FlexLine*>& flexLines = scratch->acquireFlexLines();
+  bool sumHypotheticalMainSizeOverflow =
+      collectFlexLines(flexLines, itemSizes, availableSize, scratch);
+  scratch->releaseItemSizes(itemSizes);
 
   // get max line's  main size
   float maxSumItemsMainSize = 0;
@@ -1003,19 +1638,19 @@ void HPNode::layoutImpl(float parentWidth,
   // TODO(ianwang): if has set , what to do for next run in determineCrossAxisSize's
   // layoutImpl
   float containerInnerMainSize = 0.0f;
-  if (isDefined(style.dim[axisDim[mainAxis]])) {
+  if (isDefined(styleDim[axisDim[mainAxis]])) {
     // MeasureModeExactly
-    containerInnerMainSize = style.dim[axisDim[mainAxis]] - getPaddingAndBorder(mainAxis);
+    containerInnerMainSize = styleDim[axisDim[mainAxis]] - getPaddingAndBorder(mainAxis);
   } else {
     if (sumHypotheticalMainSizeOverflow) {  // MeasureModeAtMost
       // if sum of hypothetical MainSize > available size;
       float mainInnerSize =
           axisDim[mainAxis] == DimWidth ? availableSize.width : availableSize.height;
 
-      if (maxSumItemsMainSize > mainInnerSize && !style.isOverflowScroll()) {
+      if (maxSumItemsMainSize > mainInnerSize && !style->isOverflowScroll()) {
         if (parent && parent->getNodeAlign(this) == FlexAlignStretch &&
             axisDim[mainAxis] == axisDim[parent->resolveCrossAxis()] &&
-            style.positionType != PositionTypeAbsolute) {
+            style->positionType != PositionTypeAbsolute) {
           // it this node has text child and node main axis(width) is stretch
           // ,cross axis length(height) is undefined
           // text can has multi-line, text's height can affect parent's height
@@ -1037,12 +1672,9 @@ void HPNode::layoutImpl(float parentWidth,
   if ((layoutAction == LayoutActionMeasureWidth && isRowDirection(mainAxis)) ||
       (layoutAction == LayoutActionMeasureHeight && isColumnDirection(mainAxis))) {
     // cache layout result & state...
-    cacheLayoutOrMeasureResult(availableSize, measureMode, layoutAction);
-    // free flexLines, allocate in collectFlexLines.
-    // TODO(ianwang): opt.
-    for (size_t i = 0; i < flexLines.size(); i++) {
-      delete flexLines[i];
-    }
+    cacheLayoutOrMeasureResult(cacheSize, measureMode, layoutAction, scratch);
+    saveAppendPass(layoutAction, availableSize, measureMode, maxSumItemsMainSize, 0);
+    scratch->releaseFlexLines(flexLines);
     return;
   }
 
@@ -1050,6 +1682,7 @@ void HPNode::layoutImpl(float parentWidth,
   // To resolve the flexible lengths of the items within a flex line:
   // TODO(ianwang): this's the only place that confirm child items main axis size, see
   // item->setLayoutDim
+  scratch->switchPhase(LayoutPhaseFlexibleLengths);
   determineItemsMainAxisSize(flexLines, layoutAction);
 
   // 9.4. Cross Size Determination
@@ -1057,8 +1690,9 @@ void HPNode::layoutImpl(float parentWidth,
   // TODO(ianwang): The real place that Determine
   // the flex container's used cross size is at step 15.
 
+  scratch->switchPhase(LayoutPhaseCrossSize);
   float sumLinesCrossSize =
-      determineCrossAxisSize(flexLines, availableSize, layoutAction, layoutContext);
+      determineCrossAxisSize(flexLines, availableSize, layoutAction, scratch, layoutContext);
 
   if (!performLayout) {
     // TODO(ianwang): for measure, I put the calculate of flex container's cross size in
@@ -1073,39 +1707,38 @@ void HPNode::layoutImpl(float parentWidth,
     // clamped by the min and max cross size properties of the flex container.
     FlexDirection crossAxis = resolveCrossAxis();
     float crossDimSize;
-    if (isDefined(style.dim[axisDim[crossAxis]])) {
-      crossDimSize = style.dim[axisDim[crossAxis]];
+    if (isDefined(styleDim[axisDim[crossAxis]])) {
+      crossDimSize = styleDim[axisDim[crossAxis]];
     } else {
       crossDimSize = (sumLinesCrossSize + getPaddingAndBorder(crossAxis));
     }
     result.dim[axisDim[crossAxis]] = boundAxis(crossAxis, crossDimSize);
     // cache layout result & state...
-    cacheLayoutOrMeasureResult(availableSize, measureMode, layoutAction);
-
-    // free flexLines, allocate in collectFlexLines.
-    for (size_t i = 0; i < flexLines.size(); i++) {
-      delete flexLines[i];
-    }
+    cacheLayoutOrMeasureResult(cacheSize, measureMode, layoutAction, scratch);
+    saveAppendPass(layoutAction, availableSize, measureMode, maxSumItemsMainSize,
+                   sumLinesCrossSize);
+    scratch->releaseFlexLines(flexLines);
     return;
   }
 
   // 9.5. Main-Axis Alignment
-  mainAxisAlignment(flexLines);
+  scratch->switchPhase(LayoutPhaseMainAlign);
+  mainAxisAlignment(flexLines, scratch);
 
   // 9.6. Cross-Axis Alignment
   // if contianer's innerCross size not defined,
   // then it will be determined in step 15 of crossAxisAlignment
-  crossAxisAlignment(flexLines);
+  scratch->switchPhase(LayoutPhaseCrossAlign);
+  crossAxisAlignment(flexLines, scratch);
 
-  // free flexLines, allocate in collectFlexLines.
-  for (size_t i = 0; i < flexLines.size(); i++) {
-    delete flexLines[i];
-  }
+  scratch->releaseFlexLines(flexLines);
 
   // cache layout result & state...
-  cacheLayoutOrMeasureResult(availableSize, measureMode, layoutAction);
+  cacheLayoutOrMeasureResult(cacheSize, measureMode, layoutAction, scratch);
+  saveAppendPass(layoutAction, availableSize, measureMode, maxSumItemsMainSize, sumLinesCrossSize);
   // layout fixed elements...
-  layoutFixedItems(measureMode, layoutContext);
+  scratch->switchPhase(LayoutPhaseFixedItems);
+  layoutFixedItems(scratch, layoutContext);
 
   return;
 }
@@ -1114,10 +1747,23 @@ void HPNode::layoutImpl(float parentWidth,
 float HPNode::determineCrossAxisSize(std::vector<FlexLine*>& flexLines,
                                      HPSize availableSize,
                                      FlexLayoutAction layoutAction,
+                                     HPLayoutScratch* scratch,
                                      void* layoutContext) {
-  FlexDirection mainAxis = style.flexDirection;
   FlexDirection crossAxis = resolveCrossAxis();
   float sumLinesCrossSize = 0;
+  // items are independent once their main size is determined,
+  // lay out items of all lines concurrently if parallel layout is enabled.
+  bool itemsLaidOut = false;
+  if (scratch->threadPool() != nullptr) {
+    std::vector<HPNodeRef>& items = scratch->acquireItems();
+    for (size_t i = 0; i < flexLines.size(); i++) {
+      items.insert(items.end(), flexLines[i]->items.begin(), flexLines[i]->items.end());
+    }
+    itemsLaidOut =
+        layoutItemsInParallel(items, false, layoutAction, availableSize, scratch, layoutContext);
+    scratch->releaseItems(items);
+  }
+
   for (size_t i = 0; i < flexLines.size(); i++) {
     FlexLine* line = flexLines[i];
     float maxItemCrossSize = 0;
@@ -1132,19 +1778,9 @@ float HPNode::determineCrossAxisSize(std::vector<FlexLine*>& flexLines,
       // happen. 7.Determine the hypothetical cross size of each item by
       // performing layout with the used main size and the available space,
       // treating auto as fit-content.
-      FlexLayoutAction oldLayoutAction = layoutAction;
-      if (getNodeAlign(item) == FlexAlignStretch && item->style.isDimensionAuto(crossAxis) &&
-          !item->style.hasAutoMargin(crossAxis) && layoutAction == LayoutActionLayout) {
-        // Delay layout for stretch item, do layout later in step 11.
-        layoutAction =
-            axisDim[crossAxis] == DimWidth ? LayoutActionMeasureWidth : LayoutActionMeasureHeight;
+      if (!itemsLaidOut) {
+        layoutItemWithUsedMainSize(item, layoutAction, availableSize, scratch, layoutContext);
       }
-      float oldMainDim = item->style.getDim(mainAxis);
-      item->style.setDim(mainAxis, item->getLayoutDim(mainAxis));
-      item->layoutImpl(availableSize.width, availableSize.height, getLayoutDirection(),
-                       layoutAction, layoutContext);
-      item->style.setDim(mainAxis, oldMainDim);
-      layoutAction = oldLayoutAction;
       // if child item had overflow , then transfer this state to its parent.
       // see HippyTest_HadOverflowTests.spacing_overflow_in_nested_nodes in
       // ./tests/HPHadOverflowTest.cpp
@@ -1176,12 +1812,12 @@ float HPNode::determineCrossAxisSize(std::vector<FlexLine*>& flexLines,
     sumLinesCrossSize += maxItemCrossSize;
 
     // single line , set line height as container inner height
-    if (flexLines.size() == 1 && isDefined(style.dim[axisDim[crossAxis]])) {
+    if (flexLines.size() == 1 && isDefined(styleDim[axisDim[crossAxis]])) {
       // if following assert is true, means front-end's style is in unsuitable
       // state .. such as main axis is undefined but set flex-wrap as FlexWrap.
-      // ASSERT(style.flexWrap == FlexNoWrap);
+      // ASSERT(style->flexWrap == FlexNoWrap);
       float innerCrossSize =
-          boundAxis(crossAxis, style.dim[axisDim[crossAxis]]) - getPaddingAndBorder(crossAxis);
+          boundAxis(crossAxis, styleDim[axisDim[crossAxis]]) - getPaddingAndBorder(crossAxis);
 
       line->lineCrossSize = innerCrossSize;
       sumLinesCrossSize = innerCrossSize;
@@ -1189,9 +1825,9 @@ float HPNode::determineCrossAxisSize(std::vector<FlexLine*>& flexLines,
   }
 
   // 9.Handle 'align-content: stretch' for lines
-  if (isDefined(style.dim[axisDim[crossAxis]]) && style.alignContent == FlexAlignStretch) {
+  if (isDefined(styleDim[axisDim[crossAxis]]) && style->alignContent == FlexAlignStretch) {
     float innerCrossSize =
-        boundAxis(crossAxis, style.dim[axisDim[crossAxis]]) - getPaddingAndBorder(crossAxis);
+        boundAxis(crossAxis, styleDim[axisDim[crossAxis]]) - getPaddingAndBorder(crossAxis);
     if (sumLinesCrossSize < innerCrossSize) {
       for (size_t i = 0; i < flexLines.size(); i++) {
         FlexLine* line = flexLines[i];
@@ -1202,6 +1838,9 @@ float HPNode::determineCrossAxisSize(std::vector<FlexLine*>& flexLines,
 
   // 11.Determine the used cross size of each flex item
   // Think about item align-self: stretch
+  // stretched items are collected and laid out concurrently in parallel layout.
+  bool parallel = scratch->threadPool() != nullptr;
+  std::vector<HPNodeRef>* stretchedItems = parallel ? &scratch->acquireItems() : nullptr;
   for (size_t i = 0; i < flexLines.size(); i++) {
     FlexLine* line = flexLines[i];
     for (size_t j = 0; j < line->items.size(); j++) {
@@ -1213,22 +1852,15 @@ float HPNode::determineCrossAxisSize(std::vector<FlexLine*>& flexLines,
       //    size is the used cross size of its flex line, clamped according to
       //    the item's min and max cross size properties.
       // 2):Otherwise,the used cross size is the item's hypothetical cross size.
-      if (getNodeAlign(item) == FlexAlignStretch && item->style.isDimensionAuto(crossAxis) &&
-          !item->style.hasAutoMargin(crossAxis)) {
+      if (getNodeAlign(item) == FlexAlignStretch && item->isStyleDimensionAuto(crossAxis) &&
+          !item->style.edges(crossAxis).hasAutoMargin) {
         item->result.dim[axisDim[crossAxis]] =
             item->boundAxis(crossAxis, line->lineCrossSize - item->getMargin(crossAxis));
-        // If the flex item has align-self: stretch, redo layout for its
-        // contents, treating this used size as its definite cross size so that
-        // percentage-sized children can be resolved.
-        float oldMainDim = item->style.getDim(mainAxis);
-        float oldCrossDim = item->style.getDim(crossAxis);
-        item->style.setDim(mainAxis, item->getLayoutDim(mainAxis));
-        item->style.setDim(crossAxis, item->getLayoutDim(crossAxis));
-        item->layoutImpl(availableSize.width, availableSize.height, getLayoutDirection(),
-                         layoutAction, layoutContext);
-        item->style.setDim(mainAxis, oldMainDim);
-        item->style.setDim(crossAxis, oldCrossDim);
-
+        if (parallel) {
+          stretchedItems->push_back(item);
+        } else {
+          layoutStretchedItem(item, layoutAction, availableSize, scratch, layoutContext);
+        }
       } else {
         // Otherwise, the used cross size is the item's hypothetical cross size.
         // see the step7.
@@ -1238,14 +1870,182 @@ float HPNode::determineCrossAxisSize(std::vector<FlexLine*>& flexLines,
     }
   }
 
+  if (parallel) {
+    if (!layoutItemsInParallel(*stretchedItems, true, layoutAction, availableSize, scratch,
+                               layoutContext)) {
+      for (size_t i = 0; i < stretchedItems->size(); i++) {
+        layoutStretchedItem((*stretchedItems)[i], layoutAction, availableSize, scratch,
+                            layoutContext);
+      }
+    }
+    scratch->releaseItems(*stretchedItems);
+  }
+
   // TODO(ianwang): Why Determine  the flex container's used cross size in step 15.
   return sumLinesCrossSize;
 }
 
+// 7.Determine the hypothetical cross size of item by performing layout
+// with the used main size and the available space, treating auto as fit-content.
+void HPNode::layoutItemWithUsedMainSize(HPNodeRef item,
+                                        FlexLayoutAction layoutAction,
+                                        HPSize availableSize,
+                                        HPLayoutScratch* scratch,
+                                        void* layoutContext) {
+  FlexDirection mainAxis = style->flexDirection;
+  FlexDirection crossAxis = resolveCrossAxis();
+  if (item->isWindowedOut) {
+    // out of scroll window, the cross size of last layout is kept.
+    if (isDefined(item->getStyleDim(crossAxis))) {
+      item->setLayoutDim(crossAxis, item->boundAxis(crossAxis, item->getStyleDim(crossAxis)));
+    }
+    item->markNewLayout(scratch);
+    return;
+  }
+  if (getNodeAlign(item) == FlexAlignStretch && item->isStyleDimensionAuto(crossAxis) &&
+      !item->style.edges(crossAxis).hasAutoMargin && layoutAction == LayoutActionLayout) {
+    // Delay layout for stretch item, do layout later in step 11.
+    layoutAction =
+        axisDim[crossAxis] == DimWidth ? LayoutActionMeasureWidth : LayoutActionMeasureHeight;
+  }
+  float oldMainDim = item->getStyleDim(mainAxis);
+  item->setStyleDim(mainAxis, item->getLayoutDim(mainAxis));
+  item->layoutImpl(availableSize.width, availableSize.height, getLayoutDirection(), layoutAction,
+                   scratch, layoutContext);
+  item->setStyleDim(mainAxis, oldMainDim);
+}
+
+// 11.If the flex item has align-self: stretch, redo layout for its
+// contents, treating this used size as its definite cross size so that
+// percentage-sized children can be resolved.
+void HPNode::layoutStretchedItem(HPNodeRef item,
+                                 FlexLayoutAction layoutAction,
+                                 HPSize availableSize,
+                                 HPLayoutScratch* scratch,
+                                 void* layoutContext) {
+  if (item->isWindowedOut) {
+    return;
+  }
+  FlexDirection mainAxis = style->flexDirection;
+  FlexDirection crossAxis = resolveCrossAxis();
+  float oldMainDim = item->getStyleDim(mainAxis);
+  float oldCrossDim = item->getStyleDim(crossAxis);
+  item->setStyleDim(mainAxis, item->getLayoutDim(mainAxis));
+  item->setStyleDim(crossAxis, item->getLayoutDim(crossAxis));
+  item->layoutImpl(availableSize.width, availableSize.height, getLayoutDirection(), layoutAction,
+                   scratch, layoutContext);
+  item->setStyleDim(mainAxis, oldMainDim);
+  item->setStyleDim(crossAxis, oldCrossDim);
+}
+
+// run on a pool thread, or on a thread waiting for its batch.
+void HPNode::layoutItemTask(void* data) {
+  HPItemLayoutTask* task = reinterpret_cast<HPItemLayoutTask*>(data);
+  HPLayoutScratch* scratch = HPLayoutScratch::current();
+  HPLayoutThreadPool* oldPool = scratch->threadPool();
+  HPLayoutStats* oldStats = scratch->stats();
+  LayoutPhase oldPhase = scratch->switchPhase(LayoutPhaseOther);
+  scratch->setThreadPool(task->pool);
+  scratch->setStats(task->stats);
+  if (task->stretched) {
+    task->container->layoutStretchedItem(task->item, task->layoutAction, task->availableSize,
+                                         scratch, task->layoutContext);
+  } else {
+    task->container->layoutItemWithUsedMainSize(task->item, task->layoutAction,
+                                                task->availableSize, scratch,
+                                                task->layoutContext);
+  }
+  scratch->switchPhase(LayoutPhaseOther);
+  // time of task is not counted in the phase of a waiting thread.
+  scratch->setStats(oldStats);
+  scratch->switchPhase(oldPhase);
+  scratch->setThreadPool(oldPool);
+}
+
+/*
+ * lay out subtrees of items concurrently, each item only writes its own subtree.
+ * items with big enough subtrees are submitted to the pool, the others and
+ * items whose subtree has measure nodes (subtreeWeight is 0) are laid out on
+ * this thread, so measure functions are always called by the thread that
+ * started the layout.
+ * return false and lay out nothing if no item is worth a task.
+ */
+bool HPNode::layoutItemsInParallel(std::vector<HPNodeRef>& items,
+                                   bool stretched,
+                                   FlexLayoutAction layoutAction,
+                                   HPSize availableSize,
+                                   HPLayoutScratch* scratch,
+                                   void* layoutContext) {
+  HPLayoutThreadPool* pool = scratch->threadPool();
+  uint32_t minSubtreeNodes = pool->minSubtreeNodes();
+  HPItemTaskList& taskList = scratch->acquireItemTasks();
+  std::vector<HPItemLayoutTask>& taskData = taskList.data;
+  for (size_t i = 0; i < items.size(); i++) {
+    HPNodeRef item = items[i];
+    if (item->subtreeWeight > 0 && item->subtreeWeight >= minSubtreeNodes) {
+      HPItemLayoutTask task = {this, item, stretched, layoutAction, availableSize, pool,
+                               layoutContext, nullptr};
+      taskData.push_back(task);
+    }
+  }
+  if (taskData.empty()) {
+    scratch->releaseItemTasks(taskList);
+    return false;
+  }
+
+  std::vector<HPLayoutStats>& taskStats = taskList.stats;
+  if (scratch->stats() != nullptr) {
+    taskStats.resize(taskData.size());
+  }
+  std::vector<HPLayoutTask>& tasks = taskList.tasks;
+  tasks.resize(taskData.size());
+  for (size_t i = 0; i < taskData.size(); i++) {
+    if (!taskStats.empty()) {
+      HPLayoutStatsReset(&taskStats[i]);
+      taskData[i].stats = &taskStats[i];
+    }
+    tasks[i].func = layoutItemTask;
+    tasks[i].data = &taskData[i];
+  }
+  HPLayoutTaskBatch batch;
+  pool->submit(&batch, tasks.data(), tasks.size());
+
+  for (size_t i = 0; i < items.size(); i++) {
+    HPNodeRef item = items[i];
+    if (item->subtreeWeight > 0 && item->subtreeWeight >= minSubtreeNodes) {
+      continue;
+    }
+    if (stretched) {
+      layoutStretchedItem(item, layoutAction, availableSize, scratch, layoutContext);
+    } else {
+      layoutItemWithUsedMainSize(item, layoutAction, availableSize, scratch, layoutContext);
+    }
+  }
+  pool->wait(&batch);
+  for (size_t i = 0; i < taskStats.size(); i++) {
+    HPLayoutStatsMerge(scratch->stats(), &taskStats[i]);
+  }
+  scratch->releaseItemTasks(taskList);
+  return true;
+}
+
+// node count of the subtree, 0 if any node in it has a measure function.
+uint32_t HPNode::updateSubtreeWeight() {
+  bool hasMeasure = measure != nullptr;
+  uint32_t weight = 1;
+  for (size_t i = 0; i < children.size(); i++) {
+    uint32_t childWeight = children[i]->updateSubtreeWeight();
+    hasMeasure = hasMeasure || childWeight == 0;
+    weight += childWeight;
+  }
+  subtreeWeight = hasMeasure ? 0 : weight;
+  return subtreeWeight;
+}
+
 // See  9.7 Resolving Flexible Lengths.
 void HPNode::determineItemsMainAxisSize(std::vector<FlexLine*>& flexLines,
                                         FlexLayoutAction layoutAction) {
-  FlexDirection mainAxis = style.flexDirection;
+  FlexDirection mainAxis = style->flexDirection;
   float mainAxisContentSize = result.dim[axisDim[mainAxis]] - getPaddingAndBorder(mainAxis);
   // 6. Resolve the flexible lengths of all the flex items to find their used
   // main size (see section 9.7.)
@@ -1265,21 +2065,26 @@ void HPNode::determineItemsMainAxisSize(std::vector<FlexLine*>& flexLines,
 }
 
 // 9.5 Main-Axis Alignment
-void HPNode::mainAxisAlignment(std::vector<FlexLine*>& flexLines) {
+void HPNode::mainAxisAlignment(std::vector<FlexLine*>& flexLines, HPLayoutScratch* scratch) {
   // TODO(ianwang): RTL::
   // 12. Distribute any remaining free space. For each flex line:
-  FlexDirection mainAxis = style.flexDirection;
+  FlexDirection mainAxis = style->flexDirection;
   float mainAxisContentSize = getLayoutDim(mainAxis) - getPaddingAndBorder(mainAxis);
   for (size_t i = 0; i < flexLines.size(); i++) {
     FlexLine* line = flexLines[i];
     line->SetContainerMainInnerSize(mainAxisContentSize);
-    line->alignItems();
+    line->alignItems(scratch);
   }
 }
 
 // 9.6 Cross-Axis Alignment
-void HPNode::crossAxisAlignment(std::vector<FlexLine*>& flexLines) {
+void HPNode::crossAxisAlignment(std::vector<FlexLine*>& flexLines, HPLayoutScratch* scratch) {
   FlexDirection crossAxis = resolveCrossAxis();
+  HP_AXIS_DISPATCH(crossAxis, crossAxisAlignment, (flexLines, scratch));
+}
+
+template <FlexDirection crossAxis>
+void HPNode::crossAxisAlignment(std::vector<FlexLine*>& flexLines, HPLayoutScratch* scratch) {
   float sumLinesCrossSize = 0;
   int linesCount = flexLines.size();
   for (int i = 0; i < linesCount; i++) {
@@ -1289,39 +2094,41 @@ void HPNode::crossAxisAlignment(std::vector<FlexLine*>& flexLines) {
       HPNodeRef item = line->items[j];
       // 13.Resolve cross-axis auto margins. If a flex item has auto cross-axis
       // margins:
-      float remainingFreeSpace =
-          line->lineCrossSize - item->result.dim[axisDim[crossAxis]] - item->getMargin(crossAxis);
+      float remainingFreeSpace = line->lineCrossSize - item->result.dim[HPAxis<crossAxis>::dim] -
+                                 item->getMargin<crossAxis>();
+      const HPResolvedEdges& itemEdges = item->style.edges(crossAxis);
       if (remainingFreeSpace > 0) {
         // If its outer cross size (treating those auto margins as zero) is less
         // than the cross size of its flex line, distribute the difference in
         // those sizes equally to the auto margins.
-        if (item->isAutoStartMargin(crossAxis) && item->isAutoEndMargin(crossAxis)) {
-          item->setLayoutStartMargin(crossAxis, remainingFreeSpace / 2);
-          item->setLayoutEndMargin(crossAxis, remainingFreeSpace / 2);
-        } else if (item->isAutoStartMargin(crossAxis)) {
-          item->setLayoutStartMargin(crossAxis, remainingFreeSpace);
-        } else if (item->isAutoEndMargin(crossAxis)) {
-          item->setLayoutEndMargin(crossAxis, remainingFreeSpace);
+        if (itemEdges.autoStartMargin && itemEdges.autoEndMargin) {
+          item->setLayoutStartMargin<crossAxis>(remainingFreeSpace / 2);
+          item->setLayoutEndMargin<crossAxis>(remainingFreeSpace / 2);
+        } else if (itemEdges.autoStartMargin) {
+          item->setLayoutStartMargin<crossAxis>(remainingFreeSpace);
+        } else if (itemEdges.autoEndMargin) {
+          item->setLayoutEndMargin<crossAxis>(remainingFreeSpace);
         } else {
           // For margin:: assign style value to result value at this place..
-          item->setLayoutStartMargin(crossAxis, item->getStartMargin(crossAxis));
-          item->setLayoutEndMargin(crossAxis, item->getEndMargin(crossAxis));
+          item->setLayoutStartMargin<crossAxis>(itemEdges.startMargin);
+          item->setLayoutEndMargin<crossAxis>(itemEdges.endMargin);
         }
       } else {
         // Otherwise, if the block-start or inline-start margin
         // (whichever is in the cross axis) is auto, set it to zero.
         // Set the opposite margin so that the outer cross size of the
         // item equals the cross size of its flex line.
-        item->setLayoutStartMargin(crossAxis, item->getStartMargin(crossAxis));
-        item->setLayoutEndMargin(crossAxis, item->getEndMargin(crossAxis));
+        item->setLayoutStartMargin<crossAxis>(itemEdges.startMargin);
+        item->setLayoutEndMargin<crossAxis>(itemEdges.endMargin);
       }
 
       // 14.Align all flex items along the cross-axis per align-self,
       // if neither of the item's cross-axis margins are auto.
       // calculate item's offset in its line by style align-self
-      remainingFreeSpace = line->lineCrossSize - item->result.dim[axisDim[crossAxis]] -
-                           item->getLayoutMargin(crossAxis);
-      float offset = item->getLayoutStartMargin(crossAxis);
+      remainingFreeSpace =
+          line->lineCrossSize - item->result.dim[HPAxis<crossAxis>::dim] -
+          (item->getLayoutStartMargin<crossAxis>() + item->getLayoutEndMargin<crossAxis>());
+      float offset = item->getLayoutStartMargin<crossAxis>();
       switch (getNodeAlign(item)) {  // when align self is auto , it overwrite by align items
         case FlexAlignStart:
           break;
@@ -1337,7 +2144,7 @@ void HPNode::crossAxisAlignment(std::vector<FlexLine*>& flexLines) {
       }
       // include (axisStart[crossAxis] == CSSTop) and (axisStart[crossAxis] ==
       // CSSBottom) For temporary store. use false parameter
-      item->setLayoutStartPosition(crossAxis, offset, false);
+      item->setLayoutStartPosition<crossAxis>(offset, scratch, false);
     }
   }
 
@@ -1348,20 +2155,20 @@ void HPNode::crossAxisAlignment(std::vector<FlexLine*>& flexLines) {
   // clamped by the min and max cross size properties of the flex container.
 
   float crossDimSize;
-  if (isDefined(style.dim[axisDim[crossAxis]])) {
-    crossDimSize = style.dim[axisDim[crossAxis]];
+  if (isDefined(styleDim[HPAxis<crossAxis>::dim])) {
+    crossDimSize = styleDim[HPAxis<crossAxis>::dim];
   } else {
-    crossDimSize = (sumLinesCrossSize + getPaddingAndBorder(crossAxis));
+    crossDimSize = (sumLinesCrossSize + getPaddingAndBorder<crossAxis>());
   }
-  result.dim[axisDim[crossAxis]] = boundAxis(crossAxis, crossDimSize);
+  result.dim[HPAxis<crossAxis>::dim] = boundAxis<crossAxis>(crossDimSize);
 
   // when container's cross size determined align all flex lines by
   // align-content 16.Align all flex lines per align-content
-  float innerCrossSize = result.dim[axisDim[crossAxis]] - getPaddingAndBorder(crossAxis);
+  float innerCrossSize = result.dim[HPAxis<crossAxis>::dim] - getPaddingAndBorder<crossAxis>();
   float remainingFreeSpace = innerCrossSize - sumLinesCrossSize;
-  float offset = getStartPaddingAndBorder(crossAxis);
+  float offset = getStartPaddingAndBorder<crossAxis>();
   float space = 0;
-  switch (style.alignContent) {
+  switch (style->alignContent) {
     case FlexAlignStart:
       break;
     case FlexAlignCenter:
@@ -1392,15 +2199,14 @@ void HPNode::crossAxisAlignment(std::vector<FlexLine*>& flexLines) {
       HPNodeRef item = line->items[j];
       // include (axisStart[crossAxis] == CSSTop) and (axisStart[crossAxis] ==
       // CSSBottom) getLayoutStartPosition set in step 14.
-      item->setLayoutStartPosition(crossAxis,
-                                   crossAxisPostionStart + item->getLayoutStartPosition(crossAxis));
+      item->setLayoutStartPosition<crossAxis>(
+          crossAxisPostionStart + item->getLayoutStartPosition<crossAxis>(), scratch);
       // layout start position has use relative ,so end position not use it ,use
       // false parameter.
-      item->setLayoutEndPosition(
-          crossAxis,
-          (getLayoutDim(crossAxis) - item->getLayoutStartPosition(crossAxis) -
-           item->getLayoutDim(crossAxis)),
-          false);
+      item->setLayoutEndPosition<crossAxis>(
+          (getLayoutDim<crossAxis>() - item->getLayoutStartPosition<crossAxis>() -
+           item->getLayoutDim<crossAxis>()),
+          scratch, false);
     }
 
     crossAxisPostionStart += line->lineCrossSize + space;
@@ -1415,18 +2221,18 @@ void HPNode::crossAxisAlignment(std::vector<FlexLine*>& flexLines) {
 // item in the flex container, assuming both the child and the flex container
 // were fixed-size boxes of their used size. For this purpose, auto margins are
 // treated as zero.
-void HPNode::layoutFixedItems(HPSizeMode measureMode, void* layoutContext) {
+void HPNode::layoutFixedItems(HPLayoutScratch* scratch, void* layoutContext) {
   FlexDirection mainAxis = resolveMainAxis();
   FlexDirection crossAxis = resolveCrossAxis();
   std::vector<HPNodeRef>& items = children;
   for (size_t i = 0; i < items.size(); i++) {
     HPNodeRef item = items[i];
     // for display none item, reset its layout result.
-    if (item->style.displayType == DisplayTypeNone) {
-      item->resetLayoutRecursive();
+    if (item->style->displayType == DisplayTypeNone) {
+      item->resetLayoutRecursive(true, scratch);
       continue;
     }
-    if (item->style.positionType != PositionTypeAbsolute) {
+    if (item->style->positionType != PositionTypeAbsolute) {
       continue;
     }
 
@@ -1434,59 +2240,67 @@ void HPNode::layoutFixedItems(HPSizeMode measureMode, void* layoutContext) {
     float parentHeight =
         getLayoutDim(FLexDirectionColumn) - getPaddingAndBorder(FLexDirectionColumn);
 
-    float itemOldStyleDimMainAxis = item->style.getDim(mainAxis);
-    float itemOldStyleDimCrossAxis = item->style.getDim(crossAxis);
-
-    if (isUndefined(itemOldStyleDimMainAxis) && isDefined(item->style.getStartPosition(mainAxis)) &&
-        isDefined(item->style.getEndPosition(mainAxis))) {
-      item->style.setDim(mainAxis,
-                         (getLayoutDim(mainAxis) - style.getStartBorder(mainAxis) -
-                          style.getEndBorder(mainAxis) - item->style.getStartPosition(mainAxis) -
-                          item->style.getEndPosition(mainAxis) - item->getMargin(mainAxis)));
+    float itemOldStyleDimMainAxis = item->getStyleDim(mainAxis);
+    float itemOldStyleDimCrossAxis = item->getStyleDim(crossAxis);
+
+    const HPResolvedEdges& itemMainEdges = item->style.edges(mainAxis);
+    const HPResolvedEdges& itemCrossEdges = item->style.edges(crossAxis);
+    if (isUndefined(itemOldStyleDimMainAxis) && isDefined(itemMainEdges.startPosition) &&
+        isDefined(itemMainEdges.endPosition)) {
+      item->setStyleDim(mainAxis,
+                         (getLayoutDim(mainAxis) - style.edges(mainAxis).startBorder -
+                          style.edges(mainAxis).endBorder - itemMainEdges.startPosition -
+                          itemMainEdges.endPosition - item->getMargin(mainAxis)));
     }
 
-    if (isUndefined(itemOldStyleDimCrossAxis) &&
-        isDefined(item->style.getStartPosition(crossAxis)) &&
-        isDefined(item->style.getEndPosition(crossAxis))) {
-      item->style.setDim(crossAxis,
-                         (getLayoutDim(crossAxis) - style.getStartBorder(crossAxis) -
-                          style.getEndBorder(crossAxis) - item->style.getStartPosition(crossAxis) -
-                          item->style.getEndPosition(crossAxis) - item->getMargin(crossAxis)));
+    if (isUndefined(itemOldStyleDimCrossAxis) && isDefined(itemCrossEdges.startPosition) &&
+        isDefined(itemCrossEdges.endPosition)) {
+      item->setStyleDim(crossAxis,
+                         (getLayoutDim(crossAxis) - style.edges(crossAxis).startBorder -
+                          style.edges(crossAxis).endBorder - itemCrossEdges.startPosition -
+                          itemCrossEdges.endPosition - item->getMargin(crossAxis)));
     }
 
-    item->layoutImpl(parentWidth, parentHeight, getLayoutDirection(), LayoutActionLayout,
+    item->layoutImpl(parentWidth, parentHeight, getLayoutDirection(), LayoutActionLayout, scratch,
                      layoutContext);
     // recover item's previous style value
-    item->style.setDim(mainAxis, itemOldStyleDimMainAxis);
-    item->style.setDim(crossAxis, itemOldStyleDimCrossAxis);
+    item->setStyleDim(mainAxis, itemOldStyleDimMainAxis);
+    item->setStyleDim(crossAxis, itemOldStyleDimCrossAxis);
     // after layout, calculate fix item 's postion
     // 1) for main axis
-    calculateFixedItemPosition(item, mainAxis);
+    calculateFixedItemPosition(item, mainAxis, scratch);
     // 2)for cross axis
-    calculateFixedItemPosition(item, crossAxis);
+    calculateFixedItemPosition(item, crossAxis, scratch);
   }
 }
 
 // when item's layout complete, update fixed item's position on Specified axis
 // called in layoutFixedItems
 // should be called twice, one for main axis ,one for cross axis
-void HPNode::calculateFixedItemPosition(HPNodeRef item, FlexDirection axis) {
-  if (isDefined(item->style.getStartPosition(axis))) {
-    item->setLayoutStartPosition(axis, getStartBorder(axis) + item->getLayoutStartMargin(axis) +
-                                           item->style.getStartPosition(axis));
+void HPNode::calculateFixedItemPosition(HPNodeRef item,
+                                        FlexDirection axis,
+                                        HPLayoutScratch* scratch) {
+  const HPResolvedEdges& itemEdges = item->style.edges(axis);
+  if (isDefined(itemEdges.startPosition)) {
+    item->setLayoutStartPosition(
+        axis, getStartBorder(axis) + item->getLayoutStartMargin(axis) + itemEdges.startPosition,
+        scratch);
     item->setLayoutEndPosition(
-        axis, getLayoutDim(axis) - item->getLayoutStartPosition(axis) - item->getLayoutDim(axis));
+        axis, getLayoutDim(axis) - item->getLayoutStartPosition(axis) - item->getLayoutDim(axis),
+        scratch);
 
-  } else if (isDefined(item->style.getEndPosition(axis))) {
-    item->setLayoutEndPosition(axis, getEndBorder(axis) + item->getLayoutEndMargin(axis) +
-                                         item->style.getEndPosition(axis));
+  } else if (isDefined(itemEdges.endPosition)) {
+    item->setLayoutEndPosition(
+        axis, getEndBorder(axis) + item->getLayoutEndMargin(axis) + itemEdges.endPosition,
+        scratch);
     item->setLayoutStartPosition(
-        axis, getLayoutDim(axis) - item->getLayoutEndPosition(axis) - item->getLayoutDim(axis));
+        axis, getLayoutDim(axis) - item->getLayoutEndPosition(axis) - item->getLayoutDim(axis),
+        scratch);
   } else {
     float remainingFreeSpace =
         getLayoutDim(axis) - getPaddingAndBorder(axis) - item->getLayoutDim(axis);
     float offset = getStartPaddingAndBorder(axis);
-    FlexAlign alignMode = (axis == resolveMainAxis() ? style.justifyContent : getNodeAlign(item));
+    FlexAlign alignMode = (axis == resolveMainAxis() ? style->justifyContent : getNodeAlign(item));
     switch (alignMode) {
       case FlexAlignStart:
         break;
@@ -1501,10 +2315,74 @@ void HPNode::calculateFixedItemPosition(HPNodeRef item, FlexDirection axis) {
     }
 
     item->setLayoutStartPosition(
-        axis, getStartPaddingAndBorder(axis) + item->getLayoutStartMargin(axis) + offset);
+        axis, getStartPaddingAndBorder(axis) + item->getLayoutStartMargin(axis) + offset, scratch);
     item->setLayoutEndPosition(
-        axis, getLayoutDim(axis) - item->getLayoutStartPosition(axis) - item->getLayoutDim(axis));
+        axis, getLayoutDim(axis) - item->getLayoutStartPosition(axis) - item->getLayoutDim(axis),
+        scratch);
+  }
+}
+
+/*
+ * layout dirty boundaries in subtree alone, with inputs of their last layout.
+ * ancestors of a dirty boundary are clean, so the inputs are still valid, and
+ * the result is the same as a layout from root.
+ * overflow state is the only result propagated from children to ancestors,
+ * if it changes, the boundary and its ancestors are dirtied and true is
+ * returned to layout again from root.
+ */
+bool HPNode::layoutDirtyBoundaries(HPLayoutScratch* scratch, void* layoutContext) {
+  if (!hasDirtyDescendant) {
+    return false;
+  }
+  hasDirtyDescendant = false;
+  // new results in subtree are converted from here, see convertLayoutResult.
+  markNewLayout(scratch);
+  bool relayoutAncestors = false;
+  std::vector<HPNodeRef>& items = children;
+  for (size_t i = 0; i < items.size(); i++) {
+    HPNodeRef item = items[i];
+    if (item->isDirty) {
+      HPLayoutBoundaryInput* input = item->boundaryInput;
+      bool hadOverflow = item->result.hadOverflow;
+      if (input != nullptr) {
+        float oldWidth = item->styleDim[DimWidth];
+        float oldHeight = item->styleDim[DimHeight];
+        item->styleDim[DimWidth] = input->styleDim[DimWidth];
+        item->styleDim[DimHeight] = input->styleDim[DimHeight];
+        item->layoutImpl(input->parentWidth, input->parentHeight, input->parentDirection,
+                         LayoutActionLayout, scratch, layoutContext);
+        item->styleDim[DimWidth] = oldWidth;
+        item->styleDim[DimHeight] = oldHeight;
+      }
+      if (input == nullptr || item->result.hadOverflow != hadOverflow) {
+        // dirty as if propagated to root, so that layout is the same as a full one.
+        // overflow of items is read before they are laid out, restore it.
+        item->result.hadOverflow = hadOverflow;
+        for (HPNodeRef node = item; node != nullptr; node = node->parent) {
+          node->setDirty(true);
+          node->invalidateAppendPasses(nullptr);
+        }
+        relayoutAncestors = true;
+      }
+    }
+    if (item->layoutDirtyBoundaries(scratch, layoutContext)) {
+      relayoutAncestors = true;
+    }
+  }
+  return relayoutAncestors;
+}
+
+// layout results rounded by convertLayoutResult are restored before the node
+// is laid out or converted again, so that results don't drift with rounding.
+void HPNode::restoreUnroundedLayout() {
+  if (!isLayoutRounded) {
+    return;
   }
+  result.position[CSSLeft] = unroundedLayout[0];
+  result.position[CSSTop] = unroundedLayout[1];
+  result.dim[DimWidth] = unroundedLayout[2];
+  result.dim[DimHeight] = unroundedLayout[3];
+  isLayoutRounded = false;
 }
 
 // convert position and dimension values to integer value..
@@ -1516,14 +2394,21 @@ void HPNode::convertLayoutResult(float absLeft, float absTop) {
   if (!hasNewLayout()) {
     return;
   }
+  // rounded before and not laid out since, round the same values again.
+  restoreUnroundedLayout();
   const float left = result.position[CSSLeft];
   const float top = result.position[CSSTop];
   const float width = result.dim[DimWidth];
   const float height = result.dim[DimHeight];
+  unroundedLayout[0] = left;
+  unroundedLayout[1] = top;
+  unroundedLayout[2] = width;
+  unroundedLayout[3] = height;
+  isLayoutRounded = true;
 
   absLeft += left;
   absTop += top;
-  bool isTextNode = style.nodeType == NodeTypeText;
+  bool isTextNode = style->nodeType == NodeTypeText;
   result.position[CSSLeft] = HPRoundValueToPixelGrid(left, false, isTextNode);
   result.position[CSSTop] = HPRoundValueToPixelGrid(top, false, isTextNode);
 
@@ -21,11 +21,15 @@
 
 #include "Flex.h"
 #include "FlexLine.h"
+#include "HPAxis.h"
 #include "HPLayoutCache.h"
+#include "HPLayoutScratch.h"
+#include "HPMeasureCache.h"
 #include "HPStyle.h"
 #include "HPUtil.h"
 
 class HPNode;
+class HPNodeArena;
 typedef HPNode *HPNodeRef;
 typedef HPSize (*HPMeasureFunc)(HPNodeRef node,
                                 float width,
@@ -35,15 +39,97 @@ typedef HPSize (*HPMeasureFunc)(HPNodeRef node,
                                 void *layoutContext);
 typedef void (*HPDirtiedFunc)(HPNodeRef node);
 
+// inputs of the last layout of a layout boundary given by its parent,
+// used to layout the boundary again without its ancestors.
+typedef struct {
+  float parentWidth;
+  float parentHeight;
+  HPDirection parentDirection;
+  // style dims as set by parent during layout, e.g. flexed main size.
+  float styleDim[2];
+} HPLayoutBoundaryInput;
+
+// optional parts of a layout pass, see HPNode::layout.
+struct HPLayoutOptions {
+  HPLayoutOptions()
+      : threadPool(nullptr),
+        stats(nullptr),
+        batchMeasure(nullptr),
+        measurePool(nullptr),
+        resumableLayout(nullptr) {}
+  // lays out independent subtrees concurrently, see layoutItemsInParallel.
+  HPLayoutThreadPool *threadPool;
+  // filled with statistics of the pass.
+  HPLayoutStats *stats;
+  // measures predictable text leaves in one call before the pass.
+  HPBatchMeasureFunc batchMeasure;
+  // measures predictable text leaves concurrently before the pass, used if
+  // batchMeasure is not set.
+  HPLayoutThreadPool *measurePool;
+  // set by HPResumableLayout on its thread, the pass parks at its
+  // checkpoints and new layouts are published when it's finished.
+  HPResumableLayout *resumableLayout;
+};
+
+// a pass of a single line column container, items appended after it are
+// laid out alone as long as inputs of the pass are the same.
+typedef struct {
+  bool valid;
+  HPDirection direction;
+  // cross axis inputs
+  float crossDim;
+  float availableCross;
+  MeasureMode crossMeasureMode;
+  // items in the pass and main offset after their margin boxes.
+  uint32_t itemCount;
+  float mainEnd;
+  float mainDim;
+  // cross size of the line, for passes measuring cross size.
+  float lineCrossSize;
+} HPAppendPass;
+
+// passes by action, measure of height, measure of width and layout, see
+// layoutAppendedItems.
+typedef struct {
+  HPAppendPass passes[3];
+  // some item has flex shrink, appended items can't overflow then.
+  bool hasShrinkItems;
+} HPAppendInput;
+
+// viewport of an overflow scroll container on its main axis, set by
+// HPNodeSetScrollWindow. only items overlapping the window extended by
+// margin on both sides are laid out, the others keep their last layout
+// size, items never laid out get averageItemSize.
+typedef struct {
+  // from main start edge of the container's border box.
+  float start;
+  float length;
+  float margin;
+  // outer main size of items never laid out, refined after every layout
+  // from items whose size is known.
+  float averageItemSize;
+} HPScrollWindow;
+
 class HPNode {
  public:
   HPNode();
+  // takes over links, layout and allocations of node, which is left with
+  // nothing to unlink or free. used to move nodes, see HPNodeArena::compact.
+  HPNode(HPNode &&node);
+  HPNode(const HPNode &) = delete;
+  HPNode &operator=(const HPNode &) = delete;
   virtual ~HPNode();
   void initLayoutResult();
   bool reset();
   void printNode(uint32_t indent = 0);
-  HPStyle getStyle();
+  const HPStyle &getStyle();
   void setStyle(const HPStyle &st);
+  // changes style in place by change(HPStyle &), which returns whether it
+  // changed any field, the style is interned again then. edges are resolved
+  // again only if it changed and touchesEdges, i.e. change sets margin,
+  // padding, border or position. returns what change returns.
+  template <typename Change>
+  bool updateStyle(Change change, bool touchesEdges = false);
   bool setMeasureFunc(HPMeasureFunc _measure);
   void setParent(HPNodeRef _parent);
   HPNodeRef getParent();
@@ -56,9 +142,14 @@ class HPNode {
 
   void setDisplayType(DisplayType displayType);
   void setHasNewLayout(bool hasNewLayoutOrNot);
+  // new result of a layout pass, kept until the end of a resumable layout.
+  void markNewLayout(HPLayoutScratch *scratch);
   bool hasNewLayout();
   void markAsDirty();
+  void markContentDirty(HPNodeRef item = nullptr);
   void setDirty(bool dirtyOrNot);
+  bool isLayoutBoundary();
+  bool needsLayout();
   void setDirtiedFunc(HPDirtiedFunc _dirtiedFunc);
 
   void setContext(void *_context);
@@ -77,13 +168,21 @@ class HPNode {
 
   void setLayoutStartMargin(FlexDirection axis, float value);
   void setLayoutEndMargin(FlexDirection axis, float value);
+  void setLayoutPadding(CSSDirection dir, float value);
+  void setLayoutBorder(CSSDirection dir, float value);
   float getLayoutMargin(FlexDirection axis);
   float getLayoutStartMargin(FlexDirection axis);
   float getLayoutEndMargin(FlexDirection axis);
 
   float resolveRelativePosition(FlexDirection axis, bool forAxisStart);
-  void setLayoutStartPosition(FlexDirection axis, float value, bool addRelativePosition = true);
-  void setLayoutEndPosition(FlexDirection axis, float value, bool addRelativePosition = true);
+  void setLayoutStartPosition(FlexDirection axis,
+                              float value,
+                              HPLayoutScratch *scratch,
+                              bool addRelativePosition = true);
+  void setLayoutEndPosition(FlexDirection axis,
+                            float value,
+                            HPLayoutScratch *scratch,
+                            bool addRelativePosition = true);
   float getLayoutStartPosition(FlexDirection axis);
   float getLayoutEndPosition(FlexDirection axis);
 
@@ -95,59 +194,182 @@ class HPNode {
               float parentHeight,
               HPDirection parentDirection = DirectionLTR,
               void *layoutContext = nullptr);
+  void layout(float parentWidth,
+              float parentHeight,
+              HPDirection parentDirection,
+              void *layoutContext,
+              const HPLayoutOptions &options);
   float getMainAxisDim();
   float getLayoutDim(FlexDirection axis);
   bool isLayoutDimDefined(FlexDirection axis);
   void setLayoutDim(FlexDirection axis, float value);
+  float getStyleDim(FlexDirection axis);
+  void setStyleDim(FlexDirection axis, float value);
+  void setStyleDim(Dimension dimension, float value);
+  bool isStyleDimensionAuto(FlexDirection axis);
   void setLayoutDirection(HPDirection direction);
   HPDirection getLayoutDirection();
   FlexAlign getNodeAlign(HPNodeRef item);
 
+  // same as above for an axis known at compile time, used by kernels
+  // instantiated per axis, see HPAxis.h.
+  template <FlexDirection axis>
+  float getLayoutDim();
+  template <FlexDirection axis>
+  void setLayoutDim(float value);
+  template <FlexDirection axis>
+  float getStartPaddingAndBorder();
+  template <FlexDirection axis>
+  float getPaddingAndBorder();
+  template <FlexDirection axis>
+  float getMargin();
+  template <FlexDirection axis>
+  void setLayoutStartMargin(float value);
+  template <FlexDirection axis>
+  void setLayoutEndMargin(float value);
+  template <FlexDirection axis>
+  float getLayoutStartMargin();
+  template <FlexDirection axis>
+  float getLayoutEndMargin();
+  template <FlexDirection axis>
+  float resolveRelativePosition(bool forAxisStart);
+  template <FlexDirection axis>
+  void setLayoutStartPosition(float value,
+                              HPLayoutScratch *scratch,
+                              bool addRelativePosition = true);
+  template <FlexDirection axis>
+  void setLayoutEndPosition(float value,
+                            HPLayoutScratch *scratch,
+                            bool addRelativePosition = true);
+  template <FlexDirection axis>
+  float getLayoutStartPosition();
+  template <FlexDirection axis>
+  float boundAxis(float value);
+
  protected:
   HPDirection resolveDirection(HPDirection parentDirection);
   void resolveStyleValues();
-  void resetLayoutRecursive(bool isDisplayNone = true);
+  // scratch of the layout pass, only used for display none.
+  void resetLayoutRecursive(bool isDisplayNone, HPLayoutScratch *scratch);
   void cacheLayoutOrMeasureResult(HPSize availableSize,
                                   HPSizeMode measureMode,
-                                  FlexLayoutAction layoutAction);
+                                  FlexLayoutAction layoutAction,
+                                  HPLayoutScratch *scratch);
   void layoutSingleNode(float availableWidth,
                         MeasureMode widthMeasureMode,
                         float availableHeight,
                         MeasureMode heightMeasureMode,
                         FlexLayoutAction layoutAction,
+                        HPLayoutScratch *scratch,
                         void *layoutContext = nullptr);
   void layoutImpl(float parentWidth,
                   float parentHeight,
                   HPDirection parentDirection,
                   FlexLayoutAction layoutAction,
+                  HPLayoutScratch *scratch,
                   void *layoutContext = nullptr);
-  void calculateItemsFlexBasis(HPSize availableSize, void *layoutContext);
-  bool collectFlexLines(std::vector<FlexLine *> &flexLines, HPSize availableSize);
+  HPLayoutEdges *layoutEdges();
+  bool layoutAppendedItems(HPSize availableSize,
+                           HPSizeMode measureMode,
+                           FlexLayoutAction layoutAction,
+                           HPLayoutScratch *scratch,
+                           void *layoutContext);
+  void saveAppendPass(FlexLayoutAction layoutAction,
+                      HPSize availableSize,
+                      HPSizeMode measureMode,
+                      float sumItemsMainSize,
+                      float lineCrossSize);
+  void invalidateAppendPasses(HPNodeRef item);
+  float calculateItemFlexBaseSize(HPNodeRef item,
+                                  HPSize availableSize,
+                                  HPLayoutScratch *scratch,
+                                  void *layoutContext);
+  void calculateItemsFlexBasis(std::vector<HPFlexItemSizes> &itemSizes,
+                               HPSize availableSize,
+                               HPLayoutScratch *scratch,
+                               void *layoutContext);
+  template <FlexDirection mainAxis>
+  void calculateItemsFlexBasis(std::vector<HPFlexItemSizes> &itemSizes,
+                               HPSize availableSize,
+                               HPLayoutScratch *scratch,
+                               void *layoutContext);
+  bool collectFlexLines(std::vector<FlexLine *> &flexLines,
+                        std::vector<HPFlexItemSizes> &itemSizes,
+                        HPSize availableSize,
+                        HPLayoutScratch *scratch);
   void determineItemsMainAxisSize(std::vector<FlexLine *> &flexLines,
                                   FlexLayoutAction layoutAction);
   float determineCrossAxisSize(std::vector<FlexLine *> &flexLines,
                                HPSize availableSize,
                                FlexLayoutAction layoutAction,
+                               HPLayoutScratch *scratch,
                                void *layoutContext);
-  void mainAxisAlignment(std::vector<FlexLine *> &flexLines);
-  void crossAxisAlignment(std::vector<FlexLine *> &flexLines);
+  void layoutItemWithUsedMainSize(HPNodeRef item,
+                                  FlexLayoutAction layoutAction,
+                                  HPSize availableSize,
+                                  HPLayoutScratch *scratch,
+                                  void *layoutContext);
+  void layoutStretchedItem(HPNodeRef item,
+                           FlexLayoutAction layoutAction,
+                           HPSize availableSize,
+                           HPLayoutScratch *scratch,
+                           void *layoutContext);
+  bool layoutItemsInParallel(std::vector<HPNodeRef> &items,
+                             bool stretched,
+                             FlexLayoutAction layoutAction,
+                             HPSize availableSize,
+                             HPLayoutScratch *scratch,
+                             void *layoutContext);
+  static void layoutItemTask(void *data);
+  uint32_t updateSubtreeWeight();
+  void mainAxisAlignment(std::vector<FlexLine *> &flexLines, HPLayoutScratch *scratch);
+  void crossAxisAlignment(std::vector<FlexLine *> &flexLines, HPLayoutScratch *scratch);
+  template <FlexDirection crossAxis>
+  void crossAxisAlignment(std::vector<FlexLine *> &flexLines, HPLayoutScratch *scratch);
 
-  void layoutFixedItems(HPSizeMode measureMode, void *layoutContext);
-  void calculateFixedItemPosition(HPNodeRef item, FlexDirection axis);
+  void layoutFixedItems(HPLayoutScratch *scratch, void *layoutContext);
+  void calculateFixedItemPosition(HPNodeRef item, FlexDirection axis, HPLayoutScratch *scratch);
+
+  void markHasDirtyDescendant();
+  bool layoutDirtyBoundaries(HPLayoutScratch *scratch, void *layoutContext);
 
   void convertLayoutResult(float absLeft, float absTop);
+  void restoreUnroundedLayout();
 
  public:
-  HPStyle style;
+  // interned, shared by nodes with same style. modify by setStyle.
+  HPStyleRef style;
+  // width and height, kept out of the interned style since they differ
+  // node by node and are changed temporarily during layout.
+  float styleDim[2];
   HPLayout result;
 
   void *context;
   std::vector<HPNodeRef> children;
   HPNodeRef parent;
   HPMeasureFunc measure;
+  // key of measured content in HPMeasureCache::shared(), 0 if not cached.
+  uint64_t measureCacheKey;
+  // arena which allocates this node, nullptr if allocated by HPNodeNew
+  HPNodeArena *arena;
+  // node count of subtree for parallel layout, 0 if it has measure nodes.
+  uint32_t subtreeWeight;
+
+  // inputs of last layout, allocated only for nodes with fixed width and height.
+  HPLayoutBoundaryInput *boundaryInput;
+  // passes of last layout to lay out appended items alone, allocated only
+  // for column containers, see layoutAppendedItems.
+  HPAppendInput *appendInput;
+  // allocated only for windowed scroll containers, see HPScrollWindow.
+  HPScrollWindow *scrollWindow;
 
   bool isFrozen;
+  // out of the scroll window of parent in its last layout, the frame is an
+  // estimate and the subtree is not laid out.
+  bool isWindowedOut;
   bool isDirty;
+  // some layout boundary in subtree is dirty, but dirty stopped there.
+  bool hasDirtyDescendant;
   bool _hasNewLayout;
   HPDirtiedFunc dirtiedFunc;
 
@@ -155,7 +377,138 @@ class HPNode {
   HPLayoutCache layoutCache;
   // layout result is in initial state or not
   bool inInitailState;
-#ifdef LAYOUT_TIME_ANALYZE
-  int fetchCount;
-#endif
+  // left, top, width and height of result before rounded by
+  // convertLayoutResult, the node is laid out again from these. not part of
+  // HPLayout since they are read once per layout of the node, see
+  // restoreUnroundedLayout.
+  float unroundedLayout[4];
+  bool isLayoutRounded;
 };
+
+template <typename Change>
+inline bool HPNode::updateStyle(Change change, bool touchesEdges) {
+  bool changed = change(style.edit());
+  style.commit(changed, changed && touchesEdges);
+  return changed;
+}
+
+template <FlexDirection axis>
+inline float HPNode::getLayoutDim() {
+  return result.dim[HPAxis<axis>::dim];
+}
+
+template <FlexDirection axis>
+inline void HPNode::setLayoutDim(float value) {
+  result.dim[HPAxis<axis>::dim] = value;
+}
+
+template <FlexDirection axis>
+inline float HPNode::getStartPaddingAndBorder() {
+  return style.edges(axis).startPaddingAndBorder;
+}
+
+template <FlexDirection axis>
+inline float HPNode::getPaddingAndBorder() {
+  return style.edges(axis).paddingAndBorder;
+}
+
+template <FlexDirection axis>
+inline float HPNode::getMargin() {
+  return style.edges(axis).margin;
+}
+
+template <FlexDirection axis>
+inline void HPNode::setLayoutStartMargin(float value) {
+  if (result.edges == nullptr && value == 0) {
+    return;
+  }
+  layoutEdges()->margin[HPAxis<axis>::start] = value;
+}
+
+template <FlexDirection axis>
+inline void HPNode::setLayoutEndMargin(float value) {
+  if (result.edges == nullptr && value == 0) {
+    return;
+  }
+  layoutEdges()->margin[HPAxis<axis>::end] = value;
+}
+
+template <FlexDirection axis>
+inline float HPNode::getLayoutStartMargin() {
+  if (result.edges == nullptr) {
+    return 0;
+  }
+  float value = result.edges->margin[HPAxis<axis>::start];
+  return isDefined(value) ? value : 0;
+}
+
+template <FlexDirection axis>
+inline float HPNode::getLayoutEndMargin() {
+  if (result.edges == nullptr) {
+    return 0;
+  }
+  float value = result.edges->margin[HPAxis<axis>::end];
+  return isDefined(value) ? value : 0;
+}
+
+template <FlexDirection axis>
+inline float HPNode::resolveRelativePosition(bool forAxisStart) {
+  if (style->positionType != PositionTypeRelative) {
+    return 0.0f;
+  }
+  float value = style.edges(axis).startPosition;
+  if (isDefined(value)) {
+    return forAxisStart ? value : -value;
+  }
+  value = style.edges(axis).endPosition;
+  if (isDefined(value)) {
+    return forAxisStart ? -value : value;
+  }
+  return 0.0f;
+}
+
+template <FlexDirection axis>
+inline void HPNode::setLayoutStartPosition(float value,
+                                           HPLayoutScratch *scratch,
+                                           bool addRelativePosition) {
+  if (addRelativePosition && style->positionType == PositionTypeRelative) {
+    value += resolveRelativePosition<axis>(true);
+  }
+  if (!FloatIsEqual(result.cachedPosition[HPAxis<axis>::start], value)) {
+    result.cachedPosition[HPAxis<axis>::start] = value;
+    markNewLayout(scratch);
+  }
+  result.position[HPAxis<axis>::start] = value;
+}
+
+template <FlexDirection axis>
+inline void HPNode::setLayoutEndPosition(float value,
+                                         HPLayoutScratch *scratch,
+                                         bool addRelativePosition) {
+  if (addRelativePosition && style->positionType == PositionTypeRelative) {
+    value += resolveRelativePosition<axis>(false);
+  }
+  if (!FloatIsEqual(result.cachedPosition[HPAxis<axis>::end], value)) {
+    result.cachedPosition[HPAxis<axis>::end] = value;
+    markNewLayout(scratch);
+  }
+  result.position[HPAxis<axis>::end] = value;
+}
+
+template <FlexDirection axis>
+inline float HPNode::getLayoutStartPosition() {
+  return result.position[HPAxis<axis>::start];
+}
+
+template <FlexDirection axis>
+inline float HPNode::boundAxis(float value) {
+  float min = style->minDim[HPAxis<axis>::dim];
+  float max = style->maxDim[HPAxis<axis>::dim];
+  if (!isUndefined(max) && max >= 0.0 && value > max) {
+    value = max;
+  }
+  if (!isUndefined(min) && min >= 0.0 && value < min) {
+    value = min;
+  }
+  return value;
+}
@@ -0,0 +1,226 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPNodeArena.h"
+
+#include <algorithm>
+#include <new>
+#include <unordered_map>
+#include <utility>
+
+#include "Hippy.h"
+
+HPNodeArena::HPNodeArena(uint32_t nodesPerSlab_) {
+  nodesPerSlab = nodesPerSlab_ > 0 ? nodesPerSlab_ : HP_ARENA_DEFAULT_SLAB_NODES;
+  slabIndex = 0;
+  slabUsed = 0;
+  liveCount = 0;
+}
+
+HPNodeArena::~HPNodeArena() {
+  // nodes must be freed before its arena.
+  ASSERT(liveCount == 0);
+  for (size_t i = 0; i < slabs.size(); i++) {
+    free(slabs[i].memory);
+  }
+  slabs.clear();
+}
+
+void HPNodeArena::addSlab(uint32_t capacity) {
+  Slab slab;
+  slab.memory = reinterpret_cast<char*>(malloc(sizeof(HPNode) * capacity));
+  slab.capacity = capacity;
+  ASSERT(slab.memory != nullptr);
+  slabs.push_back(slab);
+}
+
+void* HPNodeArena::allocSlot() {
+  if (!freeSlots.empty()) {
+    void* slot = freeSlots.back();
+    freeSlots.pop_back();
+    return slot;
+  }
+
+  if (slabIndex < slabs.size() && slabUsed < slabs[slabIndex].capacity) {
+    return slabs[slabIndex].memory + sizeof(HPNode) * (slabUsed++);
+  }
+
+  if (slabIndex + 1 < slabs.size()) {
+    // slabs recycled by recycleSlabs, bump into next one.
+    slabIndex++;
+  } else {
+    addSlab(nodesPerSlab);
+    slabIndex = slabs.size() - 1;
+  }
+  slabUsed = 1;
+  return slabs[slabIndex].memory;
+}
+
+void HPNodeArena::releaseSlot(void* slot) {
+  ASSERT(liveCount > 0);
+  liveCount--;
+  if (liveCount == 0) {
+    recycleSlabs();
+  } else {
+    freeSlots.push_back(slot);
+  }
+}
+
+// all nodes are freed, reuse slabs from the beginning without free list.
+void HPNodeArena::recycleSlabs() {
+  freeSlots.clear();
+  slabIndex = 0;
+  slabUsed = 0;
+}
+
+HPNodeRef HPNodeArena::allocNode() {
+  HPNodeRef node = new (allocSlot()) HPNode();
+  node->arena = this;
+  liveCount++;
+  return node;
+}
+
+void HPNodeArena::freeNode(HPNodeRef node) {
+  if (node == nullptr) {
+    return;
+  }
+  ASSERT(node->arena == this);
+  // destructor remove node from its parent, reset its children's parent.
+  node->~HPNode();
+  releaseSlot(node);
+}
+
+/*
+ * free root and all its descendants.
+ * unlike HPNodeFreeRecursive for heap nodes, children are not removed
+ * one by one from their parents (which dirties and erases from vector
+ * for every child), descendants are destroyed directly.
+ */
+void HPNodeArena::freeTree(HPNodeRef root) {
+  if (root == nullptr) {
+    return;
+  }
+  ASSERT(root->arena == this);
+  HPNodeRef parent = root->getParent();
+  if (parent != nullptr) {
+    std::vector<HPNodeRef>::iterator p =
+        std::find(parent->children.begin(), parent->children.end(), root);
+    if (p != parent->children.end()) {
+      parent->children.erase(p);
+    }
+    root->setParent(nullptr);
+    parent->markContentDirty();
+  }
+
+  std::vector<HPNodeRef>& items = root->children;
+  for (size_t i = 0; i < items.size(); i++) {
+    HPNodeRef item = items[i];
+    item->setParent(nullptr);
+    if (item->arena == this) {
+      freeTree(item);
+    } else {
+      // child from another arena or heap.
+      HPNodeFreeRecursive(item);
+    }
+  }
+  items.clear();
+  root->~HPNode();
+  releaseSlot(root);
+}
+
+/*
+ * move the tree of root into one slab in depth-first (pre-order) order.
+ * only compact when all live nodes of this arena are in root's tree,
+ * otherwise the old slabs can't be released, return root unchanged.
+ * return the new address of root, relocatedFunc is called for each moved node.
+ */
+HPNodeRef HPNodeArena::compact(HPNodeRef root, HPNodeRelocatedFunc relocatedFunc) {
+  if (root == nullptr || root->arena != this || root->getParent() != nullptr) {
+    return root;
+  }
+
+  std::vector<HPNodeRef> order;
+  order.reserve(liveCount);
+  order.push_back(root);
+  // pre-order traversal, order itself is used as the visited list.
+  std::vector<HPNodeRef> stack;
+  for (size_t i = root->children.size(); i > 0; i--) {
+    stack.push_back(root->children[i - 1]);
+  }
+  while (!stack.empty()) {
+    HPNodeRef node = stack.back();
+    stack.pop_back();
+    if (node->arena != this) {
+      return root;
+    }
+    order.push_back(node);
+    for (size_t i = node->children.size(); i > 0; i--) {
+      stack.push_back(node->children[i - 1]);
+    }
+  }
+
+  if (order.size() != liveCount) {
+    return root;
+  }
+
+  Slab slab;
+  slab.capacity = order.size();
+  slab.memory = reinterpret_cast<char*>(malloc(sizeof(HPNode) * slab.capacity));
+  ASSERT(slab.memory != nullptr);
+
+  std::unordered_map<HPNodeRef, HPNodeRef> relocated;
+  relocated.reserve(order.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    HPNodeRef newNode = new (slab.memory + sizeof(HPNode) * i) HPNode(std::move(*order[i]));
+    relocated[order[i]] = newNode;
+  }
+
+  for (size_t i = 0; i < order.size(); i++) {
+    HPNodeRef oldNode = order[i];
+    HPNodeRef newNode = relocated[oldNode];
+    newNode->parent = newNode->parent == nullptr ? nullptr : relocated[newNode->parent];
+    for (size_t j = 0; j < newNode->children.size(); j++) {
+      newNode->children[j] = relocated[newNode->children[j]];
+    }
+    if (relocatedFunc != nullptr) {
+      relocatedFunc(oldNode, newNode);
+    }
+  }
+
+  // old nodes are left with nothing to unlink or free.
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i]->~HPNode();
+  }
+
+  for (size_t i = 0; i < slabs.size(); i++) {
+    free(slabs[i].memory);
+  }
+  slabs.clear();
+  freeSlots.clear();
+  slabs.push_back(slab);
+  slabIndex = 0;
+  slabUsed = slab.capacity;
+  return relocated[root];
+}
+
+uint32_t HPNodeArena::liveNodeCount() {
+  return liveCount;
+}
+
+uint32_t HPNodeArena::slabCount() {
+  return slabs.size();
+}
@@ -0,0 +1,69 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+class HPNode;
+typedef HPNode* HPNodeRef;
+// called for every node moved by HPNodeArena::compact,
+// owners holding node pointers (java FlexNode etc.) should update them.
+typedef void (*HPNodeRelocatedFunc)(HPNodeRef oldNode, HPNodeRef newNode);
+
+#define HP_ARENA_DEFAULT_SLAB_NODES 256
+
+/* Slab allocator for the nodes of one root tree.
+ * nodes are placement-constructed in fixed size slabs, freed slots are reused,
+ * and when the last node is freed all slabs are recycled in one step.
+ * compact() moves a whole tree into one slab in depth-first order, so a layout
+ * pass walks memory mostly sequentially.
+ */
+class HPNodeArena {
+ public:
+  explicit HPNodeArena(uint32_t nodesPerSlab = HP_ARENA_DEFAULT_SLAB_NODES);
+  virtual ~HPNodeArena();
+  HPNodeRef allocNode();
+  void freeNode(HPNodeRef node);
+  void freeTree(HPNodeRef root);
+  HPNodeRef compact(HPNodeRef root, HPNodeRelocatedFunc relocatedFunc = nullptr);
+  uint32_t liveNodeCount();
+  uint32_t slabCount();
+
+ protected:
+  typedef struct {
+    char* memory;
+    uint32_t capacity;
+  } Slab;
+
+  void* allocSlot();
+  void releaseSlot(void* slot);
+  void addSlab(uint32_t capacity);
+  void recycleSlabs();
+
+ private:
+  std::vector<Slab> slabs;
+  // slots released by freeNode, reused before bump allocation.
+  std::vector<void*> freeSlots;
+  uint32_t nodesPerSlab;
+  // bump position in the last slab
+  uint32_t slabIndex;
+  uint32_t slabUsed;
+  uint32_t liveCount;
+};
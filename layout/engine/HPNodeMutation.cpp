@@ -0,0 +1,298 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPNodeMutation.h"
+
+#include "Hippy.h"
+
+// largest value of enum properties, -1 for properties holding a float.
+static int HPStylePropertyMaxEnum(uint8_t property) {
+  switch (property) {
+    case HPStylePropertyDirection:
+      return DirectionRTL;
+    case HPStylePropertyFlexDirection:
+      return FLexDirectionColumnReverse;
+    case HPStylePropertyJustifyContent:
+    case HPStylePropertyAlignContent:
+    case HPStylePropertyAlignItems:
+    case HPStylePropertyAlignSelf:
+      return FlexAlignSpaceEvenly;
+    case HPStylePropertyFlexWrap:
+      return FlexWrapReverse;
+    case HPStylePropertyPositionType:
+      return PositionTypeAbsolute;
+    case HPStylePropertyDisplay:
+      return DisplayTypeNone;
+    case HPStylePropertyOverflow:
+      return OverflowScroll;
+    case HPStylePropertyNodeType:
+      return NodeTypeText;
+    default:
+      return -1;
+  }
+}
+
+// enum values index per axis tables, so they must be in range.
+static bool HPStyleMutationIsValid(const HPMutation& mutation) {
+  if (mutation.property >= HPStylePropertyCount) {
+    return false;
+  }
+  if (mutation.property >= HPStylePropertyMargin &&
+      mutation.property <= HPStylePropertyPosition && mutation.edge > CSSAll) {
+    return false;
+  }
+  int maxEnum = HPStylePropertyMaxEnum(mutation.property);
+  if (maxEnum < 0) {
+    return true;
+  }
+  // NaN fails both comparisons.
+  return mutation.value >= 0.0f && mutation.value < maxEnum + 1.0f;
+}
+
+// whether ancestor is node itself or one of its ancestors, inserting such a
+// child would make a cycle.
+static bool HPNodeIsSelfOrAncestor(HPNodeRef node, HPNodeRef ancestor) {
+  for (HPNodeRef current = node; current != nullptr; current = current->getParent()) {
+    if (current == ancestor) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// style of one node being changed by a run of HPMutationSetStyle.
+class HPPendingStyle {
+ public:
+  HPPendingStyle() : node(nullptr), changed(false) {}
+
+  void begin(HPNodeRef target) {
+    if (node == target) {
+      return;
+    }
+    flush();
+    node = target;
+    style = node->getStyle();
+  }
+
+  void flush() {
+    if (node == nullptr) {
+      return;
+    }
+    if (changed) {
+      node->setStyle(style);
+      node->markAsDirty();
+    }
+    node = nullptr;
+    changed = false;
+  }
+
+  template <typename T>
+  void set(T& field, T value) {
+    if (field != value) {
+      field = value;
+      changed = true;
+    }
+  }
+
+  void setFloat(float& field, float value) {
+    if (!FloatIsEqual(field, value)) {
+      field = value;
+      changed = true;
+    }
+  }
+
+  void setDim(Dimension dim, float value) {
+    if (!FloatIsEqual(node->styleDim[dim], value)) {
+      node->styleDim[dim] = value;
+      changed = true;
+    }
+  }
+
+  // same as HPNodeStyleSetFlex.
+  void setFlex(float flex) {
+    if (FloatIsEqual(style.flex, flex)) {
+      return;
+    }
+    if (FloatIsEqual(flex, 0.0f)) {
+      style.flexGrow = 0.0f;
+      style.flexShrink = 0.0f;
+    } else if (flex > 0.0f) {
+      style.flexGrow = flex;
+      style.flexShrink = 1.0f;
+    } else {
+      style.flexGrow = 0.0f;
+      style.flexShrink = -flex;
+    }
+    style.flex = flex;
+    changed = true;
+  }
+
+  bool apply(const HPMutation& mutation) {
+    float value = mutation.value;
+    CSSDirection edge = static_cast<CSSDirection>(mutation.edge);
+    int enumValue = static_cast<int>(value);
+    switch (mutation.property) {
+      case HPStylePropertyDirection:
+        set(style.direction, static_cast<HPDirection>(enumValue));
+        break;
+      case HPStylePropertyFlexDirection:
+        set(style.flexDirection, static_cast<FlexDirection>(enumValue));
+        break;
+      case HPStylePropertyJustifyContent:
+        set(style.justifyContent, static_cast<FlexAlign>(enumValue));
+        break;
+      case HPStylePropertyAlignContent:
+        set(style.alignContent, static_cast<FlexAlign>(enumValue));
+        break;
+      case HPStylePropertyAlignItems:
+        set(style.alignItems, static_cast<FlexAlign>(enumValue));
+        break;
+      case HPStylePropertyAlignSelf:
+        set(style.alignSelf, static_cast<FlexAlign>(enumValue));
+        break;
+      case HPStylePropertyFlexWrap:
+        set(style.flexWrap, static_cast<FlexWrapMode>(enumValue));
+        break;
+      case HPStylePropertyPositionType:
+        set(style.positionType, static_cast<PositionType>(enumValue));
+        break;
+      case HPStylePropertyDisplay:
+        set(style.displayType, static_cast<DisplayType>(enumValue));
+        break;
+      case HPStylePropertyOverflow:
+        set(style.overflowType, static_cast<OverflowType>(enumValue));
+        break;
+      case HPStylePropertyFlex:
+        setFlex(value);
+        break;
+      case HPStylePropertyFlexGrow:
+        setFloat(style.flexGrow, value);
+        break;
+      case HPStylePropertyFlexShrink:
+        setFloat(style.flexShrink, value);
+        break;
+      case HPStylePropertyFlexBasis:
+        setFloat(style.flexBasis, value);
+        break;
+      case HPStylePropertyWidth:
+        setDim(DimWidth, value);
+        break;
+      case HPStylePropertyHeight:
+        setDim(DimHeight, value);
+        break;
+      case HPStylePropertyMinWidth:
+        setFloat(style.minDim[DimWidth], value);
+        break;
+      case HPStylePropertyMinHeight:
+        setFloat(style.minDim[DimHeight], value);
+        break;
+      case HPStylePropertyMaxWidth:
+        setFloat(style.maxDim[DimWidth], value);
+        break;
+      case HPStylePropertyMaxHeight:
+        setFloat(style.maxDim[DimHeight], value);
+        break;
+      case HPStylePropertyMargin:
+        changed |= style.setMargin(edge, value);
+        break;
+      case HPStylePropertyMarginAuto:
+        changed |= style.setMargin(edge, VALUE_AUTO);
+        break;
+      case HPStylePropertyPadding:
+        changed |= style.setPadding(edge, value);
+        break;
+      case HPStylePropertyBorder:
+        changed |= style.setBorder(edge, value);
+        break;
+      case HPStylePropertyPosition:
+        changed |= style.setPosition(edge, value);
+        break;
+      case HPStylePropertyNodeType:
+        set(style.nodeType, static_cast<NodeType>(enumValue));
+        break;
+      default:
+        return false;
+    }
+    return true;
+  }
+
+ private:
+  HPNodeRef node;
+  HPStyle style;
+  bool changed;
+};
+
+uint32_t HPNodeApplyMutations(HPNodeRef* nodes,
+                              uint32_t nodeCount,
+                              const HPMutation* mutations,
+                              uint32_t count,
+                              HPNodeArenaRef arena) {
+  if (nodes == nullptr || mutations == nullptr) {
+    return 0;
+  }
+
+  HPPendingStyle pending;
+  uint32_t applied = 0;
+  for (; applied < count; applied++) {
+    const HPMutation& mutation = mutations[applied];
+    if (mutation.node >= nodeCount) {
+      break;
+    }
+    HPNodeRef node = nodes[mutation.node];
+    if (mutation.op == HPMutationCreateNode) {
+      if (node != nullptr) {
+        break;
+      }
+      nodes[mutation.node] = HPNodeNewInArena(arena);
+      continue;
+    }
+    if (node == nullptr) {
+      break;
+    }
+
+    if (mutation.op == HPMutationSetStyle) {
+      if (!HPStyleMutationIsValid(mutation)) {
+        break;
+      }
+      pending.begin(node);
+      if (!pending.apply(mutation)) {
+        break;
+      }
+      continue;
+    }
+
+    // tree changes dirty nodes themselves, finish pending style first.
+    pending.flush();
+    if (mutation.arg >= nodeCount || nodes[mutation.arg] == nullptr) {
+      break;
+    }
+    HPNodeRef child = nodes[mutation.arg];
+    bool succeeded = false;
+    if (mutation.op == HPMutationInsertChild) {
+      succeeded = child->getParent() == nullptr && !HPNodeIsSelfOrAncestor(node, child) &&
+                  mutation.index <= node->childCount() &&
+                  node->insertChild(child, mutation.index);
+    } else if (mutation.op == HPMutationRemoveChild) {
+      succeeded = node->removeChild(child);
+    }
+    if (!succeeded) {
+      break;
+    }
+  }
+  pending.flush();
+  return applied;
+}
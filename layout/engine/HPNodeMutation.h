@@ -0,0 +1,83 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Packed buffer of tree and style operations, applied in one call by
+ * HPNodeApplyMutations, e.g. a whole screen created from java through one JNI
+ * call instead of a call per property.
+ * nodes are referenced by index in a node table given with the buffer.
+ * style changes of a node are applied to a copy of its style, which is
+ * interned and marked dirty once when the node's run of style mutations ends,
+ * instead of once per property.
+ */
+typedef enum {
+  HPMutationCreateNode,   // new node stored at nodes[node]
+  HPMutationInsertChild,  // insert nodes[arg] to nodes[node] at position index
+  HPMutationRemoveChild,  // remove nodes[arg] from nodes[node]
+  HPMutationSetStyle,     // set property of nodes[node] to value
+  HPMutationOpCount,
+} HPMutationOp;
+
+// properties of HPMutationSetStyle, enum values are passed as float value.
+typedef enum {
+  HPStylePropertyDirection,
+  HPStylePropertyFlexDirection,
+  HPStylePropertyJustifyContent,
+  HPStylePropertyAlignContent,
+  HPStylePropertyAlignItems,
+  HPStylePropertyAlignSelf,
+  HPStylePropertyFlexWrap,
+  HPStylePropertyPositionType,
+  HPStylePropertyDisplay,
+  HPStylePropertyOverflow,
+  HPStylePropertyFlex,
+  HPStylePropertyFlexGrow,
+  HPStylePropertyFlexShrink,
+  HPStylePropertyFlexBasis,
+  HPStylePropertyWidth,
+  HPStylePropertyHeight,
+  HPStylePropertyMinWidth,
+  HPStylePropertyMinHeight,
+  HPStylePropertyMaxWidth,
+  HPStylePropertyMaxHeight,
+  // properties below use edge
+  HPStylePropertyMargin,
+  HPStylePropertyMarginAuto,
+  HPStylePropertyPadding,
+  HPStylePropertyBorder,
+  HPStylePropertyPosition,
+  // properties below have no edge, appended to keep ids used by java.
+  HPStylePropertyNodeType,
+  HPStylePropertyCount,
+} HPStyleProperty;
+
+// 16 bytes, little endian as written by java ByteBuffer in native order.
+typedef struct {
+  uint8_t op;        // HPMutationOp
+  uint8_t property;  // HPStyleProperty of HPMutationSetStyle
+  uint8_t edge;      // CSSDirection of edge properties
+  uint8_t reserved;
+  uint32_t node;
+  uint32_t arg;
+  union {
+    float value;
+    uint32_t index;
+  };
+} HPMutation;
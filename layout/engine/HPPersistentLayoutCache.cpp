@@ -0,0 +1,305 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPPersistentLayoutCache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <unordered_map>
+
+#include "HPNode.h"
+#include "HPUtil.h"
+
+// FNV-1a over 32 bit words.
+static inline uint64_t hashWord(uint64_t hash, uint32_t word) {
+  hash ^= word;
+  hash *= 1099511628211ull;
+  return hash;
+}
+
+static inline uint32_t floatBits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+HPPersistentLayoutCache::HPPersistentLayoutCache(const char* directory, uint64_t salt)
+    : directory(directory == nullptr ? "." : directory), salt(salt) {
+  resetStats();
+}
+
+HPPersistentLayoutCache::~HPPersistentLayoutCache() {}
+
+bool HPPersistentLayoutCache::layout(HPNodeRef root,
+                                     float width,
+                                     float height,
+                                     HPDirection direction,
+                                     void* layoutContext,
+                                     HPLayoutStats* stats) {
+  uint64_t key = treeKey(root, width, height, direction);
+  if (key != 0 && load(key, width, height, direction)) {
+    counters.hitCount++;
+    if (stats != nullptr) {
+      HPLayoutStatsReset(stats);
+    }
+    nodes.clear();
+    styles.clear();
+    return true;
+  }
+  HPLayoutOptions options;
+  options.stats = stats;
+  root->layout(width, height, direction, layoutContext, options);
+  if (key == 0) {
+    counters.uncacheableCount++;
+  } else {
+    counters.missCount++;
+    if (store(key, width, height, direction)) {
+      counters.storeCount++;
+    }
+  }
+  nodes.clear();
+  styles.clear();
+  return false;
+}
+
+HPPersistentLayoutCacheStats HPPersistentLayoutCache::stats() {
+  return counters;
+}
+
+void HPPersistentLayoutCache::resetStats() {
+  memset(&counters, 0, sizeof(counters));
+}
+
+uint64_t HPPersistentLayoutCache::treeKey(HPNodeRef root,
+                                          float width,
+                                          float height,
+                                          HPDirection direction) {
+  nodes.clear();
+  styles.clear();
+  if (root == nullptr || root->getParent() != nullptr) {
+    return 0;
+  }
+  uint64_t hash = 14695981039346656037ull;
+  hash = hashWord(hash, static_cast<uint32_t>(salt));
+  hash = hashWord(hash, static_cast<uint32_t>(salt >> 32));
+  hash = hashWord(hash, floatBits(width));
+  hash = hashWord(hash, floatBits(height));
+  hash = hashWord(hash, static_cast<uint32_t>(direction));
+  // depth first, children pushed in reverse to visit them in order.
+  stack.clear();
+  stack.push_back(root);
+  while (!stack.empty()) {
+    HPNodeRef node = stack.back();
+    stack.pop_back();
+    if ((node->measure != nullptr && node->measureCacheKey == 0) || node->scrollWindow != nullptr) {
+      nodes.clear();
+      styles.clear();
+      return 0;
+    }
+    nodes.push_back(node);
+    styles.push_back(node->style);
+    hash = hashWord(hash, node->style.hash());
+    hash = hashWord(hash, floatBits(node->styleDim[DimWidth]));
+    hash = hashWord(hash, floatBits(node->styleDim[DimHeight]));
+    hash = hashWord(hash, node->measure != nullptr ? 1 : 0);
+    hash = hashWord(hash, static_cast<uint32_t>(node->measureCacheKey));
+    hash = hashWord(hash, static_cast<uint32_t>(node->measureCacheKey >> 32));
+    hash = hashWord(hash, node->childCount());
+    for (uint32_t i = node->childCount(); i > 0; i--) {
+      stack.push_back(node->getChild(i - 1));
+    }
+  }
+  // 0 means not cacheable.
+  return hash == 0 ? 1 : hash;
+}
+
+std::string HPPersistentLayoutCache::pathOf(uint64_t key) {
+  char name[32];
+  snprintf(name, sizeof(name), "/%016llx.hplayout", static_cast<unsigned long long>(key));
+  return directory + name;
+}
+
+// the whole entry is checked against nodes before results are written, so a
+// tree is either laid out from the entry or left untouched.
+bool HPPersistentLayoutCache::load(uint64_t key,
+                                   float width,
+                                   float height,
+                                   HPDirection direction) {
+  FILE* file = fopen(pathOf(key).c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  buffer.clear();
+  uint8_t chunk[4096];
+  size_t size;
+  while ((size = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    buffer.insert(buffer.end(), chunk, chunk + size);
+  }
+  fclose(file);
+
+  HPPersistentLayoutHeader header;
+  if (buffer.size() < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, buffer.data(), sizeof(header));
+  if (header.magic != HP_PERSISTENT_LAYOUT_MAGIC ||
+      header.version != HP_PERSISTENT_LAYOUT_VERSION || header.key != key ||
+      header.nodeCount != nodes.size() || header.edgeCount > header.nodeCount ||
+      header.styleCount > header.nodeCount || header.styleSize != HPStyle::fieldsSize() ||
+      floatBits(header.width) != floatBits(width) ||
+      floatBits(header.height) != floatBits(height) ||
+      header.direction != static_cast<uint32_t>(direction)) {
+    return false;
+  }
+  // counts are at most nodes.size(), so offsets don't overflow.
+  const size_t stylesOffset = sizeof(header);
+  const size_t recordsOffset = stylesOffset + header.styleCount * header.styleSize;
+  const size_t edgesOffset =
+      recordsOffset + header.nodeCount * sizeof(HPPersistentLayoutRecord);
+  if (buffer.size() != edgesOffset + header.edgeCount * sizeof(HPLayoutEdges)) {
+    return false;
+  }
+  const uint8_t* storedStyles = buffer.data() + stylesOffset;
+  const uint8_t* records = buffer.data() + recordsOffset;
+  styleFields.resize(header.styleSize);
+  uint32_t edgeCount = 0;
+  for (size_t i = 0; i < nodes.size(); i++) {
+    HPNodeRef node = nodes[i];
+    HPPersistentLayoutRecord record;
+    memcpy(&record, records + i * sizeof(record), sizeof(record));
+    if (record.styleIndex >= header.styleCount || record.childCount != node->childCount() ||
+        floatBits(record.styleDim[DimWidth]) != floatBits(node->styleDim[DimWidth]) ||
+        floatBits(record.styleDim[DimHeight]) != floatBits(node->styleDim[DimHeight]) ||
+        record.measureCacheKey != node->measureCacheKey ||
+        record.hasMeasure != (node->measure != nullptr ? 1 : 0) ||
+        record.direction > DirectionRTL || record.isRounded > 1) {
+      return false;
+    }
+    styles[i].get().writeFields(styleFields.data());
+    if (memcmp(storedStyles + record.styleIndex * header.styleSize, styleFields.data(),
+               header.styleSize) != 0) {
+      return false;
+    }
+    edgeCount += record.hasEdges ? 1 : 0;
+  }
+  if (edgeCount != header.edgeCount) {
+    return false;
+  }
+
+  const uint8_t* edges = buffer.data() + edgesOffset;
+  for (size_t i = 0; i < nodes.size(); i++) {
+    HPNodeRef node = nodes[i];
+    HPPersistentLayoutRecord record;
+    memcpy(&record, records + i * sizeof(record), sizeof(record));
+    // clean as after layout, without calling dirtied functions.
+    node->initLayoutResult();
+    node->layoutCache.clearCache();
+    memcpy(node->result.position, record.position, sizeof(record.position));
+    memcpy(node->result.cachedPosition, record.position, sizeof(record.position));
+    node->result.dim[DimWidth] = record.dim[DimWidth];
+    node->result.dim[DimHeight] = record.dim[DimHeight];
+    node->result.hadOverflow = record.hadOverflow != 0;
+    node->result.direction = static_cast<HPDirection>(record.direction);
+    // laid out again from the same values as after a layout.
+    memcpy(node->unroundedLayout, record.unrounded, sizeof(record.unrounded));
+    node->isLayoutRounded = record.isRounded != 0;
+    if (record.hasEdges) {
+      node->result.edges = new HPLayoutEdges();
+      memcpy(node->result.edges, edges, sizeof(HPLayoutEdges));
+      edges += sizeof(HPLayoutEdges);
+    }
+    node->isWindowedOut = false;
+    node->isDirty = false;
+    node->setHasNewLayout(true);
+    node->inInitailState = false;
+  }
+  return true;
+}
+
+bool HPPersistentLayoutCache::store(uint64_t key,
+                                    float width,
+                                    float height,
+                                    HPDirection direction) {
+  HPPersistentLayoutHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = HP_PERSISTENT_LAYOUT_MAGIC;
+  header.version = HP_PERSISTENT_LAYOUT_VERSION;
+  header.key = key;
+  header.nodeCount = static_cast<uint32_t>(nodes.size());
+  header.styleSize = static_cast<uint32_t>(HPStyle::fieldsSize());
+  header.width = width;
+  header.height = height;
+  header.direction = static_cast<uint32_t>(direction);
+  std::vector<HPPersistentLayoutRecord> records(nodes.size());
+  std::vector<HPLayoutEdges> edges;
+  // nodes with equal styles share an interned one, which is written once.
+  std::unordered_map<const HPStyle*, uint32_t> styleIndexes;
+  styleFields.clear();
+  for (size_t i = 0; i < nodes.size(); i++) {
+    HPNodeRef node = nodes[i];
+    HPLayout& result = node->result;
+    HPPersistentLayoutRecord& record = records[i];
+    memset(&record, 0, sizeof(record));
+    const HPStyle* style = &styles[i].get();
+    std::unordered_map<const HPStyle*, uint32_t>::iterator it = styleIndexes.find(style);
+    if (it == styleIndexes.end()) {
+      it = styleIndexes.insert(std::make_pair(style, header.styleCount++)).first;
+      styleFields.resize(styleFields.size() + header.styleSize);
+      style->writeFields(styleFields.data() + styleFields.size() - header.styleSize);
+    }
+    record.styleIndex = it->second;
+    record.childCount = node->childCount();
+    record.styleDim[DimWidth] = node->styleDim[DimWidth];
+    record.styleDim[DimHeight] = node->styleDim[DimHeight];
+    record.measureCacheKey = node->measureCacheKey;
+    record.hasMeasure = node->measure != nullptr ? 1 : 0;
+    memcpy(record.position, result.position, sizeof(record.position));
+    record.dim[DimWidth] = result.dim[DimWidth];
+    record.dim[DimHeight] = result.dim[DimHeight];
+    record.direction = static_cast<uint8_t>(result.direction);
+    record.hadOverflow = result.hadOverflow ? 1 : 0;
+    record.hasEdges = result.edges != nullptr ? 1 : 0;
+    if (node->isLayoutRounded) {
+      memcpy(record.unrounded, node->unroundedLayout, sizeof(record.unrounded));
+      record.isRounded = 1;
+    }
+    if (result.edges != nullptr) {
+      edges.push_back(*result.edges);
+    }
+  }
+  header.edgeCount = static_cast<uint32_t>(edges.size());
+
+  // readers never see a partially written entry.
+  std::string path = pathOf(key);
+  std::string temporaryPath = path + ".tmp";
+  FILE* file = fopen(temporaryPath.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(styleFields.data(), 1, styleFields.size(), file) == styleFields.size() &&
+            fwrite(records.data(), sizeof(HPPersistentLayoutRecord), records.size(), file) ==
+                records.size() &&
+            fwrite(edges.data(), sizeof(HPLayoutEdges), edges.size(), file) == edges.size();
+  ok = fclose(file) == 0 && ok;
+  if (!ok || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    remove(temporaryPath.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,127 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "Flex.h"
+#include "HPLayoutStats.h"
+#include "HPNode.h"
+
+#define HP_PERSISTENT_LAYOUT_MAGIC 0x434c5048  // "HPLC"
+#define HP_PERSISTENT_LAYOUT_VERSION 3
+
+// file of one entry, little endian as written by the device:
+//   HPPersistentLayoutHeader
+//   uint8_t[styleCount][styleSize]       distinct styles, see HPStyle::writeFields
+//   HPPersistentLayoutRecord[nodeCount]  depth first order, root first
+//   HPLayoutEdges[edgeCount]             of records with hasEdges, in order
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint32_t nodeCount;
+  uint32_t edgeCount;
+  uint32_t styleCount;
+  // HPStyle::fieldsSize() of the build which wrote the entry.
+  uint32_t styleSize;
+  float width;
+  float height;
+  uint32_t direction;
+  uint32_t reserved;
+} HPPersistentLayoutHeader;
+
+typedef struct {
+  // checked against the node before any result is applied, the tree key
+  // is only a hash of them.
+  uint32_t styleIndex;
+  uint32_t childCount;
+  float styleDim[2];
+  uint64_t measureCacheKey;
+  uint8_t hasMeasure;
+  float position[4];
+  float dim[2];
+  // left, top, width and height before rounded, see HPNode::unroundedLayout.
+  float unrounded[4];
+  uint8_t direction;
+  uint8_t hadOverflow;
+  uint8_t hasEdges;
+  uint8_t isRounded;
+} HPPersistentLayoutRecord;
+
+typedef struct {
+  uint32_t hitCount;
+  uint32_t missCount;
+  // trees which can't be keyed, see treeKey.
+  uint32_t uncacheableCount;
+  uint32_t storeCount;
+} HPPersistentLayoutCacheStats;
+
+/* Layout results of whole trees kept on disk between launches, so the first
+ * layout of a page laid out before is read instead of computed.
+ * a tree is keyed by a hash of its structure, styles and measure cache keys
+ * (see HPNodeSetMeasureCacheKey) plus viewport and salt. the caller changes
+ * salt when anything else measure functions depend on changes, e.g. font
+ * scale or app version.
+ * on a hit results are written to nodes, which are clean as after a layout
+ * but keep no layout cache, so the next layout of the tree is a full one.
+ * rounded results keep their unrounded values, which later layouts start from.
+ * an entry whose styles, sizes, measure keys and child counts do not all
+ * match the tree node by node, or which can't be read, falls back to normal
+ * layout, whose results replace it.
+ * each entry is a file in directory, written to a temporary file and renamed.
+ * not thread safe, use one cache per layout thread.
+ */
+class HPPersistentLayoutCache {
+ public:
+  explicit HPPersistentLayoutCache(const char* directory, uint64_t salt = 0);
+  virtual ~HPPersistentLayoutCache();
+  // true if results are read from the cache, else root is laid out by
+  // HPNode::layout and its results stored.
+  bool layout(HPNodeRef root,
+              float width,
+              float height,
+              HPDirection direction,
+              void* layoutContext = nullptr,
+              HPLayoutStats* stats = nullptr);
+  HPPersistentLayoutCacheStats stats();
+  void resetStats();
+
+ protected:
+  // walk root's tree into nodes, 0 if it has measure nodes without measure
+  // cache key or windowed scroll containers.
+  uint64_t treeKey(HPNodeRef root, float width, float height, HPDirection direction);
+  bool load(uint64_t key, float width, float height, HPDirection direction);
+  bool store(uint64_t key, float width, float height, HPDirection direction);
+  std::string pathOf(uint64_t key);
+
+ private:
+  std::string directory;
+  uint64_t salt;
+  HPPersistentLayoutCacheStats counters;
+  // nodes of the tree being laid out in depth first order, and their styles
+  // before layout, which changes style of root.
+  std::vector<HPNodeRef> nodes;
+  std::vector<HPStyleRef> styles;
+  std::vector<HPNodeRef> stack;
+  std::vector<uint8_t> buffer;
+  std::vector<uint8_t> styleFields;
+};
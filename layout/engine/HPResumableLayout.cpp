@@ -0,0 +1,153 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPResumableLayout.h"
+
+// clock is read once per this many visits.
+static const uint32_t kClockCheckInterval = 8;
+
+// results and caches of an abandoned layout are partial, nodes it didn't
+// reach are still dirty but may have cached results of unfinished passes.
+static void dirtyTree(HPNodeRef node) {
+  node->layoutCache.clearCache();
+  node->markAsDirty();
+  for (uint32_t i = 0; i < node->childCount(); i++) {
+    dirtyTree(node->getChild(i));
+  }
+}
+
+HPResumableLayout::HPResumableLayout(HPNodeRef node,
+                                     float parentWidth,
+                                     float parentHeight,
+                                     HPDirection parentDirection,
+                                     void* layoutContext) {
+  root = node;
+  width = parentWidth;
+  height = parentHeight;
+  direction = parentDirection;
+  context = layoutContext;
+  state = StateParked;
+  started = false;
+  abandoned = false;
+  deadline = 0;
+  visitLimit = 0;
+  sliceVisits = 0;
+  visits = 0;
+}
+
+HPResumableLayout::~HPResumableLayout() {
+  if (!started) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state == StateParked) {
+      abandoned = true;
+      state = StateRunning;
+    }
+  }
+  condition.notify_all();
+  pthread_join(thread, nullptr);
+  // on the calling thread, dirtied callbacks of nodes are called here.
+  if (abandoned) {
+    dirtyTree(root);
+  }
+}
+
+HPLayoutStatus HPResumableLayout::run(double budgetMs, uint32_t budgetVisits) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (state == StateFinished) {
+    return LayoutStatusFinished;
+  }
+  deadline = budgetMs > 0 ? HPLayoutScratch::now() + budgetMs : 0;
+  visitLimit = budgetVisits;
+  sliceVisits = 0;
+  state = StateRunning;
+  if (!started) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, HP_RESUMABLE_LAYOUT_STACK_SIZE);
+    started = pthread_create(&thread, &attr, &HPResumableLayout::threadEntry, this) == 0;
+    pthread_attr_destroy(&attr);
+    if (!started) {
+      // no thread to park, laid out in this call.
+      root->layout(width, height, direction, context);
+      state = StateFinished;
+      return LayoutStatusFinished;
+    }
+  } else {
+    condition.notify_all();
+  }
+  condition.wait(lock, [this]() { return state != StateRunning; });
+  return state == StateFinished ? LayoutStatusFinished : LayoutStatusNotFinished;
+}
+
+bool HPResumableLayout::isFinished() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return state == StateFinished;
+}
+
+// budget is checked before the visit is counted, so every slice makes at
+// least one visit and never more than its limit.
+bool HPResumableLayout::checkpoint() {
+  if (abandoned) {
+    return false;
+  }
+  if (sliceVisits > 0) {
+    bool expired = visitLimit > 0 && sliceVisits >= visitLimit;
+    if (!expired && deadline > 0 && sliceVisits % kClockCheckInterval == 0) {
+      expired = HPLayoutScratch::now() >= deadline;
+    }
+    if (expired) {
+      std::unique_lock<std::mutex> lock(mutex);
+      state = StateParked;
+      condition.notify_all();
+      condition.wait(lock, [this]() { return state == StateRunning; });
+      if (abandoned) {
+        return false;
+      }
+    }
+  }
+  visits++;
+  sliceVisits++;
+  return true;
+}
+
+void HPResumableLayout::publishNewLayouts() {
+  if (!abandoned) {
+    for (size_t i = 0; i < newLayouts.size(); i++) {
+      newLayouts[i]->setHasNewLayout(true);
+    }
+  }
+  std::vector<HPNodeRef>().swap(newLayouts);
+}
+
+void* HPResumableLayout::threadEntry(void* layout) {
+  static_cast<HPResumableLayout*>(layout)->layoutThreadMain();
+  return nullptr;
+}
+
+void HPResumableLayout::layoutThreadMain() {
+  HPLayoutOptions options;
+  options.resumableLayout = this;
+  root->layout(width, height, direction, context, options);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    state = StateFinished;
+  }
+  condition.notify_all();
+}
@@ -0,0 +1,113 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "HPNode.h"
+
+// stack size of the layout thread, layoutImpl recurses once per tree level.
+#ifndef HP_RESUMABLE_LAYOUT_STACK_SIZE
+#define HP_RESUMABLE_LAYOUT_STACK_SIZE (1024 * 1024)
+#endif
+
+typedef enum {
+  LayoutStatusFinished,
+  LayoutStatusNotFinished,
+} HPLayoutStatus;
+
+/* Layout of a tree spread over several calls of run(), each within a time
+ * or work budget, e.g. first layout of a huge page over several frames.
+ * layoutImpl is recursive, so the layout runs on a thread of its own which
+ * parks at a checkpoint when the budget of run() expires, keeping its
+ * progress on its stack, and continues at the next run(). run() waits
+ * meanwhile, so layout never runs concurrently with its caller.
+ * node results are written in place, but new layouts are published only
+ * when it's finished: hasNewLayout of nodes is set, and results rounded,
+ * once the whole tree is laid out, so a transfer of new layouts between
+ * run() calls takes none of the partial results. the tree must not be
+ * changed until run() returns LayoutStatusFinished. measure functions are
+ * called on the layout thread. a layout freed before it's finished is
+ * abandoned, the tree is marked dirty then and nothing is published.
+ * every layout costs a pthread, created at the first run() and joined when
+ * the layout is freed, whose stack (HP_RESUMABLE_LAYOUT_STACK_SIZE, 1 MB by
+ * default) stays reserved until then. it pays off for a large tree laid out
+ * over several frames; small trees, or many layouts in flight at once,
+ * should use HPNodeDoLayout instead.
+ */
+class HPResumableLayout {
+ public:
+  HPResumableLayout(HPNodeRef node,
+                    float parentWidth,
+                    float parentHeight,
+                    HPDirection direction,
+                    void* layoutContext);
+  // an unfinished layout stops at its next checkpoint, its partial results
+  // are dropped by marking the whole tree dirty.
+  virtual ~HPResumableLayout();
+  // budgetMs <= 0 or budgetVisits 0 is no limit of that kind. every call
+  // does at least one layoutImpl visit.
+  HPLayoutStatus run(double budgetMs, uint32_t budgetVisits = 0);
+  bool isFinished();
+  // layoutImpl visits so far.
+  uint32_t visitCount() { return visits; }
+  // called by layoutImpl on the layout thread, parks if budget expired.
+  // returns false if the layout was abandoned, layoutImpl returns at once.
+  bool checkpoint();
+  // called by HPNode on the layout thread for a node with a new layout.
+  void deferNewLayout(HPNodeRef node) { newLayouts.push_back(node); }
+  // sets hasNewLayout of deferred nodes, once the layout is finished.
+  void publishNewLayouts();
+
+ protected:
+  void layoutThreadMain();
+  static void* threadEntry(void* layout);
+
+ private:
+  typedef enum {
+    StateParked,
+    StateRunning,
+    StateFinished,
+  } State;
+
+  HPNodeRef root;
+  float width;
+  float height;
+  HPDirection direction;
+  void* context;
+
+  pthread_t thread;
+  std::mutex mutex;
+  std::condition_variable condition;
+  State state;
+  bool started;
+  // set while parked, read by the layout thread only after it resumes.
+  bool abandoned;
+  // budget of current run, only used by the layout thread while running.
+  double deadline;
+  uint32_t visitLimit;
+  uint32_t sliceVisits;
+  uint32_t visits;
+  // nodes with a new layout, published when the layout is finished.
+  std::vector<HPNodeRef> newLayouts;
+};
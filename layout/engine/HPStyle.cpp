@@ -20,6 +20,8 @@
 #include <string.h>
 
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
 
 typedef float CSSValue[CSS_PROPS_COUNT];
 typedef CSSDirection CSSFrom[CSS_PROPS_COUNT];
@@ -58,8 +60,6 @@ HPStyle::HPStyle() {
   displayType = DisplayTypeFlex;
   overflowType = OverflowVisible;
 
-  dim[DimWidth] = VALUE_UNDEFINED;  // initial value : auto
-  dim[DimHeight] = VALUE_UNDEFINED;
   minDim[DimWidth] = VALUE_UNDEFINED;
   minDim[DimHeight] = VALUE_UNDEFINED;
   maxDim[DimWidth] = VALUE_UNDEFINED;
@@ -95,7 +95,7 @@ HPStyle::~HPStyle() {
   // TODO(ianwang): Auto-generated destructor stub
 }
 
-std::string edge2String(int type, CSSValue &edges, CSSFrom &edgesFrom) {
+std::string edge2String(int type, const CSSValue &edges, const CSSFrom &edgesFrom) {
   std::string prefix = "";
   if (type == 0) {  // margin
     prefix = "margin";
@@ -175,7 +175,7 @@ std::string edge2String(int type, CSSValue &edges, CSSFrom &edgesFrom) {
   return styles;
 }
 
-std::string HPStyle::toString() {
+std::string HPStyle::toString() const {
   std::string styles;
   char str[60] = {0};
   if (flexDirection != FLexDirectionColumn) {
@@ -250,18 +250,6 @@ std::string HPStyle::toString() {
     styles += str;
   }
 
-  memset(str, 0, sizeof(str));
-  if (isDefined(dim[DimWidth])) {
-    snprintf(str, 50, "width:%0.f; ", dim[DimWidth]);
-    styles += str;
-  }
-
-  memset(str, 0, sizeof(str));
-  if (isDefined(dim[DimHeight])) {
-    snprintf(str, 50, "height:%0.f; ", dim[DimHeight]);
-    styles += str;
-  }
-
   memset(str, 0, sizeof(str));
   if (isDefined(minDim[DimWidth])) {
     snprintf(str, 50, "min-width:%0.f; ", minDim[DimWidth]);
@@ -329,14 +317,13 @@ std::string HPStyle::toString() {
  */
 bool setEdges(CSSDirection dir, float value, CSSValue &edges, CSSFrom &edgesFrom) {
   bool hasSet = false;
-  if (dir == CSSStart || dir == CSSEnd) {
-    if (!FloatIsEqual(edges[dir], value)) {
-      edges[dir] = value;
+  if (dir >= CSSLeft && dir <= CSSEnd) {
+    // an unchanged value still takes priority, over horizontal, vertical and
+    // all, or for start and end over left and right.
+    if (edgesFrom[dir] != dir) {
       edgesFrom[dir] = dir;
       hasSet = true;
     }
-  } else if (dir >= CSSLeft && dir <= CSSBottom) {
-    edgesFrom[dir] = dir;
     if (!FloatIsEqual(edges[dir], value)) {
       edges[dir] = value;
       hasSet = true;
@@ -344,7 +331,10 @@ bool setEdges(CSSDirection dir, float value, CSSValue &edges, CSSFrom &edgesFrom
 
   } else if (dir == CSSHorizontal) {
     if (edgesFrom[CSSLeft] != CSSLeft) {
-      edgesFrom[CSSLeft] = CSSHorizontal;
+      if (edgesFrom[CSSLeft] != CSSHorizontal) {
+        edgesFrom[CSSLeft] = CSSHorizontal;
+        hasSet = true;
+      }
       if (!FloatIsEqual(edges[CSSLeft], value)) {
         edges[CSSLeft] = value;
         hasSet = true;
@@ -352,7 +342,10 @@ bool setEdges(CSSDirection dir, float value, CSSValue &edges, CSSFrom &edgesFrom
     }
 
     if (edgesFrom[CSSRight] != CSSRight) {
-      edgesFrom[CSSRight] = CSSHorizontal;
+      if (edgesFrom[CSSRight] != CSSHorizontal) {
+        edgesFrom[CSSRight] = CSSHorizontal;
+        hasSet = true;
+      }
       if (!FloatIsEqual(edges[CSSRight], value)) {
         edges[CSSRight] = value;
         hasSet = true;
@@ -361,14 +354,20 @@ bool setEdges(CSSDirection dir, float value, CSSValue &edges, CSSFrom &edgesFrom
 
   } else if (dir == CSSVertical) {
     if (edgesFrom[CSSTop] != CSSTop) {
-      edgesFrom[CSSTop] = CSSVertical;
+      if (edgesFrom[CSSTop] != CSSVertical) {
+        edgesFrom[CSSTop] = CSSVertical;
+        hasSet = true;
+      }
       if (!FloatIsEqual(edges[CSSTop], value)) {
         edges[CSSTop] = value;
         hasSet = true;
       }
     }
     if (edgesFrom[CSSBottom] != CSSBottom) {
-      edgesFrom[CSSBottom] = CSSVertical;
+      if (edgesFrom[CSSBottom] != CSSVertical) {
+        edgesFrom[CSSBottom] = CSSVertical;
+        hasSet = true;
+      }
       if (!FloatIsEqual(edges[CSSBottom], value)) {
         edges[CSSBottom] = value;
         hasSet = true;
@@ -416,7 +415,7 @@ bool HPStyle::setPosition(CSSDirection dir, float value) {
   return false;
 }
 
-float HPStyle::getStartPosition(FlexDirection axis) {
+float HPStyle::getStartPosition(FlexDirection axis) const {
   if (isRowDirection(axis) && isDefined(position[CSSStart])) {
     return position[CSSStart];
   } else if (isDefined(position[axisStart[axis]])) {
@@ -425,7 +424,7 @@ float HPStyle::getStartPosition(FlexDirection axis) {
   return VALUE_AUTO;
 }
 
-float HPStyle::getEndPosition(FlexDirection axis) {
+float HPStyle::getEndPosition(FlexDirection axis) const {
   if (isRowDirection(axis) && isDefined(position[CSSEnd])) {
     return position[CSSEnd];
   } else if (isDefined(position[axisEnd[axis]])) {
@@ -434,28 +433,8 @@ float HPStyle::getEndPosition(FlexDirection axis) {
   return VALUE_AUTO;
 }
 
-void HPStyle::setDim(Dimension dimension, float value) {
-  dim[dimension] = value;
-}
-
-float HPStyle::getDim(Dimension dimension) {
-  return dim[dimension];
-}
-
-void HPStyle::setDim(FlexDirection axis, float value) {
-  setDim(axisDim[axis], value);
-}
-
-float HPStyle::getDim(FlexDirection axis) {
-  return dim[axisDim[axis]];
-}
-
-bool HPStyle::isDimensionAuto(FlexDirection axis) {
-  return isUndefined(dim[axisDim[axis]]);
-}
-
 // axis must be get from resolveMainAxis or resolveCrossAxis in HPNode
-float HPStyle::getStartBorder(FlexDirection axis) {
+float HPStyle::getStartBorder(FlexDirection axis) const {
   if (isRowDirection(axis) && isDefined(border[CSSStart]) && borderFrom[CSSStart] != CSSNONE) {
     return border[CSSStart];
   }
@@ -465,7 +444,7 @@ float HPStyle::getStartBorder(FlexDirection axis) {
   return 0.0f;
 }
 
-float HPStyle::getEndBorder(FlexDirection axis) {
+float HPStyle::getEndBorder(FlexDirection axis) const {
   if (isRowDirection(axis) && isDefined(border[CSSEnd]) && borderFrom[CSSEnd] != CSSNONE) {
     return border[CSSEnd];
   }
@@ -475,7 +454,7 @@ float HPStyle::getEndBorder(FlexDirection axis) {
   return 0.0f;
 }
 
-float HPStyle::getStartPadding(FlexDirection axis) {
+float HPStyle::getStartPadding(FlexDirection axis) const {
   if (isRowDirection(axis) && isDefined(padding[CSSStart]) && paddingFrom[CSSStart] != CSSNONE) {
     return padding[CSSStart];
   } else if (isDefined(padding[axisStart[axis]])) {
@@ -484,7 +463,7 @@ float HPStyle::getStartPadding(FlexDirection axis) {
   return 0.0f;
 }
 
-float HPStyle::getEndPadding(FlexDirection axis) {
+float HPStyle::getEndPadding(FlexDirection axis) const {
   if (isRowDirection(axis) && isDefined(padding[CSSEnd]) && paddingFrom[CSSEnd] != CSSNONE) {
     return padding[CSSEnd];
   } else if (isDefined(padding[axisEnd[axis]])) {
@@ -494,7 +473,7 @@ float HPStyle::getEndPadding(FlexDirection axis) {
 }
 
 // auto margins are treated as zero
-float HPStyle::getStartMargin(FlexDirection axis) {
+float HPStyle::getStartMargin(FlexDirection axis) const {
   if (isRowDirection(axis) && isDefined(margin[CSSStart]) && marginFrom[CSSStart] != CSSNONE) {
     return margin[CSSStart];
   }
@@ -505,7 +484,7 @@ float HPStyle::getStartMargin(FlexDirection axis) {
 }
 
 // auto margins are treated as zero
-float HPStyle::getEndMargin(FlexDirection axis) {
+float HPStyle::getEndMargin(FlexDirection axis) const {
   if (isRowDirection(axis) && isDefined(margin[CSSEnd]) && marginFrom[CSSEnd] != CSSNONE) {
     return margin[CSSEnd];
   }
@@ -515,33 +494,51 @@ float HPStyle::getEndMargin(FlexDirection axis) {
   return 0.0f;
 }
 
-float HPStyle::getMargin(FlexDirection axis) {
+float HPStyle::getMargin(FlexDirection axis) const {
   return getStartMargin(axis) + getEndMargin(axis);
 }
 
-bool HPStyle::isAutoStartMargin(FlexDirection axis) {
+bool HPStyle::isAutoStartMargin(FlexDirection axis) const {
   if (isRowDirection(axis) && marginFrom[CSSStart] != CSSNONE) {
     return isUndefined(margin[CSSStart]);
   }
   return isUndefined(margin[axisStart[axis]]);
 }
 
-bool HPStyle::isAutoEndMargin(FlexDirection axis) {
+bool HPStyle::isAutoEndMargin(FlexDirection axis) const {
   if (isRowDirection(axis) && marginFrom[CSSEnd] != CSSNONE) {
     return isUndefined(margin[CSSEnd]);
   }
   return isUndefined(margin[axisEnd[axis]]);
 }
 
-bool HPStyle::hasAutoMargin(FlexDirection axis) {
+bool HPStyle::hasAutoMargin(FlexDirection axis) const {
   return isAutoStartMargin(axis) || isAutoEndMargin(axis);
 }
 
-bool HPStyle::isOverflowScroll() {
+void HPStyle::resolveEdges(FlexDirection axis, HPResolvedEdges &edges) const {
+  edges.startMargin = getStartMargin(axis);
+  edges.endMargin = getEndMargin(axis);
+  edges.margin = edges.startMargin + edges.endMargin;
+  edges.startPadding = getStartPadding(axis);
+  edges.endPadding = getEndPadding(axis);
+  edges.startBorder = getStartBorder(axis);
+  edges.endBorder = getEndBorder(axis);
+  edges.startPaddingAndBorder = edges.startPadding + edges.startBorder;
+  edges.endPaddingAndBorder = edges.endPadding + edges.endBorder;
+  edges.paddingAndBorder = edges.startPaddingAndBorder + edges.endPaddingAndBorder;
+  edges.startPosition = getStartPosition(axis);
+  edges.endPosition = getEndPosition(axis);
+  edges.autoStartMargin = isAutoStartMargin(axis);
+  edges.autoEndMargin = isAutoEndMargin(axis);
+  edges.hasAutoMargin = edges.autoStartMargin || edges.autoEndMargin;
+}
+
+bool HPStyle::isOverflowScroll() const {
   return overflowType == OverflowScroll;
 }
 
-float HPStyle::getFlexBasis() {
+float HPStyle::getFlexBasis() const {
   if (isDefined(flexBasis)) {
     return flexBasis;
   } else if (isDefined(flex) && flex > 0.0f) {
@@ -550,3 +547,300 @@ float HPStyle::getFlexBasis() {
 
   return VALUE_AUTO;
 }
+
+// all fields take part in style interning.
+#define HP_STYLE_FIELDS(V) \
+  V(nodeType)              \
+  V(direction)             \
+  V(flexDirection)         \
+  V(justifyContent)        \
+  V(alignContent)          \
+  V(alignItems)            \
+  V(alignSelf)             \
+  V(flexWrap)              \
+  V(positionType)          \
+  V(displayType)           \
+  V(overflowType)          \
+  V(flexBasis)             \
+  V(flexGrow)              \
+  V(flexShrink)            \
+  V(flex)                  \
+  V(margin)                \
+  V(marginFrom)            \
+  V(padding)               \
+  V(paddingFrom)           \
+  V(border)                \
+  V(borderFrom)            \
+  V(position)              \
+  V(minDim)                \
+  V(maxDim)                \
+  V(itemSpace)             \
+  V(lineSpace)
+
+// fields are compared bitwise, so NAN (auto, undefined) equals NAN.
+bool HPStyle::isEqual(const HPStyle &other) const {
+#define HP_STYLE_FIELD_EQUAL(field) \
+  if (memcmp(&(field), &(other.field), sizeof(field)) != 0) return false;
+  HP_STYLE_FIELDS(HP_STYLE_FIELD_EQUAL)
+#undef HP_STYLE_FIELD_EQUAL
+  return true;
+}
+
+// FNV-1a over 32 bit words, all style fields are 4 bytes enums or floats.
+static inline uint32_t hashWords(uint32_t hash, const void *data, size_t size) {
+  const char *bytes = reinterpret_cast<const char *>(data);
+  for (size_t i = 0; i + sizeof(uint32_t) <= size; i += sizeof(uint32_t)) {
+    uint32_t word;
+    memcpy(&word, bytes + i, sizeof(uint32_t));
+    hash ^= word;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+uint32_t HPStyle::hashValue() const {
+  uint32_t hash = 2166136261u;
+#define HP_STYLE_FIELD_HASH(field) hash = hashWords(hash, &(field), sizeof(field));
+  HP_STYLE_FIELDS(HP_STYLE_FIELD_HASH)
+#undef HP_STYLE_FIELD_HASH
+  return hash;
+}
+
+size_t HPStyle::fieldsSize() {
+  size_t size = 0;
+  const HPStyle *style = nullptr;
+#define HP_STYLE_FIELD_SIZE(field) size += sizeof(style->field);
+  HP_STYLE_FIELDS(HP_STYLE_FIELD_SIZE)
+#undef HP_STYLE_FIELD_SIZE
+  return size;
+}
+
+void HPStyle::writeFields(uint8_t *bytes) const {
+#define HP_STYLE_FIELD_WRITE(field)      \
+  memcpy(bytes, &(field), sizeof(field)); \
+  bytes += sizeof(field);
+  HP_STYLE_FIELDS(HP_STYLE_FIELD_WRITE)
+#undef HP_STYLE_FIELD_WRITE
+}
+
+/* style intern table.
+ * styles are set from dom thread and layout threads, which may run trees
+ * concurrently, so the table is split in shards by hash with a lock each.
+ * reference counts are atomic and taken without lock, a record is looked up
+ * or removed only under the lock of its shard. a record found with count 0
+ * is being released and is skipped.
+ */
+#define HP_STYLE_SHARD_COUNT 16
+
+typedef struct {
+  std::mutex mutex;
+  std::unordered_multimap<uint32_t, HPStyleRecord *> records;
+} HPStyleShard;
+
+static HPStyleShard gStyleShards[HP_STYLE_SHARD_COUNT];
+
+static inline HPStyleShard &shardOf(uint32_t hash) {
+  return gStyleShards[hash % HP_STYLE_SHARD_COUNT];
+}
+
+// edges are resolved on every axis whenever the style of a record changes.
+static void setRecordStyle(HPStyleRecord *record, const HPStyle &style) {
+  record->style = style;
+  for (int axis = FLexDirectionRow; axis <= FLexDirectionColumnReverse; axis++) {
+    style.resolveEdges(static_cast<FlexDirection>(axis), record->edges[axis]);
+  }
+}
+
+// a reference to a record which may be released concurrently, fails if it is.
+static bool retainIfAlive(HPStyleRecord *record) {
+  uint32_t count = record->refCount.load(std::memory_order_relaxed);
+  while (count > 0) {
+    if (record->refCount.compare_exchange_weak(count, count + 1, std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// record with equal style from shard of hash, retained, or nullptr.
+static HPStyleRecord *findStyleRecordLocked(HPStyleShard &shard,
+                                            uint32_t hash,
+                                            const HPStyle &style) {
+  auto range = shard.records.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->style.isEqual(style) && retainIfAlive(it->second)) {
+      return it->second;
+    }
+  }
+  return nullptr;
+}
+
+static void eraseStyleRecordLocked(HPStyleShard &shard, HPStyleRecord *record) {
+  auto range = shard.records.equal_range(record->hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == record) {
+      shard.records.erase(it);
+      return;
+    }
+  }
+}
+
+// intern record, unless a record with equal style is interned meanwhile,
+// which is returned instead and record is freed.
+static HPStyleRecord *internStyleRecord(HPStyleRecord *record) {
+  HPStyleShard &shard = shardOf(record->hash);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  HPStyleRecord *interned = findStyleRecordLocked(shard, record->hash, record->style);
+  if (interned != nullptr) {
+    delete record;
+    return interned;
+  }
+  shard.records.insert(std::make_pair(record->hash, record));
+  return record;
+}
+
+static HPStyleRecord *acquireStyleRecord(const HPStyle &style) {
+  uint32_t hash = style.hashValue();
+  HPStyleShard &shard = shardOf(hash);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    HPStyleRecord *record = findStyleRecordLocked(shard, hash, style);
+    if (record != nullptr) {
+      return record;
+    }
+  }
+  // edges are resolved out of the lock.
+  HPStyleRecord *record = new HPStyleRecord();
+  setRecordStyle(record, style);
+  record->refCount.store(1, std::memory_order_relaxed);
+  record->hash = hash;
+  return internStyleRecord(record);
+}
+
+static void releaseStyleRecord(HPStyleRecord *record) {
+  if (record->refCount.fetch_sub(1, std::memory_order_acq_rel) > 1) {
+    return;
+  }
+  // count 0 can't be retained again, nobody else finds it any more.
+  HPStyleShard &shard = shardOf(record->hash);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    eraseStyleRecordLocked(shard, record);
+  }
+  delete record;
+}
+
+// default style record, holds one extra reference, never released.
+// not a function local static, nodes are created on several threads and
+// android builds with -fno-threadsafe-statics, call_once is not affected.
+static std::once_flag gDefaultStyleOnce;
+static HPStyleRecord *gDefaultStyleRecord = nullptr;
+
+static void initDefaultStyleRecord() {
+  gDefaultStyleRecord = acquireStyleRecord(HPStyle());
+}
+
+static HPStyleRecord *defaultStyleRecord() {
+  std::call_once(gDefaultStyleOnce, initDefaultStyleRecord);
+  return gDefaultStyleRecord;
+}
+
+HPStyleRef::HPStyleRef() {
+  record = defaultStyleRecord();
+  record->refCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+HPStyleRef::HPStyleRef(const HPStyleRef &other) {
+  record = other.record;
+  record->refCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+HPStyleRef &HPStyleRef::operator=(const HPStyleRef &other) {
+  if (record == other.record) {
+    return *this;
+  }
+  other.record->refCount.fetch_add(1, std::memory_order_relaxed);
+  releaseStyleRecord(record);
+  record = other.record;
+  return *this;
+}
+
+HPStyleRef::~HPStyleRef() {
+  releaseStyleRecord(record);
+}
+
+void HPStyleRef::set(const HPStyle &value) {
+  // the default record has one more count, it's never owned.
+  if (record->refCount.load(std::memory_order_acquire) == 1) {
+    // sole owner, update the record in place, this is the common case when
+    // setting styles of a new node one by one. it can only be retained
+    // through the table, so the count is stable once it's out of the table.
+    HPStyleShard &shard = shardOf(record->hash);
+    bool owned;
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      owned = record->refCount.load(std::memory_order_acquire) == 1;
+      if (owned) {
+        eraseStyleRecordLocked(shard, record);
+      }
+    }
+    if (owned) {
+      setRecordStyle(record, value);
+      record->hash = value.hashValue();
+      record = internStyleRecord(record);
+      return;
+    }
+  }
+
+  HPStyleRecord *newRecord = acquireStyleRecord(value);
+  releaseStyleRecord(record);
+  record = newRecord;
+}
+
+HPStyle &HPStyleRef::edit() {
+  if (record->refCount.load(std::memory_order_acquire) == 1) {
+    HPStyleShard &shard = shardOf(record->hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (record->refCount.load(std::memory_order_acquire) == 1) {
+      eraseStyleRecordLocked(shard, record);
+      return record->style;
+    }
+  }
+  // shared, edit an unshared copy which is out of the table.
+  HPStyleRecord *copy = new HPStyleRecord();
+  copy->style = record->style;
+  for (int axis = FLexDirectionRow; axis <= FLexDirectionColumnReverse; axis++) {
+    copy->edges[axis] = record->edges[axis];
+  }
+  copy->refCount.store(1, std::memory_order_relaxed);
+  copy->hash = record->hash;
+  releaseStyleRecord(record);
+  record = copy;
+  return record->style;
+}
+
+void HPStyleRef::commit(bool changed, bool edgesChanged) {
+  if (edgesChanged) {
+    for (int axis = FLexDirectionRow; axis <= FLexDirectionColumnReverse; axis++) {
+      record->style.resolveEdges(static_cast<FlexDirection>(axis), record->edges[axis]);
+    }
+  }
+  if (changed) {
+    record->hash = record->style.hashValue();
+  }
+  record = internStyleRecord(record);
+}
+
+// default style has one more count held by intern table.
+uint32_t HPStyleRef::shareCount() const {
+  return record->refCount.load(std::memory_order_relaxed);
+}
+
+uint32_t HPStyleRef::internedCount() {
+  uint32_t count = 0;
+  for (size_t i = 0; i < HP_STYLE_SHARD_COUNT; i++) {
+    std::lock_guard<std::mutex> lock(gStyleShards[i].mutex);
+    count += static_cast<uint32_t>(gStyleShards[i].records.size());
+  }
+  return count;
+}
@@ -17,44 +17,73 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#include <atomic>
 #include <string>
 
 #include "Flex.h"
 #include "HPUtil.h"
 // CSSLeft <---> CSSEnd
 #define CSS_PROPS_COUNT (6)
+
+// edges of a style resolved on an axis by the getters of HPStyle, start and
+// end are of the axis.
+typedef struct {
+  float startMargin;
+  float endMargin;
+  float margin;
+  float startPadding;
+  float endPadding;
+  float startBorder;
+  float endBorder;
+  float startPaddingAndBorder;
+  float endPaddingAndBorder;
+  float paddingAndBorder;
+  // VALUE_AUTO if not set
+  float startPosition;
+  float endPosition;
+  bool autoStartMargin;
+  bool autoEndMargin;
+  bool hasAutoMargin;
+} HPResolvedEdges;
+
 class HPStyle {
  public:
   HPStyle();
   virtual ~HPStyle();
-  std::string toString();
+  std::string toString() const;
   void setDirection(HPDirection direction_) { direction = direction_; }
 
   bool setMargin(CSSDirection dir, float value);
   bool setPadding(CSSDirection dir, float value);
   bool setBorder(CSSDirection dir, float value);
-  bool isDimensionAuto(FlexDirection axis);
-
-  float getStartBorder(FlexDirection axis);
-  float getEndBorder(FlexDirection axis);
-  float getStartPadding(FlexDirection axis);
-  float getEndPadding(FlexDirection axis);
-  float getStartMargin(FlexDirection axis);
-  float getEndMargin(FlexDirection axis);
-  float getMargin(FlexDirection axis);
-  bool isAutoStartMargin(FlexDirection axis);
-  bool isAutoEndMargin(FlexDirection axis);
-  bool hasAutoMargin(FlexDirection axis);
+
+  float getStartBorder(FlexDirection axis) const;
+  float getEndBorder(FlexDirection axis) const;
+  float getStartPadding(FlexDirection axis) const;
+  float getEndPadding(FlexDirection axis) const;
+  float getStartMargin(FlexDirection axis) const;
+  float getEndMargin(FlexDirection axis) const;
+  float getMargin(FlexDirection axis) const;
+  bool isAutoStartMargin(FlexDirection axis) const;
+  bool isAutoEndMargin(FlexDirection axis) const;
+  bool hasAutoMargin(FlexDirection axis) const;
 
   bool setPosition(CSSDirection dir, float value);
-  float getStartPosition(FlexDirection axis);
-  float getEndPosition(FlexDirection axis);
-  void setDim(FlexDirection axis, float value);
-  float getDim(FlexDirection axis);
-  void setDim(Dimension dimension, float value);
-  float getDim(Dimension dimension);
-  bool isOverflowScroll();
-  float getFlexBasis();
+  float getStartPosition(FlexDirection axis) const;
+  float getEndPosition(FlexDirection axis) const;
+
+  void resolveEdges(FlexDirection axis, HPResolvedEdges &edges) const;
+  bool isOverflowScroll() const;
+  float getFlexBasis() const;
+
+  bool isEqual(const HPStyle &other) const;
+  uint32_t hashValue() const;
+  // all fields packed in fieldsSize() bytes, without padding and vtable, so
+  // they can be kept out of the process and compared bitwise as isEqual.
+  static size_t fieldsSize();
+  void writeFields(uint8_t *bytes) const;
 
  public:
   NodeType nodeType;
@@ -82,10 +111,57 @@ class HPStyle {
   CSSDirection borderFrom[CSS_PROPS_COUNT];
   float position[CSS_PROPS_COUNT];
 
-  float dim[2];
+  // width & height are not here, they are kept in HPNode::styleDim
+  // because layout overrides them on every pass.
   float minDim[2];
   float maxDim[2];
 
   float itemSpace;
   float lineSpace;
 };
+
+// interned style, shared by all HPStyleRef with equal style.
+typedef struct HPStyleRecord {
+  HPStyle style;
+  // edges resolved on each FlexDirection when interned, layout reads them
+  // instead of resolving start, end and shorthand edges node by node.
+  HPResolvedEdges edges[4];
+  // changed without lock, 0 means released, see HPStyle.cpp.
+  std::atomic<uint32_t> refCount;
+  uint32_t hash;
+} HPStyleRecord;
+
+/* Copy on write handle of an interned style.
+ * nodes with equal styles share one immutable HPStyle record, records are
+ * hash interned and reference counted, see HPStyle.cpp.
+ * read through operator->, modify by set() with a new value, or in place
+ * between edit() and commit(), which interns it again.
+ */
+class HPStyleRef {
+ public:
+  HPStyleRef();
+  HPStyleRef(const HPStyleRef &other);
+  HPStyleRef &operator=(const HPStyleRef &other);
+  ~HPStyleRef();
+  const HPStyle *operator->() const { return &record->style; }
+  const HPStyle &get() const { return record->style; }
+  // resolved edges on axis, the axis is resolved with layout direction.
+  const HPResolvedEdges &edges(FlexDirection axis) const { return record->edges[axis]; }
+  void set(const HPStyle &value);
+  // style to change in place, must be followed by commit(). the record is
+  // taken out of the intern table if owned alone, else copied.
+  HPStyle &edit();
+  // interns the edited style again. its hash is updated only if changed,
+  // its edges are resolved again only if edgesChanged.
+  void commit(bool changed, bool edgesChanged);
+  // count of handles sharing this style.
+  uint32_t shareCount() const;
+  // HPStyle::hashValue of the style, same in every launch.
+  uint32_t hash() const { return record->hash; }
+
+  // count of distinct styles alive.
+  static uint32_t internedCount();
+
+ private:
+  HPStyleRecord *record;
+};
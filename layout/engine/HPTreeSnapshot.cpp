@@ -0,0 +1,446 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HPTreeSnapshot.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "Hippy.h"
+
+// state of the tree being recorded, measure functions are swapped for
+// recordMeasure which reaches it as the layout context of the recording
+// pass, so records of different trees may run at the same time.
+class HPSnapshotRecorder {
+ public:
+  explicit HPSnapshotRecorder(void* layoutContext) : layoutContext(layoutContext) {}
+
+  void collect(HPNodeRef node) {
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(node);
+    indexes[node] = index;
+    add(HPMutationCreateNode, 0, 0, index, 0, 0);
+    addStyle(index, node);
+    if (node->measure != nullptr) {
+      measureNodes.push_back(index);
+    }
+    for (uint32_t i = 0; i < node->childCount(); i++) {
+      uint32_t childIndex = static_cast<uint32_t>(nodes.size());
+      collect(node->getChild(i));
+      HPMutation& insert = add(HPMutationInsertChild, 0, 0, index, childIndex, 0);
+      insert.index = i;
+    }
+  }
+
+  // changes of style from a new node's.
+  void addStyle(uint32_t index, HPNodeRef node) {
+    const HPStyle& style = node->style.get();
+    addEnum(index, HPStylePropertyDirection, style.direction, defaults.direction);
+    addEnum(index, HPStylePropertyFlexDirection, style.flexDirection, defaults.flexDirection);
+    addEnum(index, HPStylePropertyJustifyContent, style.justifyContent,
+            defaults.justifyContent);
+    addEnum(index, HPStylePropertyAlignContent, style.alignContent, defaults.alignContent);
+    addEnum(index, HPStylePropertyAlignItems, style.alignItems, defaults.alignItems);
+    addEnum(index, HPStylePropertyAlignSelf, style.alignSelf, defaults.alignSelf);
+    addEnum(index, HPStylePropertyFlexWrap, style.flexWrap, defaults.flexWrap);
+    addEnum(index, HPStylePropertyPositionType, style.positionType, defaults.positionType);
+    addEnum(index, HPStylePropertyDisplay, style.displayType, defaults.displayType);
+    addEnum(index, HPStylePropertyOverflow, style.overflowType, defaults.overflowType);
+    addEnum(index, HPStylePropertyNodeType, style.nodeType, defaults.nodeType);
+    // flex sets grow and shrink, which may be set again after it.
+    if (isDefined(style.flex)) {
+      add(HPMutationSetStyle, HPStylePropertyFlex, 0, index, 0, style.flex);
+      add(HPMutationSetStyle, HPStylePropertyFlexGrow, 0, index, 0, style.flexGrow);
+      add(HPMutationSetStyle, HPStylePropertyFlexShrink, 0, index, 0, style.flexShrink);
+    } else {
+      addFloat(index, HPStylePropertyFlexGrow, style.flexGrow, defaults.flexGrow);
+      addFloat(index, HPStylePropertyFlexShrink, style.flexShrink, defaults.flexShrink);
+    }
+    addFloat(index, HPStylePropertyFlexBasis, style.flexBasis, defaults.flexBasis);
+    addFloat(index, HPStylePropertyWidth, node->styleDim[DimWidth], VALUE_UNDEFINED);
+    addFloat(index, HPStylePropertyHeight, node->styleDim[DimHeight], VALUE_UNDEFINED);
+    addFloat(index, HPStylePropertyMinWidth, style.minDim[DimWidth], VALUE_UNDEFINED);
+    addFloat(index, HPStylePropertyMinHeight, style.minDim[DimHeight], VALUE_UNDEFINED);
+    addFloat(index, HPStylePropertyMaxWidth, style.maxDim[DimWidth], VALUE_UNDEFINED);
+    addFloat(index, HPStylePropertyMaxHeight, style.maxDim[DimHeight], VALUE_UNDEFINED);
+    // edges set by user, set edge by edge. left, top, right and bottom set
+    // through horizontal, vertical or all are read the same way.
+    for (int edge = CSSLeft; edge <= CSSEnd; edge++) {
+      if (style.marginFrom[edge] != CSSNONE) {
+        if (isUndefined(style.margin[edge])) {
+          add(HPMutationSetStyle, HPStylePropertyMarginAuto, edge, index, 0, 0);
+        } else {
+          add(HPMutationSetStyle, HPStylePropertyMargin, edge, index, 0, style.margin[edge]);
+        }
+      }
+      if (style.paddingFrom[edge] != CSSNONE) {
+        add(HPMutationSetStyle, HPStylePropertyPadding, edge, index, 0, style.padding[edge]);
+      }
+      if (style.borderFrom[edge] != CSSNONE) {
+        add(HPMutationSetStyle, HPStylePropertyBorder, edge, index, 0, style.border[edge]);
+      }
+      if (isDefined(style.position[edge])) {
+        add(HPMutationSetStyle, HPStylePropertyPosition, edge, index, 0, style.position[edge]);
+      }
+    }
+  }
+
+  void addEnum(uint32_t index, HPStyleProperty property, int value, int defaultValue) {
+    if (value != defaultValue) {
+      add(HPMutationSetStyle, property, 0, index, 0, static_cast<float>(value));
+    }
+  }
+
+  void addFloat(uint32_t index, HPStyleProperty property, float value, float defaultValue) {
+    if (!FloatIsEqual(value, defaultValue)) {
+      add(HPMutationSetStyle, property, 0, index, 0, value);
+    }
+  }
+
+  HPMutation& add(HPMutationOp op,
+                  uint32_t property,
+                  uint32_t edge,
+                  uint32_t node,
+                  uint32_t arg,
+                  float value) {
+    HPMutation mutation;
+    memset(&mutation, 0, sizeof(mutation));
+    mutation.op = static_cast<uint8_t>(op);
+    mutation.property = static_cast<uint8_t>(property);
+    mutation.edge = static_cast<uint8_t>(edge);
+    mutation.node = node;
+    mutation.arg = arg;
+    mutation.value = value;
+    mutations.push_back(mutation);
+    return mutations.back();
+  }
+
+  // swap measure functions for recordMeasure, the tree is dirtied without
+  // calling dirtied functions, and laid out without scroll windows and
+  // shared measure results so that every measure node is measured.
+  void begin(HPMeasureFunc recordMeasure) {
+    savedMeasures.resize(nodes.size());
+    savedDirtiedFuncs.resize(nodes.size());
+    savedCacheKeys.resize(nodes.size());
+    savedWindows.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+      HPNodeRef node = nodes[i];
+      savedMeasures[i] = node->measure;
+      savedDirtiedFuncs[i] = node->dirtiedFunc;
+      savedCacheKeys[i] = node->measureCacheKey;
+      savedWindows[i] = node->scrollWindow;
+      if (node->measure != nullptr) {
+        node->measure = recordMeasure;
+      }
+      node->dirtiedFunc = nullptr;
+      node->measureCacheKey = 0;
+      node->scrollWindow = nullptr;
+    }
+    for (size_t i = 0; i < nodes.size(); i++) {
+      nodes[i]->markAsDirty();
+    }
+  }
+
+  // windowed containers were laid out whole, they are windowed again by
+  // their next layout.
+  void end() {
+    for (size_t i = 0; i < nodes.size(); i++) {
+      HPNodeRef node = nodes[i];
+      node->measure = savedMeasures[i];
+      node->measureCacheKey = savedCacheKeys[i];
+      node->scrollWindow = savedWindows[i];
+      if (node->scrollWindow != nullptr) {
+        node->markAsDirty();
+      }
+      node->dirtiedFunc = savedDirtiedFuncs[i];
+    }
+  }
+
+  HPStyle defaults;
+  // context of the caller, passed on to the recorded measure functions.
+  void* layoutContext;
+  std::vector<HPNodeRef> nodes;
+  std::unordered_map<HPNodeRef, uint32_t> indexes;
+  std::vector<HPMutation> mutations;
+  std::vector<uint32_t> measureNodes;
+  std::vector<HPSnapshotMeasure> measures;
+  std::vector<HPMeasureFunc> savedMeasures;
+  std::vector<HPDirtiedFunc> savedDirtiedFuncs;
+  std::vector<uint64_t> savedCacheKeys;
+  std::vector<HPScrollWindow*> savedWindows;
+};
+
+static HPSize recordMeasure(HPNodeRef node,
+                            float width,
+                            MeasureMode widthMeasureMode,
+                            float height,
+                            MeasureMode heightMeasureMode,
+                            void* layoutContext) {
+  HPSnapshotRecorder* recorder = static_cast<HPSnapshotRecorder*>(layoutContext);
+  uint32_t index = recorder->indexes[node];
+  HPSize size = recorder->savedMeasures[index](node, width, widthMeasureMode, height,
+                                               heightMeasureMode, recorder->layoutContext);
+  HPSnapshotMeasure measure;
+  memset(&measure, 0, sizeof(measure));
+  measure.node = index;
+  measure.widthMeasureMode = static_cast<uint8_t>(widthMeasureMode);
+  measure.heightMeasureMode = static_cast<uint8_t>(heightMeasureMode);
+  measure.width = width;
+  measure.height = height;
+  measure.resultWidth = size.width;
+  measure.resultHeight = size.height;
+  recorder->measures.push_back(measure);
+  return size;
+}
+
+static bool isSameRequest(const HPSnapshotMeasure& a, const HPSnapshotMeasure& b) {
+  return a.node == b.node && a.widthMeasureMode == b.widthMeasureMode &&
+         a.heightMeasureMode == b.heightMeasureMode && FloatIsEqual(a.width, b.width) &&
+         FloatIsEqual(a.height, b.height);
+}
+
+static bool isBeforeInNode(const HPSnapshotMeasure& a, const HPSnapshotMeasure& b) {
+  return a.node < b.node;
+}
+
+// every node is reached from the first one exactly once.
+static bool isTree(const std::vector<HPNodeRef>& nodes) {
+  if (nodes[0] == nullptr || nodes[0]->getParent() != nullptr) {
+    return false;
+  }
+  size_t reached = 0;
+  std::vector<HPNodeRef> stack(1, nodes[0]);
+  while (!stack.empty()) {
+    HPNodeRef node = stack.back();
+    stack.pop_back();
+    // a node reached twice is in a cycle.
+    if (++reached > nodes.size()) {
+      return false;
+    }
+    for (uint32_t i = 0; i < node->childCount(); i++) {
+      stack.push_back(node->getChild(i));
+    }
+  }
+  return reached == nodes.size();
+}
+
+template <typename T>
+static void appendArray(std::vector<uint8_t>& buffer, const T* items, size_t count) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(items);
+  buffer.insert(buffer.end(), bytes, bytes + count * sizeof(T));
+}
+
+HPTreeSnapshot::HPTreeSnapshot()
+    : width(VALUE_UNDEFINED), height(VALUE_UNDEFINED), direction(DirectionLTR), misses(0) {}
+
+HPTreeSnapshot::~HPTreeSnapshot() {
+  clear();
+}
+
+bool HPTreeSnapshot::record(HPNodeRef root,
+                            float width,
+                            float height,
+                            HPDirection direction,
+                            void* layoutContext,
+                            std::vector<uint8_t>& buffer) {
+  if (root == nullptr) {
+    return false;
+  }
+  HPSnapshotRecorder recorder(layoutContext);
+  recorder.collect(root);
+  recorder.begin(recordMeasure);
+  root->layout(width, height, direction, &recorder);
+  recorder.end();
+
+  // results of a node in call order, same requests once.
+  std::vector<HPSnapshotMeasure>& measures = recorder.measures;
+  std::stable_sort(measures.begin(), measures.end(), isBeforeInNode);
+  measures.erase(std::unique(measures.begin(), measures.end(), isSameRequest), measures.end());
+
+  HPSnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = HP_SNAPSHOT_MAGIC;
+  header.version = HP_SNAPSHOT_VERSION;
+  header.nodeCount = static_cast<uint32_t>(recorder.nodes.size());
+  header.mutationCount = static_cast<uint32_t>(recorder.mutations.size());
+  header.measureNodeCount = static_cast<uint32_t>(recorder.measureNodes.size());
+  header.measureCount = static_cast<uint32_t>(measures.size());
+  header.width = width;
+  header.height = height;
+  header.direction = direction;
+  appendArray(buffer, &header, 1);
+  appendArray(buffer, recorder.mutations.data(), recorder.mutations.size());
+  appendArray(buffer, recorder.measureNodes.data(), recorder.measureNodes.size());
+  appendArray(buffer, measures.data(), measures.size());
+  return true;
+}
+
+bool HPTreeSnapshot::load(const uint8_t* data, size_t size) {
+  clear();
+  HPSnapshotHeader header;
+  if (data == nullptr || size < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+  uint64_t expectedSize = sizeof(header) +
+                          static_cast<uint64_t>(header.mutationCount) * sizeof(HPMutation) +
+                          static_cast<uint64_t>(header.measureNodeCount) * sizeof(uint32_t) +
+                          static_cast<uint64_t>(header.measureCount) * sizeof(HPSnapshotMeasure);
+  // every node is created by a mutation of its own, nodes are not allocated
+  // for more than the mutations in data.
+  if (header.magic != HP_SNAPSHOT_MAGIC || header.version != HP_SNAPSHOT_VERSION ||
+      header.nodeCount == 0 || header.nodeCount > header.mutationCount ||
+      header.direction > DirectionRTL || expectedSize != size) {
+    return false;
+  }
+  const uint8_t* cursor = data + sizeof(header);
+  std::vector<HPMutation> mutations(header.mutationCount);
+  if (!mutations.empty()) {
+    memcpy(mutations.data(), cursor, mutations.size() * sizeof(HPMutation));
+  }
+  cursor += mutations.size() * sizeof(HPMutation);
+  std::vector<uint32_t> measureNodes(header.measureNodeCount);
+  if (!measureNodes.empty()) {
+    memcpy(measureNodes.data(), cursor, measureNodes.size() * sizeof(uint32_t));
+  }
+  cursor += measureNodes.size() * sizeof(uint32_t);
+  measures.resize(header.measureCount);
+  if (!measures.empty()) {
+    memcpy(measures.data(), cursor, measures.size() * sizeof(HPSnapshotMeasure));
+  }
+
+  nodes.assign(header.nodeCount, nullptr);
+  uint32_t applied = HPNodeApplyMutations(nodes.data(), header.nodeCount, mutations.data(),
+                                          header.mutationCount);
+  if (applied != header.mutationCount || !isTree(nodes)) {
+    clear();
+    return false;
+  }
+  std::stable_sort(measures.begin(), measures.end(), isBeforeInNode);
+  // tables are referenced by node contexts, sized before taking addresses.
+  tables.resize(measureNodes.size());
+  for (size_t i = 0; i < measureNodes.size(); i++) {
+    uint32_t index = measureNodes[i];
+    if (index >= nodes.size() || nodes[index] == nullptr || nodes[index]->childCount() > 0) {
+      clear();
+      return false;
+    }
+    HPSnapshotMeasure key;
+    memset(&key, 0, sizeof(key));
+    key.node = index;
+    std::vector<HPSnapshotMeasure>::iterator first =
+        std::lower_bound(measures.begin(), measures.end(), key, isBeforeInNode);
+    std::vector<HPSnapshotMeasure>::iterator last =
+        std::upper_bound(first, measures.end(), key, isBeforeInNode);
+    MeasureTable& table = tables[i];
+    table.snapshot = this;
+    table.first = static_cast<uint32_t>(first - measures.begin());
+    table.count = static_cast<uint32_t>(last - first);
+    // setting measure function makes it a text node, keep recorded type.
+    HPNodeRef node = nodes[index];
+    NodeType nodeType = node->style->nodeType;
+    node->setContext(&table);
+    node->setMeasureFunc(replayMeasure);
+    HPNodeSetNodeType(node, nodeType);
+  }
+  width = header.width;
+  height = header.height;
+  direction = static_cast<HPDirection>(header.direction);
+  return true;
+}
+
+void HPTreeSnapshot::layout(HPLayoutStats* stats) {
+  if (nodes.empty()) {
+    return;
+  }
+  for (size_t i = 0; i < nodes.size(); i++) {
+    nodes[i]->markAsDirty();
+  }
+  HPLayoutOptions options;
+  options.stats = stats;
+  nodes[0]->layout(width, height, direction, nullptr, options);
+}
+
+HPNodeRef HPTreeSnapshot::root() {
+  return nodes.empty() ? nullptr : nodes[0];
+}
+
+uint32_t HPTreeSnapshot::nodeCount() {
+  return static_cast<uint32_t>(nodes.size());
+}
+
+uint32_t HPTreeSnapshot::missCount() {
+  return misses;
+}
+
+// recorded result of the same request, or of the closest one with the same
+// measure modes.
+HPSize HPTreeSnapshot::replayMeasure(HPNodeRef node,
+                                     float width,
+                                     MeasureMode widthMeasureMode,
+                                     float height,
+                                     MeasureMode heightMeasureMode,
+                                     void* /*layoutContext*/) {
+  MeasureTable* table = reinterpret_cast<MeasureTable*>(node->getContext());
+  const HPSnapshotMeasure* measures = table->snapshot->measures.data() + table->first;
+  HPSize size = {0, 0};
+  const HPSnapshotMeasure* closest = nullptr;
+  float closestDistance = 0;
+  for (uint32_t i = 0; i < table->count; i++) {
+    const HPSnapshotMeasure& measure = measures[i];
+    if (measure.widthMeasureMode != widthMeasureMode ||
+        measure.heightMeasureMode != heightMeasureMode) {
+      continue;
+    }
+    if (FloatIsEqual(measure.width, width) && FloatIsEqual(measure.height, height)) {
+      size.width = measure.resultWidth;
+      size.height = measure.resultHeight;
+      return size;
+    }
+    float distance = (isDefined(width) && isDefined(measure.width) ? fabs(measure.width - width)
+                                                                   : 0) +
+                     (isDefined(height) && isDefined(measure.height)
+                          ? fabs(measure.height - height)
+                          : 0);
+    if (closest == nullptr || distance < closestDistance) {
+      closest = &measure;
+      closestDistance = distance;
+    }
+  }
+  table->snapshot->misses++;
+  if (closest == nullptr && table->count > 0) {
+    closest = &measures[0];
+  }
+  if (closest != nullptr) {
+    size.width = closest->resultWidth;
+    size.height = closest->resultHeight;
+  }
+  return size;
+}
+
+void HPTreeSnapshot::clear() {
+  for (size_t i = 0; i < nodes.size(); i++) {
+    HPNodeFree(nodes[i]);
+  }
+  nodes.clear();
+  measures.clear();
+  tables.clear();
+  misses = 0;
+}
@@ -0,0 +1,121 @@
+/* Tencent is pleased to support the open source community by making Hippy
+ * available. Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights
+ * reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "HPLayoutStats.h"
+#include "HPNode.h"
+#include "HPNodeMutation.h"
+
+#define HP_SNAPSHOT_MAGIC 0x4e535048  // "HPSN"
+#define HP_SNAPSHOT_VERSION 1
+
+/* Binary snapshot of a tree, to replay its layout offline, e.g. a slow page
+ * recorded in production becomes a benchmark or regression input.
+ * layout, little endian as written by the recording device:
+ *   HPSnapshotHeader
+ *   HPMutation[mutationCount]          builds the tree, node 0 is root
+ *   uint32_t[measureNodeCount]         nodes with measure function
+ *   HPSnapshotMeasure[measureCount]    recorded measure results by node
+ * measure functions are replaced by tables of the results they returned
+ * while recording, so replay needs neither text engine nor java.
+ * scroll windows, measure cache keys and contexts are not recorded.
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t nodeCount;
+  uint32_t mutationCount;
+  uint32_t measureNodeCount;
+  uint32_t measureCount;
+  // viewport and direction passed to layout
+  float width;
+  float height;
+  uint32_t direction;
+  uint32_t reserved;
+} HPSnapshotHeader;
+
+typedef struct {
+  uint32_t node;
+  uint8_t widthMeasureMode;
+  uint8_t heightMeasureMode;
+  uint16_t reserved;
+  float width;
+  float height;
+  float resultWidth;
+  float resultHeight;
+} HPSnapshotMeasure;
+
+// tree loaded from a snapshot, owns its nodes.
+class HPTreeSnapshot {
+ public:
+  HPTreeSnapshot();
+  virtual ~HPTreeSnapshot();
+  // lay out root's tree again from scratch with measure functions recorded,
+  // and append its snapshot to buffer. this is a full layout of the live
+  // tree on the calling thread: every measure function is called again
+  // without the measure cache, and results of the nodes are overwritten.
+  // scroll windows are off while recording, windowed containers are left
+  // dirty and laid out whole by the recording, until their next layout.
+  // like any layout, it must not run concurrently with other layouts of
+  // the same tree.
+  static bool record(HPNodeRef root,
+                     float width,
+                     float height,
+                     HPDirection direction,
+                     void* layoutContext,
+                     std::vector<uint8_t>& buffer);
+  // false if data is not a valid snapshot.
+  bool load(const uint8_t* data, size_t size);
+  // lay out the whole tree again, as its first layout.
+  void layout(HPLayoutStats* stats = nullptr);
+  HPNodeRef root();
+  uint32_t nodeCount();
+  // measure requests not found in the tables since load, answered by the
+  // closest recorded result of the node.
+  uint32_t missCount();
+
+ protected:
+  typedef struct {
+    HPTreeSnapshot* snapshot;
+    // range of the node's results in measures
+    uint32_t first;
+    uint32_t count;
+  } MeasureTable;
+
+  static HPSize replayMeasure(HPNodeRef node,
+                              float width,
+                              MeasureMode widthMeasureMode,
+                              float height,
+                              MeasureMode heightMeasureMode,
+                              void* layoutContext);
+  void clear();
+
+ private:
+  std::vector<HPNodeRef> nodes;
+  std::vector<HPSnapshotMeasure> measures;
+  std::vector<MeasureTable> tables;
+  float width;
+  float height;
+  HPDirection direction;
+  uint32_t misses;
+};
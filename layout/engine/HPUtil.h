@@ -29,7 +29,6 @@
 #include "Flex.h"
 
 // #define __DEBUG__
-// #define LAYOUT_TIME_ANALYZE
 #define ASSERT(e) (assert(e))
 #define nullptr (NULL)
 #define VALUE_AUTO (NAN)
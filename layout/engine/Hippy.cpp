@@ -26,6 +26,10 @@ HPNodeRef HPNodeNew() {
 void HPNodeFree(HPNodeRef node) {
   if (node == nullptr)
     return;
+  if (node->arena != nullptr) {
+    node->arena->freeNode(node);
+    return;
+  }
   // free self
   delete node;
 }
@@ -35,6 +39,12 @@ void HPNodeFreeRecursive(HPNodeRef node) {
     return;
   }
 
+  if (node->arena != nullptr) {
+    // bulk free, descendants not removed from parent one by one.
+    node->arena->freeTree(node);
+    return;
+  }
+
   while (node->childCount() > 0) {
     HPNodeRef child = node->getChild(0);
     HPNodeFreeRecursive(child);
@@ -43,29 +53,54 @@ void HPNodeFreeRecursive(HPNodeRef node) {
   HPNodeFree(node);
 }
 
+HPNodeArenaRef HPNodeArenaNew(uint32_t nodesPerSlab) {
+  return new HPNodeArena(nodesPerSlab);
+}
+
+void HPNodeArenaFree(HPNodeArenaRef arena) {
+  if (arena == nullptr)
+    return;
+  delete arena;
+}
+
+HPNodeRef HPNodeNewInArena(HPNodeArenaRef arena) {
+  if (arena == nullptr)
+    return HPNodeNew();
+  return arena->allocNode();
+}
+
+HPNodeRef HPNodeArenaCompact(HPNodeRef root, HPNodeRelocatedFunc relocatedFunc) {
+  if (root == nullptr || root->arena == nullptr)
+    return root;
+  return root->arena->compact(root, relocatedFunc);
+}
+
 void HPNodeStyleSetDirection(HPNodeRef node, HPDirection direction) {
-  if (node == nullptr || node->style.direction == direction) {
+  if (node == nullptr || node->style->direction == direction) {
     return;
   }
 
-  node->style.direction = direction;
+  node->updateStyle([direction](HPStyle& style) {
+    style.direction = direction;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetWidth(HPNodeRef node, float width) {
-  if (node == nullptr || FloatIsEqual(node->style.dim[DimWidth], width)) {
+  if (node == nullptr || FloatIsEqual(node->styleDim[DimWidth], width)) {
     return;
   }
 
-  node->style.dim[DimWidth] = width;
+  node->styleDim[DimWidth] = width;
   node->markAsDirty();
 }
 
 void HPNodeStyleSetHeight(HPNodeRef node, float height) {
-  if (node == nullptr || FloatIsEqual(node->style.dim[DimHeight], height))
+  if (node == nullptr || FloatIsEqual(node->styleDim[DimHeight], height))
     return;
 
-  node->style.dim[DimHeight] = height;
+  node->styleDim[DimHeight] = height;
   node->markAsDirty();
 }
 
@@ -77,7 +112,7 @@ bool HPNodeSetMeasureFunc(HPNodeRef node, HPMeasureFunc _measure) {
 }
 
 void HPNodeStyleSetFlex(HPNodeRef node, float flex) {
-  if (node == nullptr || FloatIsEqual(node->style.flex, flex))
+  if (node == nullptr || FloatIsEqual(node->style->flex, flex))
     return;
   if (FloatIsEqual(flex, 0.0f)) {
     HPNodeStyleSetFlexGrow(node, 0.0f);
@@ -89,53 +124,72 @@ void HPNodeStyleSetFlex(HPNodeRef node, float flex) {
     HPNodeStyleSetFlexGrow(node, 0.0f);
     HPNodeStyleSetFlexShrink(node, -flex);
   }
-  node->style.flex = flex;
+  node->updateStyle([flex](HPStyle& style) {
+    style.flex = flex;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetFlexGrow(HPNodeRef node, float flexGrow) {
-  if (node == nullptr || FloatIsEqual(node->style.flexGrow, flexGrow))
+  if (node == nullptr || FloatIsEqual(node->style->flexGrow, flexGrow))
     return;
 
-  node->style.flexGrow = flexGrow;
+  node->updateStyle([flexGrow](HPStyle& style) {
+    style.flexGrow = flexGrow;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetFlexShrink(HPNodeRef node, float flexShrink) {
-  if (node == nullptr || FloatIsEqual(node->style.flexShrink, flexShrink))
+  if (node == nullptr || FloatIsEqual(node->style->flexShrink, flexShrink))
     return;
 
-  node->style.flexShrink = flexShrink;
+  node->updateStyle([flexShrink](HPStyle& style) {
+    style.flexShrink = flexShrink;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetFlexBasis(HPNodeRef node, float flexBasis) {
-  if (node == nullptr || FloatIsEqual(node->style.flexBasis, flexBasis))
+  if (node == nullptr || FloatIsEqual(node->style->flexBasis, flexBasis))
     return;
 
-  node->style.flexBasis = flexBasis;
+  node->updateStyle([flexBasis](HPStyle& style) {
+    style.flexBasis = flexBasis;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetFlexDirection(HPNodeRef node, FlexDirection direction) {
-  if (node == nullptr || node->style.flexDirection == direction)
+  if (node == nullptr || node->style->flexDirection == direction)
     return;
 
-  node->style.flexDirection = direction;
+  node->updateStyle([direction](HPStyle& style) {
+    style.flexDirection = direction;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetPositionType(HPNodeRef node, PositionType positionType) {
-  if (node == nullptr || node->style.positionType == positionType)
+  if (node == nullptr || node->style->positionType == positionType)
     return;
-  node->style.positionType = positionType;
+  node->updateStyle([positionType](HPStyle& style) {
+    style.positionType = positionType;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetPosition(HPNodeRef node, CSSDirection dir, float value) {
-  if (node == nullptr || FloatIsEqual(node->style.position[dir], value))
+  if (node == nullptr || FloatIsEqual(node->style->position[dir], value))
     return;
-  if (node->style.setPosition(dir, value)) {
+  if (node->updateStyle(
+          [dir, value](HPStyle& style) { return style.setPosition(dir, value); }, true)) {
     node->markAsDirty();
   }
 }
@@ -143,7 +197,8 @@ void HPNodeStyleSetPosition(HPNodeRef node, CSSDirection dir, float value) {
 void HPNodeStyleSetMargin(HPNodeRef node, CSSDirection dir, float value) {
   if (node == nullptr)
     return;
-  if (node->style.setMargin(dir, value)) {
+  if (node->updateStyle(
+          [dir, value](HPStyle& style) { return style.setMargin(dir, value); }, true)) {
     node->markAsDirty();
   }
 }
@@ -155,7 +210,8 @@ void HPNodeStyleSetMarginAuto(HPNodeRef node, CSSDirection dir) {
 void HPNodeStyleSetPadding(HPNodeRef node, CSSDirection dir, float value) {
   if (node == nullptr)
     return;
-  if (node->style.setPadding(dir, value)) {
+  if (node->updateStyle(
+          [dir, value](HPStyle& style) { return style.setPadding(dir, value); }, true)) {
     node->markAsDirty();
   }
 }
@@ -163,45 +219,61 @@ void HPNodeStyleSetPadding(HPNodeRef node, CSSDirection dir, float value) {
 void HPNodeStyleSetBorder(HPNodeRef node, CSSDirection dir, float value) {
   if (node == nullptr)
     return;
-  if (node->style.setBorder(dir, value)) {
+  if (node->updateStyle(
+          [dir, value](HPStyle& style) { return style.setBorder(dir, value); }, true)) {
     node->markAsDirty();
   }
 }
 
 void HPNodeStyleSetFlexWrap(HPNodeRef node, FlexWrapMode wrapMode) {
-  if (node == nullptr || node->style.flexWrap == wrapMode)
+  if (node == nullptr || node->style->flexWrap == wrapMode)
     return;
 
-  node->style.flexWrap = wrapMode;
+  node->updateStyle([wrapMode](HPStyle& style) {
+    style.flexWrap = wrapMode;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetJustifyContent(HPNodeRef node, FlexAlign justify) {
-  if (node == nullptr || node->style.justifyContent == justify)
+  if (node == nullptr || node->style->justifyContent == justify)
     return;
-  node->style.justifyContent = justify;
+  node->updateStyle([justify](HPStyle& style) {
+    style.justifyContent = justify;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetAlignContent(HPNodeRef node, FlexAlign align) {
-  if (node == nullptr || node->style.alignContent == align)
+  if (node == nullptr || node->style->alignContent == align)
     return;
-  node->style.alignContent = align;
+  node->updateStyle([align](HPStyle& style) {
+    style.alignContent = align;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetAlignItems(HPNodeRef node, FlexAlign align) {
-  if (node == nullptr || node->style.alignItems == align)
+  if (node == nullptr || node->style->alignItems == align)
     return;
   // FlexAlignStart == FlexAlignBaseline
-  node->style.alignItems = align;
+  node->updateStyle([align](HPStyle& style) {
+    style.alignItems = align;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetAlignSelf(HPNodeRef node, FlexAlign align) {
-  if (node == nullptr || node->style.alignSelf == align)
+  if (node == nullptr || node->style->alignSelf == align)
     return;
-  node->style.alignSelf = align;
+  node->updateStyle([align](HPStyle& style) {
+    style.alignSelf = align;
+    return true;
+  });
   node->markAsDirty();
 }
 
@@ -244,18 +316,18 @@ float HPNodeLayoutGetHeight(HPNodeRef node) {
 float HPNodeLayoutGetMargin(HPNodeRef node, CSSDirection dir) {
   if (node == nullptr || dir > CSSBottom)
     return 0;
-  return node->result.margin[dir];
+  return node->result.edges == nullptr ? 0 : node->result.edges->margin[dir];
 }
 
 float HPNodeLayoutGetPadding(HPNodeRef node, CSSDirection dir) {
   if (node == nullptr || dir > CSSBottom)
     return 0;
-  return node->result.padding[dir];
+  return node->result.edges == nullptr ? 0 : node->result.edges->padding[dir];
 }
 float HPNodeLayoutGetBorder(HPNodeRef node, CSSDirection dir) {
   if (node == nullptr || dir > CSSBottom)
     return 0;
-  return node->result.border[dir];
+  return node->result.edges == nullptr ? 0 : node->result.edges->border[dir];
 }
 bool HPNodeLayoutGetHadOverflow(HPNodeRef node) {
   if (node == nullptr)
@@ -270,45 +342,63 @@ void HPNodeStyleSetDisplay(HPNodeRef node, DisplayType displayType) {
 }
 
 void HPNodeStyleSetMaxWidth(HPNodeRef node, float value) {
-  if (node == nullptr || FloatIsEqual(node->style.maxDim[DimWidth], value))
+  if (node == nullptr || FloatIsEqual(node->style->maxDim[DimWidth], value))
     return;
-  node->style.maxDim[DimWidth] = value;
+  node->updateStyle([value](HPStyle& style) {
+    style.maxDim[DimWidth] = value;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetMaxHeight(HPNodeRef node, float value) {
-  if (node == nullptr || FloatIsEqual(node->style.maxDim[DimHeight], value))
+  if (node == nullptr || FloatIsEqual(node->style->maxDim[DimHeight], value))
     return;
-  node->style.maxDim[DimHeight] = value;
+  node->updateStyle([value](HPStyle& style) {
+    style.maxDim[DimHeight] = value;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetMinWidth(HPNodeRef node, float value) {
-  if (node == nullptr || FloatIsEqual(node->style.minDim[DimWidth], value))
+  if (node == nullptr || FloatIsEqual(node->style->minDim[DimWidth], value))
     return;
-  node->style.minDim[DimWidth] = value;
+  node->updateStyle([value](HPStyle& style) {
+    style.minDim[DimWidth] = value;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeStyleSetMinHeight(HPNodeRef node, float value) {
-  if (node == nullptr || FloatIsEqual(node->style.minDim[DimHeight], value))
+  if (node == nullptr || FloatIsEqual(node->style->minDim[DimHeight], value))
     return;
-  node->style.minDim[DimHeight] = value;
+  node->updateStyle([value](HPStyle& style) {
+    style.minDim[DimHeight] = value;
+    return true;
+  });
   node->markAsDirty();
 }
 
 void HPNodeSetNodeType(HPNodeRef node, NodeType nodeType) {
-  if (node == nullptr || nodeType == node->style.nodeType)
+  if (node == nullptr || nodeType == node->style->nodeType)
     return;
-  node->style.nodeType = nodeType;
+  node->updateStyle([nodeType](HPStyle& style) {
+    style.nodeType = nodeType;
+    return true;
+  });
   // node->markAsDirty();
 }
 
 void HPNodeStyleSetOverflow(HPNodeRef node, OverflowType overflowType) {
-  if (node == nullptr || overflowType == node->style.overflowType)
+  if (node == nullptr || overflowType == node->style->overflowType)
     return;
 
-  node->style.overflowType = overflowType;
+  node->updateStyle([overflowType](HPStyle& style) {
+    style.overflowType = overflowType;
+    return true;
+  });
   node->markAsDirty();
 }
 
@@ -346,18 +436,330 @@ void HPNodeMarkDirty(HPNodeRef node) {
 bool HPNodeIsDirty(HPNodeRef node) {
   if (node == nullptr)
     return false;
-  return node->isDirty;
+  return node->needsLayout();
 }
 
 void HPNodeDoLayout(HPNodeRef node,
                     float parentWidth,
                     float parentHeight,
                     HPDirection direction,
-                    void* layoutContext) {
+                    void* layoutContext,
+                    HPLayoutStats* stats) {
+  if (node == nullptr)
+    return;
+
+  HPLayoutOptions options;
+  options.stats = stats;
+  node->layout(parentWidth, parentHeight, direction, layoutContext, options);
+}
+
+HPResumableLayoutRef HPResumableLayoutNew(HPNodeRef node,
+                                          float parentWidth,
+                                          float parentHeight,
+                                          HPDirection direction,
+                                          void* layoutContext) {
+  if (node == nullptr)
+    return nullptr;
+
+  return new HPResumableLayout(node, parentWidth, parentHeight, direction, layoutContext);
+}
+
+HPLayoutStatus HPResumableLayoutRun(HPResumableLayoutRef layout,
+                                    double budgetMs,
+                                    uint32_t budgetVisits) {
+  if (layout == nullptr)
+    return LayoutStatusFinished;
+
+  return layout->run(budgetMs, budgetVisits);
+}
+
+void HPResumableLayoutFree(HPResumableLayoutRef layout) {
+  if (layout == nullptr)
+    return;
+  delete layout;
+}
+
+void HPNodeDoBatchMeasuredLayout(HPNodeRef node,
+                                 float parentWidth,
+                                 float parentHeight,
+                                 HPBatchMeasureFunc batchMeasure,
+                                 HPDirection direction,
+                                 void* layoutContext,
+                                 HPLayoutStats* stats) {
+  if (node == nullptr)
+    return;
+
+  HPLayoutOptions options;
+  options.stats = stats;
+  options.batchMeasure = batchMeasure;
+  node->layout(parentWidth, parentHeight, direction, layoutContext, options);
+}
+
+void HPNodeDoLayoutRoots(HPLayoutRoot* roots, uint32_t count, HPLayoutThreadPoolRef pool) {
+  if (roots == nullptr)
+    return;
+
+  HPLayoutRootsConcurrently(roots, count, pool);
+}
+
+void HPNodeDoPremeasuredLayout(HPNodeRef node,
+                               float parentWidth,
+                               float parentHeight,
+                               HPLayoutThreadPoolRef pool,
+                               HPDirection direction,
+                               void* layoutContext,
+                               HPLayoutStats* stats) {
+  if (node == nullptr)
+    return;
+
+  HPLayoutOptions options;
+  options.stats = stats;
+  options.measurePool = pool;
+  node->layout(parentWidth, parentHeight, direction, layoutContext, options);
+}
+
+HPLayoutThreadPoolRef HPLayoutThreadPoolNew(uint32_t threadCount, uint32_t minSubtreeNodes) {
+  return new HPLayoutThreadPool(threadCount, minSubtreeNodes);
+}
+
+void HPLayoutThreadPoolFree(HPLayoutThreadPoolRef pool) {
+  if (pool == nullptr)
+    return;
+  delete pool;
+}
+
+void HPNodeDoParallelLayout(HPNodeRef node,
+                            float parentWidth,
+                            float parentHeight,
+                            HPLayoutThreadPoolRef pool,
+                            HPDirection direction,
+                            void* layoutContext,
+                            HPLayoutStats* stats) {
+  if (node == nullptr)
+    return;
+
+  HPLayoutOptions options;
+  options.threadPool = pool;
+  options.stats = stats;
+  node->layout(parentWidth, parentHeight, direction, layoutContext, options);
+}
+
+HPLayoutServiceRef HPLayoutServiceNew(void* layoutContext) {
+  return new HPLayoutService(layoutContext);
+}
+
+void HPLayoutServiceFree(HPLayoutServiceRef service) {
+  if (service == nullptr)
+    return;
+  delete service;
+}
+
+uint64_t HPLayoutServiceSubmit(HPLayoutServiceRef service, const HPLayoutTransaction& transaction) {
+  if (service == nullptr)
+    return 0;
+
+  return service->submit(transaction);
+}
+
+HPLayoutFramePtr HPLayoutServiceGetFrame(HPLayoutServiceRef service) {
+  if (service == nullptr)
+    return HPLayoutFramePtr();
+
+  return service->frame();
+}
+
+HPLayoutFramePtr HPLayoutServiceWaitForFrame(HPLayoutServiceRef service, uint64_t version) {
+  if (service == nullptr)
+    return HPLayoutFramePtr();
+
+  return service->waitForFrame(version);
+}
+
+void HPLayoutCacheSetCapacity(uint32_t capacity) {
+  HPLayoutCache::setCapacity(capacity);
+}
+
+HPLayoutCacheStats HPLayoutCacheGetStats() {
+  return HPLayoutCache::globalStats();
+}
+
+void HPLayoutCacheResetStats() {
+  HPLayoutCache::resetGlobalStats();
+}
+
+HPLayoutCacheStats HPNodeGetLayoutCacheStats(HPNodeRef node) {
+  if (node == nullptr) {
+    HPLayoutCacheStats empty = {0, 0, 0, 0, 0};
+    return empty;
+  }
+  return node->layoutCache.stats();
+}
+
+void HPNodeSetMeasureCacheKey(HPNodeRef node, uint64_t contentKey) {
+  if (node == nullptr || node->measureCacheKey == contentKey)
+    return;
+  node->measureCacheKey = contentKey;
+  node->markAsDirty();
+}
+
+uint64_t HPNodeGetMeasureCacheKey(HPNodeRef node) {
+  if (node == nullptr)
+    return 0;
+  return node->measureCacheKey;
+}
+
+void HPNodeSetScrollWindow(HPNodeRef node,
+                           float start,
+                           float length,
+                           float margin,
+                           float estimatedItemSize) {
   if (node == nullptr)
     return;
+  HPScrollWindow* window = node->scrollWindow;
+  if (window == nullptr) {
+    window = new HPScrollWindow();
+    window->averageItemSize = estimatedItemSize;
+    node->scrollWindow = window;
+  } else if (FloatIsEqual(window->start, start) && FloatIsEqual(window->length, length) &&
+             FloatIsEqual(window->margin, margin)) {
+    return;
+  }
+  window->start = start;
+  window->length = length;
+  window->margin = margin;
+  node->markAsDirty();
+}
+
+void HPNodeClearScrollWindow(HPNodeRef node) {
+  if (node == nullptr || node->scrollWindow == nullptr)
+    return;
+  delete node->scrollWindow;
+  node->scrollWindow = nullptr;
+  node->markAsDirty();
+}
+
+void HPMeasureCacheSetCapacity(uint32_t capacity) {
+  HPMeasureCache::shared()->setCapacity(capacity);
+}
+
+void HPMeasureCacheInvalidate() {
+  HPMeasureCache::shared()->invalidate();
+}
+
+HPMeasureCacheStats HPMeasureCacheGetStats() {
+  return HPMeasureCache::shared()->stats();
+}
+
+void HPMeasureCacheResetStats() {
+  HPMeasureCache::shared()->resetStats();
+}
+
+HPFrameBufferRef HPFrameBufferNew() {
+  return new HPFrameBuffer();
+}
+
+void HPFrameBufferFree(HPFrameBufferRef buffer) {
+  if (buffer == nullptr)
+    return;
+  delete buffer;
+}
+
+uint32_t HPNodeFillFrameBuffer(HPNodeRef root, HPFrameBufferRef buffer, float scale) {
+  if (buffer == nullptr)
+    return 0;
+  return buffer->fill(root, scale);
+}
+
+const HPAbsoluteFrame* HPFrameBufferGetFrames(HPFrameBufferRef buffer) {
+  if (buffer == nullptr)
+    return nullptr;
+  return buffer->frames();
+}
+
+uint32_t HPFrameBufferGetCount(HPFrameBufferRef buffer) {
+  if (buffer == nullptr)
+    return 0;
+  return buffer->count();
+}
+
+bool HPNodeRecordSnapshot(HPNodeRef root,
+                          float width,
+                          float height,
+                          std::vector<uint8_t>* buffer,
+                          HPDirection direction,
+                          void* layoutContext) {
+  if (root == nullptr || buffer == nullptr)
+    return false;
+  return HPTreeSnapshot::record(root, width, height, direction, layoutContext, *buffer);
+}
+
+HPTreeSnapshotRef HPTreeSnapshotLoad(const uint8_t* data, size_t size) {
+  HPTreeSnapshotRef snapshot = new HPTreeSnapshot();
+  if (!snapshot->load(data, size)) {
+    delete snapshot;
+    return nullptr;
+  }
+  return snapshot;
+}
+
+void HPTreeSnapshotFree(HPTreeSnapshotRef snapshot) {
+  if (snapshot == nullptr)
+    return;
+  delete snapshot;
+}
+
+HPNodeRef HPTreeSnapshotGetRoot(HPTreeSnapshotRef snapshot) {
+  if (snapshot == nullptr)
+    return nullptr;
+  return snapshot->root();
+}
+
+void HPTreeSnapshotLayout(HPTreeSnapshotRef snapshot, HPLayoutStats* stats) {
+  if (snapshot == nullptr)
+    return;
+  snapshot->layout(stats);
+}
+
+uint32_t HPTreeSnapshotGetMissCount(HPTreeSnapshotRef snapshot) {
+  if (snapshot == nullptr)
+    return 0;
+  return snapshot->missCount();
+}
+
+HPPersistentLayoutCacheRef HPPersistentLayoutCacheNew(const char* directory, uint64_t salt) {
+  return new HPPersistentLayoutCache(directory, salt);
+}
+
+void HPPersistentLayoutCacheFree(HPPersistentLayoutCacheRef cache) {
+  if (cache == nullptr)
+    return;
+  delete cache;
+}
 
-  node->layout(parentWidth, parentHeight, direction, layoutContext);
+bool HPNodeDoPersistentCachedLayout(HPNodeRef node,
+                                    float parentWidth,
+                                    float parentHeight,
+                                    HPPersistentLayoutCacheRef cache,
+                                    HPDirection direction,
+                                    void* layoutContext,
+                                    HPLayoutStats* stats) {
+  if (node == nullptr)
+    return false;
+  if (cache == nullptr) {
+    HPLayoutOptions options;
+    options.stats = stats;
+    node->layout(parentWidth, parentHeight, direction, layoutContext, options);
+    return false;
+  }
+  return cache->layout(node, parentWidth, parentHeight, direction, layoutContext, stats);
+}
+
+HPPersistentLayoutCacheStats HPPersistentLayoutCacheGetStats(HPPersistentLayoutCacheRef cache) {
+  if (cache == nullptr) {
+    HPPersistentLayoutCacheStats empty = {0, 0, 0, 0};
+    return empty;
+  }
+  return cache->stats();
 }
 
 void HPNodePrint(HPNodeRef node) {
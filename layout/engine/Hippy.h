@@ -21,12 +21,34 @@
 
 #pragma once
 
+#include "HPFrameBuffer.h"
 #include "HPNode.h"
+#include "HPLayoutScheduler.h"
+#include "HPLayoutService.h"
+#include "HPNodeArena.h"
+#include "HPNodeMutation.h"
+#include "HPPersistentLayoutCache.h"
+#include "HPResumableLayout.h"
+#include "HPTreeSnapshot.h"
+
+typedef HPNodeArena* HPNodeArenaRef;
+typedef HPFrameBuffer* HPFrameBufferRef;
+typedef HPLayoutThreadPool* HPLayoutThreadPoolRef;
+typedef HPLayoutService* HPLayoutServiceRef;
+typedef HPPersistentLayoutCache* HPPersistentLayoutCacheRef;
+typedef HPResumableLayout* HPResumableLayoutRef;
+typedef HPTreeSnapshot* HPTreeSnapshotRef;
 
 HPNodeRef HPNodeNew();
 void HPNodeFree(HPNodeRef node);
 void HPNodeFreeRecursive(HPNodeRef node);
 
+// per root tree node arena, see HPNodeArena.h
+HPNodeArenaRef HPNodeArenaNew(uint32_t nodesPerSlab = HP_ARENA_DEFAULT_SLAB_NODES);
+void HPNodeArenaFree(HPNodeArenaRef arena);
+HPNodeRef HPNodeNewInArena(HPNodeArenaRef arena);
+HPNodeRef HPNodeArenaCompact(HPNodeRef root, HPNodeRelocatedFunc relocatedFunc = nullptr);
+
 void HPNodeStyleSetDirection(HPNodeRef node, HPDirection direction);
 void HPNodeStyleSetWidth(HPNodeRef node, float width);
 void HPNodeStyleSetHeight(HPNodeRef node, float height);
@@ -73,10 +95,163 @@ bool HPNodeHasNewLayout(HPNodeRef node);
 void HPNodesetHasNewLayout(HPNodeRef node, bool hasNewLayout);
 void HPNodeMarkDirty(HPNodeRef node);
 bool HPNodeIsDirty(HPNodeRef node);
+// stats is filled with statistics of this layout if not nullptr,
+// see HPLayoutStats.h
 void HPNodeDoLayout(HPNodeRef node,
                     float parentWidth,
                     float parentHeight,
                     HPDirection direction = DirectionLTR,
-                    void* layoutContext = nullptr);
+                    void* layoutContext = nullptr,
+                    HPLayoutStats* stats = nullptr);
+
+// layout spread over several calls within a budget, see HPResumableLayout.h
+// the tree must not be read or changed until run returns LayoutStatusFinished.
+// it's laid out on a thread of its own, measure functions are called on that
+// thread, not on the thread calling HPResumableLayoutRun.
+HPResumableLayoutRef HPResumableLayoutNew(HPNodeRef node,
+                                          float parentWidth,
+                                          float parentHeight,
+                                          HPDirection direction = DirectionLTR,
+                                          void* layoutContext = nullptr);
+// budgetMs <= 0 or budgetVisits 0 is no limit of that kind.
+HPLayoutStatus HPResumableLayoutRun(HPResumableLayoutRef layout,
+                                    double budgetMs,
+                                    uint32_t budgetVisits = 0);
+// an unfinished layout is abandoned, the tree is marked dirty.
+void HPResumableLayoutFree(HPResumableLayoutRef layout);
+
+// measure requests of dirty measure nodes which can be predicted before
+// layout are resolved by one batchMeasure call, see HPBatchMeasure.h.
+// the others are measured by measure functions of nodes as usual.
+void HPNodeDoBatchMeasuredLayout(HPNodeRef node,
+                                 float parentWidth,
+                                 float parentHeight,
+                                 HPBatchMeasureFunc batchMeasure,
+                                 HPDirection direction = DirectionLTR,
+                                 void* layoutContext = nullptr,
+                                 HPLayoutStats* stats = nullptr);
+
+// parallel layout of independent subtrees, see HPLayoutThreadPool.h
+// results are the same as HPNodeDoLayout, measure functions are only
+// called on the calling thread.
+HPLayoutThreadPoolRef HPLayoutThreadPoolNew(
+    uint32_t threadCount,
+    uint32_t minSubtreeNodes = HP_PARALLEL_MIN_SUBTREE_NODES);
+void HPLayoutThreadPoolFree(HPLayoutThreadPoolRef pool);
+void HPNodeDoParallelLayout(HPNodeRef node,
+                            float parentWidth,
+                            float parentHeight,
+                            HPLayoutThreadPoolRef pool,
+                            HPDirection direction = DirectionLTR,
+                            void* layoutContext = nullptr,
+                            HPLayoutStats* stats = nullptr);
+
+// lay out independent root trees concurrently, see HPLayoutScheduler.h
+// measure functions of the roots must be thread safe.
+void HPNodeDoLayoutRoots(HPLayoutRoot* roots, uint32_t count, HPLayoutThreadPoolRef pool);
+
+// like HPNodeDoBatchMeasuredLayout, but predicted requests are measured
+// by measure functions of their nodes concurrently on pool before layout,
+// measure functions must be thread safe then.
+void HPNodeDoPremeasuredLayout(HPNodeRef node,
+                               float parentWidth,
+                               float parentHeight,
+                               HPLayoutThreadPoolRef pool,
+                               HPDirection direction = DirectionLTR,
+                               void* layoutContext = nullptr,
+                               HPLayoutStats* stats = nullptr);
+
+// layout on a thread of its own with double buffered results, see
+// HPLayoutService.h. measure functions are called on the service thread.
+HPLayoutServiceRef HPLayoutServiceNew(void* layoutContext = nullptr);
+void HPLayoutServiceFree(HPLayoutServiceRef service);
+uint64_t HPLayoutServiceSubmit(HPLayoutServiceRef service, const HPLayoutTransaction& transaction);
+HPLayoutFramePtr HPLayoutServiceGetFrame(HPLayoutServiceRef service);
+HPLayoutFramePtr HPLayoutServiceWaitForFrame(HPLayoutServiceRef service, uint64_t version);
+
+// per node layout cache, see HPLayoutCache.h
+void HPLayoutCacheSetCapacity(uint32_t capacity);
+HPLayoutCacheStats HPLayoutCacheGetStats();
+void HPLayoutCacheResetStats();
+HPLayoutCacheStats HPNodeGetLayoutCacheStats(HPNodeRef node);
+
+// measure results shared between nodes with same content, see HPMeasureCache.h
+// key is supplied by caller, e.g. hash of text and font style, 0 disables it.
+void HPNodeSetMeasureCacheKey(HPNodeRef node, uint64_t contentKey);
+uint64_t HPNodeGetMeasureCacheKey(HPNodeRef node);
+void HPMeasureCacheSetCapacity(uint32_t capacity);
+// drop all cached results, measured nodes must be marked dirty by caller.
+void HPMeasureCacheInvalidate();
+HPMeasureCacheStats HPMeasureCacheGetStats();
+void HPMeasureCacheResetStats();
+
+// bulk tree and style changes, see HPNodeMutation.h
+// created nodes are allocated in arena if not nullptr. returns count of
+// mutations applied, it stops at the first invalid one, e.g. node index out
+// of table or node not created yet.
+uint32_t HPNodeApplyMutations(HPNodeRef* nodes,
+                              uint32_t nodeCount,
+                              const HPMutation* mutations,
+                              uint32_t count,
+                              HPNodeArenaRef arena = nullptr);
+
+// windowed layout of an overflow scroll container, see HPScrollWindow in
+// HPNode.h. start and length are on the container's main axis, items within
+// margin of the window are laid out as well. estimatedItemSize is the outer
+// main size of items never laid out until the window has laid out some.
+// the container is dirtied when the window changes.
+void HPNodeSetScrollWindow(HPNodeRef node,
+                           float start,
+                           float length,
+                           float margin = 0,
+                           float estimatedItemSize = 0);
+// lay out all items again.
+void HPNodeClearScrollWindow(HPNodeRef node);
+
+// absolute frames of a laid out tree in one flat buffer, in depth first
+// order, see HPFrameBuffer.h. scale is pixels per layout unit, frames are
+// snapped to whole pixels. returns count of frames.
+HPFrameBufferRef HPFrameBufferNew();
+void HPFrameBufferFree(HPFrameBufferRef buffer);
+uint32_t HPNodeFillFrameBuffer(HPNodeRef root, HPFrameBufferRef buffer, float scale = 1);
+const HPAbsoluteFrame* HPFrameBufferGetFrames(HPFrameBufferRef buffer);
+uint32_t HPFrameBufferGetCount(HPFrameBufferRef buffer);
+
+// binary snapshot of a tree to replay its layout offline, see
+// HPTreeSnapshot.h. recording lays root's tree out again from scratch and
+// appends the snapshot to buffer. it costs a full first layout of the tree:
+// every measure function is called again, skipping the measure cache, node
+// results are overwritten and scroll windows are dropped for the pass, so
+// windowed containers are dirty after it. record on demand, e.g. for a
+// slow page, not on every frame.
+bool HPNodeRecordSnapshot(HPNodeRef root,
+                          float width,
+                          float height,
+                          std::vector<uint8_t>* buffer,
+                          HPDirection direction = DirectionLTR,
+                          void* layoutContext = nullptr);
+// nullptr if data is not a valid snapshot.
+HPTreeSnapshotRef HPTreeSnapshotLoad(const uint8_t* data, size_t size);
+void HPTreeSnapshotFree(HPTreeSnapshotRef snapshot);
+HPNodeRef HPTreeSnapshotGetRoot(HPTreeSnapshotRef snapshot);
+// lay out the whole tree again in the recorded viewport.
+void HPTreeSnapshotLayout(HPTreeSnapshotRef snapshot, HPLayoutStats* stats = nullptr);
+uint32_t HPTreeSnapshotGetMissCount(HPTreeSnapshotRef snapshot);
+
+// first layout results of trees kept in files of directory between launches,
+// see HPPersistentLayoutCache.h. salt is changed by caller when measured
+// sizes may change, e.g. font scale. returns true if results are read from
+// the cache, else the tree is laid out as HPNodeDoLayout and stored.
+HPPersistentLayoutCacheRef HPPersistentLayoutCacheNew(const char* directory, uint64_t salt = 0);
+void HPPersistentLayoutCacheFree(HPPersistentLayoutCacheRef cache);
+bool HPNodeDoPersistentCachedLayout(HPNodeRef node,
+                                    float parentWidth,
+                                    float parentHeight,
+                                    HPPersistentLayoutCacheRef cache,
+                                    HPDirection direction = DirectionLTR,
+                                    void* layoutContext = nullptr,
+                                    HPLayoutStats* stats = nullptr);
+HPPersistentLayoutCacheStats HPPersistentLayoutCacheGetStats(HPPersistentLayoutCacheRef cache);
+
 void HPNodePrint(HPNodeRef node);
 bool HPNodeReset(HPNodeRef node);
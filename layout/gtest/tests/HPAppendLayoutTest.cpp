@@ -0,0 +1,139 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <Hippy.h>
+#include <gtest.h>
+#include "HPTestUtil.h"
+
+#include <stdint.h>
+
+// row index of an infinite feed, a box and a text which shrinks.
+static HPNodeRef _feedRow(uint32_t index) {
+  const HPNodeRef row = HPNodeNew();
+  HPNodeStyleSetFlexDirection(row, FLexDirectionRow);
+  HPNodeStyleSetPadding(row, CSSAll, 8);
+  HPNodeStyleSetMargin(row, CSSBottom, 1.5f);
+  const HPNodeRef box = HPNodeNew();
+  HPNodeStyleSetWidth(box, 24);
+  HPNodeStyleSetHeight(box, 24);
+  HPNodeInsertChild(row, box, 0);
+  const HPNodeRef text = newText(10 + index * 37 % 80);
+  HPNodeStyleSetFlexShrink(text, 1);
+  HPNodeInsertChild(row, text, 1);
+  return row;
+}
+
+// column of the first rowCount rows of the feed.
+static HPNodeRef _feed(uint32_t rowCount) {
+  const HPNodeRef column = HPNodeNew();
+  for (uint32_t i = 0; i < rowCount; i++) {
+    HPNodeInsertChild(column, _feedRow(i), i);
+  }
+  return column;
+}
+
+// scroll view with a column as content.
+static HPNodeRef newScrollView(HPNodeRef content) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 360);
+  HPNodeStyleSetHeight(root, 600);
+  const HPNodeRef scroll = HPNodeNew();
+  HPNodeStyleSetFlexGrow(scroll, 1);
+  HPNodeStyleSetOverflow(scroll, OverflowScroll);
+  HPNodeInsertChild(root, scroll, 0);
+  HPNodeStyleSetPadding(content, CSSTop, 10);
+  HPNodeInsertChild(scroll, content, 0);
+  return root;
+}
+
+TEST(HippyTest, append_lays_out_only_appended_items) {
+  const HPNodeRef root = newScrollView(_feed(2000));
+  HPNodeRef content = root->getChild(0)->getChild(0);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  for (uint32_t page = 0; page < 3; page++) {
+    // new rows are styled after they are inserted.
+    for (uint32_t i = 0; i < 20; i++) {
+      uint32_t index = content->childCount();
+      const HPNodeRef row = _feedRow(index);
+      HPNodeInsertChild(content, row, index);
+      HPNodeStyleSetMargin(row, CSSLeft, static_cast<float>(i % 3));
+    }
+    HPLayoutStats stats;
+    HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &stats);
+    // content is measured in both axes and laid out by the append path.
+    ASSERT_EQ(stats.appendLayoutCount, 3u);
+    ASSERT_LE(stats.measureFuncCount, 3 * 20u);
+    // a full layout visits about 7 nodes per row of the content.
+    ASSERT_LT(stats.visitCount, 20 * 30u);
+  }
+
+  const HPNodeRef expected = newScrollView(_feed(2060));
+  HPNodeRef expectedContent = expected->getChild(0)->getChild(0);
+  for (uint32_t i = 2000; i < 2060; i++) {
+    HPNodeStyleSetMargin(expectedContent->getChild(i), CSSLeft,
+                         static_cast<float>((i - 2000) % 20 % 3));
+  }
+  HPNodeDoLayout(expected, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  expectSameLayout(root, expected);
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, append_with_other_changes_lays_out_all_items) {
+  const HPNodeRef root = newScrollView(_feed(200));
+  HPNodeRef content = root->getChild(0)->getChild(0);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  // an item before the appended ones changed.
+  HPNodeInsertChild(content, _feedRow(200), 200);
+  HPNodeRef text = content->getChild(10)->getChild(1);
+  text->setContext(reinterpret_cast<void*>(static_cast<uintptr_t>(150)));
+  HPNodeMarkDirty(text);
+  HPLayoutStats stats;
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &stats);
+  ASSERT_EQ(stats.appendLayoutCount, 0u);
+
+  // inserted before the last laid out item.
+  HPNodeInsertChild(content, _feedRow(201), 100);
+  HPLayoutStatsReset(&stats);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &stats);
+  ASSERT_EQ(stats.appendLayoutCount, 0u);
+
+  // appended item grows.
+  const HPNodeRef row = _feedRow(202);
+  HPNodeStyleSetFlexGrow(row, 1);
+  HPNodeInsertChild(content, row, 202);
+  HPLayoutStatsReset(&stats);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &stats);
+  ASSERT_EQ(stats.appendLayoutCount, 0u);
+
+  const HPNodeRef expected = newScrollView(_feed(200));
+  HPNodeRef expectedContent = expected->getChild(0)->getChild(0);
+  HPNodeInsertChild(expectedContent, _feedRow(200), 200);
+  expectedContent->getChild(10)->getChild(1)->setContext(
+      reinterpret_cast<void*>(static_cast<uintptr_t>(150)));
+  HPNodeInsertChild(expectedContent, _feedRow(201), 100);
+  const HPNodeRef expectedRow = _feedRow(202);
+  HPNodeStyleSetFlexGrow(expectedRow, 1);
+  HPNodeInsertChild(expectedContent, expectedRow, 202);
+  HPNodeDoLayout(expected, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  expectSameLayout(root, expected);
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(root);
+}
@@ -0,0 +1,210 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Hippy.h>
+#include <gtest.h>
+#include "HPTestUtil.h"
+
+#include <stdint.h>
+
+static uint32_t batchCount = 0;
+static uint32_t batchRequestCount = 0;
+
+static void _batchMeasureText(HPMeasureRequest* requests, uint32_t count, void* layoutContext) {
+  batchCount++;
+  batchRequestCount += count;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t length =
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(requests[i].node->getContext()));
+    requests[i].result =
+        measureTextLength(length, requests[i].width, requests[i].widthMeasureMode);
+  }
+}
+
+// column of 6 cards 375 px wide, each a box and a text which shrinks.
+static HPNodeRef _cards() {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 375);
+  HPNodeStyleSetPadding(root, CSSAll, 10);
+  for (uint32_t i = 0; i < 6; i++) {
+    const HPNodeRef card = HPNodeNew();
+    HPNodeStyleSetFlexDirection(card, FLexDirectionRow);
+    HPNodeStyleSetPadding(card, CSSAll, 12);
+    HPNodeStyleSetMargin(card, CSSBottom, 8);
+    const HPNodeRef box = HPNodeNew();
+    HPNodeStyleSetWidth(box, 24);
+    HPNodeStyleSetHeight(box, 24);
+    HPNodeInsertChild(card, box, 0);
+    const HPNodeRef text = newText(10 + i * 37 % 30);
+    HPNodeStyleSetFlexShrink(text, 1);
+    HPNodeInsertChild(card, text, 1);
+    HPNodeInsertChild(root, card, i);
+  }
+  return root;
+}
+
+TEST(HippyTest, batch_measure_resolves_text_in_one_call) {
+  const HPNodeRef expected = _cards();
+  HPNodeDoLayout(expected, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  const HPNodeRef root = _cards();
+  measureCount = 0;
+  batchCount = 0;
+  batchRequestCount = 0;
+  HPLayoutStats stats;
+  HPNodeDoBatchMeasuredLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, _batchMeasureText,
+                              DirectionLTR, nullptr, &stats);
+  ASSERT_EQ(1u, batchCount);
+  ASSERT_EQ(6u, batchRequestCount);
+  ASSERT_EQ(6u, stats.batchMeasureCount);
+  ASSERT_EQ(0u, measureCount.load());
+  ASSERT_EQ(0u, stats.measureFuncCount);
+  ASSERT_GE(stats.batchMeasureHitCount, 6u);
+  expectSameLayout(expected, root);
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, batch_measure_requests_only_dirty_text) {
+  const HPNodeRef root = _cards();
+  HPNodeDoBatchMeasuredLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, _batchMeasureText);
+
+  const HPNodeRef text = root->getChild(3)->getChild(1);
+  text->setContext(reinterpret_cast<void*>(static_cast<uintptr_t>(40)));
+  HPNodeMarkDirty(text);
+  measureCount = 0;
+  batchCount = 0;
+  batchRequestCount = 0;
+  HPNodeDoBatchMeasuredLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, _batchMeasureText);
+  ASSERT_EQ(1u, batchCount);
+  ASSERT_EQ(1u, batchRequestCount);
+  ASSERT_EQ(0u, measureCount.load());
+  // 40 chars fit in the 307 px next to the box.
+  ASSERT_FLOAT_EQ(280, HPNodeLayoutGetWidth(text));
+
+  // nothing is dirty, batch function is not called.
+  batchCount = 0;
+  HPNodeDoBatchMeasuredLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, _batchMeasureText);
+  ASSERT_EQ(0u, batchCount);
+
+  HPNodeFreeRecursive(root);
+}
+
+// flexed text is measured again with its flexed width, which is not
+// predicted, so it falls back to the measure function.
+TEST(HippyTest, batch_measure_falls_back_to_measure_func) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 200);
+  HPNodeStyleSetFlexDirection(root, FLexDirectionRow);
+  const HPNodeRef text = newText(8);
+  HPNodeStyleSetFlexGrow(text, 1);
+  HPNodeInsertChild(root, text, 0);
+  const HPNodeRef other = newText(4);
+  HPNodeInsertChild(root, other, 1);
+
+  measureCount = 0;
+  batchRequestCount = 0;
+  HPNodeDoBatchMeasuredLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, _batchMeasureText);
+  ASSERT_EQ(2u, batchRequestCount);
+  ASSERT_GE(measureCount.load(), 1u);
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetLeft(text));
+  ASSERT_FLOAT_EQ(172, HPNodeLayoutGetWidth(text));
+  ASSERT_FLOAT_EQ(172, HPNodeLayoutGetLeft(other));
+  ASSERT_FLOAT_EQ(28, HPNodeLayoutGetWidth(other));
+
+  HPNodeFreeRecursive(root);
+}
+
+// like a batch function which fails, e.g. by an exception in java.
+static void _batchMeasureNothing(HPMeasureRequest* requests, uint32_t count, void* layoutContext) {
+  batchCount++;
+}
+
+TEST(HippyTest, batch_measure_unfilled_requests_use_measure_func) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 100);
+  HPNodeInsertChild(root, newText(4), 0);
+  HPNodeInsertChild(root, newText(20), 1);
+
+  measureCount = 0;
+  batchCount = 0;
+  HPLayoutStats stats;
+  HPNodeDoBatchMeasuredLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, _batchMeasureNothing,
+                              DirectionLTR, nullptr, &stats);
+  ASSERT_EQ(1u, batchCount);
+  ASSERT_EQ(0u, stats.batchMeasureHitCount);
+  ASSERT_EQ(2u, measureCount.load());
+  ASSERT_FLOAT_EQ(17, HPNodeLayoutGetHeight(root->getChild(0)));
+  // 20 chars wrap to 2 lines in 100 px.
+  ASSERT_FLOAT_EQ(34, HPNodeLayoutGetHeight(root->getChild(1)));
+
+  HPNodeFreeRecursive(root);
+}
+
+static HPNodeRef nestedRoot = nullptr;
+
+// lays out another tree while the outer layout measures node.
+static HPSize _measureWithNestedLayout(HPNodeRef node,
+                                       float width,
+                                       MeasureMode widthMeasureMode,
+                                       float height,
+                                       MeasureMode heightMeasureMode,
+                                       void* layoutContext) {
+  HPNodeMarkDirty(nestedRoot);
+  HPNodeDoLayout(nestedRoot, width, VALUE_UNDEFINED);
+  return measureTextLength(textLength(node), width, widthMeasureMode);
+}
+
+// leaves nodes laying out another tree to their measure function.
+static void _batchMeasureTextOnly(HPMeasureRequest* requests, uint32_t count, void* layoutContext) {
+  for (uint32_t i = 0; i < count; i++) {
+    if (requests[i].node->measure == _measureText) {
+      requests[i].result = measureTextLength(textLength(requests[i].node), requests[i].width,
+                                             requests[i].widthMeasureMode);
+    }
+  }
+}
+
+// a layout nested in a measure function keeps predicted measures and
+// stats of the outer layout.
+TEST(HippyTest, batch_measure_kept_across_nested_layout) {
+  nestedRoot = HPNodeNew();
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 200);
+  const HPNodeRef nesting = newText(8);
+  HPNodeSetMeasureFunc(nesting, _measureWithNestedLayout);
+  HPNodeInsertChild(root, nesting, 0);
+  for (uint32_t i = 1; i < 4; i++) {
+    HPNodeInsertChild(root, newText(10 * i), i);
+  }
+
+  measureCount = 0;
+  HPLayoutStats stats;
+  HPNodeDoBatchMeasuredLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, _batchMeasureTextOnly,
+                              DirectionLTR, nullptr, &stats);
+  ASSERT_EQ(0u, measureCount.load());
+  ASSERT_EQ(4u, stats.batchMeasureCount);
+  ASSERT_EQ(3u, stats.batchMeasureHitCount);
+  ASSERT_EQ(1u, stats.measureFuncCount);
+  ASSERT_FLOAT_EQ(17, HPNodeLayoutGetHeight(nesting));
+  ASSERT_FLOAT_EQ(34, HPNodeLayoutGetHeight(root->getChild(3)));
+  ASSERT_FLOAT_EQ(200, HPNodeLayoutGetWidth(nestedRoot));
+
+  HPNodeFreeRecursive(root);
+  HPNodeFree(nestedRoot);
+  nestedRoot = nullptr;
+}
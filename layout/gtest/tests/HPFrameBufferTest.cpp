@@ -0,0 +1,119 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <Hippy.h>
+#include <gtest.h>
+
+TEST(HippyTest, frame_buffer_absolute_frames_in_depth_first_order) {
+  // column of 3 rows of 2 boxes.
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 300);
+  HPNodeStyleSetPadding(root, CSSAll, 10);
+  for (uint32_t i = 0; i < 3; i++) {
+    const HPNodeRef row = HPNodeNew();
+    HPNodeStyleSetFlexDirection(row, FLexDirectionRow);
+    for (uint32_t j = 0; j < 2; j++) {
+      const HPNodeRef box = HPNodeNew();
+      HPNodeStyleSetWidth(box, 20);
+      HPNodeStyleSetHeight(box, 20);
+      HPNodeInsertChild(row, box, j);
+    }
+    HPNodeInsertChild(root, row, i);
+  }
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  const HPFrameBufferRef buffer = HPFrameBufferNew();
+
+  ASSERT_EQ(10u, HPNodeFillFrameBuffer(root, buffer));
+  ASSERT_EQ(10u, HPFrameBufferGetCount(buffer));
+  const HPAbsoluteFrame* frames = HPFrameBufferGetFrames(buffer);
+  ASSERT_TRUE(frames[0].node == root);
+  ASSERT_EQ(HP_FRAME_NO_PARENT, frames[0].parent);
+  ASSERT_EQ(10u, frames[0].subtreeSize);
+  ASSERT_FLOAT_EQ(300, frames[0].width);
+  ASSERT_FLOAT_EQ(80, frames[0].height);
+
+  for (uint32_t i = 0; i < 3; i++) {
+    const HPNodeRef row = root->getChild(i);
+    const uint32_t rowIndex = 1 + i * 3;
+    ASSERT_TRUE(frames[rowIndex].node == row);
+    ASSERT_EQ(0u, frames[rowIndex].parent);
+    ASSERT_EQ(3u, frames[rowIndex].subtreeSize);
+    ASSERT_FLOAT_EQ(10, frames[rowIndex].x);
+    ASSERT_FLOAT_EQ(10 + i * 20, frames[rowIndex].y);
+    for (uint32_t j = 0; j < 2; j++) {
+      const HPAbsoluteFrame& box = frames[rowIndex + 1 + j];
+      ASSERT_TRUE(box.node == row->getChild(j));
+      ASSERT_EQ(rowIndex, box.parent);
+      ASSERT_FLOAT_EQ(HPNodeLayoutGetLeft(row) + HPNodeLayoutGetLeft(box.node), box.x);
+      ASSERT_FLOAT_EQ(HPNodeLayoutGetTop(row) + HPNodeLayoutGetTop(box.node), box.y);
+      ASSERT_FLOAT_EQ(20, box.width);
+      ASSERT_FLOAT_EQ(20, box.height);
+    }
+  }
+
+  // buffer is reused by the next fill.
+  HPNodeRemoveChild(root, root->getChild(2));
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_EQ(7u, HPNodeFillFrameBuffer(root, buffer));
+  ASSERT_EQ(7u, HPFrameBufferGetFrames(buffer)[0].subtreeSize);
+
+  HPFrameBufferFree(buffer);
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, frame_buffer_snaps_absolute_edges_to_pixel_grid) {
+  // unrounded results, as left by layout on android.
+  const HPNodeRef root = HPNodeNew();
+  const HPNodeRef first = HPNodeNew();
+  const HPNodeRef second = HPNodeNew();
+  HPNodeInsertChild(root, first, 0);
+  HPNodeInsertChild(root, second, 1);
+  root->result.position[CSSLeft] = 0.4f;
+  root->result.position[CSSTop] = 0;
+  root->result.dim[DimWidth] = 100;
+  root->result.dim[DimHeight] = 10;
+  first->result.position[CSSLeft] = 0.4f;
+  first->result.position[CSSTop] = 0;
+  first->result.dim[DimWidth] = 33.55f;
+  first->result.dim[DimHeight] = 10;
+  second->result.position[CSSLeft] = 33.95f;
+  second->result.position[CSSTop] = 0;
+  second->result.dim[DimWidth] = 33.3f;
+  second->result.dim[DimHeight] = 10;
+  const HPFrameBufferRef buffer = HPFrameBufferNew();
+
+  // edges are rounded at absolute positions, so neighbours still touch.
+  ASSERT_EQ(3u, HPNodeFillFrameBuffer(root, buffer));
+  const HPAbsoluteFrame* frames = HPFrameBufferGetFrames(buffer);
+  ASSERT_FLOAT_EQ(0, frames[0].x);
+  ASSERT_FLOAT_EQ(1, frames[1].x);
+  ASSERT_FLOAT_EQ(33, frames[1].width);
+  ASSERT_FLOAT_EQ(frames[1].x + frames[1].width, frames[2].x);
+  ASSERT_FLOAT_EQ(34, frames[2].x);
+  ASSERT_FLOAT_EQ(34, frames[2].width);
+
+  // half pixels at scale 2.
+  ASSERT_EQ(3u, HPNodeFillFrameBuffer(root, buffer, 2));
+  frames = HPFrameBufferGetFrames(buffer);
+  ASSERT_FLOAT_EQ(0.5f, frames[0].x);
+  ASSERT_FLOAT_EQ(1, frames[1].x);
+  ASSERT_FLOAT_EQ(33.5f, frames[1].width);
+  ASSERT_FLOAT_EQ(frames[1].x + frames[1].width, frames[2].x);
+
+  HPFrameBufferFree(buffer);
+  HPNodeFreeRecursive(root);
+}
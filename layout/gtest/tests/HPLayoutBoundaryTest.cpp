@@ -0,0 +1,314 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Hippy.h>
+#include <gtest.h>
+#include "HPTestUtil.h"
+#include <string.h>
+#include <vector>
+
+static float longTextWidth = 52;
+
+static HPSize _measureTextWidth(HPNodeRef node,
+                           float width,
+                           MeasureMode widthMeasureMode,
+                           float height,
+                           MeasureMode heightMeasureMode,
+                           void* layoutContext) {
+  measureCount++;
+  // text width is kept in context, default is 36.
+  float* textWidth = reinterpret_cast<float*>(node->getContext());
+  HPSize size = {textWidth != nullptr ? *textWidth : 36, 17};
+  return size;
+}
+
+// rows of fixed size cells, each cell has a text leaf and a box.
+static HPNodeRef buildCellTree() {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 362);
+  for (uint32_t i = 0; i < 10; i++) {
+    const HPNodeRef row = HPNodeNew();
+    HPNodeStyleSetFlexDirection(row, FLexDirectionRow);
+    HPNodeStyleSetPadding(row, CSSLeft, 2);
+    HPNodeInsertChild(root, row, i);
+    for (uint32_t j = 0; j < 4; j++) {
+      const HPNodeRef cell = HPNodeNew();
+      HPNodeStyleSetWidth(cell, 80);
+      HPNodeStyleSetHeight(cell, 40);
+      // flexed main size differs from style width.
+      HPNodeStyleSetFlexGrow(cell, j % 2);
+      HPNodeStyleSetAlignItems(cell, FlexAlignCenter);
+      HPNodeInsertChild(row, cell, j);
+      const HPNodeRef text = HPNodeNew();
+      HPNodeSetMeasureFunc(text, _measureTextWidth);
+      HPNodeInsertChild(cell, text, 0);
+      const HPNodeRef box = HPNodeNew();
+      HPNodeStyleSetHeight(box, 10);
+      HPNodeStyleSetFlexGrow(box, 1);
+      HPNodeInsertChild(cell, box, 1);
+    }
+  }
+  return root;
+}
+
+static void setLongText(HPNodeRef text) {
+  text->setContext(&longTextWidth);
+  HPNodeMarkDirty(text);
+}
+
+TEST(HippyTest, layout_boundary_stops_dirty) {
+  const HPNodeRef root = buildCellTree();
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  const HPNodeRef row = root->getChild(3);
+  const HPNodeRef cell = row->getChild(1);
+  ASSERT_TRUE(cell->isLayoutBoundary());
+  ASSERT_FALSE(row->isLayoutBoundary());
+
+  HPNodeMarkDirty(cell->getChild(0));
+  ASSERT_TRUE(cell->isDirty);
+  ASSERT_FALSE(row->isDirty);
+  ASSERT_FALSE(root->isDirty);
+  // root still needs layout for the dirty boundary.
+  ASSERT_TRUE(HPNodeIsDirty(root));
+
+  measureCount = 0;
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_EQ(1u, measureCount.load());
+  ASSERT_FALSE(HPNodeIsDirty(root));
+  ASSERT_FALSE(cell->isDirty);
+
+  // style change of a boundary itself dirties its ancestors.
+  HPNodeStyleSetHeight(cell, 50);
+  ASSERT_TRUE(row->isDirty);
+  ASSERT_TRUE(root->isDirty);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_EQ(50, HPNodeLayoutGetHeight(row));
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, layout_boundary_relayout_same_as_full_layout) {
+  const HPNodeRef root = buildCellTree();
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  // text grows in a few cells, a cell gets a new child.
+  setLongText(root->getChild(1)->getChild(0)->getChild(0));
+  setLongText(root->getChild(6)->getChild(3)->getChild(0));
+  const HPNodeRef extra = HPNodeNew();
+  HPNodeStyleSetWidth(extra, 12);
+  HPNodeInsertChild(root->getChild(8)->getChild(1), extra, 2);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  // fresh tree with the same final content.
+  const HPNodeRef expected = buildCellTree();
+  expected->getChild(1)->getChild(0)->getChild(0)->setContext(&longTextWidth);
+  expected->getChild(6)->getChild(3)->getChild(0)->setContext(&longTextWidth);
+  const HPNodeRef expectedExtra = HPNodeNew();
+  HPNodeStyleSetWidth(expectedExtra, 12);
+  HPNodeInsertChild(expected->getChild(8)->getChild(1), expectedExtra, 2);
+  HPNodeDoLayout(expected, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  expectSameLayout(expected, root);
+
+  HPNodeFreeRecursive(root);
+  HPNodeFreeRecursive(expected);
+}
+
+TEST(HippyTest, layout_boundary_overflow_relayouts_ancestors) {
+  const HPNodeRef root = buildCellTree();
+  const HPNodeRef expected = buildCellTree();
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  // content taller than the cell makes it overflow.
+  const HPNodeRef cell = root->getChild(5)->getChild(0);
+  const HPNodeRef tall = HPNodeNew();
+  HPNodeStyleSetHeight(tall, 200);
+  HPNodeStyleSetFlexShrink(tall, 0);
+  HPNodeInsertChild(cell, tall, 0);
+  ASSERT_FALSE(root->isDirty);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_TRUE(HPNodeLayoutGetHadOverflow(cell));
+
+  const HPNodeRef expectedTall = HPNodeNew();
+  HPNodeStyleSetHeight(expectedTall, 200);
+  HPNodeStyleSetFlexShrink(expectedTall, 0);
+  HPNodeInsertChild(expected->getChild(5)->getChild(0), expectedTall, 0);
+  HPNodeDoLayout(expected, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  expectSameLayout(expected, root);
+
+  HPNodeRemoveChild(cell, tall);
+  HPNodeFree(tall);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_FALSE(HPNodeLayoutGetHadOverflow(cell));
+  HPNodeRemoveChild(expected->getChild(5)->getChild(0), expectedTall);
+  HPNodeFree(expectedTall);
+  HPNodeDoLayout(expected, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  expectSameLayout(expected, root);
+
+  HPNodeFreeRecursive(root);
+  HPNodeFreeRecursive(expected);
+}
+
+// text widths with fractions, so results are rounded differently by position.
+// fractions are exact in float, so that no result depends on order of sums.
+static float randomTextWidths[] = {12.25f, 17.5f, 26.75f, 31.25f, 44.5f, 58.75f};
+
+// small linear congruential generator, same sequence on every platform.
+static uint32_t nextRandom(uint32_t* state) {
+  *state = *state * 1103515245 + 12345;
+  return (*state >> 16) & 0x7fff;
+}
+
+static float randomFraction(uint32_t* state, uint32_t range) {
+  return (nextRandom(state) % (range * 4)) / 4.0f;
+}
+
+static HPNodeRef buildRandomNode(uint32_t* state, uint32_t depth) {
+  const HPNodeRef node = HPNodeNew();
+  const uint32_t kind = depth == 0 ? 3 : nextRandom(state) % 4;
+  if (kind == 0) {
+    HPNodeSetMeasureFunc(node, _measureTextWidth);
+    node->setContext(&randomTextWidths[nextRandom(state) % 6]);
+    if (nextRandom(state) % 2 == 0) {
+      HPNodeSetNodeType(node, NodeTypeText);
+    }
+    return node;
+  }
+  if (kind == 1) {
+    HPNodeStyleSetHeight(node, 5 + randomFraction(state, 20));
+    HPNodeStyleSetFlexGrow(node, nextRandom(state) % 2);
+    return node;
+  }
+  if (kind == 2) {
+    // layout boundary.
+    HPNodeStyleSetWidth(node, 30 + randomFraction(state, 60));
+    HPNodeStyleSetHeight(node, 20 + randomFraction(state, 40));
+  }
+  HPNodeStyleSetFlexDirection(node, static_cast<FlexDirection>(nextRandom(state) % 4));
+  HPNodeStyleSetAlignItems(node, static_cast<FlexAlign>(1 + nextRandom(state) % 4));
+  HPNodeStyleSetPadding(node, CSSLeft, randomFraction(state, 4));
+  HPNodeStyleSetPadding(node, CSSTop, randomFraction(state, 4));
+  HPNodeStyleSetMargin(node, CSSLeft, randomFraction(state, 4));
+  HPNodeStyleSetMargin(node, CSSTop, randomFraction(state, 4));
+  if (depth < 3) {
+    const uint32_t count = 1 + nextRandom(state) % 4;
+    for (uint32_t i = 0; i < count; i++) {
+      HPNodeInsertChild(node, buildRandomNode(state, depth + 1), i);
+    }
+  }
+  return node;
+}
+
+static void collectNodes(HPNodeRef node, std::vector<HPNodeRef>* nodes) {
+  nodes->push_back(node);
+  for (uint32_t i = 0; i < node->childCount(); i++) {
+    collectNodes(node->getChild(i), nodes);
+  }
+}
+
+// applies same mutations to trees of same content.
+static void mutateRandomNode(HPNodeRef root, uint32_t* state) {
+  std::vector<HPNodeRef> nodes;
+  collectNodes(root, &nodes);
+  const HPNodeRef node = nodes[1 + nextRandom(state) % (nodes.size() - 1)];
+  if (node->measure != nullptr) {
+    node->setContext(&randomTextWidths[nextRandom(state) % 6]);
+    HPNodeMarkDirty(node);
+    return;
+  }
+  const uint32_t kind = nextRandom(state) % 3;
+  if (kind == 0) {
+    HPNodeStyleSetPadding(node, CSSTop, randomFraction(state, 4));
+  } else if (kind == 1 || node->childCount() == 0) {
+    const HPNodeRef box = HPNodeNew();
+    HPNodeStyleSetHeight(box, 1 + randomFraction(state, 10));
+    HPNodeStyleSetWidth(box, 1 + randomFraction(state, 10));
+    HPNodeInsertChild(node, box, 0);
+  } else {
+    const HPNodeRef child = node->getChild(node->childCount() - 1);
+    HPNodeRemoveChild(node, child);
+    HPNodeFreeRecursive(child);
+  }
+}
+
+TEST(HippyTest, layout_boundary_relayout_same_as_full_layout_randomized) {
+  for (uint32_t seed = 1; seed <= 200; seed++) {
+    uint32_t treeState = seed;
+    const HPNodeRef root = buildRandomNode(&treeState, 0);
+    HPNodeStyleSetWidth(root, 375);
+    HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+    uint32_t mutationState = seed;
+    for (uint32_t round = 1; round <= 3; round++) {
+      for (uint32_t i = 0; i < 3; i++) {
+        mutateRandomNode(root, &mutationState);
+      }
+      HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+      // fresh tree laid out once after same mutations.
+      treeState = seed;
+      const HPNodeRef expected = buildRandomNode(&treeState, 0);
+      HPNodeStyleSetWidth(expected, 375);
+      uint32_t expectedState = seed;
+      for (uint32_t i = 0; i < round * 3; i++) {
+        mutateRandomNode(expected, &expectedState);
+      }
+      HPNodeDoLayout(expected, VALUE_UNDEFINED, VALUE_UNDEFINED);
+      SCOPED_TRACE(seed);
+      expectSameLayout(expected, root);
+      HPNodeFreeRecursive(expected);
+    }
+    HPNodeFreeRecursive(root);
+  }
+}
+
+// padding of box is wider than the space it's stretched to, relayout must not
+// reuse its size of the last layout, which had another width.
+static HPNodeRef buildPaddedBoxTree() {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetMargin(root, CSSAll, 2.5f);
+  const HPNodeRef column = HPNodeNew();
+  HPNodeStyleSetMargin(column, CSSLeft, 20);
+  const HPNodeRef box = HPNodeNew();
+  HPNodeStyleSetPadding(box, CSSAll, 100);
+  const HPNodeRef hidden = HPNodeNew();
+  HPNodeStyleSetWidth(hidden, 46.5f);
+  HPNodeStyleSetMinHeight(hidden, 67.4f);
+  HPNodeStyleSetDisplay(hidden, DisplayTypeNone);
+  HPNodeInsertChild(box, hidden, 0);
+  HPNodeInsertChild(column, box, 0);
+  HPNodeInsertChild(root, column, 0);
+  const HPNodeRef text = newText(20);
+  HPNodeStyleSetFlexShrink(text, 2);
+  HPNodeStyleSetMaxWidth(text, 14);
+  HPNodeInsertChild(root, text, 1);
+  return root;
+}
+
+TEST(HippyTest, relayout_of_box_wider_than_its_space_same_as_full_layout) {
+  const HPNodeRef root = buildPaddedBoxTree();
+  HPNodeDoLayout(root, 129, VALUE_UNDEFINED, DirectionRTL);
+  HPNodeStyleSetMargin(root, CSSLeft, 33.7f);
+  HPNodeStyleSetMargin(root->getChild(1), CSSVertical, 10);
+  HPNodeDoLayout(root, 129, VALUE_UNDEFINED, DirectionRTL);
+
+  const HPNodeRef expected = buildPaddedBoxTree();
+  HPNodeStyleSetMargin(expected, CSSLeft, 33.7f);
+  HPNodeStyleSetMargin(expected->getChild(1), CSSVertical, 10);
+  HPNodeDoLayout(expected, 129, VALUE_UNDEFINED, DirectionRTL);
+  expectSameLayout(expected, root);
+
+  HPNodeFreeRecursive(root);
+  HPNodeFreeRecursive(expected);
+}
@@ -0,0 +1,133 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Hippy.h>
+#include <gtest.h>
+
+static HPSize atMost(float width) {
+  HPSize size = {width, VALUE_UNDEFINED};
+  return size;
+}
+
+static const HPSizeMode atMostWidth = {MeasureModeAtMost, MeasureModeUndefined};
+
+TEST(HippyTest, layout_cache_keeps_more_than_six_measures) {
+  HPLayoutStats layoutStats;
+  HPLayoutStatsReset(&layoutStats);
+  HPLayoutCache cache;
+  for (uint32_t i = 0; i < 10; i++) {
+    HPSize result = {static_cast<float>(i), 10};
+    cache.cacheResult(atMost(100 + i), result, atMostWidth, LayoutActionMeasureWidth);
+  }
+  ASSERT_EQ(10u, cache.measureCount());
+  for (uint32_t i = 0; i < 10; i++) {
+    MeasureResult* cached = cache.getCachedMeasureResult(
+        atMost(100 + i), atMostWidth, LayoutActionMeasureWidth, false, &layoutStats);
+    ASSERT_TRUE(cached != nullptr);
+    ASSERT_EQ(i, cached->resultSize.width);
+  }
+  // same constraints replace the result.
+  HPSize result = {42, 10};
+  cache.cacheResult(atMost(100), result, atMostWidth, LayoutActionMeasureWidth);
+  ASSERT_EQ(10u, cache.measureCount());
+  ASSERT_EQ(42, cache.getCachedMeasureResult(atMost(100), atMostWidth, LayoutActionMeasureWidth,
+                                             false, &layoutStats)->resultSize.width);
+
+  HPLayoutCacheStats stats = cache.stats();
+  ASSERT_EQ(11u, stats.measureHitCount);
+  ASSERT_EQ(0u, stats.measureMissCount);
+  ASSERT_EQ(0u, stats.evictCount);
+  ASSERT_EQ(11u, layoutStats.measureCacheHitCount);
+
+  // lookups without statistics are not counted.
+  cache.getCachedMeasureResult(atMost(100), atMostWidth, LayoutActionMeasureWidth, false);
+  ASSERT_EQ(11u, cache.stats().measureHitCount);
+}
+
+TEST(HippyTest, layout_cache_evicts_least_used) {
+  HPLayoutCacheSetCapacity(3);
+  HPLayoutStats layoutStats;
+  HPLayoutStatsReset(&layoutStats);
+  HPLayoutCache cache;
+  HPSize result = {10, 10};
+  cache.cacheResult(atMost(100), result, atMostWidth, LayoutActionMeasureWidth, &layoutStats);
+  cache.cacheResult(atMost(200), result, atMostWidth, LayoutActionMeasureWidth, &layoutStats);
+  cache.cacheResult(atMost(300), result, atMostWidth, LayoutActionMeasureWidth, &layoutStats);
+  // 100 and 300 are used, 200 is evicted for a new result.
+  cache.getCachedMeasureResult(atMost(100), atMostWidth, LayoutActionMeasureWidth, false,
+                               &layoutStats);
+  cache.getCachedMeasureResult(atMost(300), atMostWidth, LayoutActionMeasureWidth, false,
+                               &layoutStats);
+  cache.cacheResult(atMost(400), result, atMostWidth, LayoutActionMeasureWidth, &layoutStats);
+  ASSERT_EQ(3u, cache.measureCount());
+  ASSERT_TRUE(cache.getCachedMeasureResult(atMost(200), atMostWidth, LayoutActionMeasureWidth,
+                                           false, &layoutStats) == nullptr);
+  ASSERT_TRUE(cache.getCachedMeasureResult(atMost(100), atMostWidth, LayoutActionMeasureWidth,
+                                           false, &layoutStats) != nullptr);
+  ASSERT_TRUE(cache.getCachedMeasureResult(atMost(400), atMostWidth, LayoutActionMeasureWidth,
+                                           false, &layoutStats) != nullptr);
+
+  HPLayoutCacheStats stats = cache.stats();
+  ASSERT_EQ(4u, stats.measureHitCount);
+  ASSERT_EQ(1u, stats.measureMissCount);
+  ASSERT_EQ(1u, stats.evictCount);
+  ASSERT_EQ(4u, layoutStats.measureCacheHitCount);
+  ASSERT_EQ(1u, layoutStats.measureCacheMissCount);
+  ASSERT_EQ(1u, layoutStats.measureCacheEvictCount);
+
+  // results are dropped but statistics are kept.
+  cache.clearCache();
+  ASSERT_EQ(0u, cache.measureCount());
+  ASSERT_EQ(1u, cache.stats().evictCount);
+  HPLayoutCacheSetCapacity(HP_LAYOUT_CACHE_DEFAULT_CAPACITY);
+}
+
+TEST(HippyTest, layout_cache_node_and_global_stats) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 100);
+  HPNodeStyleSetHeight(root, 100);
+  const HPNodeRef child = HPNodeNew();
+  HPNodeStyleSetHeight(child, 20);
+  HPNodeInsertChild(root, child, 0);
+  HPLayoutCacheResetStats();
+
+  // layouts without statistics are not counted.
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  HPLayoutCacheStats stats = HPNodeGetLayoutCacheStats(root);
+  ASSERT_EQ(0u, stats.layoutMissCount);
+  ASSERT_EQ(0u, HPLayoutCacheGetStats().layoutMissCount);
+
+  HPLayoutStats layoutStats;
+  HPNodeMarkDirty(child);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &layoutStats);
+  stats = HPNodeGetLayoutCacheStats(root);
+  ASSERT_EQ(0u, stats.layoutHitCount);
+  ASSERT_EQ(1u, stats.layoutMissCount);
+
+  // clean tree is laid out from cache.
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &layoutStats);
+  stats = HPNodeGetLayoutCacheStats(root);
+  ASSERT_EQ(1u, stats.layoutHitCount);
+  ASSERT_EQ(1u, stats.layoutMissCount);
+  ASSERT_EQ(1u, layoutStats.layoutCacheHitCount);
+
+  HPLayoutCacheStats childStats = HPNodeGetLayoutCacheStats(child);
+  HPLayoutCacheStats global = HPLayoutCacheGetStats();
+  ASSERT_EQ(stats.layoutHitCount + childStats.layoutHitCount, global.layoutHitCount);
+  ASSERT_EQ(stats.layoutMissCount + childStats.layoutMissCount, global.layoutMissCount);
+  ASSERT_EQ(stats.measureMissCount + childStats.measureMissCount, global.measureMissCount);
+  HPNodeFreeRecursive(root);
+}
@@ -0,0 +1,68 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <Hippy.h>
+#include <gtest.h>
+
+TEST(HippyTest, layout_edges_not_allocated_without_edges) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 100);
+  HPNodeStyleSetHeight(root, 100);
+  const HPNodeRef child = HPNodeNew();
+  HPNodeStyleSetHeight(child, 10);
+  HPNodeInsertChild(root, child, 0);
+
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_TRUE(root->result.edges == nullptr);
+  ASSERT_TRUE(child->result.edges == nullptr);
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetMargin(child, CSSLeft));
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetPadding(child, CSSTop));
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetBorder(child, CSSRight));
+  ASSERT_FLOAT_EQ(100, HPNodeLayoutGetWidth(child));
+
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, layout_edges_allocated_on_demand) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 100);
+  HPNodeStyleSetHeight(root, 100);
+  HPNodeStyleSetPadding(root, CSSTop, 5);
+  const HPNodeRef child = HPNodeNew();
+  HPNodeStyleSetHeight(child, 10);
+  HPNodeStyleSetMargin(child, CSSLeft, 10);
+  HPNodeStyleSetBorder(child, CSSBottom, 2);
+  HPNodeInsertChild(root, child, 0);
+
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_TRUE(root->result.edges != nullptr);
+  ASSERT_TRUE(child->result.edges != nullptr);
+  ASSERT_FLOAT_EQ(5, HPNodeLayoutGetPadding(root, CSSTop));
+  ASSERT_FLOAT_EQ(10, HPNodeLayoutGetMargin(child, CSSLeft));
+  ASSERT_FLOAT_EQ(2, HPNodeLayoutGetBorder(child, CSSBottom));
+  ASSERT_FLOAT_EQ(10, HPNodeLayoutGetLeft(child));
+  ASSERT_FLOAT_EQ(5, HPNodeLayoutGetTop(child));
+  ASSERT_FLOAT_EQ(90, HPNodeLayoutGetWidth(child));
+
+  // removing the edges clears the results.
+  HPNodeStyleSetMargin(child, CSSLeft, 0);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetMargin(child, CSSLeft));
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetLeft(child));
+
+  HPNodeFreeRecursive(root);
+}
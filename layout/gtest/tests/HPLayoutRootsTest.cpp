@@ -0,0 +1,105 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Hippy.h>
+#include <gtest.h>
+#include "HPTestUtil.h"
+
+#include <stdint.h>
+
+#include <thread>
+
+// column of 50 rows with a fixed box and a text, differs by seed.
+static HPNodeRef _root(uint32_t seed) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetPadding(root, CSSAll, 4);
+  for (uint32_t i = 0; i < 50; i++) {
+    const HPNodeRef row = HPNodeNew();
+    HPNodeStyleSetFlexDirection(row, FLexDirectionRow);
+    const HPNodeRef box = HPNodeNew();
+    HPNodeStyleSetWidth(box, 10.0f + seed);
+    HPNodeStyleSetHeight(box, 10.0f + seed);
+    HPNodeInsertChild(row, box, 0);
+    const HPNodeRef text = newText(3 + i * 37 % (20 + seed));
+    HPNodeStyleSetFlexShrink(text, 1);
+    HPNodeInsertChild(row, text, 1);
+    HPNodeInsertChild(root, row, i);
+  }
+  return root;
+}
+
+TEST(HippyTest, layout_roots_concurrently) {
+  const uint32_t rootCount = 8;
+  HPLayoutThreadPoolRef pool = HPLayoutThreadPoolNew(4);
+  HPNodeRef expected[rootCount];
+  HPLayoutRoot roots[rootCount];
+  HPLayoutStats stats[rootCount];
+  for (uint32_t i = 0; i < rootCount; i++) {
+    expected[i] = _root(i + 1);
+    HPNodeDoLayout(expected[i], 200 + i * 10, VALUE_UNDEFINED);
+    HPLayoutRoot root = {_root(i + 1), 200.0f + i * 10, VALUE_UNDEFINED,
+                         DirectionLTR, nullptr, &stats[i]};
+    roots[i] = root;
+  }
+
+  HPNodeDoLayoutRoots(roots, rootCount, pool);
+  for (uint32_t i = 0; i < rootCount; i++) {
+    expectSameLayout(expected[i], roots[i].node);
+    // root, 50 rows of box and text.
+    ASSERT_EQ(151u, stats[i].newLayoutCount);
+  }
+
+  // relayout after changes in some roots.
+  HPNodeStyleSetWidth(roots[2].node->getChild(5)->getChild(0), 40);
+  HPNodeStyleSetWidth(expected[2]->getChild(5)->getChild(0), 40);
+  roots[6].parentWidth = 320;
+  HPNodeDoLayout(expected[2], roots[2].parentWidth, VALUE_UNDEFINED);
+  HPNodeDoLayout(expected[6], 320, VALUE_UNDEFINED);
+  HPNodeDoLayoutRoots(roots, rootCount, pool);
+  for (uint32_t i = 0; i < rootCount; i++) {
+    expectSameLayout(expected[i], roots[i].node);
+  }
+  // unchanged subtrees of roots are answered by their caches.
+  ASSERT_LE(stats[0].newLayoutCount, 1u);
+
+  for (uint32_t i = 0; i < rootCount; i++) {
+    HPNodeFreeRecursive(expected[i]);
+    HPNodeFreeRecursive(roots[i].node);
+  }
+  HPLayoutThreadPoolFree(pool);
+}
+
+// layouts on other threads add to the global cache counts.
+TEST(HippyTest, layout_cache_global_stats_from_other_threads) {
+  HPNodeRef root = _root(3);
+  HPNodeDoLayout(root, 200, VALUE_UNDEFINED);
+  HPLayoutCacheResetStats();
+  std::thread thread([root]() {
+    HPLayoutStats layoutStats;
+    HPNodeMarkDirty(root->getChild(0)->getChild(1));
+    HPNodeDoLayout(root, 200, VALUE_UNDEFINED, DirectionLTR, nullptr, &layoutStats);
+  });
+  thread.join();
+  HPLayoutCacheStats stats = HPLayoutCacheGetStats();
+  ASSERT_GT(stats.layoutHitCount + stats.measureHitCount, 0u);
+  ASSERT_GT(stats.layoutMissCount, 0u);
+
+  HPLayoutCacheResetStats();
+  stats = HPLayoutCacheGetStats();
+  ASSERT_EQ(0u, stats.layoutHitCount);
+  ASSERT_EQ(0u, stats.layoutMissCount);
+  HPNodeFreeRecursive(root);
+}
@@ -0,0 +1,52 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Hippy.h>
+#include <gtest.h>
+
+TEST(HippyTest, scratch_flex_lines_reused_in_relayout) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetFlexDirection(root, FLexDirectionRow);
+  HPNodeStyleSetFlexWrap(root, FlexWrap);
+  HPNodeStyleSetWidth(root, 100);
+
+  for (uint32_t i = 0; i < 6; i++) {
+    const HPNodeRef child = HPNodeNew();
+    HPNodeStyleSetWidth(child, 40);
+    HPNodeInsertChild(root, child, i);
+    const HPNodeRef grandChild = HPNodeNew();
+    HPNodeStyleSetHeight(grandChild, 10);
+    HPNodeInsertChild(child, grandChild, 0);
+  }
+
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_FLOAT_EQ(30, HPNodeLayoutGetHeight(root));
+  ASSERT_FLOAT_EQ(20, HPNodeLayoutGetTop(root->getChild(5)));
+
+  HPLayoutScratch* scratch = HPLayoutScratch::current();
+  uint32_t freeLineCount = scratch->freeFlexLineCount();
+  ASSERT_GE(freeLineCount, 3u);
+
+  for (uint32_t i = 0; i < 3; i++) {
+    HPNodeStyleSetWidth(root, 100 + i);
+    HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+    ASSERT_EQ(freeLineCount, scratch->freeFlexLineCount());
+  }
+  ASSERT_FLOAT_EQ(30, HPNodeLayoutGetHeight(root));
+  ASSERT_FLOAT_EQ(40, HPNodeLayoutGetLeft(root->getChild(5)));
+
+  HPNodeFreeRecursive(root);
+}
@@ -0,0 +1,244 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Hippy.h>
+#include <gtest.h>
+
+#include <stdint.h>
+
+#include <atomic>
+#include <thread>
+
+static HPMutation _create(uint32_t node) {
+  HPMutation mutation = {HPMutationCreateNode, 0, 0, 0, node, 0, {0}};
+  return mutation;
+}
+
+static HPMutation _insert(uint32_t parent, uint32_t child, uint32_t index) {
+  HPMutation mutation = {HPMutationInsertChild, 0, 0, 0, parent, child, {0}};
+  mutation.index = index;
+  return mutation;
+}
+
+static HPMutation _remove(uint32_t parent, uint32_t child) {
+  HPMutation mutation = {HPMutationRemoveChild, 0, 0, 0, parent, child, {0}};
+  return mutation;
+}
+
+static HPMutation _style(uint32_t node, HPStyleProperty property, float value) {
+  HPMutation mutation = {HPMutationSetStyle, static_cast<uint8_t>(property), 0, 0, node, 0,
+                         {value}};
+  return mutation;
+}
+
+static HPLayoutTransaction _transaction(float width, float height) {
+  HPLayoutTransaction transaction;
+  transaction.width = width;
+  transaction.height = height;
+  transaction.direction = DirectionLTR;
+  return transaction;
+}
+
+// 10 px height per char of context.
+static HPSize _measureTextHeight(HPNodeRef node,
+                           float width,
+                           MeasureMode widthMeasureMode,
+                           float height,
+                           MeasureMode heightMeasureMode,
+                           void* layoutContext) {
+  uint32_t length = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(node->getContext()));
+  HPSize size = {width, length * 10.0f};
+  return size;
+}
+
+TEST(HippyTest, layout_service_publishes_frames) {
+  HPLayoutServiceRef service = HPLayoutServiceNew();
+  HPLayoutFramePtr empty = HPLayoutServiceGetFrame(service);
+  ASSERT_EQ(0u, empty->version);
+
+  // root row with two flexed children.
+  HPLayoutTransaction transaction = _transaction(300, 100);
+  transaction.mutations.push_back(_style(0, HPStylePropertyFlexDirection, FLexDirectionRow));
+  transaction.mutations.push_back(_create(1));
+  transaction.mutations.push_back(_style(1, HPStylePropertyFlexGrow, 1));
+  transaction.mutations.push_back(_create(2));
+  transaction.mutations.push_back(_style(2, HPStylePropertyFlexGrow, 2));
+  transaction.mutations.push_back(_insert(0, 1, 0));
+  transaction.mutations.push_back(_insert(0, 2, 1));
+  uint64_t version = HPLayoutServiceSubmit(service, transaction);
+  HPLayoutFramePtr first = HPLayoutServiceWaitForFrame(service, version);
+  ASSERT_EQ(version, first->version);
+  ASSERT_EQ(3u, first->records.size());
+  ASSERT_FLOAT_EQ(300, first->records[0].width);
+  ASSERT_FLOAT_EQ(100, first->records[1].width);
+  ASSERT_FLOAT_EQ(100, first->records[1].height);
+  ASSERT_FLOAT_EQ(100, first->records[2].left);
+  ASSERT_FLOAT_EQ(200, first->records[2].width);
+
+  // a held frame is not changed by later layouts.
+  HPLayoutTransaction resize = _transaction(600, 100);
+  version = HPLayoutServiceSubmit(service, resize);
+  HPLayoutFramePtr second = HPLayoutServiceWaitForFrame(service, version);
+  ASSERT_EQ(version, second->version);
+  ASSERT_FLOAT_EQ(400, second->records[2].width);
+  ASSERT_FLOAT_EQ(200, first->records[2].width);
+  ASSERT_TRUE(HPLayoutServiceGetFrame(service) == second);
+
+  // a frame is refilled once its last reader drops it, not while held.
+  const HPLayoutFrame* released = first.get();
+  first.reset();
+  version = HPLayoutServiceSubmit(service, _transaction(500, 100));
+  HPLayoutFramePtr third = HPLayoutServiceWaitForFrame(service, version);
+  ASSERT_TRUE(third.get() == released);
+  ASSERT_FLOAT_EQ(500, third->records[0].width);
+  ASSERT_FLOAT_EQ(600, second->records[0].width);
+
+  HPLayoutServiceFree(service);
+  // held frames outlive the service.
+  ASSERT_FLOAT_EQ(500, third->records[0].width);
+}
+
+TEST(HippyTest, layout_service_measures_and_frees_nodes) {
+  HPLayoutServiceRef service = HPLayoutServiceNew();
+  HPLayoutTransaction transaction = _transaction(200, VALUE_UNDEFINED);
+  transaction.mutations.push_back(_create(1));
+  transaction.mutations.push_back(_create(2));
+  transaction.mutations.push_back(_insert(0, 1, 0));
+  transaction.mutations.push_back(_insert(0, 2, 1));
+  HPLayoutMeasureBinding text = {1, _measureTextHeight, reinterpret_cast<void*>(3)};
+  transaction.measures.push_back(text);
+  HPLayoutServiceSubmit(service, transaction);
+
+  // new content of text, node 2 removed and freed.
+  HPLayoutTransaction update = _transaction(200, VALUE_UNDEFINED);
+  update.mutations.push_back(_remove(0, 2));
+  text.context = reinterpret_cast<void*>(5);
+  update.measures.push_back(text);
+  update.freeNodes.push_back(2);
+  uint64_t version = HPLayoutServiceSubmit(service, update);
+  HPLayoutFramePtr frame = HPLayoutServiceWaitForFrame(service, version);
+  ASSERT_FLOAT_EQ(50, frame->records[1].height);
+  ASSERT_FLOAT_EQ(50, frame->records[0].height);
+  ASSERT_TRUE(isUndefined(frame->records[2].width));
+
+  // freed id is created again.
+  HPLayoutTransaction reuse = _transaction(200, VALUE_UNDEFINED);
+  reuse.mutations.push_back(_create(2));
+  reuse.mutations.push_back(_style(2, HPStylePropertyHeight, 30));
+  reuse.mutations.push_back(_insert(0, 2, 1));
+  version = HPLayoutServiceSubmit(service, reuse);
+  frame = HPLayoutServiceWaitForFrame(service, version);
+  ASSERT_FLOAT_EQ(50, frame->records[2].top);
+  ASSERT_FLOAT_EQ(80, frame->records[0].height);
+
+  HPLayoutServiceFree(service);
+}
+
+TEST(HippyTest, layout_service_drops_invalid_transactions) {
+  HPLayoutServiceRef service = HPLayoutServiceNew();
+  HPLayoutTransaction transaction = _transaction(200, 100);
+  transaction.mutations.push_back(_create(1));
+  transaction.mutations.push_back(_style(1, HPStylePropertyHeight, 40));
+  transaction.mutations.push_back(_insert(0, 1, 0));
+  uint64_t version = HPLayoutServiceSubmit(service, transaction);
+  HPLayoutFramePtr frame = HPLayoutServiceWaitForFrame(service, version);
+  ASSERT_EQ(2u, frame->records.size());
+
+  // ids past the table and the created nodes, 0xFFFFFFFF wraps a size.
+  HPLayoutTransaction wrap = _transaction(200, 100);
+  wrap.mutations.push_back(_style(0xFFFFFFFF, HPStylePropertyHeight, 10));
+  HPLayoutTransaction huge = _transaction(200, 100);
+  huge.mutations.push_back(_create(0x80000000));
+  HPLayoutServiceSubmit(service, wrap);
+  version = HPLayoutServiceSubmit(service, huge);
+  frame = HPLayoutServiceWaitForFrame(service, version);
+  ASSERT_EQ(2u, frame->records.size());
+  ASSERT_FLOAT_EQ(40, frame->records[1].height);
+
+  // fails at the last mutation, everything before it is undone.
+  HPLayoutTransaction partial = _transaction(300, 100);
+  partial.mutations.push_back(_style(1, HPStylePropertyHeight, 60));
+  partial.mutations.push_back(_remove(0, 1));
+  partial.mutations.push_back(_create(2));
+  partial.mutations.push_back(_insert(0, 2, 0));
+  partial.mutations.push_back(_insert(2, 1, 0));
+  partial.mutations.push_back(_insert(0, 0, 0));
+  version = HPLayoutServiceSubmit(service, partial);
+  frame = HPLayoutServiceWaitForFrame(service, version);
+  ASSERT_EQ(2u, frame->records.size());
+  ASSERT_FLOAT_EQ(200, frame->records[0].width);
+  ASSERT_FLOAT_EQ(0, frame->records[1].top);
+  ASSERT_FLOAT_EQ(40, frame->records[1].height);
+
+  // id 2 is free to be created by a valid transaction.
+  HPLayoutTransaction valid = _transaction(200, 100);
+  valid.mutations.push_back(_create(2));
+  valid.mutations.push_back(_style(2, HPStylePropertyHeight, 20));
+  valid.mutations.push_back(_insert(0, 2, 1));
+  version = HPLayoutServiceSubmit(service, valid);
+  frame = HPLayoutServiceWaitForFrame(service, version);
+  ASSERT_EQ(3u, frame->records.size());
+  ASSERT_FLOAT_EQ(40, frame->records[2].top);
+
+  HPLayoutServiceFree(service);
+}
+
+// readers never see a frame mixing two layouts.
+TEST(HippyTest, layout_service_frames_are_consistent) {
+  HPLayoutServiceRef service = HPLayoutServiceNew();
+  HPLayoutTransaction transaction = _transaction(400, 100);
+  transaction.mutations.push_back(_style(0, HPStylePropertyFlexDirection, FLexDirectionRow));
+  for (uint32_t i = 1; i <= 4; i++) {
+    transaction.mutations.push_back(_create(i));
+    transaction.mutations.push_back(_style(i, HPStylePropertyFlexGrow, 1));
+    transaction.mutations.push_back(_insert(0, i, i - 1));
+  }
+  HPLayoutServiceSubmit(service, transaction);
+
+  std::atomic<bool> done(false);
+  std::atomic<uint32_t> inconsistent(0);
+  std::thread reader([service, &done, &inconsistent]() {
+    uint64_t lastVersion = 0;
+    while (!done) {
+      HPLayoutFramePtr frame = HPLayoutServiceGetFrame(service);
+      if (frame->version < lastVersion) {
+        inconsistent++;
+      }
+      lastVersion = frame->version;
+      if (frame->records.size() == 5) {
+        float sum = 0;
+        for (uint32_t i = 1; i <= 4; i++) {
+          sum += frame->records[i].width;
+        }
+        if (sum != frame->records[0].width) {
+          inconsistent++;
+        }
+      }
+    }
+  });
+  uint64_t version = 0;
+  for (uint32_t i = 0; i < 200; i++) {
+    version = HPLayoutServiceSubmit(service, _transaction(400 + (i % 50) * 4, 100));
+  }
+  HPLayoutFramePtr frame = HPLayoutServiceWaitForFrame(service, version);
+  done = true;
+  reader.join();
+  ASSERT_EQ(0u, inconsistent.load());
+  ASSERT_EQ(version, frame->version);
+  ASSERT_FLOAT_EQ(400 + 49 * 4, frame->records[0].width);
+
+  HPLayoutServiceFree(service);
+}
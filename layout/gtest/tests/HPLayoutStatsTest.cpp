@@ -0,0 +1,110 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <Hippy.h>
+#include <gtest.h>
+#include "HPTestUtil.h"
+
+// column of count rows of a box and a text, or a box of fixed height
+// instead of the text if not measured.
+static HPNodeRef _rows(uint32_t count, bool measured) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 300);
+  HPNodeStyleSetHeight(root, 600);
+  for (uint32_t i = 0; i < count; i++) {
+    const HPNodeRef row = HPNodeNew();
+    HPNodeStyleSetFlexDirection(row, FLexDirectionRow);
+    const HPNodeRef box = HPNodeNew();
+    HPNodeStyleSetWidth(box, 20);
+    HPNodeStyleSetHeight(box, 20);
+    HPNodeInsertChild(row, box, 0);
+    HPNodeRef text;
+    if (measured) {
+      text = newText(10);
+    } else {
+      text = HPNodeNew();
+      HPNodeStyleSetHeight(text, 20);
+    }
+    HPNodeStyleSetFlexShrink(text, 1);
+    HPNodeInsertChild(row, text, 1);
+    HPNodeInsertChild(root, row, i);
+  }
+  return root;
+}
+
+TEST(HippyTest, layout_stats_counts) {
+  const HPNodeRef root = _rows(4, true);
+  HPLayoutStats stats;
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &stats);
+
+  // root, 4 rows, 8 leaves have new layout.
+  ASSERT_EQ(13u, stats.newLayoutCount);
+  ASSERT_EQ(4u, stats.measureFuncCount);
+  ASSERT_GE(stats.visitCount, 13u);
+  ASSERT_EQ(stats.visitCount, stats.layoutCount + stats.measureWidthCount +
+                                  stats.measureHeightCount);
+  ASSERT_GT(stats.totalTime, 0.0);
+  double phaseTime = 0;
+  for (int i = 0; i < LayoutPhaseCount; i++) {
+    ASSERT_GE(stats.phaseTime[i], 0.0);
+    phaseTime += stats.phaseTime[i];
+  }
+  ASSERT_LE(phaseTime, stats.totalTime * 1.01 + 0.01);
+
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, layout_stats_cached_relayout) {
+  const HPNodeRef root = _rows(4, true);
+  HPLayoutStats stats;
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &stats);
+
+  // unchanged rows are answered by their layout cache.
+  HPNodeStyleSetHeight(root->getChild(2)->getChild(0), 30);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &stats);
+  ASSERT_EQ(0u, stats.measureFuncCount);
+  ASSERT_GE(stats.layoutCacheHitCount, 3u);
+  ASSERT_LT(stats.newLayoutCount, 13u);
+
+  // stats are reset by each layout.
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &stats);
+  ASSERT_EQ(0u, stats.newLayoutCount);
+  ASSERT_EQ(0u, stats.measureFuncCount);
+
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, layout_stats_parallel_layout) {
+  // no measure in rows of parallel tree, so that they go to pool threads.
+  const HPNodeRef serialRoot = _rows(12, false);
+  const HPNodeRef parallelRoot = _rows(12, false);
+  HPLayoutThreadPoolRef pool = HPLayoutThreadPoolNew(2, 2);
+
+  HPLayoutStats serialStats;
+  HPLayoutStats parallelStats;
+  HPNodeDoLayout(serialRoot, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr,
+                 &serialStats);
+  HPNodeDoParallelLayout(parallelRoot, VALUE_UNDEFINED, VALUE_UNDEFINED, pool, DirectionLTR,
+                         nullptr, &parallelStats);
+  ASSERT_EQ(serialStats.newLayoutCount, parallelStats.newLayoutCount);
+  ASSERT_EQ(serialStats.visitCount, parallelStats.visitCount);
+  ASSERT_EQ(serialStats.layoutCount, parallelStats.layoutCount);
+
+  HPLayoutThreadPoolFree(pool);
+  HPNodeFreeRecursive(serialRoot);
+  HPNodeFreeRecursive(parallelRoot);
+}
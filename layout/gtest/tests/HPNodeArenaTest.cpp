@@ -0,0 +1,151 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Hippy.h>
+#include <gtest.h>
+
+static HPNodeRef buildRowTree(HPNodeArenaRef arena) {
+  const HPNodeRef root = HPNodeNewInArena(arena);
+  HPNodeStyleSetWidth(root, 100);
+  HPNodeStyleSetHeight(root, 100);
+
+  for (uint32_t i = 0; i < 4; i++) {
+    const HPNodeRef child = HPNodeNewInArena(arena);
+    HPNodeStyleSetFlexDirection(child, FLexDirectionRow);
+    HPNodeStyleSetFlexGrow(child, 1);
+    // insert at front, so allocation order differs from tree order
+    HPNodeInsertChild(root, child, 0);
+
+    for (uint32_t j = 0; j < 5; j++) {
+      const HPNodeRef grandChild = HPNodeNewInArena(arena);
+      HPNodeStyleSetFlexGrow(grandChild, 1);
+      HPNodeInsertChild(child, grandChild, 0);
+    }
+  }
+  return root;
+}
+
+static int relocatedCount = 0;
+static void _relocated(HPNodeRef oldNode, HPNodeRef newNode) {
+  relocatedCount++;
+}
+
+TEST(HippyTest, arena_node_layout_same_as_heap_node) {
+  HPNodeArenaRef arena = HPNodeArenaNew(8);
+  const HPNodeRef arenaRoot = buildRowTree(arena);
+  const HPNodeRef heapRoot = buildRowTree(nullptr);
+  ASSERT_EQ(25u, arena->liveNodeCount());
+  ASSERT_EQ(4u, arena->slabCount());
+
+  HPNodeDoLayout(arenaRoot, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  HPNodeDoLayout(heapRoot, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  for (uint32_t i = 0; i < 4; i++) {
+    HPNodeRef arenaChild = arenaRoot->getChild(i);
+    HPNodeRef heapChild = heapRoot->getChild(i);
+    ASSERT_FLOAT_EQ(HPNodeLayoutGetTop(heapChild), HPNodeLayoutGetTop(arenaChild));
+    ASSERT_FLOAT_EQ(HPNodeLayoutGetHeight(heapChild), HPNodeLayoutGetHeight(arenaChild));
+    for (uint32_t j = 0; j < 5; j++) {
+      ASSERT_FLOAT_EQ(HPNodeLayoutGetLeft(heapChild->getChild(j)),
+                      HPNodeLayoutGetLeft(arenaChild->getChild(j)));
+      ASSERT_FLOAT_EQ(HPNodeLayoutGetWidth(heapChild->getChild(j)),
+                      HPNodeLayoutGetWidth(arenaChild->getChild(j)));
+    }
+  }
+
+  HPNodeFreeRecursive(arenaRoot);
+  HPNodeFreeRecursive(heapRoot);
+  ASSERT_EQ(0u, arena->liveNodeCount());
+  HPNodeArenaFree(arena);
+}
+
+TEST(HippyTest, arena_reuse_freed_nodes) {
+  HPNodeArenaRef arena = HPNodeArenaNew(8);
+  const HPNodeRef root = HPNodeNewInArena(arena);
+  const HPNodeRef child0 = HPNodeNewInArena(arena);
+  const HPNodeRef child1 = HPNodeNewInArena(arena);
+  HPNodeInsertChild(root, child0, 0);
+  HPNodeInsertChild(root, child1, 1);
+
+  HPNodeFree(child0);
+  ASSERT_EQ(1u, root->childCount());
+  ASSERT_EQ(child1, root->getChild(0));
+  ASSERT_EQ(2u, arena->liveNodeCount());
+
+  const HPNodeRef child2 = HPNodeNewInArena(arena);
+  ASSERT_EQ(child0, child2);
+
+  HPNodeFree(child2);
+  HPNodeFreeRecursive(root);
+  ASSERT_EQ(0u, arena->liveNodeCount());
+  ASSERT_EQ(1u, arena->slabCount());
+
+  // slabs are recycled after all nodes freed.
+  ASSERT_EQ(root, HPNodeNewInArena(arena));
+  HPNodeFree(root);
+  HPNodeArenaFree(arena);
+}
+
+TEST(HippyTest, arena_compact_in_depth_first_order) {
+  HPNodeArenaRef arena = HPNodeArenaNew(8);
+  HPNodeRef root = buildRowTree(arena);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  float childTop = HPNodeLayoutGetTop(root->getChild(2));
+  float grandChildLeft = HPNodeLayoutGetLeft(root->getChild(2)->getChild(3));
+
+  relocatedCount = 0;
+  root = HPNodeArenaCompact(root, _relocated);
+  ASSERT_EQ(25, relocatedCount);
+  ASSERT_EQ(1u, arena->slabCount());
+  ASSERT_EQ(25u, arena->liveNodeCount());
+
+  // pre-order: root, child0, child0's children, child1 ...
+  HPNodeRef expected = root + 1;
+  for (uint32_t i = 0; i < root->childCount(); i++) {
+    HPNodeRef child = root->getChild(i);
+    ASSERT_EQ(expected, child);
+    ASSERT_EQ(root, child->getParent());
+    expected++;
+    for (uint32_t j = 0; j < child->childCount(); j++) {
+      ASSERT_EQ(expected, child->getChild(j));
+      ASSERT_EQ(child, child->getChild(j)->getParent());
+      expected++;
+    }
+  }
+
+  ASSERT_FLOAT_EQ(childTop, HPNodeLayoutGetTop(root->getChild(2)));
+  ASSERT_FLOAT_EQ(grandChildLeft, HPNodeLayoutGetLeft(root->getChild(2)->getChild(3)));
+
+  HPNodeStyleSetWidth(root, 200);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_FLOAT_EQ(40, HPNodeLayoutGetWidth(root->getChild(2)->getChild(3)));
+
+  HPNodeFreeRecursive(root);
+  HPNodeArenaFree(arena);
+}
+
+TEST(HippyTest, arena_not_compact_with_detached_nodes) {
+  HPNodeArenaRef arena = HPNodeArenaNew(8);
+  const HPNodeRef root = buildRowTree(arena);
+  const HPNodeRef detached = HPNodeNewInArena(arena);
+
+  ASSERT_EQ(root, HPNodeArenaCompact(root));
+  ASSERT_EQ(root, HPNodeArenaCompact(root->getChild(0)->getParent()));
+
+  HPNodeFree(detached);
+  HPNodeFreeRecursive(root);
+  HPNodeArenaFree(arena);
+}
@@ -0,0 +1,228 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <Hippy.h>
+#include <gtest.h>
+
+static HPMutation _create(uint32_t node) {
+  HPMutation mutation = {HPMutationCreateNode, 0, 0, 0, node, 0, {0}};
+  return mutation;
+}
+
+static HPMutation _insert(uint32_t parent, uint32_t child, uint32_t index) {
+  HPMutation mutation = {HPMutationInsertChild, 0, 0, 0, parent, child, {0}};
+  mutation.index = index;
+  return mutation;
+}
+
+static HPMutation _style(uint32_t node,
+                         HPStyleProperty property,
+                         float value,
+                         CSSDirection edge = CSSNONE) {
+  HPMutation mutation = {HPMutationSetStyle, static_cast<uint8_t>(property),
+                         static_cast<uint8_t>(edge == CSSNONE ? 0 : edge), 0, node, 0, {value}};
+  return mutation;
+}
+
+TEST(HippyTest, mutation_builds_same_tree_as_node_api) {
+  // root row with two flexed children, second one has margin and padding.
+  HPNodeRef nodes[3] = {nullptr, nullptr, nullptr};
+  std::vector<HPMutation> mutations;
+  mutations.push_back(_create(0));
+  mutations.push_back(_style(0, HPStylePropertyFlexDirection, FLexDirectionRow));
+  mutations.push_back(_style(0, HPStylePropertyWidth, 300));
+  mutations.push_back(_style(0, HPStylePropertyHeight, 100));
+  mutations.push_back(_style(0, HPStylePropertyAlignItems, FlexAlignCenter));
+  mutations.push_back(_create(1));
+  mutations.push_back(_style(1, HPStylePropertyFlex, 1));
+  mutations.push_back(_style(1, HPStylePropertyHeight, 20));
+  mutations.push_back(_create(2));
+  mutations.push_back(_style(2, HPStylePropertyFlexGrow, 2));
+  mutations.push_back(_style(2, HPStylePropertyHeight, 40));
+  mutations.push_back(_style(2, HPStylePropertyMargin, 10, CSSLeft));
+  mutations.push_back(_style(2, HPStylePropertyPadding, 5, CSSAll));
+  mutations.push_back(_insert(0, 1, 0));
+  mutations.push_back(_insert(0, 2, 1));
+  ASSERT_EQ(mutations.size(),
+            HPNodeApplyMutations(nodes, 3, mutations.data(), mutations.size()));
+  HPNodeDoLayout(nodes[0], VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetFlexDirection(root, FLexDirectionRow);
+  HPNodeStyleSetWidth(root, 300);
+  HPNodeStyleSetHeight(root, 100);
+  HPNodeStyleSetAlignItems(root, FlexAlignCenter);
+  const HPNodeRef first = HPNodeNew();
+  HPNodeStyleSetFlex(first, 1);
+  HPNodeStyleSetHeight(first, 20);
+  HPNodeInsertChild(root, first, 0);
+  const HPNodeRef second = HPNodeNew();
+  HPNodeStyleSetFlexGrow(second, 2);
+  HPNodeStyleSetHeight(second, 40);
+  HPNodeStyleSetMargin(second, CSSLeft, 10);
+  HPNodeStyleSetPadding(second, CSSAll, 5);
+  HPNodeInsertChild(root, second, 1);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  ASSERT_EQ(2u, nodes[0]->childCount());
+  ASSERT_TRUE(nodes[1]->style.get().isEqual(first->style.get()));
+  ASSERT_TRUE(nodes[2]->style.get().isEqual(second->style.get()));
+  const HPNodeRef expected[3] = {root, first, second};
+  for (int i = 0; i < 3; i++) {
+    ASSERT_FLOAT_EQ(HPNodeLayoutGetLeft(expected[i]), HPNodeLayoutGetLeft(nodes[i]));
+    ASSERT_FLOAT_EQ(HPNodeLayoutGetTop(expected[i]), HPNodeLayoutGetTop(nodes[i]));
+    ASSERT_FLOAT_EQ(HPNodeLayoutGetWidth(expected[i]), HPNodeLayoutGetWidth(nodes[i]));
+    ASSERT_FLOAT_EQ(HPNodeLayoutGetHeight(expected[i]), HPNodeLayoutGetHeight(nodes[i]));
+  }
+
+  HPNodeFreeRecursive(nodes[0]);
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, mutation_dirties_only_changed_nodes) {
+  HPNodeRef nodes[3] = {HPNodeNew(), HPNodeNew(), HPNodeNew()};
+  HPNodeStyleSetWidth(nodes[0], 200);
+  HPNodeStyleSetHeight(nodes[1], 30);
+  HPNodeStyleSetHeight(nodes[2], 30);
+  HPNodeInsertChild(nodes[0], nodes[1], 0);
+  HPNodeInsertChild(nodes[0], nodes[2], 1);
+  HPNodeDoLayout(nodes[0], VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  // same values do not dirty.
+  HPMutation same[2] = {_style(1, HPStylePropertyHeight, 30),
+                        _style(1, HPStylePropertyFlexGrow, 0)};
+  ASSERT_EQ(2u, HPNodeApplyMutations(nodes, 3, same, 2));
+  ASSERT_FALSE(HPNodeIsDirty(nodes[0]));
+
+  // several properties of a node are one style change.
+  uint32_t internedCount = HPStyleRef::internedCount();
+  HPMutation changed[3] = {_style(2, HPStylePropertyHeight, 50),
+                           _style(2, HPStylePropertyMargin, 4, CSSTop),
+                           _style(2, HPStylePropertyAlignSelf, FlexAlignEnd)};
+  ASSERT_EQ(3u, HPNodeApplyMutations(nodes, 3, changed, 3));
+  ASSERT_EQ(internedCount + 1, HPStyleRef::internedCount());
+  ASSERT_FALSE(HPNodeIsDirty(nodes[1]));
+  ASSERT_TRUE(HPNodeIsDirty(nodes[2]));
+  ASSERT_TRUE(HPNodeIsDirty(nodes[0]));
+
+  HPNodeDoLayout(nodes[0], VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_FLOAT_EQ(34, HPNodeLayoutGetTop(nodes[2]));
+  ASSERT_FLOAT_EQ(50, HPNodeLayoutGetHeight(nodes[2]));
+  ASSERT_FLOAT_EQ(84, HPNodeLayoutGetHeight(nodes[0]));
+
+  HPNodeFreeRecursive(nodes[0]);
+}
+
+TEST(HippyTest, mutation_keeps_explicit_edge_with_unchanged_value) {
+  HPNodeRef nodes[2] = {HPNodeNew(), HPNodeNew()};
+  HPNodeStyleSetWidth(nodes[0], 100);
+  HPNodeStyleSetWidth(nodes[1], 100);
+
+  // in one batch.
+  HPMutation batch[2] = {_style(0, HPStylePropertyPadding, 0, CSSBottom),
+                         _style(0, HPStylePropertyPadding, 4, CSSAll)};
+  ASSERT_EQ(2u, HPNodeApplyMutations(nodes, 2, batch, 2));
+
+  // across batches, the first one leaves the value unchanged.
+  HPMutation explicitEdges[3] = {_style(1, HPStylePropertyPadding, 0, CSSBottom),
+                                 _style(1, HPStylePropertyMargin, 0, CSSTop),
+                                 _style(1, HPStylePropertyBorder, 0, CSSLeft)};
+  ASSERT_EQ(3u, HPNodeApplyMutations(nodes, 2, explicitEdges, 3));
+  HPMutation shorthands[3] = {_style(1, HPStylePropertyPadding, 4, CSSAll),
+                              _style(1, HPStylePropertyMargin, 3, CSSVertical),
+                              _style(1, HPStylePropertyBorder, 2, CSSHorizontal)};
+  ASSERT_EQ(3u, HPNodeApplyMutations(nodes, 2, shorthands, 3));
+
+  HPNodeDoLayout(nodes[0], VALUE_UNDEFINED, VALUE_UNDEFINED);
+  HPNodeDoLayout(nodes[1], VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetPadding(nodes[0], CSSBottom));
+  ASSERT_FLOAT_EQ(4, HPNodeLayoutGetHeight(nodes[0]));
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetPadding(nodes[1], CSSBottom));
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetMargin(nodes[1], CSSTop));
+  ASSERT_FLOAT_EQ(3, HPNodeLayoutGetMargin(nodes[1], CSSBottom));
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetBorder(nodes[1], CSSLeft));
+  ASSERT_FLOAT_EQ(2, HPNodeLayoutGetBorder(nodes[1], CSSRight));
+  ASSERT_FLOAT_EQ(4, HPNodeLayoutGetHeight(nodes[1]));
+
+  HPNodeFree(nodes[0]);
+  HPNodeFree(nodes[1]);
+}
+
+TEST(HippyTest, mutation_stops_at_invalid_mutation) {
+  HPNodeRef nodes[2] = {nullptr, nullptr};
+  HPMutation mutations[4] = {_create(0), _style(0, HPStylePropertyWidth, 10),
+                             _insert(0, 1, 0), _create(1)};
+  // child is not created yet.
+  ASSERT_EQ(2u, HPNodeApplyMutations(nodes, 2, mutations, 4));
+  ASSERT_FLOAT_EQ(10, nodes[0]->styleDim[DimWidth]);
+  ASSERT_TRUE(nodes[1] == nullptr);
+
+  HPMutation outOfTable = _style(2, HPStylePropertyWidth, 10);
+  ASSERT_EQ(0u, HPNodeApplyMutations(nodes, 2, &outOfTable, 1));
+  HPMutation badIndex[2] = {_create(1), _insert(0, 1, 3)};
+  ASSERT_EQ(1u, HPNodeApplyMutations(nodes, 2, badIndex, 2));
+  ASSERT_EQ(0u, nodes[0]->childCount());
+
+  HPNodeFree(nodes[1]);
+  HPNodeFreeRecursive(nodes[0]);
+}
+
+TEST(HippyTest, mutation_rejects_out_of_range_enum_values) {
+  HPNodeRef nodes[1] = {nullptr};
+  HPMutation create = _create(0);
+  ASSERT_EQ(1u, HPNodeApplyMutations(nodes, 1, &create, 1));
+
+  HPMutation invalid[5] = {_style(0, HPStylePropertyFlexDirection, 7),
+                           _style(0, HPStylePropertyFlexDirection, -1),
+                           _style(0, HPStylePropertyFlexDirection, NAN),
+                           _style(0, HPStylePropertyAlignItems, FlexAlignSpaceEvenly + 1),
+                           _style(0, HPStylePropertyAlignSelf, -0.5f)};
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(0u, HPNodeApplyMutations(nodes, 1, &invalid[i], 1));
+  }
+  ASSERT_EQ(FLexDirectionColumn, nodes[0]->getStyle().flexDirection);
+  ASSERT_EQ(FlexAlignStretch, nodes[0]->getStyle().alignItems);
+  ASSERT_EQ(FlexAlignAuto, nodes[0]->getStyle().alignSelf);
+
+  HPMutation valid[2] = {_style(0, HPStylePropertyFlexDirection, FLexDirectionColumnReverse),
+                         _style(0, HPStylePropertyAlignItems, FlexAlignSpaceEvenly)};
+  ASSERT_EQ(2u, HPNodeApplyMutations(nodes, 1, valid, 2));
+  ASSERT_EQ(FLexDirectionColumnReverse, nodes[0]->getStyle().flexDirection);
+  ASSERT_EQ(FlexAlignSpaceEvenly, nodes[0]->getStyle().alignItems);
+
+  HPNodeFree(nodes[0]);
+}
+
+TEST(HippyTest, mutation_rejects_insert_making_cycle) {
+  HPNodeRef nodes[3] = {nullptr, nullptr, nullptr};
+  HPMutation build[5] = {_create(0), _create(1), _create(2), _insert(0, 1, 0), _insert(1, 2, 0)};
+  ASSERT_EQ(5u, HPNodeApplyMutations(nodes, 3, build, 5));
+
+  // node under itself.
+  HPMutation self = _insert(2, 2, 0);
+  ASSERT_EQ(0u, HPNodeApplyMutations(nodes, 3, &self, 1));
+  ASSERT_EQ(0u, nodes[2]->childCount());
+
+  // root under its grandchild.
+  HPMutation ancestor = _insert(2, 0, 0);
+  ASSERT_EQ(0u, HPNodeApplyMutations(nodes, 3, &ancestor, 1));
+  ASSERT_EQ(0u, nodes[2]->childCount());
+  ASSERT_TRUE(nodes[0]->getParent() == nullptr);
+
+  HPNodeDoLayout(nodes[0], 100, 100);
+  HPNodeFreeRecursive(nodes[0]);
+}
@@ -0,0 +1,155 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <Hippy.h>
+#include <gtest.h>
+#include "HPTestUtil.h"
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+
+static std::thread::id layoutThreadId;
+static bool measuredOnOtherThread = false;
+
+static HPSize _measureOnAnyThread(HPNodeRef node,
+                           float width,
+                           MeasureMode widthMeasureMode,
+                           float height,
+                           MeasureMode heightMeasureMode,
+                           void* layoutContext) {
+  if (std::this_thread::get_id() != layoutThreadId) {
+    measuredOnOtherThread = true;
+  }
+  HPSize size = {widthMeasureMode == MeasureModeExactly ? width : 35, 17};
+  return size;
+}
+
+// rows of growing boxes, only texts of every 3rd row are measured.
+static HPNodeRef buildGrowingRows() {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 375);
+  HPNodeStyleSetPadding(root, CSSAll, 3);
+  for (uint32_t i = 0; i < 12; i++) {
+    const HPNodeRef row = HPNodeNew();
+    HPNodeStyleSetFlexDirection(row, FLexDirectionRow);
+    HPNodeStyleSetMargin(row, CSSBottom, 1.5f);
+    for (uint32_t j = 0; j < 7; j++) {
+      const HPNodeRef box = HPNodeNew();
+      HPNodeStyleSetWidth(box, 10.3f);
+      HPNodeStyleSetHeight(box, 10.3f);
+      HPNodeStyleSetFlexGrow(box, j + 1);
+      HPNodeStyleSetPadding(box, CSSLeft, 0.3f * j);
+      HPNodeInsertChild(row, box, j);
+    }
+    const HPNodeRef text = HPNodeNew();
+    HPNodeStyleSetFlexShrink(text, 1);
+    if (i % 3 == 0) {
+      HPNodeSetMeasureFunc(text, _measureOnAnyThread);
+    } else {
+      HPNodeStyleSetHeight(text, 17);
+    }
+    HPNodeInsertChild(row, text, 7);
+    HPNodeInsertChild(root, row, i);
+  }
+  return root;
+}
+
+TEST(HippyTest, parallel_layout_same_as_serial_layout) {
+  layoutThreadId = std::this_thread::get_id();
+  measuredOnOtherThread = false;
+  const HPNodeRef serialRoot = buildGrowingRows();
+  const HPNodeRef parallelRoot = buildGrowingRows();
+  // small threshold so that rows are laid out by pool threads
+  HPLayoutThreadPoolRef pool = HPLayoutThreadPoolNew(3, 4);
+
+  HPNodeDoLayout(serialRoot, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  HPNodeDoParallelLayout(parallelRoot, VALUE_UNDEFINED, VALUE_UNDEFINED, pool);
+  expectSameLayout(serialRoot, parallelRoot);
+  ASSERT_FALSE(measuredOnOtherThread);
+
+  // relayout after a change in one row.
+  HPNodeStyleSetFlexGrow(serialRoot->getChild(4)->getChild(2), 5);
+  HPNodeStyleSetFlexGrow(parallelRoot->getChild(4)->getChild(2), 5);
+  HPNodeDoLayout(serialRoot, 320, VALUE_UNDEFINED);
+  HPNodeDoParallelLayout(parallelRoot, 320, VALUE_UNDEFINED, pool);
+  expectSameLayout(serialRoot, parallelRoot);
+  ASSERT_FALSE(measuredOnOtherThread);
+
+  HPLayoutThreadPoolFree(pool);
+  HPNodeFreeRecursive(serialRoot);
+  HPNodeFreeRecursive(parallelRoot);
+}
+
+TEST(HippyTest, parallel_layout_subtree_weight) {
+  const HPNodeRef root = buildGrowingRows();
+  HPLayoutThreadPoolRef pool = HPLayoutThreadPoolNew(2);
+  HPNodeDoParallelLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, pool);
+
+  // rows with a text leaf are kept on the calling thread.
+  ASSERT_EQ(0u, root->subtreeWeight);
+  ASSERT_EQ(0u, root->getChild(0)->subtreeWeight);
+  ASSERT_EQ(9u, root->getChild(1)->subtreeWeight);
+  ASSERT_EQ(1u, root->getChild(1)->getChild(0)->subtreeWeight);
+
+  HPLayoutThreadPoolFree(pool);
+  HPNodeFreeRecursive(root);
+}
+
+static std::atomic<bool> blockerStarted(false);
+static std::atomic<bool> blockerReleased(false);
+
+static void blockWorker(void* data) {
+  blockerStarted = true;
+  while (!blockerReleased) {
+    std::this_thread::yield();
+  }
+}
+
+static void recordThread(void* data) {
+  *static_cast<std::thread::id*>(data) = std::this_thread::get_id();
+}
+
+TEST(HippyTest, parallel_layout_waiter_runs_only_own_batch) {
+  HPLayoutThreadPoolRef pool = HPLayoutThreadPoolNew(1);
+  // the only worker is busy, tasks below stay queued.
+  HPLayoutTask blocker = {blockWorker, nullptr};
+  HPLayoutTaskBatch blockerBatch;
+  pool->submit(&blockerBatch, &blocker, 1);
+  while (!blockerStarted) {
+    std::this_thread::yield();
+  }
+
+  // a waiter doesn't run tasks of other batches, e.g. layout of another root.
+  std::thread::id foreignThread;
+  std::thread::id ownThread;
+  HPLayoutTask foreign = {recordThread, &foreignThread};
+  HPLayoutTask own = {recordThread, &ownThread};
+  HPLayoutTaskBatch foreignBatch;
+  HPLayoutTaskBatch ownBatch;
+  pool->submit(&foreignBatch, &foreign, 1);
+  pool->submit(&ownBatch, &own, 1);
+  pool->wait(&ownBatch);
+  ASSERT_EQ(std::this_thread::get_id(), ownThread);
+  ASSERT_EQ(1u, foreignBatch.remaining.load());
+
+  blockerReleased = true;
+  pool->wait(&blockerBatch);
+  pool->wait(&foreignBatch);
+  ASSERT_EQ(0u, foreignBatch.remaining.load());
+  HPLayoutThreadPoolFree(pool);
+}
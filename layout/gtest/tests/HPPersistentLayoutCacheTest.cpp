@@ -0,0 +1,298 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <Hippy.h>
+#include <gtest.h>
+#include "HPTestUtil.h"
+
+static void setText(HPNodeRef text, uint32_t length, bool keyed) {
+  text->setContext(reinterpret_cast<void*>(static_cast<uintptr_t>(length)));
+  if (keyed) {
+    HPNodeSetMeasureCacheKey(text, 1000 + length);
+  }
+}
+
+// column of count rows of a box and a text, texts are keyed so that they
+// can be cached.
+static HPNodeRef _rows(uint32_t count, bool keyed = true) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetPadding(root, CSSAll, 8);
+  for (uint32_t i = 0; i < count; i++) {
+    const HPNodeRef row = HPNodeNew();
+    HPNodeStyleSetFlexDirection(row, FLexDirectionRow);
+    HPNodeStyleSetPadding(row, CSSAll, 4);
+    const HPNodeRef box = HPNodeNew();
+    HPNodeStyleSetWidth(box, 16);
+    HPNodeStyleSetHeight(box, 16);
+    HPNodeInsertChild(row, box, 0);
+    const HPNodeRef text = newText(0);
+    setText(text, 5 + i * 37 % 24, keyed);
+    HPNodeStyleSetFlexShrink(text, 1);
+    HPNodeInsertChild(row, text, 1);
+    HPNodeInsertChild(root, row, i);
+  }
+  return root;
+}
+
+static std::string makeCacheDirectory() {
+  char path[] = "/tmp/hplayoutXXXXXX";
+  return mkdtemp(path);
+}
+
+// names of entries in directory.
+static std::vector<std::string> listEntries(const std::string& directory) {
+  std::vector<std::string> entries;
+  DIR* dir = opendir(directory.c_str());
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      entries.push_back(directory + "/" + entry->d_name);
+    }
+  }
+  closedir(dir);
+  return entries;
+}
+
+static std::vector<uint8_t> readEntry(const std::string& path) {
+  std::vector<uint8_t> bytes;
+  FILE* file = fopen(path.c_str(), "rb");
+  int c;
+  while ((c = fgetc(file)) != EOF) {
+    bytes.push_back(static_cast<uint8_t>(c));
+  }
+  fclose(file);
+  return bytes;
+}
+
+static void removeCacheDirectory(const std::string& directory) {
+  DIR* dir = opendir(directory.c_str());
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      unlink((directory + "/" + entry->d_name).c_str());
+    }
+  }
+  closedir(dir);
+  rmdir(directory.c_str());
+}
+
+TEST(HippyTest, persistent_layout_cache_reads_first_layout_of_same_tree) {
+  const std::string directory = makeCacheDirectory();
+  const HPNodeRef expected = _rows(6);
+  HPNodeDoLayout(expected, 375, VALUE_UNDEFINED, DirectionRTL);
+
+  HPPersistentLayoutCacheRef cache = HPPersistentLayoutCacheNew(directory.c_str(), 7);
+  const HPNodeRef first = _rows(6);
+  ASSERT_FALSE(HPNodeDoPersistentCachedLayout(first, 375, VALUE_UNDEFINED, cache, DirectionRTL));
+  expectSameLayout(expected, first);
+  HPPersistentLayoutCacheFree(cache);
+
+  // next launch.
+  cache = HPPersistentLayoutCacheNew(directory.c_str(), 7);
+  const HPNodeRef second = _rows(6);
+  measureCount = 0;
+  ASSERT_TRUE(HPNodeDoPersistentCachedLayout(second, 375, VALUE_UNDEFINED, cache, DirectionRTL));
+  ASSERT_EQ(0u, measureCount.load());
+  expectSameLayout(expected, second);
+  ASSERT_FALSE(HPNodeIsDirty(second->getChild(2)->getChild(1)));
+  ASSERT_TRUE(HPNodeHasNewLayout(second->getChild(2)));
+  HPPersistentLayoutCacheStats stats = HPPersistentLayoutCacheGetStats(cache);
+  ASSERT_EQ(1u, stats.hitCount);
+  ASSERT_EQ(0u, stats.missCount);
+
+  // later changes are laid out as usual.
+  setText(expected->getChild(2)->getChild(1), 30, true);
+  HPNodeMarkDirty(expected->getChild(2)->getChild(1));
+  HPNodeDoLayout(expected, 375, VALUE_UNDEFINED, DirectionRTL);
+  setText(second->getChild(2)->getChild(1), 30, true);
+  HPNodeMarkDirty(second->getChild(2)->getChild(1));
+  HPNodeDoLayout(second, 375, VALUE_UNDEFINED, DirectionRTL);
+  expectSameLayout(expected, second);
+
+  HPPersistentLayoutCacheFree(cache);
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(first);
+  HPNodeFreeRecursive(second);
+  removeCacheDirectory(directory);
+}
+
+TEST(HippyTest, persistent_layout_cache_falls_back_on_mismatch) {
+  const std::string directory = makeCacheDirectory();
+  HPPersistentLayoutCacheRef cache = HPPersistentLayoutCacheNew(directory.c_str());
+  const HPNodeRef first = _rows(6);
+  ASSERT_FALSE(HPNodeDoPersistentCachedLayout(first, 375, 667, cache));
+  HPNodeFreeRecursive(first);
+
+  // other viewport, style or content.
+  HPNodeRef root = _rows(6);
+  ASSERT_FALSE(HPNodeDoPersistentCachedLayout(root, 320, 667, cache));
+  HPNodeFreeRecursive(root);
+  root = _rows(6);
+  HPNodeStyleSetPadding(root->getChild(3), CSSTop, 2);
+  ASSERT_FALSE(HPNodeDoPersistentCachedLayout(root, 375, 667, cache));
+  HPNodeFreeRecursive(root);
+  root = _rows(6);
+  setText(root->getChild(3)->getChild(1), 9, true);
+  ASSERT_FALSE(HPNodeDoPersistentCachedLayout(root, 375, 667, cache));
+  HPNodeFreeRecursive(root);
+  ASSERT_EQ(4u, HPPersistentLayoutCacheGetStats(cache).missCount);
+
+  // measured content without key can't be cached.
+  root = _rows(6, false);
+  ASSERT_FALSE(HPNodeDoPersistentCachedLayout(root, 375, 667, cache));
+  ASSERT_EQ(1u, HPPersistentLayoutCacheGetStats(cache).uncacheableCount);
+  HPNodeFreeRecursive(root);
+
+  // truncated entries are laid out again and replaced.
+  DIR* dir = opendir(directory.c_str());
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      ASSERT_EQ(0, truncate((directory + "/" + entry->d_name).c_str(), 100));
+    }
+  }
+  closedir(dir);
+  const HPNodeRef expected = _rows(6);
+  HPNodeDoLayout(expected, 375, 667);
+  root = _rows(6);
+  ASSERT_FALSE(HPNodeDoPersistentCachedLayout(root, 375, 667, cache));
+  expectSameLayout(expected, root);
+  HPNodeFreeRecursive(root);
+  root = _rows(6);
+  ASSERT_TRUE(HPNodeDoPersistentCachedLayout(root, 375, 667, cache));
+  expectSameLayout(expected, root);
+  HPNodeFreeRecursive(root);
+
+  HPNodeFreeRecursive(expected);
+  HPPersistentLayoutCacheFree(cache);
+  removeCacheDirectory(directory);
+}
+
+TEST(HippyTest, persistent_layout_cache_checks_every_node_of_colliding_entry) {
+  const std::string directory = makeCacheDirectory();
+  HPPersistentLayoutCacheRef cache = HPPersistentLayoutCacheNew(directory.c_str());
+  HPNodeRef root = _rows(4);
+  ASSERT_FALSE(HPNodeDoPersistentCachedLayout(root, 375, 667, cache));
+  HPNodeFreeRecursive(root);
+  std::vector<std::string> entries = listEntries(directory);
+  ASSERT_EQ(1u, entries.size());
+  const std::string firstPath = entries[0];
+
+  // same styles, one box is wider.
+  root = _rows(4);
+  HPNodeStyleSetWidth(root->getChild(2)->getChild(0), 40);
+  ASSERT_FALSE(HPNodeDoPersistentCachedLayout(root, 375, 667, cache));
+  HPNodeFreeRecursive(root);
+  entries = listEntries(directory);
+  ASSERT_EQ(2u, entries.size());
+  const std::string secondPath = entries[0] == firstPath ? entries[1] : entries[0];
+
+  // entry of the first tree under the key of the second, as on a key collision.
+  std::vector<uint8_t> first = readEntry(firstPath);
+  std::vector<uint8_t> second = readEntry(secondPath);
+  const size_t keyOffset = offsetof(HPPersistentLayoutHeader, key);
+  memcpy(first.data() + keyOffset, second.data() + keyOffset, sizeof(uint64_t));
+  FILE* file = fopen(secondPath.c_str(), "wb");
+  ASSERT_EQ(first.size(), fwrite(first.data(), 1, first.size(), file));
+  fclose(file);
+
+  const HPNodeRef expected = _rows(4);
+  HPNodeStyleSetWidth(expected->getChild(2)->getChild(0), 40);
+  HPNodeDoLayout(expected, 375, 667);
+  root = _rows(4);
+  HPNodeStyleSetWidth(root->getChild(2)->getChild(0), 40);
+  ASSERT_FALSE(HPNodeDoPersistentCachedLayout(root, 375, 667, cache));
+  expectSameLayout(expected, root);
+  HPNodeFreeRecursive(root);
+
+  HPNodeFreeRecursive(expected);
+  HPPersistentLayoutCacheFree(cache);
+  removeCacheDirectory(directory);
+}
+
+// rows of items with fractional sizes and positions, rounded after layout.
+static HPNodeRef buildFractionalPage(uint32_t changedLength) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetPadding(root, CSSAll, 3.3f);
+  for (uint32_t i = 0; i < 4; i++) {
+    const HPNodeRef row = HPNodeNew();
+    HPNodeStyleSetFlexDirection(row, FLexDirectionRow);
+    HPNodeStyleSetMargin(row, CSSTop, 1.7f);
+    HPNodeInsertChild(root, row, i);
+    for (uint32_t j = 0; j < 7; j++) {
+      const HPNodeRef item = HPNodeNew();
+      HPNodeStyleSetFlexGrow(item, 1 + j % 3);
+      HPNodeStyleSetPadding(item, CSSAll, 0.6f);
+      HPNodeInsertChild(row, item, j);
+      const HPNodeRef text = HPNodeNew();
+      HPNodeSetMeasureFunc(text, _measureText);
+      setText(text, i == 2 && j == 3 ? changedLength : 3 + (i + j) % 5, true);
+      HPNodeInsertChild(item, text, 0);
+    }
+  }
+  return root;
+}
+
+static void expectSameResult(HPNodeRef expected, HPNodeRef actual) {
+  ASSERT_EQ(HPNodeLayoutGetLeft(expected), HPNodeLayoutGetLeft(actual));
+  ASSERT_EQ(HPNodeLayoutGetTop(expected), HPNodeLayoutGetTop(actual));
+  ASSERT_EQ(HPNodeLayoutGetWidth(expected), HPNodeLayoutGetWidth(actual));
+  ASSERT_EQ(HPNodeLayoutGetHeight(expected), HPNodeLayoutGetHeight(actual));
+  ASSERT_EQ(expected->childCount(), actual->childCount());
+  for (uint32_t i = 0; i < expected->childCount(); i++) {
+    expectSameResult(expected->getChild(i), actual->getChild(i));
+  }
+}
+
+// as a renderer does after reading the results.
+static void clearNewLayout(HPNodeRef node) {
+  HPNodesetHasNewLayout(node, false);
+  for (uint32_t i = 0; i < node->childCount(); i++) {
+    clearNewLayout(node->getChild(i));
+  }
+}
+
+TEST(HippyTest, persistent_layout_cache_relayout_same_as_full_layout) {
+  const std::string directory = makeCacheDirectory();
+  HPPersistentLayoutCacheRef cache = HPPersistentLayoutCacheNew(directory.c_str());
+  const HPNodeRef first = buildFractionalPage(4);
+  ASSERT_FALSE(HPNodeDoPersistentCachedLayout(first, 375.5f, VALUE_UNDEFINED, cache));
+  HPNodeFreeRecursive(first);
+
+  // results read from the cache are laid out again from unrounded values.
+  const HPNodeRef root = buildFractionalPage(4);
+  ASSERT_TRUE(HPNodeDoPersistentCachedLayout(root, 375.5f, VALUE_UNDEFINED, cache));
+  clearNewLayout(root);
+  HPNodeRef text = root->getChild(2)->getChild(3)->getChild(0);
+  setText(text, 11, true);
+  HPNodeMarkDirty(text);
+  HPNodeDoLayout(root, 375.5f, VALUE_UNDEFINED);
+
+  const HPNodeRef expected = buildFractionalPage(11);
+  HPNodeDoLayout(expected, 375.5f, VALUE_UNDEFINED);
+  expectSameResult(expected, root);
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(root);
+  HPPersistentLayoutCacheFree(cache);
+  removeCacheDirectory(directory);
+}
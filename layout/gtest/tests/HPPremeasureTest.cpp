@@ -0,0 +1,89 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Hippy.h>
+#include <gtest.h>
+#include "HPTestUtil.h"
+
+#include <stdint.h>
+
+// column of count rows of an avatar and a text which shrinks.
+static HPNodeRef _feed(uint32_t count) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 360);
+  HPNodeStyleSetPadding(root, CSSAll, 16);
+  for (uint32_t i = 0; i < count; i++) {
+    const HPNodeRef row = HPNodeNew();
+    HPNodeStyleSetFlexDirection(row, FLexDirectionRow);
+    HPNodeStyleSetMargin(row, CSSBottom, 4);
+    const HPNodeRef avatar = HPNodeNew();
+    HPNodeStyleSetWidth(avatar, 40);
+    HPNodeStyleSetHeight(avatar, 40);
+    HPNodeInsertChild(row, avatar, 0);
+    const HPNodeRef text = newText(6 + i * 37 % 30);
+    HPNodeStyleSetFlexShrink(text, 1);
+    HPNodeInsertChild(row, text, 1);
+    HPNodeInsertChild(root, row, i);
+  }
+  return root;
+}
+
+TEST(HippyTest, premeasure_text_leaves_on_pool) {
+  const HPNodeRef expected = _feed(40);
+  HPNodeDoLayout(expected, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  HPLayoutThreadPoolRef pool = HPLayoutThreadPoolNew(4);
+  const HPNodeRef root = _feed(40);
+  measureCount = 0;
+  HPLayoutStats stats;
+  HPNodeDoPremeasuredLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, pool, DirectionLTR, nullptr,
+                            &stats);
+  ASSERT_EQ(40u, stats.batchMeasureCount);
+  ASSERT_EQ(40u, measureCount.load());
+  // layout pass itself measures nothing.
+  ASSERT_EQ(0u, stats.measureFuncCount);
+  ASSERT_GE(stats.batchMeasureHitCount, 40u);
+  expectSameLayout(expected, root);
+
+  // only the changed text is measured again.
+  const HPNodeRef text = root->getChild(7)->getChild(1);
+  text->setContext(reinterpret_cast<void*>(static_cast<uintptr_t>(40)));
+  HPNodeMarkDirty(text);
+  measureCount = 0;
+  HPNodeDoPremeasuredLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, pool, DirectionLTR, nullptr,
+                            &stats);
+  ASSERT_EQ(1u, stats.batchMeasureCount);
+  ASSERT_EQ(1u, measureCount.load());
+  // 40 chars fit in the 288 px next to the avatar.
+  ASSERT_FLOAT_EQ(280, HPNodeLayoutGetWidth(text));
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(root);
+  HPLayoutThreadPoolFree(pool);
+}
+
+TEST(HippyTest, premeasure_without_pool_is_plain_layout) {
+  const HPNodeRef root = _feed(4);
+  measureCount = 0;
+  HPLayoutStats stats;
+  HPNodeDoPremeasuredLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, nullptr, DirectionLTR,
+                            nullptr, &stats);
+  ASSERT_EQ(0u, stats.batchMeasureCount);
+  ASSERT_EQ(4u, stats.measureFuncCount);
+  ASSERT_FLOAT_EQ(328, HPNodeLayoutGetWidth(root->getChild(0)));
+
+  HPNodeFreeRecursive(root);
+}
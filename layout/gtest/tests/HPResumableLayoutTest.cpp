@@ -0,0 +1,126 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Hippy.h>
+#include <gtest.h>
+#include "HPTestUtil.h"
+
+#include <stdint.h>
+
+// long column of rows with a box and a text.
+static HPNodeRef _page(uint32_t rowCount) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetPadding(root, CSSAll, 6);
+  for (uint32_t i = 0; i < rowCount; i++) {
+    const HPNodeRef row = HPNodeNew();
+    HPNodeStyleSetFlexDirection(row, FLexDirectionRow);
+    const HPNodeRef box = HPNodeNew();
+    HPNodeStyleSetWidth(box, 12);
+    HPNodeStyleSetHeight(box, 12);
+    HPNodeInsertChild(row, box, 0);
+    const HPNodeRef text = newText(4 + i * 37 % 30);
+    HPNodeStyleSetFlexShrink(text, 1);
+    HPNodeInsertChild(row, text, 1);
+    HPNodeInsertChild(root, row, i);
+  }
+  return root;
+}
+
+TEST(HippyTest, resumable_layout_in_slices) {
+  const HPNodeRef expected = _page(200);
+  HPNodeDoLayout(expected, 360, VALUE_UNDEFINED);
+
+  const HPNodeRef root = _page(200);
+  HPResumableLayoutRef layout = HPResumableLayoutNew(root, 360, VALUE_UNDEFINED);
+  uint32_t slices = 1;
+  uint32_t lastVisits = 0;
+  while (HPResumableLayoutRun(layout, 0, 100) == LayoutStatusNotFinished) {
+    // every slice makes progress within its budget.
+    ASSERT_GT(layout->visitCount(), lastVisits);
+    ASSERT_LE(layout->visitCount() - lastVisits, 100u);
+    lastVisits = layout->visitCount();
+    slices++;
+    // partial results are not published.
+    ASSERT_FALSE(HPNodeHasNewLayout(root));
+    ASSERT_FALSE(HPNodeHasNewLayout(root->getChild(0)->getChild(1)));
+  }
+  ASSERT_GT(slices, 5u);
+  ASSERT_TRUE(layout->isFinished());
+  ASSERT_TRUE(HPNodeHasNewLayout(root));
+  ASSERT_TRUE(HPNodeHasNewLayout(root->getChild(199)->getChild(1)));
+  ASSERT_EQ(LayoutStatusFinished, HPResumableLayoutRun(layout, 0, 100));
+  HPResumableLayoutFree(layout);
+  expectSameLayout(expected, root);
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, resumable_layout_without_budget_runs_to_end) {
+  const HPNodeRef expected = _page(40);
+  HPNodeDoLayout(expected, 360, VALUE_UNDEFINED);
+
+  const HPNodeRef root = _page(40);
+  HPResumableLayoutRef layout = HPResumableLayoutNew(root, 360, VALUE_UNDEFINED);
+  ASSERT_EQ(LayoutStatusFinished, HPResumableLayoutRun(layout, 0));
+  HPResumableLayoutFree(layout);
+  expectSameLayout(expected, root);
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, resumable_layout_abandoned_when_freed) {
+  const HPNodeRef expected = _page(80);
+  HPNodeDoLayout(expected, 360, VALUE_UNDEFINED);
+
+  const HPNodeRef root = _page(80);
+  HPResumableLayoutRef layout = HPResumableLayoutNew(root, 360, VALUE_UNDEFINED);
+  ASSERT_EQ(LayoutStatusNotFinished, HPResumableLayoutRun(layout, 0, 50));
+  HPResumableLayoutFree(layout);
+  // nodes laid out before it stopped are dirty again, so partial results
+  // aren't reused by the next layout.
+  ASSERT_TRUE(HPNodeIsDirty(root));
+  ASSERT_TRUE(HPNodeIsDirty(root->getChild(0)->getChild(1)));
+  HPNodeDoLayout(root, 360, VALUE_UNDEFINED);
+  expectSameLayout(expected, root);
+
+  // a layout which never ran leaves the tree untouched.
+  HPNodeMarkDirty(root->getChild(0)->getChild(1));
+  HPResumableLayoutFree(HPResumableLayoutNew(root, 360, VALUE_UNDEFINED));
+  ASSERT_TRUE(HPNodeIsDirty(root));
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, resumable_layout_with_time_budget) {
+  const HPNodeRef expected = _page(200);
+  HPNodeDoLayout(expected, 360, VALUE_UNDEFINED);
+
+  const HPNodeRef root = _page(200);
+  HPResumableLayoutRef layout = HPResumableLayoutNew(root, 360, VALUE_UNDEFINED);
+  uint32_t slices = 1;
+  while (HPResumableLayoutRun(layout, 0.001) == LayoutStatusNotFinished) {
+    slices++;
+  }
+  ASSERT_GT(slices, 1u);
+  HPResumableLayoutFree(layout);
+  expectSameLayout(expected, root);
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(root);
+}
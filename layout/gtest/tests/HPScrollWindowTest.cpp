@@ -0,0 +1,169 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <Hippy.h>
+#include <gtest.h>
+#include "HPTestUtil.h"
+
+#include <stdint.h>
+
+static float contentHeight(HPNodeRef list) {
+  HPNodeRef last = list->getChild(list->childCount() - 1);
+  return HPNodeLayoutGetTop(last) + HPNodeLayoutGetHeight(last) +
+         HPNodeLayoutGetMargin(last, CSSBottom);
+}
+
+static void expectSameSize(HPNodeRef a, HPNodeRef b) {
+  ASSERT_FLOAT_EQ(HPNodeLayoutGetWidth(a), HPNodeLayoutGetWidth(b));
+  ASSERT_FLOAT_EQ(HPNodeLayoutGetHeight(a), HPNodeLayoutGetHeight(b));
+  ASSERT_EQ(a->childCount(), b->childCount());
+  for (uint32_t i = 0; i < a->childCount(); i++) {
+    ASSERT_FLOAT_EQ(HPNodeLayoutGetLeft(a->getChild(i)), HPNodeLayoutGetLeft(b->getChild(i)));
+    ASSERT_FLOAT_EQ(HPNodeLayoutGetTop(a->getChild(i)), HPNodeLayoutGetTop(b->getChild(i)));
+    expectSameSize(a->getChild(i), b->getChild(i));
+  }
+}
+
+// scroll list of 1000 rows with a box and a text, filling root.
+static HPNodeRef _list(uint32_t textPeriod) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 360);
+  HPNodeStyleSetHeight(root, 600);
+  const HPNodeRef list = HPNodeNew();
+  HPNodeStyleSetFlexGrow(list, 1);
+  HPNodeStyleSetOverflow(list, OverflowScroll);
+  HPNodeInsertChild(root, list, 0);
+  for (uint32_t i = 0; i < 1000; i++) {
+    const HPNodeRef row = HPNodeNew();
+    HPNodeStyleSetFlexDirection(row, FLexDirectionRow);
+    HPNodeStyleSetPadding(row, CSSAll, 8);
+    HPNodeStyleSetMargin(row, CSSBottom, 2);
+    const HPNodeRef box = HPNodeNew();
+    HPNodeStyleSetWidth(box, 24);
+    HPNodeStyleSetHeight(box, 24);
+    HPNodeInsertChild(row, box, 0);
+    const HPNodeRef text = newText(10 + i * 37 % textPeriod);
+    HPNodeStyleSetFlexShrink(text, 1);
+    HPNodeInsertChild(row, text, 1);
+    HPNodeInsertChild(list, row, i);
+  }
+  return root;
+}
+
+TEST(HippyTest, scroll_window_lays_out_only_visible_rows) {
+  const HPNodeRef expected = _list(80);
+  HPNodeDoLayout(expected, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  HPLayoutStats fullStats;
+  const HPNodeRef full = _list(80);
+  HPNodeDoLayout(full, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &fullStats);
+
+  const HPNodeRef root = _list(80);
+  HPNodeRef list = root->getChild(0);
+  HPNodeSetScrollWindow(list, 0, 600, 100, 40);
+  HPLayoutStats stats;
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &stats);
+
+  // rows from the start up to the end of window plus margin are exact.
+  HPNodeRef expectedList = expected->getChild(0);
+  uint32_t exactRows = 0;
+  while (HPNodeLayoutGetTop(expectedList->getChild(exactRows)) < 700) {
+    ASSERT_FLOAT_EQ(HPNodeLayoutGetTop(list->getChild(exactRows)),
+                    HPNodeLayoutGetTop(expectedList->getChild(exactRows)));
+    expectSameSize(list->getChild(exactRows), expectedList->getChild(exactRows));
+    exactRows++;
+  }
+  ASSERT_GT(exactRows, 10u);
+  // counted in every pass over the list, it's measured before layout.
+  ASSERT_GE(stats.windowedOutCount, 1000u - exactRows);
+  ASSERT_EQ(stats.measureFuncCount, fullStats.measureFuncCount * exactRows / 1000);
+  ASSERT_LT(stats.visitCount * 10, fullStats.visitCount);
+  // rows out of window are estimated, but placed one after another.
+  HPNodeRef row = list->getChild(500);
+  float averageItemSize = list->scrollWindow->averageItemSize;
+  ASSERT_GT(averageItemSize, 42);
+  ASSERT_FLOAT_EQ(HPNodeLayoutGetHeight(row), roundf(averageItemSize - 2));
+  ASSERT_FLOAT_EQ(HPNodeLayoutGetWidth(row), 360);
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(full);
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, scroll_window_keeps_content_size_stable) {
+  // text of all rows fits in one line, so rows have the same height.
+  const HPNodeRef expected = _list(20);
+  HPNodeDoLayout(expected, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  const float expectedContentHeight = contentHeight(expected->getChild(0));
+
+  const HPNodeRef root = _list(20);
+  HPNodeRef list = root->getChild(0);
+  HPNodeSetScrollWindow(list, 0, 600, 0, 100);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  // the average of measured rows replaces the initial estimate while the
+  // list is measured, so the content size is exact.
+  ASSERT_FLOAT_EQ(list->scrollWindow->averageItemSize, 42);
+  const float contentSize = contentHeight(list);
+  ASSERT_FLOAT_EQ(contentSize, expectedContentHeight);
+
+  // scroll, window rows are laid out exactly, content size is kept since rows
+  // scrolled in were estimated by the refined average.
+  HPLayoutStats stats;
+  HPNodeSetScrollWindow(list, 21000, 600, 0);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED, DirectionLTR, nullptr, &stats);
+  ASSERT_FLOAT_EQ(contentHeight(list), contentSize);
+  ASSERT_LT(stats.measureFuncCount, 40u);
+  HPNodeClearScrollWindow(list);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_FLOAT_EQ(contentHeight(list), expectedContentHeight);
+  expectSameSize(root, expected);
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(root);
+}
+
+static HPNodeRef buildFixedRowList(uint32_t rowCount, float firstRowHeight) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 360);
+  HPNodeStyleSetHeight(root, 600);
+  const HPNodeRef list = HPNodeNew();
+  HPNodeStyleSetFlexGrow(list, 1);
+  HPNodeStyleSetOverflow(list, OverflowScroll);
+  HPNodeInsertChild(root, list, 0);
+  for (uint32_t i = 0; i < rowCount; i++) {
+    const HPNodeRef row = HPNodeNew();
+    HPNodeStyleSetHeight(row, i == 0 ? firstRowHeight : 20.3f);
+    HPNodeInsertChild(list, row, i);
+  }
+  HPNodeSetScrollWindow(list, 0, 600, 0);
+  return root;
+}
+
+TEST(HippyTest, scroll_window_moves_windowed_out_rows) {
+  const HPNodeRef root = buildFixedRowList(200, 20.3f);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  // rows out of window are moved by the first row, without a layout of their own.
+  HPNodeStyleSetHeight(root->getChild(0)->getChild(0), 31.7f);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  const HPNodeRef expected = buildFixedRowList(200, 31.7f);
+  HPNodeDoLayout(expected, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_TRUE(root->getChild(0)->getChild(150)->isWindowedOut);
+  expectSameSize(root, expected);
+
+  HPNodeFreeRecursive(expected);
+  HPNodeFreeRecursive(root);
+}
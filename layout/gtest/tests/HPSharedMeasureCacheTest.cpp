@@ -0,0 +1,150 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Hippy.h>
+#include <gtest.h>
+
+static int measureCount = 0;
+
+static HPSize _measureLabel(HPNodeRef node,
+                            float width,
+                            MeasureMode widthMeasureMode,
+                            float height,
+                            MeasureMode heightMeasureMode,
+                            void* layoutContext) {
+  measureCount++;
+  HPSize size = {widthMeasureMode == MeasureModeUndefined ? 60 : width / 2, 20};
+  return size;
+}
+
+static void resetMeasureCache() {
+  HPMeasureCacheSetCapacity(HP_MEASURE_CACHE_DEFAULT_CAPACITY);
+  HPMeasureCacheInvalidate();
+  HPMeasureCacheResetStats();
+  measureCount = 0;
+}
+
+// column of labels, label i has content key keys[i].
+static HPNodeRef buildLabels(const uint64_t* keys, uint32_t count) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 300);
+  HPNodeStyleSetAlignItems(root, FlexAlignStart);
+  for (uint32_t i = 0; i < count; i++) {
+    const HPNodeRef label = HPNodeNew();
+    HPNodeSetMeasureFunc(label, _measureLabel);
+    HPNodeSetMeasureCacheKey(label, keys[i]);
+    HPNodeInsertChild(root, label, i);
+  }
+  return root;
+}
+
+TEST(HippyTest, measure_cache_shared_by_same_content) {
+  resetMeasureCache();
+  const uint64_t keys[] = {7, 7, 7, 7, 9, 9};
+  const HPNodeRef root = buildLabels(keys, 6);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  // one callback per distinct content and constraints.
+  HPMeasureCacheStats stats = HPMeasureCacheGetStats();
+  ASSERT_EQ(static_cast<uint64_t>(measureCount), stats.missCount);
+  ASSERT_TRUE(stats.hitCount > 0);
+  int firstCount = measureCount;
+  for (uint32_t i = 0; i < 6; i++) {
+    ASSERT_EQ(150, HPNodeLayoutGetWidth(root->getChild(i)));
+    ASSERT_EQ(20, HPNodeLayoutGetHeight(root->getChild(i)));
+  }
+
+  // a second tree with same contents is measured from cache.
+  const HPNodeRef other = buildLabels(keys, 6);
+  HPNodeDoLayout(other, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_EQ(firstCount, measureCount);
+  ASSERT_EQ(150, HPNodeLayoutGetWidth(other->getChild(5)));
+
+  // nodes without key are always measured.
+  HPNodeSetMeasureCacheKey(other->getChild(0), 0);
+  HPNodeDoLayout(other, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_TRUE(measureCount > firstCount);
+
+  HPNodeFreeRecursive(root);
+  HPNodeFreeRecursive(other);
+}
+
+TEST(HippyTest, measure_cache_keyed_by_constraints) {
+  resetMeasureCache();
+  const uint64_t keys[] = {7};
+  const HPNodeRef wide = buildLabels(keys, 1);
+  HPNodeDoLayout(wide, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_EQ(150, HPNodeLayoutGetWidth(wide->getChild(0)));
+
+  int count = measureCount;
+  const HPNodeRef narrow = buildLabels(keys, 1);
+  HPNodeStyleSetWidth(narrow, 100);
+  HPNodeDoLayout(narrow, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_TRUE(measureCount > count);
+  ASSERT_EQ(50, HPNodeLayoutGetWidth(narrow->getChild(0)));
+
+  // both constraints are cached now.
+  count = measureCount;
+  const HPNodeRef other = buildLabels(keys, 1);
+  HPNodeDoLayout(other, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  HPNodeStyleSetWidth(other, 100);
+  HPNodeDoLayout(other, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_EQ(count, measureCount);
+  ASSERT_EQ(50, HPNodeLayoutGetWidth(other->getChild(0)));
+
+  HPNodeFreeRecursive(wide);
+  HPNodeFreeRecursive(narrow);
+  HPNodeFreeRecursive(other);
+}
+
+TEST(HippyTest, measure_cache_lru_and_invalidate) {
+  resetMeasureCache();
+  HPMeasureCache cache(2);
+  HPSize size = {10, 20};
+  cache.put(1, 100, MeasureModeAtMost, VALUE_UNDEFINED, MeasureModeUndefined, size);
+  cache.put(2, 100, MeasureModeAtMost, VALUE_UNDEFINED, MeasureModeUndefined, size);
+  HPSize cached = {0, 0};
+  // undefined constraint values are ignored.
+  ASSERT_TRUE(cache.get(1, 100, MeasureModeAtMost, 50, MeasureModeUndefined, cached));
+  ASSERT_EQ(10, cached.width);
+  ASSERT_FALSE(cache.get(1, 100, MeasureModeExactly, 50, MeasureModeUndefined, cached));
+  // 2 is least recently used.
+  cache.put(3, 100, MeasureModeAtMost, VALUE_UNDEFINED, MeasureModeUndefined, size);
+  ASSERT_FALSE(cache.get(2, 100, MeasureModeAtMost, 0, MeasureModeUndefined, cached));
+  ASSERT_TRUE(cache.get(1, 100, MeasureModeAtMost, 0, MeasureModeUndefined, cached));
+  ASSERT_TRUE(cache.get(3, 100, MeasureModeAtMost, 0, MeasureModeUndefined, cached));
+
+  HPMeasureCacheStats stats = cache.stats();
+  ASSERT_EQ(2u, stats.size);
+  ASSERT_EQ(3u, stats.hitCount);
+  ASSERT_EQ(2u, stats.missCount);
+  ASSERT_EQ(1u, stats.evictCount);
+
+  cache.invalidate();
+  ASSERT_EQ(0u, cache.stats().size);
+  ASSERT_FALSE(cache.get(1, 100, MeasureModeAtMost, 0, MeasureModeUndefined, cached));
+
+  // shared cache is invalidated e.g. on font scale change.
+  const uint64_t keys[] = {7};
+  const HPNodeRef root = buildLabels(keys, 1);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  int count = measureCount;
+  HPMeasureCacheInvalidate();
+  HPNodeMarkDirty(root->getChild(0));
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_TRUE(measureCount > count);
+  HPNodeFreeRecursive(root);
+}
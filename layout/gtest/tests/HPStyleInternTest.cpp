@@ -0,0 +1,222 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <Hippy.h>
+#include <gtest.h>
+
+#include <thread>
+#include <vector>
+
+TEST(HippyTest, style_intern_share_same_style) {
+  const HPNodeRef node0 = HPNodeNew();
+  const HPNodeRef node1 = HPNodeNew();
+  HPNodeStyleSetFlexDirection(node0, FLexDirectionRow);
+  HPNodeStyleSetFlexGrow(node0, 1);
+  HPNodeStyleSetFlexGrow(node1, 1);
+  ASSERT_NE(&node0->style.get(), &node1->style.get());
+
+  HPNodeStyleSetFlexDirection(node1, FLexDirectionRow);
+  ASSERT_EQ(&node0->style.get(), &node1->style.get());
+  ASSERT_EQ(2u, node0->style.shareCount());
+
+  // width and height are kept per node, not in the shared style.
+  HPNodeStyleSetWidth(node0, 100);
+  HPNodeStyleSetWidth(node1, 50);
+  ASSERT_EQ(&node0->style.get(), &node1->style.get());
+
+  HPNodeFree(node0);
+  HPNodeFree(node1);
+}
+
+TEST(HippyTest, style_intern_copy_on_write) {
+  const HPNodeRef node0 = HPNodeNew();
+  const HPNodeRef node1 = HPNodeNew();
+  HPNodeStyleSetPadding(node0, CSSLeft, 10);
+  HPNodeStyleSetPadding(node1, CSSLeft, 10);
+  ASSERT_EQ(&node0->style.get(), &node1->style.get());
+  uint32_t internedCount = HPStyleRef::internedCount();
+
+  HPNodeStyleSetPadding(node1, CSSLeft, 20);
+  ASSERT_NE(&node0->style.get(), &node1->style.get());
+  ASSERT_FLOAT_EQ(10, node0->style->padding[CSSLeft]);
+  ASSERT_FLOAT_EQ(20, node1->style->padding[CSSLeft]);
+  ASSERT_EQ(internedCount + 1, HPStyleRef::internedCount());
+
+  // record released when its last user changes style.
+  HPNodeStyleSetPadding(node0, CSSLeft, 20);
+  ASSERT_EQ(&node0->style.get(), &node1->style.get());
+  ASSERT_EQ(internedCount, HPStyleRef::internedCount());
+
+  HPNodeFree(node0);
+  HPNodeFree(node1);
+}
+
+TEST(HippyTest, style_intern_layout_with_shared_style) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 100);
+  HPNodeStyleSetHeight(root, 100);
+  HPNodeStyleSetFlexDirection(root, FLexDirectionRow);
+
+  for (uint32_t i = 0; i < 4; i++) {
+    const HPNodeRef child = HPNodeNew();
+    HPNodeStyleSetFlexGrow(child, 1);
+    HPNodeInsertChild(root, child, i);
+  }
+  HPNodeStyleSetWidth(root->getChild(3), 40);
+  HPNodeStyleSetFlexGrow(root->getChild(3), 0);
+
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+  ASSERT_EQ(&root->getChild(0)->style.get(), &root->getChild(2)->style.get());
+  ASSERT_FLOAT_EQ(20, HPNodeLayoutGetWidth(root->getChild(0)));
+  ASSERT_FLOAT_EQ(40, HPNodeLayoutGetLeft(root->getChild(2)));
+  ASSERT_FLOAT_EQ(40, HPNodeLayoutGetWidth(root->getChild(3)));
+  // temporary width set during layout is restored.
+  ASSERT_TRUE(isUndefined(root->getChild(0)->styleDim[DimWidth]));
+
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, style_equal_with_undefined_value) {
+  HPStyle style0;
+  HPStyle style1;
+  ASSERT_TRUE(style0.isEqual(style1));
+  ASSERT_EQ(style0.hashValue(), style1.hashValue());
+
+  style1.setMargin(CSSTop, VALUE_AUTO);
+  style0.setMargin(CSSTop, 0);
+  ASSERT_FALSE(style0.isEqual(style1));
+  style0.setMargin(CSSTop, VALUE_AUTO);
+  ASSERT_TRUE(style0.isEqual(style1));
+}
+
+TEST(HippyTest, style_intern_resolves_edges_on_style_change) {
+  const HPNodeRef node0 = HPNodeNew();
+  const HPNodeRef node1 = HPNodeNew();
+  HPNodeStyleSetMargin(node0, CSSStart, 5);
+  HPNodeStyleSetPadding(node0, CSSHorizontal, 3);
+  HPNodeStyleSetBorder(node0, CSSLeft, 2);
+  HPNodeStyleSetPosition(node0, CSSTop, 4);
+  ASSERT_FLOAT_EQ(5, node0->style.edges(FLexDirectionRow).startMargin);
+  ASSERT_FLOAT_EQ(5, node0->style.edges(FLexDirectionRow).margin);
+  ASSERT_FLOAT_EQ(0, node0->style.edges(FLexDirectionColumn).margin);
+  ASSERT_FLOAT_EQ(5, node0->style.edges(FLexDirectionRow).startPaddingAndBorder);
+  ASSERT_FLOAT_EQ(8, node0->style.edges(FLexDirectionRow).paddingAndBorder);
+  ASSERT_FLOAT_EQ(3, node0->style.edges(FLexDirectionRowReverse).startPaddingAndBorder);
+  ASSERT_FLOAT_EQ(4, node0->style.edges(FLexDirectionColumn).startPosition);
+  ASSERT_TRUE(isUndefined(node0->style.edges(FLexDirectionColumn).endPosition));
+  ASSERT_FALSE(node0->style.edges(FLexDirectionRow).hasAutoMargin);
+
+  // updated in place by the sole owner.
+  HPNodeStyleSetMarginAuto(node0, CSSStart);
+  ASSERT_TRUE(node0->style.edges(FLexDirectionRow).autoStartMargin);
+  ASSERT_TRUE(node0->style.edges(FLexDirectionRow).hasAutoMargin);
+  ASSERT_FLOAT_EQ(0, node0->style.edges(FLexDirectionRow).startMargin);
+
+  // shared, then copied on write.
+  HPNodeStyleSetMarginAuto(node1, CSSStart);
+  HPNodeStyleSetPadding(node1, CSSHorizontal, 3);
+  HPNodeStyleSetBorder(node1, CSSLeft, 2);
+  HPNodeStyleSetPosition(node1, CSSTop, 4);
+  ASSERT_EQ(&node0->style.get(), &node1->style.get());
+  HPNodeStyleSetMargin(node1, CSSStart, 6);
+  ASSERT_FLOAT_EQ(6, node1->style.edges(FLexDirectionRow).startMargin);
+  ASSERT_TRUE(node0->style.edges(FLexDirectionRow).autoStartMargin);
+
+  HPNodeFree(node0);
+  HPNodeFree(node1);
+}
+
+// edges are not resolved again for other fields, but kept by copies.
+TEST(HippyTest, style_intern_keeps_edges_on_other_style_change) {
+  const HPNodeRef node0 = HPNodeNew();
+  const HPNodeRef node1 = HPNodeNew();
+  HPNodeStyleSetMargin(node0, CSSLeft, 5);
+  HPNodeStyleSetMargin(node1, CSSLeft, 5);
+  ASSERT_EQ(&node0->style.get(), &node1->style.get());
+
+  HPNodeStyleSetFlexGrow(node1, 1);
+  ASSERT_NE(&node0->style.get(), &node1->style.get());
+  ASSERT_FLOAT_EQ(5, node1->style.edges(FLexDirectionRow).startMargin);
+  ASSERT_FLOAT_EQ(1, node1->style->flexGrow);
+
+  HPNodeStyleSetFlexGrow(node0, 2);
+  ASSERT_FLOAT_EQ(5, node0->style.edges(FLexDirectionRow).startMargin);
+  ASSERT_EQ(node0->style.get().hashValue(), node0->style.hash());
+
+  // equal again, shared again.
+  HPNodeStyleSetFlexGrow(node0, 1);
+  ASSERT_EQ(&node0->style.get(), &node1->style.get());
+
+  HPNodeFree(node0);
+  HPNodeFree(node1);
+}
+
+TEST(HippyTest, style_intern_keeps_explicit_edge_with_unchanged_value) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetWidth(root, 100);
+  HPNodeStyleSetPadding(root, CSSBottom, 0);
+  HPNodeStyleSetPadding(root, CSSAll, 4);
+  HPNodeStyleSetMargin(root, CSSTop, 0);
+  HPNodeStyleSetMargin(root, CSSVertical, 3);
+  HPNodeStyleSetBorder(root, CSSLeft, 0);
+  HPNodeStyleSetBorder(root, CSSHorizontal, 2);
+  HPNodeDoLayout(root, VALUE_UNDEFINED, VALUE_UNDEFINED);
+
+  ASSERT_FLOAT_EQ(4, HPNodeLayoutGetPadding(root, CSSTop));
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetPadding(root, CSSBottom));
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetMargin(root, CSSTop));
+  ASSERT_FLOAT_EQ(3, HPNodeLayoutGetMargin(root, CSSBottom));
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetBorder(root, CSSLeft));
+  ASSERT_FLOAT_EQ(2, HPNodeLayoutGetBorder(root, CSSRight));
+  ASSERT_FLOAT_EQ(4, HPNodeLayoutGetHeight(root));
+
+  HPNodeFree(root);
+}
+
+// nodes of independent trees are styled on several threads at once.
+TEST(HippyTest, style_intern_concurrent_set_and_free) {
+  uint32_t internedCount = HPStyleRef::internedCount();
+  std::vector<std::thread> threads;
+  bool correct[4] = {false, false, false, false};
+  for (uint32_t t = 0; t < 4; t++) {
+    threads.push_back(std::thread([t, &correct]() {
+      bool ok = true;
+      for (uint32_t round = 0; round < 200; round++) {
+        HPNodeRef nodes[8];
+        for (uint32_t i = 0; i < 8; i++) {
+          nodes[i] = HPNodeNew();
+          // shared between threads, and own to the thread.
+          HPNodeStyleSetFlexGrow(nodes[i], static_cast<float>(i % 3));
+          HPNodeStyleSetPadding(nodes[i], CSSLeft, static_cast<float>(t * 100 + i));
+          HPNodeStyleSetPadding(nodes[i], CSSLeft, static_cast<float>(i));
+        }
+        for (uint32_t i = 0; i < 8; i++) {
+          ok = ok && nodes[i]->style->flexGrow == i % 3 && nodes[i]->style->padding[CSSLeft] == i;
+          HPNodeFree(nodes[i]);
+        }
+      }
+      correct[t] = ok;
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+  for (uint32_t t = 0; t < 4; t++) {
+    ASSERT_TRUE(correct[t]);
+  }
+  ASSERT_EQ(internedCount, HPStyleRef::internedCount());
+}
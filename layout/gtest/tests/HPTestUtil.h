@@ -0,0 +1,84 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// helpers shared by tests comparing layouts of text trees.
+
+#pragma once
+
+#include <Hippy.h>
+#include <gtest.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+
+// calls of _measureText, per test file.
+static std::atomic<uint32_t> measureCount(0);
+
+// 7 px per char, lines of 17 px wrap at width when it is given.
+static inline HPSize measureTextLength(uint32_t length,
+                                       float width,
+                                       MeasureMode widthMeasureMode) {
+  float textWidth = length * 7.0f;
+  float lines = 1;
+  if (widthMeasureMode != MeasureModeUndefined && textWidth > width && width >= 7.0f) {
+    float charsPerLine = static_cast<float>(static_cast<uint32_t>(width / 7.0f));
+    lines = static_cast<float>(static_cast<uint32_t>((length + charsPerLine - 1) / charsPerLine));
+    textWidth = charsPerLine * 7.0f;
+  }
+  HPSize size = {widthMeasureMode == MeasureModeExactly ? width : textWidth, lines * 17.0f};
+  return size;
+}
+
+static inline uint32_t textLength(HPNodeRef node) {
+  return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(node->getContext()));
+}
+
+// thread safe, text length in chars is kept in context.
+static inline HPSize _measureText(HPNodeRef node,
+                                  float width,
+                                  MeasureMode widthMeasureMode,
+                                  float height,
+                                  MeasureMode heightMeasureMode,
+                                  void* layoutContext) {
+  measureCount++;
+  return measureTextLength(textLength(node), width, widthMeasureMode);
+}
+
+static inline HPNodeRef newText(uint32_t length) {
+  const HPNodeRef text = HPNodeNew();
+  text->setContext(reinterpret_cast<void*>(static_cast<uintptr_t>(length)));
+  HPNodeSetMeasureFunc(text, _measureText);
+  return text;
+}
+
+// results of trees of same shape are the same bit for bit. hadOverflow is
+// not compared, stretched items pass it up from their previous layout.
+static inline void expectSameLayout(HPNodeRef expected, HPNodeRef actual) {
+  ASSERT_EQ(0, memcmp(expected->result.position, actual->result.position,
+                      sizeof(expected->result.position)));
+  ASSERT_EQ(0, memcmp(expected->result.dim, actual->result.dim, sizeof(expected->result.dim)));
+  for (int i = CSSLeft; i <= CSSBottom; i++) {
+    CSSDirection edge = static_cast<CSSDirection>(i);
+    ASSERT_EQ(HPNodeLayoutGetMargin(expected, edge), HPNodeLayoutGetMargin(actual, edge));
+    ASSERT_EQ(HPNodeLayoutGetPadding(expected, edge), HPNodeLayoutGetPadding(actual, edge));
+    ASSERT_EQ(HPNodeLayoutGetBorder(expected, edge), HPNodeLayoutGetBorder(actual, edge));
+  }
+  ASSERT_EQ(expected->childCount(), actual->childCount());
+  for (uint32_t i = 0; i < expected->childCount(); i++) {
+    expectSameLayout(expected->getChild(i), actual->getChild(i));
+  }
+}
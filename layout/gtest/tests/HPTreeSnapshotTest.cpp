@@ -0,0 +1,235 @@
+/* Tencent is pleased to support the open source community by making Hippy available.
+ * Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <Hippy.h>
+#include <gtest.h>
+#include "HPTestUtil.h"
+
+static uint32_t dirtiedCount = 0;
+
+static void _dirtied(HPNodeRef node) {
+  dirtiedCount++;
+}
+
+// snapshot of nodeCount nodes built by the given mutations, no measures.
+static std::vector<uint8_t> _snapshot(uint32_t nodeCount,
+                                      const HPMutation* mutations,
+                                      uint32_t mutationCount) {
+  HPSnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = HP_SNAPSHOT_MAGIC;
+  header.version = HP_SNAPSHOT_VERSION;
+  header.nodeCount = nodeCount;
+  header.mutationCount = mutationCount;
+  header.width = 100;
+  header.height = 100;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&header);
+  std::vector<uint8_t> buffer(bytes, bytes + sizeof(header));
+  bytes = reinterpret_cast<const uint8_t*>(mutations);
+  buffer.insert(buffer.end(), bytes, bytes + mutationCount * sizeof(HPMutation));
+  return buffer;
+}
+
+// column of count cards, each a row of a box and a text which shrinks.
+static HPNodeRef _cards(uint32_t count) {
+  const HPNodeRef root = HPNodeNew();
+  HPNodeStyleSetPadding(root, CSSAll, 8);
+  for (uint32_t i = 0; i < count; i++) {
+    const HPNodeRef card = HPNodeNew();
+    HPNodeStyleSetFlexDirection(card, FLexDirectionRow);
+    HPNodeStyleSetPadding(card, CSSAll, 4);
+    const HPNodeRef box = HPNodeNew();
+    HPNodeStyleSetWidth(box, 16);
+    HPNodeStyleSetHeight(box, 16);
+    HPNodeInsertChild(card, box, 0);
+    const HPNodeRef text = newText(5 + i * 37 % 24);
+    HPNodeStyleSetFlexShrink(text, 1);
+    HPNodeInsertChild(card, text, 1);
+    HPNodeInsertChild(root, card, i);
+  }
+  return root;
+}
+
+static HPMutation _mutation(HPMutationOp op, uint32_t node, uint32_t child) {
+  HPMutation mutation = {static_cast<uint8_t>(op), 0, 0, 0, node, child, {0}};
+  return mutation;
+}
+
+TEST(HippyTest, tree_snapshot_replays_recorded_layout) {
+  // wrapped cards of a box and a text, with start, auto and absolute edges.
+  const HPNodeRef root = _cards(6);
+  HPNodeStyleSetFlexDirection(root, FLexDirectionRow);
+  HPNodeStyleSetFlexWrap(root, FlexWrap);
+  for (uint32_t i = 0; i < root->childCount(); i++) {
+    const HPNodeRef card = root->getChild(i);
+    HPNodeStyleSetWidth(card, 110);
+    HPNodeStyleSetMargin(card, CSSStart, 6);
+    HPNodeStyleSetBorder(card, CSSAll, 1);
+    HPNodeStyleSetMarginAuto(card->getChild(0), CSSTop);
+    HPNodeStyleSetFlex(card->getChild(1), 1);
+    card->getChild(1)->setDirtiedFunc(_dirtied);
+    const HPNodeRef badge = HPNodeNew();
+    HPNodeStyleSetPositionType(badge, PositionTypeAbsolute);
+    HPNodeStyleSetPosition(badge, CSSEnd, 2);
+    HPNodeStyleSetPosition(badge, CSSTop, 2);
+    HPNodeStyleSetWidth(badge, 8);
+    HPNodeStyleSetHeight(badge, 8);
+    HPNodeInsertChild(card, badge, 2);
+  }
+  HPNodeDoLayout(root, 375, VALUE_UNDEFINED, DirectionRTL);
+  std::vector<uint8_t> buffer;
+  measureCount = 0;
+  dirtiedCount = 0;
+  ASSERT_TRUE(HPNodeRecordSnapshot(root, 375, VALUE_UNDEFINED, &buffer, DirectionRTL));
+  ASSERT_GT(measureCount.load(), 0u);
+  ASSERT_EQ(0u, dirtiedCount);
+  ASSERT_TRUE(root->getChild(0)->getChild(1)->measure == _measureText);
+
+  measureCount = 0;
+  const HPTreeSnapshotRef snapshot = HPTreeSnapshotLoad(buffer.data(), buffer.size());
+  ASSERT_FALSE(snapshot == nullptr);
+  HPTreeSnapshotLayout(snapshot);
+  expectSameLayout(root, HPTreeSnapshotGetRoot(snapshot));
+  ASSERT_EQ(0u, HPTreeSnapshotGetMissCount(snapshot));
+  ASSERT_EQ(0u, measureCount.load());
+
+  // replay again from scratch, with stats.
+  HPLayoutStats stats;
+  HPTreeSnapshotLayout(snapshot, &stats);
+  expectSameLayout(root, HPTreeSnapshotGetRoot(snapshot));
+  ASSERT_GT(stats.measureFuncCount, 0u);
+  ASSERT_EQ(0u, HPTreeSnapshotGetMissCount(snapshot));
+
+  HPTreeSnapshotFree(snapshot);
+  HPNodeFreeRecursive(root);
+}
+
+static void* measuredContext = nullptr;
+
+static HPSize _measureContext(HPNodeRef node,
+                              float width,
+                              MeasureMode widthMeasureMode,
+                              float height,
+                              MeasureMode heightMeasureMode,
+                              void* layoutContext) {
+  measuredContext = layoutContext;
+  return HPSize{10, 10};
+}
+
+TEST(HippyTest, tree_snapshot_passes_layout_context_to_measure) {
+  const HPNodeRef root = HPNodeNew();
+  const HPNodeRef text = HPNodeNew();
+  HPNodeSetMeasureFunc(text, _measureContext);
+  HPNodeInsertChild(root, text, 0);
+  int context = 0;
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(HPNodeRecordSnapshot(root, 100, 100, &buffer, DirectionLTR, &context));
+  ASSERT_EQ(&context, measuredContext);
+  ASSERT_TRUE(text->measure == _measureContext);
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, tree_snapshot_rejects_invalid_data) {
+  const HPNodeRef root = _cards(4);
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(HPNodeRecordSnapshot(root, 375, 667, &buffer));
+
+  ASSERT_TRUE(HPTreeSnapshotLoad(buffer.data(), buffer.size() - 1) == nullptr);
+  ASSERT_TRUE(HPTreeSnapshotLoad(buffer.data(), 8) == nullptr);
+  std::vector<uint8_t> badMagic(buffer);
+  badMagic[0] ^= 0xff;
+  ASSERT_TRUE(HPTreeSnapshotLoad(badMagic.data(), badMagic.size()) == nullptr);
+  // a child inserted into a node which is not created yet.
+  std::vector<uint8_t> badTree(buffer);
+  HPMutation* mutations = reinterpret_cast<HPMutation*>(badTree.data() + sizeof(HPSnapshotHeader));
+  mutations[0].op = HPMutationInsertChild;
+  ASSERT_TRUE(HPTreeSnapshotLoad(badTree.data(), badTree.size()) == nullptr);
+
+  const HPTreeSnapshotRef snapshot = HPTreeSnapshotLoad(buffer.data(), buffer.size());
+  ASSERT_FALSE(snapshot == nullptr);
+  HPTreeSnapshotLayout(snapshot);
+  expectSameLayout(root, HPTreeSnapshotGetRoot(snapshot));
+  HPTreeSnapshotFree(snapshot);
+  HPNodeFreeRecursive(root);
+}
+
+TEST(HippyTest, tree_snapshot_rejects_nodes_outside_tree) {
+  HPMutation tree[3] = {_mutation(HPMutationCreateNode, 0, 0),
+                        _mutation(HPMutationCreateNode, 1, 0),
+                        _mutation(HPMutationInsertChild, 0, 1)};
+  std::vector<uint8_t> buffer = _snapshot(2, tree, 3);
+  const HPTreeSnapshotRef snapshot = HPTreeSnapshotLoad(buffer.data(), buffer.size());
+  ASSERT_FALSE(snapshot == nullptr);
+  HPTreeSnapshotLayout(snapshot);
+  ASSERT_FLOAT_EQ(100, HPNodeLayoutGetWidth(HPTreeSnapshotGetRoot(snapshot)));
+  HPTreeSnapshotFree(snapshot);
+
+  // a node not inserted.
+  buffer = _snapshot(2, tree, 2);
+  ASSERT_TRUE(HPTreeSnapshotLoad(buffer.data(), buffer.size()) == nullptr);
+
+  // a node inserted into itself.
+  HPMutation self[4] = {_mutation(HPMutationCreateNode, 0, 0),
+                        _mutation(HPMutationCreateNode, 1, 0),
+                        _mutation(HPMutationInsertChild, 0, 1),
+                        _mutation(HPMutationInsertChild, 1, 1)};
+  buffer = _snapshot(2, self, 4);
+  ASSERT_TRUE(HPTreeSnapshotLoad(buffer.data(), buffer.size()) == nullptr);
+
+  // two nodes inserted into each other.
+  HPMutation cycle[5] = {_mutation(HPMutationCreateNode, 0, 0),
+                         _mutation(HPMutationCreateNode, 1, 0),
+                         _mutation(HPMutationCreateNode, 2, 0),
+                         _mutation(HPMutationInsertChild, 1, 2),
+                         _mutation(HPMutationInsertChild, 2, 1)};
+  buffer = _snapshot(3, cycle, 5);
+  ASSERT_TRUE(HPTreeSnapshotLoad(buffer.data(), buffer.size()) == nullptr);
+
+  // more nodes than mutations to create them, rejected before allocated.
+  buffer = _snapshot(0xffffffff, tree, 3);
+  ASSERT_TRUE(HPTreeSnapshotLoad(buffer.data(), buffer.size()) == nullptr);
+}
+
+TEST(HippyTest, tree_snapshot_keeps_priority_of_unchanged_edges) {
+  // start and left margins set to values they already have, so that they
+  // still take priority over left and all when replayed.
+  const HPNodeRef root = HPNodeNew();
+  const HPNodeRef start = HPNodeNew();
+  HPNodeStyleSetWidth(start, 20);
+  HPNodeStyleSetHeight(start, 20);
+  HPNodeStyleSetMargin(start, CSSLeft, 10);
+  HPNodeStyleSetMargin(start, CSSStart, 5);
+  HPNodeStyleSetMargin(start, CSSStart, 0);
+  HPNodeInsertChild(root, start, 0);
+  const HPNodeRef left = HPNodeNew();
+  HPNodeStyleSetWidth(left, 20);
+  HPNodeStyleSetHeight(left, 20);
+  HPNodeStyleSetMargin(left, CSSAll, 10);
+  HPNodeStyleSetMargin(left, CSSLeft, 10);
+  HPNodeInsertChild(root, left, 1);
+  HPNodeDoLayout(root, 100, 100);
+  ASSERT_FLOAT_EQ(0, HPNodeLayoutGetLeft(start));
+
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(HPNodeRecordSnapshot(root, 100, 100, &buffer));
+  const HPTreeSnapshotRef snapshot = HPTreeSnapshotLoad(buffer.data(), buffer.size());
+  ASSERT_FALSE(snapshot == nullptr);
+  HPTreeSnapshotLayout(snapshot);
+  expectSameLayout(root, HPTreeSnapshotGetRoot(snapshot));
+  HPTreeSnapshotFree(snapshot);
+  HPNodeFreeRecursive(root);
+}